@@ -61,6 +61,27 @@ static WMMtype_Ellipsoid        Ellip;
 static WMMtype_MagneticModel    MagneticModel;
 static float                    decimal_date;
 
+// Kept out of the stack of the calling task, the model is not reentrant anyway
+static WMMtype_LegendreFunction LegendreFunction;
+static float                    schmidtQuasiNormCache[NUMPCUP];
+static uint16_t                 schmidtQuasiNormDegree;
+
+// Field around the last point evaluated by WMM_GetMagVectorCached
+static struct wmm_field         cached_field;
+static bool                     cached_field_valid;
+
+/* Step used for the spatial gradients (central differences) */
+#define WMM_GRADIENT_STEP_DEG   0.1f
+#define WMM_GRADIENT_STEP_ALT   1000.0f
+
+/* How far the cached field is extrapolated before it is evaluated again */
+#define WMM_CACHE_RADIUS_DEG    0.5f
+#define WMM_CACHE_RADIUS_ALT    5000.0f
+
+static int wmm_check_position(float Lat, float Lon);
+static int wmm_evaluate(float Lat, float Lon, float AltEllipsoid, WMMtype_GeoMagneticElements *GeoMagneticElements);
+static float wmm_wrap_lon(float Lon);
+
 /**************************************************************************************
 *   Example use - very simple - only two exposed functions
 *
@@ -70,6 +91,11 @@ static float                    decimal_date;
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
 *	B is the NED (XYZ) magnetic vector in nTesla
+*
+*	Callers which query the model repeatedly while moving can use
+*	WMM_GetMagVectorCached(), which only runs the full model when the vehicle
+*	leaves the neighbourhood of the last evaluation, or WMM_GetMagField() to
+*	get the field together with its gradients and extrapolate it themselves.
 **************************************************************************************/
 
 int WMM_Initialize()
@@ -100,67 +126,183 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     // return '0' if all appears to be OK
     // return < 0 if error
 
-    int returned = 0;   // default to OK
+    WMMtype_GeoMagneticElements GeoMagneticElements;
 
-    // ***********
-    // range check supplied params
+    int returned = wmm_check_position(Lat, Lon);
+    if (returned < 0)
+        return returned;
 
-    if (Lat <  -90) return -1;  // error
-    if (Lat >   90) return -2;  // error
+    if (WMM_Initialize() < 0)
+        return -6;  // error
 
-    if (Lon < -180) return -3;  // error
-    if (Lon >  180) return -4;  // error
+    if (WMM_DateToYear(Month, Day, Year) < 0)
+        return -8;  // error
 
+    returned = wmm_evaluate(Lat, Lon, AltEllipsoid, &GeoMagneticElements);
+    if (returned < 0)
+        return returned;
 
-    WMMtype_CoordSpherical CoordSpherical;
-    WMMtype_CoordGeodetic CoordGeodetic;
-    WMMtype_GeoMagneticElements GeoMagneticElements;
+    B[0] = GeoMagneticElements.X * 1e-2f;
+    B[1] = GeoMagneticElements.Y * 1e-2f;
+    B[2] = GeoMagneticElements.Z * 1e-2f;
 
+    return 0;
+}
 
-    // ***********
+int WMM_GetMagField(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, struct wmm_field *field)
+{
+    WMMtype_GeoMagneticElements Center, Upper, Lower;
+    float LatUpper, LatLower;
 
-    if (returned >= 0)
-    {
-        if (WMM_Initialize() < 0)
-            returned = -6;  // error
-    }
+    int returned = wmm_check_position(Lat, Lon);
+    if (returned < 0)
+        return returned;
 
-    if (returned >= 0)
-    {
-        CoordGeodetic.lambda = Lon;
-        CoordGeodetic.phi = Lat;
-        CoordGeodetic.HeightAboveEllipsoid = AltEllipsoid/1000.0f; // convert to km
+    if (WMM_Initialize() < 0)
+        return -6;  // error
 
-        // Convert from geodeitic to Spherical Equations: 17-18, WMM Technical report
-        if (WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical) < 0)
-            returned = -7;  // error
-    }
+    if (WMM_DateToYear(Month, Day, Year) < 0)
+        return -8;  // error
 
+    returned = wmm_evaluate(Lat, Lon, AltEllipsoid, &Center);
+    if (returned < 0)
+        return returned;
 
-    if (returned >= 0)
-    {
-        if (WMM_DateToYear(Month, Day, Year) < 0)
-            returned = -8;  // error
-    }
+    field->lat = Lat;
+    field->lon = Lon;
+    field->alt = AltEllipsoid;
+    field->year = decimal_date;
 
-    if (returned >= 0)
-    {
-        // Compute the geoMagnetic field elements and their time change
-        if (WMM_Geomag(&CoordSpherical, &CoordGeodetic, &GeoMagneticElements) < 0)
-            returned = -9;  // error
-        else
-        {   // set the returned values
-            B[0] = GeoMagneticElements.X;
-            B[1] = GeoMagneticElements.Y;
-            B[2] = GeoMagneticElements.Z;
-        }
+    field->B[0] = Center.X * 1e-2f;
+    field->B[1] = Center.Y * 1e-2f;
+    field->B[2] = Center.Z * 1e-2f;
+
+    // The model is linear in time so the secular variation is the exact time derivative
+    field->dB_dyear[0] = Center.Xdot * 1e-2f;
+    field->dB_dyear[1] = Center.Ydot * 1e-2f;
+    field->dB_dyear[2] = Center.Zdot * 1e-2f;
+
+    // Central differences for the spatial gradients, one sided at the poles
+    LatUpper = Lat + WMM_GRADIENT_STEP_DEG;
+    LatLower = Lat - WMM_GRADIENT_STEP_DEG;
+    if (LatUpper > 90)
+        LatUpper = 90;
+    if (LatLower < -90)
+        LatLower = -90;
+
+    if (wmm_evaluate(LatUpper, Lon, AltEllipsoid, &Upper) < 0 ||
+        wmm_evaluate(LatLower, Lon, AltEllipsoid, &Lower) < 0)
+        return -9;  // error
+
+    field->dB_dlat[0] = (Upper.X - Lower.X) * 1e-2f / (LatUpper - LatLower);
+    field->dB_dlat[1] = (Upper.Y - Lower.Y) * 1e-2f / (LatUpper - LatLower);
+    field->dB_dlat[2] = (Upper.Z - Lower.Z) * 1e-2f / (LatUpper - LatLower);
+
+    if (wmm_evaluate(Lat, wmm_wrap_lon(Lon + WMM_GRADIENT_STEP_DEG), AltEllipsoid, &Upper) < 0 ||
+        wmm_evaluate(Lat, wmm_wrap_lon(Lon - WMM_GRADIENT_STEP_DEG), AltEllipsoid, &Lower) < 0)
+        return -9;  // error
+
+    field->dB_dlon[0] = (Upper.X - Lower.X) * 1e-2f / (2 * WMM_GRADIENT_STEP_DEG);
+    field->dB_dlon[1] = (Upper.Y - Lower.Y) * 1e-2f / (2 * WMM_GRADIENT_STEP_DEG);
+    field->dB_dlon[2] = (Upper.Z - Lower.Z) * 1e-2f / (2 * WMM_GRADIENT_STEP_DEG);
+
+    if (wmm_evaluate(Lat, Lon, AltEllipsoid + WMM_GRADIENT_STEP_ALT, &Upper) < 0 ||
+        wmm_evaluate(Lat, Lon, AltEllipsoid - WMM_GRADIENT_STEP_ALT, &Lower) < 0)
+        return -9;  // error
+
+    field->dB_dalt[0] = (Upper.X - Lower.X) * 1e-2f / (2 * WMM_GRADIENT_STEP_ALT);
+    field->dB_dalt[1] = (Upper.Y - Lower.Y) * 1e-2f / (2 * WMM_GRADIENT_STEP_ALT);
+    field->dB_dalt[2] = (Upper.Z - Lower.Z) * 1e-2f / (2 * WMM_GRADIENT_STEP_ALT);
+
+    return 0;
+}
+
+bool WMM_FieldValid(const struct wmm_field *field, float Lat, float Lon, float AltEllipsoid)
+{
+    // Degrees of longitude shrink towards the poles so this is conservative
+    return fabsf(Lat - field->lat) <= WMM_CACHE_RADIUS_DEG &&
+           fabsf(wmm_wrap_lon(Lon - field->lon)) <= WMM_CACHE_RADIUS_DEG &&
+           fabsf(AltEllipsoid - field->alt) <= WMM_CACHE_RADIUS_ALT;
+}
+
+void WMM_FieldExtrapolate(const struct wmm_field *field, float Lat, float Lon, float AltEllipsoid, float Years, float B[3])
+{
+    float dLat = Lat - field->lat;
+    float dLon = wmm_wrap_lon(Lon - field->lon);
+    float dAlt = AltEllipsoid - field->alt;
+
+    for (int i = 0; i < 3; i++)
+        B[i] = field->B[i] + dLat * field->dB_dlat[i] + dLon * field->dB_dlon[i] +
+               dAlt * field->dB_dalt[i] + Years * field->dB_dyear[i];
+}
+
+int WMM_GetMagVectorCached(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3])
+{
+    int returned = wmm_check_position(Lat, Lon);
+    if (returned < 0)
+        return returned;
+
+    if (!cached_field_valid || !WMM_FieldValid(&cached_field, Lat, Lon, AltEllipsoid)) {
+        returned = WMM_GetMagField(Lat, Lon, AltEllipsoid, Month, Day, Year, &cached_field);
+        cached_field_valid = (returned == 0);
+        if (returned < 0)
+            return returned;
+    } else if (WMM_DateToYear(Month, Day, Year) < 0) {
+        return -8;  // error
     }
 
-	B[0] = GeoMagneticElements.X * 1e-2f;
-	B[1] = GeoMagneticElements.Y * 1e-2f;
-	B[2] = GeoMagneticElements.Z * 1e-2f;
+    WMM_FieldExtrapolate(&cached_field, Lat, Lon, AltEllipsoid, decimal_date - cached_field.year, B);
 
-    return returned;
+    return 0;
+}
+
+/**
+ * Check a position is within range of the model
+ */
+static int wmm_check_position(float Lat, float Lon)
+{
+    if (Lat <  -90) return -1;  // error
+    if (Lat >   90) return -2;  // error
+
+    if (Lon < -180) return -3;  // error
+    if (Lon >  180) return -4;  // error
+
+    return 0;
+}
+
+/**
+ * Wrap a longitude (or a difference of longitudes) into [-180, 180]
+ */
+static float wmm_wrap_lon(float Lon)
+{
+    if (Lon > 180)
+        return Lon - 360;
+    if (Lon < -180)
+        return Lon + 360;
+    return Lon;
+}
+
+/**
+ * Evaluate the full model at a point for the date last set by WMM_DateToYear
+ */
+static int wmm_evaluate(float Lat, float Lon, float AltEllipsoid, WMMtype_GeoMagneticElements *GeoMagneticElements)
+{
+    WMMtype_CoordSpherical CoordSpherical;
+    WMMtype_CoordGeodetic CoordGeodetic;
+
+    CoordGeodetic.lambda = Lon;
+    CoordGeodetic.phi = Lat;
+    CoordGeodetic.HeightAboveEllipsoid = AltEllipsoid/1000.0f; // convert to km
+
+    // Convert from geodeitic to Spherical Equations: 17-18, WMM Technical report
+    if (WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical) < 0)
+        return -7;  // error
+
+    // Compute the geoMagnetic field elements and their time change
+    if (WMM_Geomag(&CoordSpherical, &CoordGeodetic, GeoMagneticElements) < 0)
+        return -9;  // error
+
+    return 0;
 }
 
 int WMM_Geomag(WMMtype_CoordSpherical * CoordSpherical, WMMtype_CoordGeodetic * CoordGeodetic, WMMtype_GeoMagneticElements * GeoMagneticElements)
@@ -195,7 +337,6 @@ int WMM_Geomag(WMMtype_CoordSpherical * CoordSpherical, WMMtype_CoordGeodetic *
     WMMtype_MagneticResults             MagneticResultsSphVar;
     WMMtype_MagneticResults             MagneticResultsGeoVar;
 
-    WMMtype_LegendreFunction            LegendreFunction;
     WMMtype_SphericalHarmonicVariables  SphVariables;
 
     // ********
@@ -791,10 +932,9 @@ int WMM_PcupLow(float *Pcup, float *dPcup, float x, uint16_t nMax)
 {
     uint16_t    n, m, index, index1, index2;
     float       k, z;
-    float schmidtQuasiNorm_s[NUMPCUP];
-    float       *schmidtQuasiNorm = schmidtQuasiNorm_s;
+    float       *schmidtQuasiNorm = schmidtQuasiNormCache;
 
-    if (!schmidtQuasiNorm)
+    if (nMax > WMM_MAX_MODEL_DEGREES)
     {
         return -1;
     }
@@ -846,23 +986,27 @@ int WMM_PcupLow(float *Pcup, float *dPcup, float x, uint16_t nMax)
 	}
 /*Compute the ration between the Gauss-normalized associated Legendre
   functions and the Schmidt quasi-normalized version. This is equivalent to
-  sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!  */
+  sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!
+  The ratios only depend on the degree so they are computed once and kept. */
 
-	schmidtQuasiNorm[0] = 1.0;
-	for (n = 1; n <= nMax; n++)
+	if (schmidtQuasiNormDegree < nMax)
 	{
-		index = (n * (n + 1) / 2);
-		index1 = (n - 1) * n / 2;
-		/* for m = 0 */
-		schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * (float)(2 * n - 1) / (float)n;
-
-		for (m = 1; m <= n; m++)
+		schmidtQuasiNorm[0] = 1.0;
+		for (n = 1; n <= nMax; n++)
 		{
-			index = (n * (n + 1) / 2 + m);
-			index1 = (n * (n + 1) / 2 + m - 1);
-			schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * sqrtf((float)((n - m + 1) * (m == 1 ? 2 : 1)) / (float)(n + m));
-		}
+			index = (n * (n + 1) / 2);
+			index1 = (n - 1) * n / 2;
+			/* for m = 0 */
+			schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * (float)(2 * n - 1) / (float)n;
 
+			for (m = 1; m <= n; m++)
+			{
+				index = (n * (n + 1) / 2 + m);
+				index1 = (n * (n + 1) / 2 + m - 1);
+				schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * sqrtf((float)((n - m + 1) * (m == 1 ? 2 : 1)) / (float)(n + m));
+			}
+		}
+		schmidtQuasiNormDegree = nMax;
 	}
 
 /* Converts the  Gauss-normalized associated Legendre
@@ -903,10 +1047,7 @@ int WMM_SummationSpecial(WMMtype_SphericalHarmonicVariables *
     float       schmidtQuasiNorm2;
     float       schmidtQuasiNorm3;
 
-    float PcupsS_s[NUMPCUPS];
-    float       *PcupS = PcupsS_s;
-    if (!PcupS)
-        return -1;
+    float       PcupS[NUMPCUPS];
 
 	PcupS[0] = 1;
 	schmidtQuasiNorm1 = 1.0;
@@ -968,10 +1109,7 @@ int WMM_SecVarSummationSpecial(WMMtype_SphericalHarmonicVariables *
     float       schmidtQuasiNorm2;
     float       schmidtQuasiNorm3;
 
-    float PcupsS_s[NUMPCUPS];
-    float       *PcupS = PcupsS_s;
-    if (!PcupS)
-        return -1;
+    float       PcupS[NUMPCUPS];
 
 	PcupS[0] = 1;
 	schmidtQuasiNorm1 = 1.0;
@@ -1011,66 +1149,40 @@ int WMM_SecVarSummationSpecial(WMMtype_SphericalHarmonicVariables *
 }
 
 /**
- * @brief Comput the MainFieldCoeffH accounting for the date
+ * @brief Compute the main field coefficient g accounting for the date
+ *
+ * The secular variation is linear in time and only modelled up to degree
+ * nMaxSecVar, i.e. for the first nMaxSecVar * (nMaxSecVar + 3) / 2 terms.
  */
 float WMM_get_main_field_coeff_g(uint16_t index) 
 {	
 	if (index >= NUMTERMS)
 		return 0;
 
-    uint16_t n, m, sum_index, a, b;
+	float coeff = CoeffFile[index][2];
+	uint16_t a = MagneticModel.nMaxSecVar;
+
+	if (index <= a * (a + 1) / 2 + a)
+		coeff += (decimal_date - MagneticModel.epoch) * CoeffFile[index][4];
 
-    float coeff = CoeffFile[index][2];
-	
-	a = MagneticModel.nMaxSecVar;
-	b = (a * (a + 1) / 2 + a);
-	for (n = 1; n <= MagneticModel.nMax; n++)
-	{
-		for (m = 0; m <= n; m++)
-		{
-			
-			sum_index = (n * (n + 1) / 2 + m);
-			
-			/* Hacky for now, will solve for which conditions need summing analytically */
-			if (sum_index != index)
-				continue;
-			
-			if (index <= b) 
-				coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_g(sum_index);
-			
-		}
-	}
-	
 	return coeff;
 }
 
+/**
+ * @brief Compute the main field coefficient h accounting for the date
+ */
 float WMM_get_main_field_coeff_h(uint16_t index) 
 {	
 	if (index >= NUMTERMS)
 		return 0;
-	
-    uint16_t n, m, sum_index, a, b;
+
 	float coeff = CoeffFile[index][3];
-	
-	a = MagneticModel.nMaxSecVar;
-	b = (a * (a + 1) / 2 + a);
-	for (n = 1; n <= MagneticModel.nMax; n++)
-	{
-		for (m = 0; m <= n; m++)
-		{
-			
-			sum_index = (n * (n + 1) / 2 + m);
-			
-			/* Hacky for now, will solve for which conditions need summing analytically */
-			if (sum_index != index)
-				continue;
-			
-			if (index <= b) 
-				coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_h(sum_index);
-		}
-	}
-	
-	return coeff;	
+	uint16_t a = MagneticModel.nMaxSecVar;
+
+	if (index <= a * (a + 1) / 2 + a)
+		coeff += (decimal_date - MagneticModel.epoch) * CoeffFile[index][5];
+
+	return coeff;
 }
 
 float WMM_get_secular_var_coeff_g(uint16_t index) 
@@ -5,7 +5,7 @@
  *
  * @file       WorldMagModel.h
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2010.
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2014
  * @brief      Source file for the World Magnetic Model
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -29,9 +29,29 @@
 #ifndef WORLDMAGMODEL_H_
 #define WORLDMAGMODEL_H_
 
+/**
+ * The magnetic field around a point together with its first order change,
+ * in the units of @ref WMM_GetMagVector
+ */
+struct wmm_field {
+	float lat;          //!< Latitude the field was evaluated at [deg]
+	float lon;          //!< Longitude the field was evaluated at [deg]
+	float alt;          //!< Altitude above the WGS-84 ellipsoid [m]
+	float year;         //!< Decimal year the field was evaluated for
+	float B[3];         //!< NED field at the point
+	float dB_dlat[3];   //!< Change per degree of latitude
+	float dB_dlon[3];   //!< Change per degree of longitude
+	float dB_dalt[3];   //!< Change per meter of altitude
+	float dB_dyear[3];  //!< Change per year (secular variation)
+};
+
 	//  Exposed Function Prototypes
 int WMM_Initialize();
 int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3]);
+int WMM_GetMagVectorCached(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3]);
+int WMM_GetMagField(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, struct wmm_field *field);
+bool WMM_FieldValid(const struct wmm_field *field, float Lat, float Lon, float AltEllipsoid);
+void WMM_FieldExtrapolate(const struct wmm_field *field, float Lat, float Lon, float AltEllipsoid, float Years, float B[3]);
 
 #endif /* WORLDMAGMODEL_H_ */
 
@@ -0,0 +1,59 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       latencytrace.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Gyro to actuator latency and loop jitter profiler
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef LATENCYTRACE_H
+#define LATENCYTRACE_H
+
+/**
+ * Trace points along the control path, in the order a gyro sample
+ * travels through them.
+ */
+enum latency_trace_event {
+	LATENCY_TRACE_SENSOR_READ,
+	LATENCY_TRACE_ATTITUDE_UPDATE,
+	LATENCY_TRACE_STABILIZATION_PID,
+	LATENCY_TRACE_ACTUATOR_OUTPUT,
+	LATENCY_TRACE_NUM_EVENTS
+};
+
+#if defined(DIAG_LATENCY)
+
+int32_t LatencyTraceInitialize(void);
+void LatencyTraceEvent(enum latency_trace_event event);
+void LatencyTraceUpdate(void);
+
+#define LATENCY_TRACE(event) LatencyTraceEvent(event)
+
+#else
+
+#define LATENCY_TRACE(event) do { } while (0)
+
+#endif /* DIAG_LATENCY */
+
+#endif // LATENCYTRACE_H
+
+/**
+ * @}
+ */
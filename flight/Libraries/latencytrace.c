@@ -0,0 +1,230 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       latencytrace.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Gyro to actuator latency and loop jitter profiler
+ *
+ * Each trace point stamps itself with @ref PIOS_DELAY_GetRaw and folds the
+ * time since the previous stage straight into a log-linear histogram, so no
+ * event storage is needed between the high rate control tasks and the 1 Hz
+ * system task that publishes @ref LatencyStats. The whole library compiles
+ * to nothing unless DIAG_LATENCY is defined.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "latencytrace.h"
+
+#if defined(DIAG_LATENCY)
+
+#include "latencystats.h"
+
+// Private constants
+
+/* Four buckets per power of two (~25% resolution) from 0 us up to 2^18 us */
+#define HIST_SUB_BITS     2
+#define HIST_SUB_BUCKETS  (1 << HIST_SUB_BITS)
+#define HIST_MAX_MSB      17
+#define HIST_NUM_BUCKETS  ((HIST_MAX_MSB - HIST_SUB_BITS + 2) * HIST_SUB_BUCKETS)
+
+#define NUM_STAGES        LATENCYSTATS_P50_NUMELEM
+
+// Private types
+
+struct latency_hist {
+	uint16_t bucket[HIST_NUM_BUCKETS];
+	uint32_t samples;
+	uint32_t max;
+	volatile bool clear;   //!< Set by the reader, honoured by the next writer
+};
+
+// Private variables
+static struct latency_hist hists[NUM_STAGES];
+static uint32_t last_raw[LATENCY_TRACE_NUM_EVENTS];
+static uint32_t origin_raw[LATENCY_TRACE_NUM_EVENTS];
+static uint8_t seen;
+
+// Private functions
+
+/**
+ * Map a duration onto a histogram bucket. Values below HIST_SUB_BUCKETS get
+ * their own bucket, above that each octave is split in HIST_SUB_BUCKETS.
+ */
+static uint8_t hist_bucket(uint32_t us)
+{
+	if (us < HIST_SUB_BUCKETS)
+		return us;
+
+	uint8_t msb = 31 - __builtin_clz(us);
+	if (msb > HIST_MAX_MSB)
+		return HIST_NUM_BUCKETS - 1;
+
+	uint8_t shift = msb - HIST_SUB_BITS;
+	return (shift + 1) * HIST_SUB_BUCKETS + ((us >> shift) & (HIST_SUB_BUCKETS - 1));
+}
+
+/**
+ * Largest duration that maps onto a bucket
+ */
+static uint32_t hist_bucket_top(uint8_t idx)
+{
+	if (idx < HIST_SUB_BUCKETS)
+		return idx;
+
+	uint8_t shift = idx / HIST_SUB_BUCKETS - 1;
+	uint32_t sub = idx % HIST_SUB_BUCKETS;
+	return ((HIST_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+static void hist_add(struct latency_hist *h, uint32_t us)
+{
+	if (h->clear) {
+		memset(h->bucket, 0, sizeof(h->bucket));
+		h->samples = 0;
+		h->max = 0;
+		h->clear = false;
+	}
+
+	h->bucket[hist_bucket(us)]++;
+	h->samples++;
+	if (us > h->max)
+		h->max = us;
+}
+
+/**
+ * Find the bucket containing the requested percentile. The result is the
+ * upper edge of that bucket so it never under reports, clamped to the
+ * exact maximum.
+ */
+static uint32_t hist_percentile(const struct latency_hist *h, uint8_t percent)
+{
+	uint32_t threshold = (h->samples * percent + 99) / 100;
+	uint32_t count = 0;
+
+	for (uint8_t i = 0; i < HIST_NUM_BUCKETS; i++) {
+		count += h->bucket[i];
+		if (count >= threshold) {
+			uint32_t top = hist_bucket_top(i);
+			return top < h->max ? top : h->max;
+		}
+	}
+
+	return h->max;
+}
+
+static uint16_t saturate_u16(uint32_t val)
+{
+	return val > 0xffff ? 0xffff : val;
+}
+
+/**
+ * Initialize library
+ */
+int32_t LatencyTraceInitialize(void)
+{
+	memset(hists, 0, sizeof(hists));
+	memset(last_raw, 0, sizeof(last_raw));
+	memset(origin_raw, 0, sizeof(origin_raw));
+	seen = 0;
+
+	return LatencyStatsInitialize();
+}
+
+/**
+ * Record that the control path passed a trace point. Must only be called
+ * from the single task that owns that trace point.
+ */
+void LatencyTraceEvent(enum latency_trace_event event)
+{
+	uint32_t now = PIOS_DELAY_GetRaw();
+
+	switch (event) {
+	case LATENCY_TRACE_SENSOR_READ:
+		origin_raw[event] = now;
+		break;
+	case LATENCY_TRACE_ATTITUDE_UPDATE:
+		if (!(seen & (1 << LATENCY_TRACE_SENSOR_READ)))
+			break;
+		hist_add(&hists[LATENCYSTATS_P50_SENSORTOATTITUDE],
+			PIOS_DELAY_DiffuS2(last_raw[LATENCY_TRACE_SENSOR_READ], now));
+		origin_raw[event] = origin_raw[LATENCY_TRACE_SENSOR_READ];
+		break;
+	case LATENCY_TRACE_STABILIZATION_PID:
+		if (seen & (1 << LATENCY_TRACE_STABILIZATION_PID))
+			hist_add(&hists[LATENCYSTATS_P50_STABILIZATIONPERIOD],
+				PIOS_DELAY_DiffuS2(last_raw[LATENCY_TRACE_STABILIZATION_PID], now));
+		if (!(seen & (1 << LATENCY_TRACE_ATTITUDE_UPDATE)))
+			break;
+		hist_add(&hists[LATENCYSTATS_P50_ATTITUDETOSTABILIZATION],
+			PIOS_DELAY_DiffuS2(last_raw[LATENCY_TRACE_ATTITUDE_UPDATE], now));
+		origin_raw[event] = origin_raw[LATENCY_TRACE_ATTITUDE_UPDATE];
+		break;
+	case LATENCY_TRACE_ACTUATOR_OUTPUT:
+		if (!(seen & (1 << LATENCY_TRACE_STABILIZATION_PID)))
+			break;
+		hist_add(&hists[LATENCYSTATS_P50_STABILIZATIONTOACTUATOR],
+			PIOS_DELAY_DiffuS2(last_raw[LATENCY_TRACE_STABILIZATION_PID], now));
+		hist_add(&hists[LATENCYSTATS_P50_SENSORTOACTUATOR],
+			PIOS_DELAY_DiffuS2(origin_raw[LATENCY_TRACE_STABILIZATION_PID], now));
+		break;
+	default:
+		return;
+	}
+
+	last_raw[event] = now;
+	seen |= 1 << event;
+}
+
+/**
+ * Publish the histograms gathered since the last call and start new ones
+ */
+void LatencyTraceUpdate(void)
+{
+	LatencyStatsData data;
+	struct latency_hist snapshot;
+
+	for (uint8_t i = 0; i < NUM_STAGES; i++) {
+		memcpy(&snapshot, &hists[i], sizeof(snapshot));
+		hists[i].clear = true;
+
+		if (snapshot.clear || snapshot.samples == 0) {
+			data.P50[i] = 0;
+			data.P99[i] = 0;
+			data.Max[i] = 0;
+			data.Samples[i] = 0;
+			continue;
+		}
+
+		data.P50[i] = saturate_u16(hist_percentile(&snapshot, 50));
+		data.P99[i] = saturate_u16(hist_percentile(&snapshot, 99));
+		data.Max[i] = saturate_u16(snapshot.max);
+		data.Samples[i] = saturate_u16(snapshot.samples);
+	}
+
+	LatencyStatsSet(&data);
+}
+
+#endif /* DIAG_LATENCY */
+
+/**
+ * @}
+ */
@@ -46,6 +46,7 @@
 
 
 #include <openpilot.h>
+#include <stdint.h>
 
 #if !defined(TRUE) && !defined(FALSE)
 #define TRUE 1
@@ -79,9 +80,19 @@ void encode_data (unsigned char msg[], int nbytes, unsigned char dst[]);
 /* CRC-CCITT checksum generator */
 BIT16 crc_ccitt(unsigned char *msg, int len);
 
+/* Table driven, reentrant codec (rs_table.c) */
+#define RS_DECODE_OK         0
+#define RS_DECODE_CORRECTED  1
+#define RS_DECODE_FAILED    -1
+
+extern const uint32_t rs_encode_table[256];
+
+void rs_encode(const unsigned char msg[], int nbytes, unsigned char dst[]);
+int rs_decode(unsigned char codeword[], int csize);
+
 /* galois arithmetic tables */
-extern const int gexp[];
-extern const int glog[];
+extern const uint8_t gexp[];
+extern const uint8_t glog[];
 
 void init_galois_tables (void);
 int ginv(int elt); 
@@ -0,0 +1,306 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       rs_table.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Table driven, reentrant Reed-Solomon codec
+ *
+ * Encodes and decodes the same codewords as rs.c and berlekamp.c. The
+ * encoder shift register holds all parity bytes in one word and is advanced
+ * a byte at a time with a single lookup in a precomputed table of the
+ * generator polynomial multiples, like a table driven CRC.
+ *
+ * The decoder runs the same register over the data part and compares it to
+ * the received parity, so an intact packet costs no more than encoding it.
+ * Only when they differ are the syndromes derived from that remainder and
+ * the errors located with Berlekamp-Massey, a Chien search limited to the
+ * codeword length and Forney's algorithm.
+ *
+ * No state is kept between calls so the codec may be used from several
+ * tasks at once.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ecc.h"
+
+#if RS_ECC_NPARITY != 4
+#error "rs_table.c only has tables for 4 parity bytes"
+#endif
+
+/*
+ * Multiples of the generator polynomial coefficients. Entry d holds
+ * genPoly[k] * d in byte k, for the generator (x + a^1)...(x + a^4) with
+ * coefficients {116, 231, 216, 30, 1}.
+ */
+const uint32_t rs_encode_table[256] = {
+	0x00000000, 0x1ed8e774, 0x3cadd3e8, 0x2275349c,
+	0x7847bbcd, 0x669f5cb9, 0x44ea6825, 0x5a328f51,
+	0xf08e6b87, 0xee568cf3, 0xcc23b86f, 0xd2fb5f1b,
+	0x88c9d04a, 0x9611373e, 0xb46403a2, 0xaabce4d6,
+	0xfd01d613, 0xe3d93167, 0xc1ac05fb, 0xdf74e28f,
+	0x85466dde, 0x9b9e8aaa, 0xb9ebbe36, 0xa7335942,
+	0x0d8fbd94, 0x13575ae0, 0x31226e7c, 0x2ffa8908,
+	0x75c80659, 0x6b10e12d, 0x4965d5b1, 0x57bd32c5,
+	0xe702b126, 0xf9da5652, 0xdbaf62ce, 0xc57785ba,
+	0x9f450aeb, 0x819ded9f, 0xa3e8d903, 0xbd303e77,
+	0x178cdaa1, 0x09543dd5, 0x2b210949, 0x35f9ee3d,
+	0x6fcb616c, 0x71138618, 0x5366b284, 0x4dbe55f0,
+	0x1a036735, 0x04db8041, 0x26aeb4dd, 0x387653a9,
+	0x6244dcf8, 0x7c9c3b8c, 0x5ee90f10, 0x4031e864,
+	0xea8d0cb2, 0xf455ebc6, 0xd620df5a, 0xc8f8382e,
+	0x92cab77f, 0x8c12500b, 0xae676497, 0xb0bf83e3,
+	0xd3047f4c, 0xcddc9838, 0xefa9aca4, 0xf1714bd0,
+	0xab43c481, 0xb59b23f5, 0x97ee1769, 0x8936f01d,
+	0x238a14cb, 0x3d52f3bf, 0x1f27c723, 0x01ff2057,
+	0x5bcdaf06, 0x45154872, 0x67607cee, 0x79b89b9a,
+	0x2e05a95f, 0x30dd4e2b, 0x12a87ab7, 0x0c709dc3,
+	0x56421292, 0x489af5e6, 0x6aefc17a, 0x7437260e,
+	0xde8bc2d8, 0xc05325ac, 0xe2261130, 0xfcfef644,
+	0xa6cc7915, 0xb8149e61, 0x9a61aafd, 0x84b94d89,
+	0x3406ce6a, 0x2ade291e, 0x08ab1d82, 0x1673faf6,
+	0x4c4175a7, 0x529992d3, 0x70eca64f, 0x6e34413b,
+	0xc488a5ed, 0xda504299, 0xf8257605, 0xe6fd9171,
+	0xbccf1e20, 0xa217f954, 0x8062cdc8, 0x9eba2abc,
+	0xc9071879, 0xd7dfff0d, 0xf5aacb91, 0xeb722ce5,
+	0xb140a3b4, 0xaf9844c0, 0x8ded705c, 0x93359728,
+	0x398973fe, 0x2751948a, 0x0524a016, 0x1bfc4762,
+	0x41cec833, 0x5f162f47, 0x7d631bdb, 0x63bbfcaf,
+	0xbb08fe98, 0xa5d019ec, 0x87a52d70, 0x997dca04,
+	0xc34f4555, 0xdd97a221, 0xffe296bd, 0xe13a71c9,
+	0x4b86951f, 0x555e726b, 0x772b46f7, 0x69f3a183,
+	0x33c12ed2, 0x2d19c9a6, 0x0f6cfd3a, 0x11b41a4e,
+	0x4609288b, 0x58d1cfff, 0x7aa4fb63, 0x647c1c17,
+	0x3e4e9346, 0x20967432, 0x02e340ae, 0x1c3ba7da,
+	0xb687430c, 0xa85fa478, 0x8a2a90e4, 0x94f27790,
+	0xcec0f8c1, 0xd0181fb5, 0xf26d2b29, 0xecb5cc5d,
+	0x5c0a4fbe, 0x42d2a8ca, 0x60a79c56, 0x7e7f7b22,
+	0x244df473, 0x3a951307, 0x18e0279b, 0x0638c0ef,
+	0xac842439, 0xb25cc34d, 0x9029f7d1, 0x8ef110a5,
+	0xd4c39ff4, 0xca1b7880, 0xe86e4c1c, 0xf6b6ab68,
+	0xa10b99ad, 0xbfd37ed9, 0x9da64a45, 0x837ead31,
+	0xd94c2260, 0xc794c514, 0xe5e1f188, 0xfb3916fc,
+	0x5185f22a, 0x4f5d155e, 0x6d2821c2, 0x73f0c6b6,
+	0x29c249e7, 0x371aae93, 0x156f9a0f, 0x0bb77d7b,
+	0x680c81d4, 0x76d466a0, 0x54a1523c, 0x4a79b548,
+	0x104b3a19, 0x0e93dd6d, 0x2ce6e9f1, 0x323e0e85,
+	0x9882ea53, 0x865a0d27, 0xa42f39bb, 0xbaf7decf,
+	0xe0c5519e, 0xfe1db6ea, 0xdc688276, 0xc2b06502,
+	0x950d57c7, 0x8bd5b0b3, 0xa9a0842f, 0xb778635b,
+	0xed4aec0a, 0xf3920b7e, 0xd1e73fe2, 0xcf3fd896,
+	0x65833c40, 0x7b5bdb34, 0x592eefa8, 0x47f608dc,
+	0x1dc4878d, 0x031c60f9, 0x21695465, 0x3fb1b311,
+	0x8f0e30f2, 0x91d6d786, 0xb3a3e31a, 0xad7b046e,
+	0xf7498b3f, 0xe9916c4b, 0xcbe458d7, 0xd53cbfa3,
+	0x7f805b75, 0x6158bc01, 0x432d889d, 0x5df56fe9,
+	0x07c7e0b8, 0x191f07cc, 0x3b6a3350, 0x25b2d424,
+	0x720fe6e1, 0x6cd70195, 0x4ea23509, 0x507ad27d,
+	0x0a485d2c, 0x1490ba58, 0x36e58ec4, 0x283d69b0,
+	0x82818d66, 0x9c596a12, 0xbe2c5e8e, 0xa0f4b9fa,
+	0xfac636ab, 0xe41ed1df, 0xc66be543, 0xd8b30237,
+};
+
+static inline uint8_t rs_mult(uint8_t a, uint8_t b)
+{
+	if (a == 0 || b == 0)
+		return 0;
+
+	return gexp[glog[a] + glog[b]];
+}
+
+static inline uint8_t rs_div(uint8_t a, uint8_t b)
+{
+	if (a == 0)
+		return 0;
+
+	return gexp[glog[a] + 255 - glog[b]];
+}
+
+/* Run the parity shift register over a block */
+static uint32_t rs_remainder(const unsigned char msg[], int nbytes)
+{
+	uint32_t lfsr = 0;
+
+	for (int i = 0; i < nbytes; i++)
+		lfsr = (lfsr << 8) ^ rs_encode_table[msg[i] ^ (lfsr >> 24)];
+
+	return lfsr;
+}
+
+/**
+ * Append the parity bytes to a message
+ * @param[in] msg The message
+ * @param[in] nbytes Length of the message
+ * @param[out] dst Buffer for the codeword of nbytes + RS_ECC_NPARITY bytes,
+ *             may be the same as msg
+ */
+void rs_encode(const unsigned char msg[], int nbytes, unsigned char dst[])
+{
+	uint32_t parity = rs_remainder(msg, nbytes);
+
+	if (dst != msg)
+		memcpy(dst, msg, nbytes);
+
+	dst[nbytes]     = parity >> 24;
+	dst[nbytes + 1] = parity >> 16;
+	dst[nbytes + 2] = parity >> 8;
+	dst[nbytes + 3] = parity;
+}
+
+/**
+ * Check a codeword and correct it in place if needed
+ * @param[in,out] codeword The received message followed by its parity bytes
+ * @param[in] csize Length of the codeword including the parity bytes
+ * @return RS_DECODE_OK if the codeword was intact, RS_DECODE_CORRECTED if
+ *         errors were found and fixed, RS_DECODE_FAILED if there were more
+ *         errors than the code can correct
+ */
+int rs_decode(unsigned char codeword[], int csize)
+{
+	int nbytes = csize - RS_ECC_NPARITY;
+
+	if (nbytes < 0)
+		return RS_DECODE_FAILED;
+
+	uint32_t received = ((uint32_t)codeword[nbytes] << 24) |
+		((uint32_t)codeword[nbytes + 1] << 16) |
+		((uint32_t)codeword[nbytes + 2] << 8) |
+		codeword[nbytes + 3];
+	uint32_t remainder = rs_remainder(codeword, nbytes) ^ received;
+
+	/* Nearly all packets stop here */
+	if (remainder == 0)
+		return RS_DECODE_OK;
+
+	/*
+	 * The codeword is a multiple of the generator plus the remainder, and
+	 * a^1..a^4 are roots of the generator, so the syndromes are just the
+	 * remainder evaluated at those roots.
+	 */
+	uint8_t syn[RS_ECC_NPARITY];
+	for (int j = 0; j < RS_ECC_NPARITY; j++) {
+		syn[j] = 0;
+		for (int k = 0; k < RS_ECC_NPARITY; k++) {
+			uint8_t coeff = remainder >> (8 * k);
+			if (coeff)
+				syn[j] ^= gexp[(glog[coeff] + (j + 1) * k) % 255];
+		}
+	}
+
+	/* Berlekamp-Massey for the error locator polynomial */
+	uint8_t lambda[RS_ECC_NPARITY + 1] = { 1 };
+	uint8_t prev[RS_ECC_NPARITY + 1] = { 0, 1 };
+	int L = 0;
+	int k = -1;
+
+	for (int n = 0; n < RS_ECC_NPARITY; n++) {
+		uint8_t d = 0;
+		for (int i = 0; i <= L; i++)
+			d ^= rs_mult(lambda[i], syn[n - i]);
+
+		if (d != 0) {
+			uint8_t next[RS_ECC_NPARITY + 1];
+			for (int i = 0; i <= RS_ECC_NPARITY; i++)
+				next[i] = lambda[i] ^ rs_mult(d, prev[i]);
+
+			if (L < n - k) {
+				int L2 = n - k;
+				k = n - L;
+				for (int i = 0; i <= RS_ECC_NPARITY; i++)
+					prev[i] = rs_div(lambda[i], d);
+				L = L2;
+			}
+
+			memcpy(lambda, next, sizeof(lambda));
+		}
+
+		/* prev = prev * z */
+		memmove(&prev[1], &prev[0], RS_ECC_NPARITY);
+		prev[0] = 0;
+	}
+
+	if (2 * L > RS_ECC_NPARITY)
+		return RS_DECODE_FAILED;
+
+	/* Error evaluator, omega = lambda * syndromes mod z^RS_ECC_NPARITY */
+	uint8_t omega[RS_ECC_NPARITY] = { 0 };
+	for (int i = 0; i < RS_ECC_NPARITY; i++)
+		for (int j = 0; j <= i && j <= L; j++)
+			omega[i] ^= rs_mult(lambda[j], syn[i - j]);
+
+	/*
+	 * Chien search, only over the positions that exist in this codeword.
+	 * Location i counts from the last parity byte backwards.
+	 */
+	uint8_t locs[RS_ECC_NPARITY / 2];
+	int nerrors = 0;
+
+	for (int i = 0; i < csize; i++) {
+		uint8_t sum = 0;
+		int r = 255 - i;
+		for (int j = 0; j <= L; j++) {
+			if (lambda[j])
+				sum ^= gexp[(glog[lambda[j]] + j * r) % 255];
+		}
+
+		if (sum == 0) {
+			if (nerrors == L)
+				return RS_DECODE_FAILED;
+			locs[nerrors++] = i;
+		}
+	}
+
+	/* Any root outside the codeword means this isn't a correctable error */
+	if (nerrors != L)
+		return RS_DECODE_FAILED;
+
+	/* Forney, evaluate omega / lambda' at a^-i */
+	for (int e = 0; e < nerrors; e++) {
+		int i = locs[e];
+		int inv = 255 - i;
+		uint8_t num = 0;
+		uint8_t denom = 0;
+
+		for (int j = 0; j < RS_ECC_NPARITY; j++) {
+			if (omega[j])
+				num ^= gexp[(glog[omega[j]] + inv * j) % 255];
+		}
+
+		/* All even powers vanish from the derivative */
+		for (int j = 1; j <= L; j += 2) {
+			if (lambda[j])
+				denom ^= gexp[(glog[lambda[j]] + inv * (j - 1)) % 255];
+		}
+
+		if (denom == 0)
+			return RS_DECODE_FAILED;
+
+		codeword[csize - i - 1] ^= rs_div(num, denom);
+	}
+
+	return RS_DECODE_CORRECTED;
+}
+
+/**
+ * @}
+ */
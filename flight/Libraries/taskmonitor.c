@@ -37,6 +37,7 @@
 static struct pios_mutex *lock;
 static struct pios_thread *handles[TASKINFO_RUNNING_NUMELEM];
 static uint32_t lastMonitorTime;
+static uint32_t lastMonitorSystime;
 
 // Private functions
 
@@ -49,6 +50,7 @@ int32_t TaskMonitorInitialize(void)
 	PIOS_Assert(lock != NULL);
 	memset(handles, 0, sizeof(struct pios_thread) * TASKINFO_RUNNING_NUMELEM);
 	lastMonitorTime = 0;
+	lastMonitorSystime = PIOS_Thread_Systime();
 #if defined(DIAG_TASKS)
 #if defined(PIOS_INCLUDE_FREERTOS)
 	lastMonitorTime = portGET_RUN_TIME_COUNTER_VALUE();
@@ -122,6 +124,9 @@ void TaskMonitorUpdateAll(void)
 
 	uint32_t currentTime;
 	uint32_t deltaTime;
+	uint32_t currentSystime;
+	uint32_t deltaSystime;
+	struct pios_thread_sched_stats sched;
 	
 	/*
 	 * Calculate the amount of elapsed run time between the last time we
@@ -135,6 +140,11 @@ void TaskMonitorUpdateAll(void)
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
 	deltaTime = ((currentTime - lastMonitorTime) / 100) ? : 1; /* avoid divide-by-zero if the interval is too small */
 	lastMonitorTime = currentTime;
+
+	/* Wall clock interval used to turn switch counts into rates */
+	currentSystime = PIOS_Thread_Systime();
+	deltaSystime = (currentSystime - lastMonitorSystime) ? : 1;
+	lastMonitorSystime = currentSystime;
 	
 	// Update all task information
 	for (n = 0; n < TASKINFO_RUNNING_NUMELEM; ++n)
@@ -145,12 +155,22 @@ void TaskMonitorUpdateAll(void)
 			data.StackRemaining[n] = PIOS_Thread_Get_Stack_Usage(handles[n]);
 			/* Generate run time stats */
 			data.RunningTime[n] = PIOS_Thread_Get_Runtime(handles[n]) / deltaTime;
+			/* Generate scheduler stats */
+			PIOS_Thread_Get_Sched_Stats(handles[n], &sched);
+			uint32_t switchRate = sched.switches * 1000 / deltaSystime;
+			uint32_t queueWait = sched.queue_wait / deltaTime;
+			data.ContextSwitches[n] = switchRate > UINT16_MAX ? UINT16_MAX : switchRate;
+			data.MaxActivation[n] = sched.max_activation_us > UINT16_MAX ? UINT16_MAX : sched.max_activation_us;
+			data.QueueWait[n] = queueWait > 100 ? 100 : queueWait;
 		}
 		else
 		{
 			data.Running[n] = TASKINFO_RUNNING_FALSE;
 			data.StackRemaining[n] = 0;
 			data.RunningTime[n] = 0;
+			data.ContextSwitches[n] = 0;
+			data.MaxActivation[n] = 0;
+			data.QueueWait[n] = 0;
 		}
 	}
 
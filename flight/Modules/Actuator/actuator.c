@@ -48,6 +48,7 @@
 #include "manualcontrolcommand.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "latencytrace.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -379,6 +380,8 @@ static void actuatorTask(void* parameters)
 		PIOS_Servo_Update();
 #endif
 
+		LATENCY_TRACE(LATENCY_TRACE_ACTUATOR_OUTPUT);
+
 		if(!success) {
 			command.NumFailedUpdates++;
 			ActuatorCommandSet(&command);
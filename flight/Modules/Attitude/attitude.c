@@ -75,6 +75,7 @@
 #include "WorldMagModel.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "latencytrace.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 2200
@@ -366,6 +367,8 @@ static void AttitudeTask(void *parameters)
 			break;
 		}
 
+		LATENCY_TRACE(LATENCY_TRACE_ATTITUDE_UPDATE);
+
 		// Use the selected source for position and velocity
 		switch (stateEstimation.NavigationFilter) {
 		case STATEESTIMATION_NAVIGATIONFILTER_INS:
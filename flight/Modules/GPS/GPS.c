@@ -61,6 +61,7 @@ static void updateSettings();
 
 #define GPS_TIMEOUT_MS                  750
 #define GPS_COM_TIMEOUT_MS              100
+#define GPS_RX_CHUNK_LEN                32 // matches the com port rx fifo
 
 
 #if defined(PIOS_GPS_MINIMAL)
@@ -80,6 +81,7 @@ static bool module_enabled = false;
 static struct pios_thread *gpsTaskHandle;
 
 static char* gps_rx_buffer;
+static uint8_t gps_rx_chunk[GPS_RX_CHUNK_LEN];
 
 static struct GPS_RX_STATS gpsRxStats;
 
@@ -253,21 +255,21 @@ static void gpsTask(void *parameters)
 			continue;
 		}
 
-		uint8_t c;
+		uint16_t received;
 
 		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		while ((received = PIOS_COM_ReceiveBuffer(gpsPort, gps_rx_chunk, sizeof(gps_rx_chunk), xDelay)) > 0)
 		{
 			int res;
 			switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_nmea_block (gps_rx_chunk, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_ubx_block (gps_rx_chunk, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 				default:
@@ -107,85 +107,93 @@ const static struct nmea_parser nmea_parsers[] = {
 #endif //PIOS_GPS_MINIMAL
 };
 
-int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+static uint8_t rx_count = 0;
+static bool start_flag = false;
+
+/**
+ * Parse a block of incoming bytes for NMEA sentences.
+ * The start of a sentence is found with a single search for '$' and the rest
+ * is copied up to the next line feed in one go, so the checksum and
+ * @ref NMEA_update_position only run once a complete sentence is buffered.
+ * Sentences may span several blocks.
+ * \return PARSER_COMPLETE if at least one sentence was processed
+ * \return PARSER_OVERRUN if a sentence didn't fit in the buffer
+ * \return PARSER_INCOMPLETE if the block ended inside a sentence
+ * \return PARSER_ERROR if the parser couldn't use the last bytes
+ */
+int parse_nmea_block (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
-	static uint8_t rx_count = 0;
-	static bool start_flag = false;
-	static bool found_cr = false;
+	bool complete = false;
+	bool overrun = false;
+	uint16_t i = 0;
+
+	while (i < len) {
+		// detect start while acquiring stream
+		if (!start_flag) {
+			const uint8_t *start = memchr(&rx[i], '$', len - i);
+			if (start == NULL)
+				break;
 
-	// detect start while acquiring stream
-	if (!start_flag && (c == '$')) // NMEA identifier found
-	{
-		start_flag = true;
-		found_cr = false;
-		rx_count = 0;
-	}
-	else
-	if (!start_flag)
-		return PARSER_ERROR;
+			// NMEA identifier found
+			i = start - rx;
+			start_flag = true;
+			rx_count = 0;
+		}
 
-	if (rx_count >= NMEA_MAX_PACKET_LENGTH)
-	{
-		// The buffer is already full and we haven't found a valid NMEA sentence.
-		// Flush the buffer and note the overflow event.
-		gpsRxStats->gpsRxOverflow++;
-		start_flag = false;
-		found_cr = false;
-		rx_count = 0;
-		return PARSER_OVERRUN;
-	}
-	else
-	{
-		gps_rx_buffer[rx_count] = c;
-		rx_count++;
-	}
+		// take everything up to and including the next line feed
+		const uint8_t *lf = memchr(&rx[i], '\n', len - i);
+		uint16_t count = lf ? (lf - &rx[i]) + 1 : len - i;
+
+		if (rx_count + count > NMEA_MAX_PACKET_LENGTH) {
+			// The buffer is full and we haven't found a valid NMEA sentence.
+			// Drop what fit plus the byte that overflowed and note the event.
+			gpsRxStats->gpsRxOverflow++;
+			i += NMEA_MAX_PACKET_LENGTH - rx_count + 1;
+			start_flag = false;
+			rx_count = 0;
+			overrun = true;
+			continue;
+		}
+
+		memcpy(&gps_rx_buffer[rx_count], &rx[i], count);
+		rx_count += count;
+		i += count;
+
+		// look for ending '\r\n' sequence, a bare line feed is just data
+		if (lf == NULL || gps_rx_buffer[rx_count - 2] != '\r')
+			continue;
 
-	// look for ending '\r\n' sequence
-	if (!found_cr && (c == '\r') )
-		found_cr = true;
-	else
-	if (found_cr && (c != '\n') )
-		found_cr = false;  // false end flag
-	else
-	if (found_cr && (c == '\n') )
-	{
 		// The NMEA functions require a zero-terminated string
 		// As we detected \r\n, the string as for sure 2 bytes long, we will also strip the \r\n
-		gps_rx_buffer[rx_count-2] = 0;
+		gps_rx_buffer[rx_count - 2] = 0;
 
 		// prepare to parse next sentence
 		start_flag = false;
-		found_cr = false;
 		rx_count = 0;
-		// Our rxBuffer must look like this now:
-		//   [0]           = '$'
-		//   ...           = zero or more bytes of sentence payload
-		//   [end_pos - 1] = '\r'
-		//   [end_pos]     = '\n'
-		//
-		// Prepare to consume the sentence from the buffer
 
 		// Validate the checksum over the sentence
-		if (!NMEA_checksum(&gps_rx_buffer[1]))
-		{	// Invalid checksum.  May indicate dropped characters on Rx.
-			//PIOS_DEBUG_PinHigh(2);
+		if (!NMEA_checksum(&gps_rx_buffer[1])) {
+			// Invalid checksum.  May indicate dropped characters on Rx.
 			gpsRxStats->gpsRxChkSumError++;
-			//PIOS_DEBUG_PinLow(2);
-			return PARSER_ERROR;
+			continue;
 		}
+
+		// Valid checksum, use this packet to update the GPS position
+		if (!NMEA_update_position(&gps_rx_buffer[1], GpsData))
+			gpsRxStats->gpsRxParserError++;
 		else
-		{	// Valid checksum, use this packet to update the GPS position
-			if (!NMEA_update_position(&gps_rx_buffer[1], GpsData)) {
-				//PIOS_DEBUG_PinHigh(2);
-				gpsRxStats->gpsRxParserError++;
-				//PIOS_DEBUG_PinLow(2);
-			}
-			else
-				gpsRxStats->gpsRxReceived++;;
-
-			return PARSER_COMPLETE;
-		}
+			gpsRxStats->gpsRxReceived++;
+
+		complete = true;
 	}
+
+	if (complete)
+		return PARSER_COMPLETE;
+	else if (overrun)
+		return PARSER_OVERRUN;
+	else if (!start_flag)
+		return PARSER_ERROR;
+
 	return PARSER_INCOMPLETE;
 }
 
@@ -267,7 +275,7 @@ static bool NMEA_parse_real(int32_t * whole, uint32_t * fract, uint8_t * fract_u
 
 	*whole = strtol(field_w, NULL, 10);
 
-	if (field_w) {
+	if (field_f) {
 		/* decimal was found so we may have a fractional part */
 		*fract = strtoul(field_f, NULL, 10);
 		*fract_units = strlen(field_f);
@@ -41,94 +41,114 @@ static uint32_t parse_errors;
 static bool checksum_ubx_message(const struct UBXPacket *);
 static uint32_t parse_ubx_message(const struct UBXPacket *, GPSPositionData *);
 
-// parse incoming character stream for messages in UBX binary format
+static enum proto_states {
+	START,
+	UBX_SY2,
+	UBX_CLASS,
+	UBX_ID,
+	UBX_LEN1,
+	UBX_LEN2,
+	UBX_PAYLOAD,
+	UBX_CHK1,
+	UBX_CHK2,
+} proto_state = START;
+static uint16_t rx_count = 0;
 
-int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+/**
+ * Parse a block of incoming bytes for messages in UBX binary format.
+ * Leading garbage is skipped with a single search for the sync character and
+ * payloads are copied in bulk, so @ref parse_ubx_message only runs once per
+ * complete frame with a valid checksum. Frames may span several blocks.
+ * \return PARSER_COMPLETE if at least one message was processed
+ * \return PARSER_INCOMPLETE if the block ended inside a message
+ * \return PARSER_ERROR if the parser couldn't use the last bytes
+ */
+int parse_ubx_block (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
-	enum proto_states {
-		START,
-		UBX_SY2,
-		UBX_CLASS,
-		UBX_ID,
-		UBX_LEN1,
-		UBX_LEN2,
-		UBX_PAYLOAD,
-		UBX_CHK1,
-		UBX_CHK2,
-		FINISHED
-	};
-
-	static enum proto_states proto_state = START;
-	static uint16_t rx_count = 0;
 	struct UBXPacket *ubx = (struct UBXPacket *)gps_rx_buffer;
+	bool complete = false;
+	uint16_t i = 0;
+
+	while (i < len) {
+		if (proto_state == START) { // detect protocol
+			const uint8_t *sync = memchr(&rx[i], UBX_SYNC1, len - i);
+			if (sync == NULL)
+				break;
+
+			// first UBX sync char found
+			i = sync - rx + 1;
+			proto_state = UBX_SY2;
+			continue;
+		}
 
-	switch (proto_state) {
-		case START: // detect protocol
-			if (c ==  UBX_SYNC1) // first UBX sync char found
-				proto_state = UBX_SY2;
-			break;
-		case UBX_SY2:
-			if (c == UBX_SYNC2) // second UBX sync char found
-				proto_state = UBX_CLASS;
-			else
-				proto_state = START; // reset state
-			break;
-		case UBX_CLASS:
-			ubx->header.class = c;
-			proto_state = UBX_ID;
-			break;
-		case UBX_ID:
-			ubx->header.id = c;
-			proto_state = UBX_LEN1;
-			break;
-		case UBX_LEN1:
-			ubx->header.len = c;
-			proto_state = UBX_LEN2;
-			break;
-		case UBX_LEN2:
-			ubx->header.len += (c << 8);
-			if (ubx->header.len > sizeof(UBXPayload)) {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
-			} else {
-				rx_count = 0;
-				proto_state = UBX_PAYLOAD;
-			}
-			break;
-		case UBX_PAYLOAD:
-			if (rx_count < ubx->header.len) {
-				ubx->payload.payload[rx_count] = c;
-				if (++rx_count == ubx->header.len)
-					proto_state = UBX_CHK1;
-			} else {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
-			}
-			break;
-		case UBX_CHK1:
-			ubx->header.ck_a = c;
-			proto_state = UBX_CHK2;
-			break;
-		case UBX_CHK2:
-			ubx->header.ck_b = c;
-			if (checksum_ubx_message(ubx)) { // message complete and valid
-				parse_ubx_message(ubx, GpsData);
-				proto_state = FINISHED;
-			} else {
-				gpsRxStats->gpsRxChkSumError++;
+		if (proto_state == UBX_PAYLOAD) {
+			uint16_t count = ubx->header.len - rx_count;
+			if (count > len - i)
+				count = len - i;
+
+			memcpy(&ubx->payload.payload[rx_count], &rx[i], count);
+			rx_count += count;
+			i += count;
+
+			if (rx_count == ubx->header.len)
+				proto_state = UBX_CHK1;
+			continue;
+		}
+
+		uint8_t c = rx[i++];
+
+		switch (proto_state) {
+			case UBX_SY2:
+				if (c == UBX_SYNC2) // second UBX sync char found
+					proto_state = UBX_CLASS;
+				else if (c != UBX_SYNC1) // repeated first sync char might still start a message
+					proto_state = START; // reset state
+				break;
+			case UBX_CLASS:
+				ubx->header.class = c;
+				proto_state = UBX_ID;
+				break;
+			case UBX_ID:
+				ubx->header.id = c;
+				proto_state = UBX_LEN1;
+				break;
+			case UBX_LEN1:
+				ubx->header.len = c;
+				proto_state = UBX_LEN2;
+				break;
+			case UBX_LEN2:
+				ubx->header.len += (c << 8);
+				if (ubx->header.len > sizeof(UBXPayload)) {
+					gpsRxStats->gpsRxOverflow++;
+					proto_state = START;
+				} else {
+					rx_count = 0;
+					proto_state = ubx->header.len ? UBX_PAYLOAD : UBX_CHK1;
+				}
+				break;
+			case UBX_CHK1:
+				ubx->header.ck_a = c;
+				proto_state = UBX_CHK2;
+				break;
+			case UBX_CHK2:
+				ubx->header.ck_b = c;
+				if (checksum_ubx_message(ubx)) { // message complete and valid
+					parse_ubx_message(ubx, GpsData);
+					gpsRxStats->gpsRxReceived++;
+					complete = true;
+				} else {
+					gpsRxStats->gpsRxChkSumError++;
+				}
 				proto_state = START;
-			}
-			break;
-		default: break;
+				break;
+			default: break;
+		}
 	}
 
-	if (proto_state == START)
-		return PARSER_ERROR;	// parser couldn't use this byte
-	else if (proto_state == FINISHED) {
-		gpsRxStats->gpsRxReceived++;
-		proto_state = START;
+	if (complete)
 		return PARSER_COMPLETE;	// message complete & processed
-	}
+	else if (proto_state == START)
+		return PARSER_ERROR;	// parser couldn't use these bytes
 
 	return PARSER_INCOMPLETE; // message not (yet) complete
 }
@@ -227,7 +227,7 @@ struct UBXPacket {
 	UBXPayload	payload;
 };
 
-int  parse_ubx_stream(uint8_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+int  parse_ubx_block(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
 
 #endif /* UBX_H */
 
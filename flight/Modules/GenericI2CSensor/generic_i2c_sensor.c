@@ -35,7 +35,8 @@
 #include "i2cvmuserprogram.h"	/* UAV Object (bytecode to run) */
 #include "pios_thread.h"
 
-extern bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_adapter);
+extern bool i2c_vm_load (const uint32_t * code, uint8_t code_len);
+extern bool i2c_vm_run (uintptr_t i2c_adapter);
 
 // Private constants
 #define STACK_SIZE_BYTES 370
@@ -139,6 +140,12 @@ static int32_t GenericI2CSensorInitialize(void)
 		return -1;
 	}
 
+	/* Verify and decode the program once, refuse to start it if it is invalid */
+	if (!i2c_vm_load(i2cvm_program, i2cvm_program_len)) {
+		module_enabled = false;
+		return -1;
+	}
+
 	I2CVMInitialize();
 
 	return 0;
@@ -152,7 +159,7 @@ static void GenericI2CSensorTask(void *parameters)
 	// Main task loop
 	while (1) {
 		/* Run the selected program */
-		if (i2c_vm_run(i2cvm_program, i2cvm_program_len, PIOS_I2C_MAIN_ADAPTER)) {
+		if (i2c_vm_run(PIOS_I2C_MAIN_ADAPTER)) {
 			/* Program ran to completion. This could be because the program is 
 			 * empty or does not infinitely loop.
 			 * Delay in order to prevent these programs from consuming all CPU.
@@ -38,16 +38,37 @@
 #include "pios_thread.h"
 #endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
 
-struct i2c_vm_regs {
-	bool     halted;
-	bool     fault;
+/* Registers addressable by instructions, indexed by enum i2c_vm_reg_names */
+#define I2C_VM_NUM_REGS (VM_R6 + 1)
+
+/* Pseudo opcode placed just past the end of a loaded program */
+#define I2C_VM_OP_END (I2C_VM_OP_SEND_UAVO + 1)
 
+struct i2c_vm_regs {
 	uintptr_t i2c_adapter;
 	uint8_t i2c_dev_addr;
 
+	uint32_t r[I2C_VM_NUM_REGS];
+
 	I2CVMData uavo;
 };
 
+/* A pre-decoded instruction. The operands have all been checked by
+ * i2c_vm_verify() so the execution loop uses them without any further
+ * validation.
+ */
+struct i2c_vm_inst {
+	const void * handler; /* address of the opcode's label in i2c_vm_exec() */
+	uint8_t op1;
+	uint8_t op2;
+	int16_t imm;          /* op3, the short immediate data or a branch target */
+};
+
+/* Program decoded by i2c_vm_load(), the buffer is grown on demand */
+static struct i2c_vm_inst * i2c_vm_prog;
+static uint16_t i2c_vm_prog_size;
+static bool i2c_vm_loaded;
+
 /******************************
  *
  * VM internal helper functions
@@ -56,757 +77,466 @@ struct i2c_vm_regs {
 
 #define SIMM_VAL(msb,lsb) ((int16_t)((((msb) & 0xFF) << 8) | ((lsb) & 0xFF)))
 
-/* Assign a 32-bit value into virtual machine registers
+/* Check that an operand names one of the general purpose registers
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] reg destination register where value will be stored
- * @param[in] val value to store in register
+ * @param[in] reg register index from the instruction
  */
-static bool i2c_vm_set_reg (struct i2c_vm_regs * vm_state, uint8_t reg, uint32_t val)
+static bool i2c_vm_reg_valid (uint8_t reg)
 {
-	switch (reg) {
-	case VM_R0:
-		vm_state->uavo.r0 = val;
-		break;
-	case VM_R1:
-		vm_state->uavo.r1 = val;
-		break;
-	case VM_R2:
-		vm_state->uavo.r2 = val;
-		break;
-	case VM_R3:
-		vm_state->uavo.r3 = val;
-		break;
-	case VM_R4:
-		vm_state->uavo.r4 = val;
-		break;
-	case VM_R5:
-		vm_state->uavo.r5 = val;
-		break;
-	case VM_R6:
-		vm_state->uavo.r6 = val;
-		break;
-	default:
-		return false;
-	}
-
-	return true;
+	return (reg >= VM_R0) && (reg <= VM_R6);
 }
 
-/* Read a 32-bit value from virtual machine registers
+/* Check that a relative branch lands inside the program, or just past its
+ * end which completes the program
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] reg register where value will be read from
- * @param[out] val pointer to hold the value of the register
+ * @param[in] pc address of the branch instruction
+ * @param[in] simm_hi,simm_lo relative offset (short immediate data)
+ * @param[in] code_len number of instructions in the program
  */
-static bool i2c_vm_get_reg (const struct i2c_vm_regs * vm_state, uint8_t reg, uint32_t * val)
+static bool i2c_vm_target_valid (uint8_t pc, uint8_t simm_hi, uint8_t simm_lo, uint8_t code_len)
 {
-	switch (reg) {
-	case VM_R0:
-		*val = vm_state->uavo.r0;
-		break;
-	case VM_R1:
-		*val = vm_state->uavo.r1;
-		break;
-	case VM_R2:
-		*val = vm_state->uavo.r2;
-		break;
-	case VM_R3:
-		*val = vm_state->uavo.r3;
-		break;
-	case VM_R4:
-		*val = vm_state->uavo.r4;
-		break;
-	case VM_R5:
-		*val = vm_state->uavo.r5;
-		break;
-	case VM_R6:
-		*val = vm_state->uavo.r6;
-		break;
-	default:
-		return false;
-	}
+	int32_t target = pc + SIMM_VAL(simm_hi, simm_lo);
 
-	return true;
+	return (target >= 0) && (target <= code_len);
 }
 
-enum aluop {
-	ALUOP_ADD,
-	ALUOP_MUL,
-	ALUOP_DIV,
-	ALUOP_LSR,
-	ALUOP_ASR,
-	ALUOP_SL,
-	ALUOP_OR,
-	ALUOP_AND,
-};
-
-/* Perform an ALU operation and update the virtual machine state (rd = ra op rb)
+/* Verify a single instruction
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] operation ALU operation to be performed
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
+ * @param[in] instruction the encoded instruction
+ * @param[in] pc address of the instruction
+ * @param[in] code_len number of instructions in the program
  */
-static bool i2c_vm_aluop_reg (struct i2c_vm_regs * vm_state, enum aluop operation, uint8_t rd, uint8_t ra, uint8_t rb)
+static bool i2c_vm_verify_inst (uint32_t instruction, uint8_t pc, uint8_t code_len)
 {
-	uint32_t ra_val;
-	uint32_t rb_val;
-	uint32_t rd_val;
-
-	/* Load ra value */
-	if (!i2c_vm_get_reg(vm_state, ra, &ra_val))
-		return false;
-
-	/* Load rb value */
-	if (!i2c_vm_get_reg(vm_state, rb, &rb_val))
-		return false;
-
-	/* Compute result */
-	switch (operation) {
-	case ALUOP_ADD:
-		rd_val = (int32_t)ra_val + (int32_t)rb_val;
-		break;
-	case ALUOP_MUL:
-		rd_val = (int32_t)ra_val * (int32_t)rb_val;
-		break;
-	case ALUOP_DIV:
-		rd_val = (int32_t)ra_val / (int32_t)rb_val;
-		break;
-	case ALUOP_AND:
-		rd_val = ra_val & rb_val;
-		break;
-	default:
-		/* invalid operation, fault */
-		return false;
+	uint8_t operator = (instruction & 0xFF000000) >> 24;
+	uint8_t op1      = (instruction & 0x00FF0000) >> 16;
+	uint8_t op2      = (instruction & 0x0000FF00) >>  8;
+	uint8_t op3      = (instruction & 0x000000FF);
+
+	switch (operator) {
+	case I2C_VM_OP_HALT:
+	case I2C_VM_OP_NOP:
+	case I2C_VM_OP_SET_DEV_ADDR:
+	case I2C_VM_OP_SEND_UAVO:
+		return true;
+	case I2C_VM_OP_DELAY:
+		return SIMM_VAL(op2, op3) >= 0;
+	case I2C_VM_OP_BNZ:
+		return i2c_vm_reg_valid(op1) && i2c_vm_target_valid(pc, op2, op3, code_len);
+	case I2C_VM_OP_JUMP:
+		return i2c_vm_target_valid(pc, op2, op3, code_len);
+	case I2C_VM_OP_STORE:
+		return op2 < sizeof(((I2CVMData *)0)->ram);
+	case I2C_VM_OP_LOAD_BE:
+	case I2C_VM_OP_LOAD_LE:
+		return (op2 >= 1) && (op2 <= 4) &&
+			(op1 + op2 <= sizeof(((I2CVMData *)0)->ram)) &&
+			i2c_vm_reg_valid(op3);
+	case I2C_VM_OP_SET_IMM:
+	case I2C_VM_OP_ADD_IMM:
+	case I2C_VM_OP_MUL_IMM:
+	case I2C_VM_OP_SL_IMM:
+	case I2C_VM_OP_LSR_IMM:
+	case I2C_VM_OP_ASR_IMM:
+	case I2C_VM_OP_OR_IMM:
+		return i2c_vm_reg_valid(op1);
+	case I2C_VM_OP_DIV_IMM:
+		return i2c_vm_reg_valid(op1) && (SIMM_VAL(op2, op3) != 0);
+	case I2C_VM_OP_ADD:
+	case I2C_VM_OP_MUL:
+	case I2C_VM_OP_DIV:
+	case I2C_VM_OP_AND:
+		return i2c_vm_reg_valid(op1) && i2c_vm_reg_valid(op2) && i2c_vm_reg_valid(op3);
+	case I2C_VM_OP_READ:
+	case I2C_VM_OP_WRITE:
+		/* Make sure the transfer fits in our buffer */
+		return op1 + op2 <= sizeof(((I2CVMData *)0)->ram);
 	}
 
-	/* Write value into destination register */
-	if (!i2c_vm_set_reg(vm_state, rd, rd_val))
-		return false;
-
-	return true;
+	/* Unknown opcode */
+	return false;
 }
 
-/* Perform an ALU operation and update the virtual machine state (rd = rd op simm)
+/* Verify a program before it is run. Every opcode, register index, RAM
+ * address and branch target is checked once here so that the execution
+ * loop does not need to.
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] operation ALU operation to be performed
- * @param[in] rd destination register for result
- * @param[in] simm_hi,simm_lo short immediate data
+ * @param[in] code pointer to program to verify
+ * @param[in] code_len number of 32-bit instructions contained in the program
  */
-static bool i2c_vm_aluop_imm (struct i2c_vm_regs * vm_state, enum aluop operation, uint8_t rd, uint8_t simm_hi, uint8_t simm_lo)
+bool i2c_vm_verify (const uint32_t * code, uint8_t code_len)
 {
-	uint32_t rd_val;
-	int16_t  simm_val;
-
-	/* Load rd value */
-	if (!i2c_vm_get_reg(vm_state, rd, &rd_val))
+	if (code == NULL || code_len == 0)
 		return false;
 
-	/* Load short-immediate data */
-	simm_val = SIMM_VAL(simm_hi, simm_lo);
-
-	/* Compute result */
-	switch (operation) {
-	case ALUOP_ADD:
-		rd_val += simm_val;
-		break;
-	case ALUOP_MUL:
-		rd_val *= simm_val;
-		break;
-	case ALUOP_DIV:
-		rd_val /= simm_val;
-		break;
-	case ALUOP_OR:
-		rd_val |= (uint16_t)simm_val;
-		break;
-	case ALUOP_ASR:
-		{
-			/* NOTE this must be a signed integer to force the >> to be an arithmetic shift */
-			int32_t rd_signed;
-
-			rd_signed = rd_val;
-			rd_signed >>= (uint8_t)(simm_val & 0x1F);
-			rd_val = rd_signed;
-		}
-		break;
-	case ALUOP_LSR:
-		rd_val >>= (uint8_t)(simm_val & 0x1F);
-		break;
-	case ALUOP_SL:
-		rd_val <<= (uint8_t)(simm_val & 0x1F);
-		break;
-	default:
-		/* invalid operation, fault */
-		return false;
+	for (uint8_t pc = 0; pc < code_len; pc++) {
+		if (!i2c_vm_verify_inst(code[pc], pc, code_len))
+			return false;
 	}
 
-	/* Write value into destination register */
-	if (!i2c_vm_set_reg(vm_state, rd, rd_val))
-		return false;
-
 	return true;
 }
 
-/*********************
- *
- * VM opcode execution
+/* Make room for a decoded program, the decoded buffer is only ever grown
  *
- ********************/
-
-/* Halt the virtual machine
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1,op2,op3 unused
+ * @param[in] size number of decoded instructions needed
  */
-static bool i2c_vm_halt (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3)
+static bool i2c_vm_prog_reserve (uint16_t size)
 {
-	vm_state->halted = true;
-	return true;
-}
+	if (size <= i2c_vm_prog_size)
+		return true;
 
-/* Virtual machine no operation instruction
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1,op2,op3 unused
- */
-static bool i2c_vm_nop (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3)
-{
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* Set virtual machine register
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd register be set
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_set_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
-{
-	if (!i2c_vm_set_reg(vm_state, rd, (uint32_t)SIMM_VAL(imm_hi, imm_lo)))
+	struct i2c_vm_inst * prog = PIOS_malloc(size * sizeof(*prog));
+	if (prog == NULL)
 		return false;
 
-	vm_state->uavo.pc++;
-	return true;
-}
+	if (i2c_vm_prog != NULL)
+		PIOS_free(i2c_vm_prog);
 
-/* Store virtual machine data in RAM
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] val value to be stored in RAM
- * @param[in] ram_addr address (in virtual RAM) where value will be stored
- * @param[in] op3 unused
- */
-static bool i2c_vm_store (struct i2c_vm_regs * vm_state, uint8_t val, uint8_t ram_addr, uint8_t op3)
-{
-	if (ram_addr >= sizeof(vm_state->uavo.ram))
-		return false;
+	i2c_vm_prog = prog;
+	i2c_vm_prog_size = size;
 
-	vm_state->uavo.ram[ram_addr] = val;
-	vm_state->uavo.pc++;
 	return true;
 }
 
-
-/* Load register information in Big Endian format
+/* Copy the register file into the UAVO snapshot
  *
  * @param[in,out] vm_state virtual machine state
- * @param[in] addr address (in virtual RAM) where value should be loaded from
- * @param[in] len number of bytes to load from RAM
- * @param[in] rd register to store the value into
+ * @param[in] pc address of the current instruction
  */
-static bool i2c_vm_load_be (struct i2c_vm_regs * vm_state, uint8_t addr, uint8_t len, uint8_t rd)
+static void i2c_vm_sync_uavo (struct i2c_vm_regs * vm_state, uint8_t pc)
 {
-	if ((len < 1) || (len > 4))
-		return false;
-
-	if (addr >= sizeof(vm_state->uavo.ram))
-		return false;
-
-	uint32_t val = 0;
-	memcpy ((void *)((uintptr_t)&val + (4 - len)), &(vm_state->uavo.ram[addr]), len);
-
-	/* Handle byte swapping */
-	val = (((val & 0xFF000000) >> 24) |
-		((val & 0x00FF0000) >> 8) |
-		((val & 0x0000FF00) << 8) |
-		((val & 0x000000FF) << 24));
-
-	if (!i2c_vm_set_reg (vm_state, rd, val))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
+	vm_state->uavo.pc = pc;
+	vm_state->uavo.r0 = vm_state->r[VM_R0];
+	vm_state->uavo.r1 = vm_state->r[VM_R1];
+	vm_state->uavo.r2 = vm_state->r[VM_R2];
+	vm_state->uavo.r3 = vm_state->r[VM_R3];
+	vm_state->uavo.r4 = vm_state->r[VM_R4];
+	vm_state->uavo.r5 = vm_state->r[VM_R5];
+	vm_state->uavo.r6 = vm_state->r[VM_R6];
 }
 
-/* Load register information in Little Endian format
+/* Transfer I2C data between the bus and virtual machine RAM
  *
  * @param[in,out] vm_state virtual machine state
- * @param[in] addr address (in virtual RAM) where value should be loaded from
- * @param[in] len number of bytes to load from RAM
- * @param[in] rd register to store the value into
+ * @param[in] rw PIOS_I2C_TXN_READ or PIOS_I2C_TXN_WRITE
+ * @param[in] ram_addr base address (in virtual RAM) of the data
+ * @param[in] len number of bytes to transfer
  */
-static bool i2c_vm_load_le (struct i2c_vm_regs * vm_state, uint8_t addr, uint8_t len, uint8_t rd)
+static bool i2c_vm_transfer (struct i2c_vm_regs * vm_state, enum pios_i2c_txn_direction rw, uint8_t ram_addr, uint8_t len)
 {
-	if ((len < 1) || (len > 4))
-		return false;
-
-	if (addr >= sizeof(vm_state->uavo.ram))
-		return false;
-
-	uint32_t val = 0;
-	memcpy (&val, &(vm_state->uavo.ram[addr]), len);
-
-	if (!i2c_vm_set_reg (vm_state, rd, val))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* ADD: rd = ra + rb
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
- */
-static bool i2c_vm_add_reg (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t ra, uint8_t rb)
-{
-	if (!i2c_vm_aluop_reg(vm_state, ALUOP_ADD, rd, ra, rb))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* ADD: rd += simm
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_add_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
-{
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_ADD, rd, imm_hi, imm_lo))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* Multiply: rd = ra * rb
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
- */
-static bool i2c_vm_mul_reg (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3)
-{
-	if (!i2c_vm_aluop_reg(vm_state, ALUOP_MUL, op1, op2, op3))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* Multiply: rd *= simm
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_mul_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
-{
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_MUL, rd, imm_hi, imm_lo))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* Divide: rd = ra / rb
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
- */
-static bool i2c_vm_div_reg (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t ra, uint8_t rb)
-{
-	if (!i2c_vm_aluop_reg(vm_state, ALUOP_DIV, rd, ra, rb))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* Divide: rd /= simm
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_div_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
-{
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_DIV, rd, imm_hi, imm_lo))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
-}
+	const struct pios_i2c_txn txn_list[] = {
+		{
+			.info = __func__,
+			.addr = vm_state->i2c_dev_addr,
+			.rw   = rw,
+			.len  = len,
+			.buf  = vm_state->uavo.ram + ram_addr,
+		},
+	};
 
-/* OR: rd |= (simm & 0xFFFF)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_or_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
-{
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_OR, rd, imm_hi, imm_lo))
-		return false;
+	int32_t rc = PIOS_I2C_Transfer(vm_state->i2c_adapter, txn_list, NELEMENTS(txn_list));
 
-	vm_state->uavo.pc++;
-	return true;
+	/* Fault the VM if the I2C transfer fails */
+	return rc >= 0;
 }
 
-/* AND: rd = ra & rb
+/* Reboot virtual machine
  *
  * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] ra first operand register
- * @param[in] rb second operand register
+ * @param[in] i2c_adapter opaque I2C adapter handle to use for i2c transactions
  */
-static bool i2c_vm_and_reg (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t ra, uint8_t rb)
+static void i2c_vm_reboot (struct i2c_vm_regs * vm_state, uintptr_t i2c_adapter)
 {
-	if (!i2c_vm_aluop_reg(vm_state, ALUOP_AND, rd, ra, rb))
-		return false;
+	/* Reset I2C configuration */
+	vm_state->i2c_dev_addr = 0;
+	vm_state->i2c_adapter  = i2c_adapter;
 
-	vm_state->uavo.pc++;
-	return true;
+	/* Reset register state */
+	memset(vm_state->r, 0, sizeof(vm_state->r));
+	i2c_vm_sync_uavo(vm_state, 0);
+	memset(vm_state->uavo.ram, 0, sizeof(vm_state->uavo.ram));
 }
 
-/* Arithmetic Shift Right (ASR): signed(rd) >>= (simm & 0x1F)
+/* Execute a decoded program with direct threading: each instruction ends by
+ * jumping straight to the label of the next one.
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo number of bits to shift (short immediate data)
- */
-static bool i2c_vm_asr_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
-{
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_ASR, rd, imm_hi, imm_lo))
-		return false;
-
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* Logical Shift Right (LSR): rd >>= (simm & 0x1F)
+ * @param[in] prog decoded program, or NULL to only fetch the dispatch table
+ * @param[in] i2c_adapter opaque I2C adapter handle to use for i2c transactions
+ * @param[out] dispatch_out label of each opcode, only set when prog is NULL
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo number of bits to shift (short immediate data)
+ * The labels only exist inside this function, so i2c_vm_load() fetches them
+ * here once to build the decoded program.
  */
-static bool i2c_vm_lsr_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
+static bool i2c_vm_exec (const struct i2c_vm_inst * prog, uintptr_t i2c_adapter, const void * const ** dispatch_out)
 {
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_LSR, rd, imm_hi, imm_lo))
-		return false;
+	static const void * const dispatch[] = {
+		/* Program flow operations */
+		[I2C_VM_OP_HALT]         = &&op_halt,         /* Halt */
+		[I2C_VM_OP_NOP]          = &&op_nop,          /* No operation */
+		[I2C_VM_OP_DELAY]        = &&op_delay,        /* Wait (ms) */
+		[I2C_VM_OP_BNZ]          = &&op_bnz,          /* Branch if register is not zero */
+		[I2C_VM_OP_JUMP]         = &&op_jump,         /* Jump relative */
+
+		/* RAM operations */
+		[I2C_VM_OP_STORE]        = &&op_store,        /* Store value */
+		[I2C_VM_OP_LOAD_BE]      = &&op_load_be,      /* Load big endian */
+		[I2C_VM_OP_LOAD_LE]      = &&op_load_le,      /* Load little endian */
+
+		/* Arithmetic operations */
+		[I2C_VM_OP_SET_IMM]      = &&op_set_imm,      /* Set register to immediate data */
+		[I2C_VM_OP_ADD]          = &&op_add,          /* Add two registers */
+		[I2C_VM_OP_ADD_IMM]      = &&op_add_imm,      /* Add immediate data to register */
+		[I2C_VM_OP_MUL]          = &&op_mul,          /* Multiply two registers */
+		[I2C_VM_OP_MUL_IMM]      = &&op_mul_imm,      /* Multiply register by immediate data */
+		[I2C_VM_OP_DIV]          = &&op_div,          /* Divide two registers */
+		[I2C_VM_OP_DIV_IMM]      = &&op_div_imm,      /* Divide register by immediate data */
+
+		/* Logical operations */
+		[I2C_VM_OP_SL_IMM]       = &&op_sl_imm,       /* Shift left */
+		[I2C_VM_OP_LSR_IMM]      = &&op_lsr_imm,      /* Logical Shift Right */
+		[I2C_VM_OP_ASR_IMM]      = &&op_asr_imm,      /* Arithmetic Shift Right */
+		[I2C_VM_OP_OR_IMM]       = &&op_or_imm,       /* Logical OR of register and immediate data */
+		[I2C_VM_OP_AND]          = &&op_and,          /* Logical AND of two registers */
+
+		/* I2C operations */
+		[I2C_VM_OP_SET_DEV_ADDR] = &&op_set_dev_addr, /* Set I2C device address */
+		[I2C_VM_OP_READ]         = &&op_read,         /* Read from I2C bus */
+		[I2C_VM_OP_WRITE]        = &&op_write,        /* Write to I2C bus */
+
+		/* UAVO operations */
+		[I2C_VM_OP_SEND_UAVO]    = &&op_send_uavo,    /* Send UAV Object */
+
+		[I2C_VM_OP_END]          = &&op_end,          /* Program completed */
+	};
 
-	vm_state->uavo.pc++;
-	return true;
-}
+	static struct i2c_vm_regs vm;
 
+	if (prog == NULL) {
+		*dispatch_out = dispatch;
+		return true;
+	}
 
-/* Logical Shift Left (SL): rd <<= (simm & 0x1F)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] rd destination register for result
- * @param[in] imm_hi,imm_lo number of bits to shift (short immediate data)
- */
-static bool i2c_vm_sl_imm (struct i2c_vm_regs * vm_state, uint8_t rd, uint8_t imm_hi, uint8_t imm_lo)
-{
-	if (!i2c_vm_aluop_imm(vm_state, ALUOP_SL, rd, imm_hi, imm_lo))
-		return false;
+	i2c_vm_reboot(&vm, i2c_adapter);
 
-	vm_state->uavo.pc++;
-	return true;
-}
+	/* Execute */
+	const struct i2c_vm_inst * ip = prog;
+	uint32_t * const r = vm.r;
+	bool fault = false;
 
-/* Jump: pc += simm
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1 unused
- * @param[in] imm_hi,imm_lo offset to apply to the program counter (short immediate data)
- */
-static bool i2c_vm_jump (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t imm_hi, uint8_t imm_lo)
-{
-	vm_state->uavo.pc += SIMM_VAL(imm_hi, imm_lo);
+#define I2C_VM_NEXT() goto *(++ip)->handler
 
-	return true;
-}
+	goto *ip->handler;
 
-/* Branch If Not Zero: pc += simm IFF (ra == 0)
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] ra register to compare
- * @param[in] imm_hi,imm_lo short immediate data
- */
-static bool i2c_vm_bnz (struct i2c_vm_regs * vm_state, uint8_t ra, uint8_t imm_hi, uint8_t imm_lo)
-{
-	uint32_t ra_val;
+op_halt:
+	goto done;
 
-	/* Load ra value */
-	if (!i2c_vm_get_reg(vm_state, ra, &ra_val))
-		return false;
+op_nop:
+	I2C_VM_NEXT();
 
-	if (ra_val) {
-		return (i2c_vm_jump(vm_state, 0, imm_hi, imm_lo));
-	} else {
-		vm_state->uavo.pc++;
+op_delay:
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Sleep(ip->imm);
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+	I2C_VM_NEXT();
+
+op_bnz:
+	/* Branch If Not Zero: pc = target IFF (ra != 0) */
+	if (r[ip->op1] == 0)
+		I2C_VM_NEXT();
+	/* Fall through */
+
+op_jump:
+	ip = &prog[ip->imm];
+	goto *ip->handler;
+
+op_store:
+	vm.uavo.ram[ip->op2] = ip->op1;
+	I2C_VM_NEXT();
+
+op_load_be:
+	{
+		uint32_t val = 0;
+		for (uint8_t i = 0; i < ip->op2; i++)
+			val = (val << 8) | vm.uavo.ram[ip->op1 + i];
+		r[ip->imm] = val;
 	}
-
-	return true;
-}
-
-/* Set I2C device address in virtual machine
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] i2c_dev_addr 7-bit I2C device address to be used in future I2C transfers
- * @param[in] op2,op3 unused
- */
-static bool i2c_vm_set_dev_addr (struct i2c_vm_regs * vm_state, uint8_t i2c_dev_addr, uint8_t op2, uint8_t op3)
-{
-	vm_state->i2c_dev_addr = i2c_dev_addr;
-	vm_state->uavo.pc++;
-	return true;
-}
-
-/* Read I2C data into virtual machine RAM
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] ram_addr base address (in virtual RAM) where data will be stored
- * @param[in] len number of bytes to read from the i2c bus and store into virtual RAM
- * @param[in] op3 unused
- */
-static bool i2c_vm_read (struct i2c_vm_regs * vm_state, uint8_t ram_addr, uint8_t len, uint8_t op3)
-{
-	/* Make sure our read fits in our buffer */
-	if ((ram_addr + len) > sizeof(vm_state->uavo.ram)) {
-		return false;
+	I2C_VM_NEXT();
+
+op_load_le:
+	{
+		uint32_t val = 0;
+		for (uint8_t i = ip->op2; i > 0; i--)
+			val = (val << 8) | vm.uavo.ram[ip->op1 + i - 1];
+		r[ip->imm] = val;
 	}
+	I2C_VM_NEXT();
 
-	const struct pios_i2c_txn txn_list[] = {
-		{
-			.info = __func__,
-			.addr = vm_state->i2c_dev_addr,
-			.rw   = PIOS_I2C_TXN_READ,
-			.len  = len,
-			.buf  = vm_state->uavo.ram + ram_addr,
-		},
-	};
+op_set_imm:
+	r[ip->op1] = (int32_t)ip->imm;
+	I2C_VM_NEXT();
 
-	int32_t rc = PIOS_I2C_Transfer(vm_state->i2c_adapter, txn_list, NELEMENTS(txn_list));
+op_add:
+	r[ip->op1] = r[ip->op2] + r[ip->imm];
+	I2C_VM_NEXT();
 
-	/* Fault the VM if the I2C transfer fails */
-	if (rc < 0)
-		return false;
+op_add_imm:
+	r[ip->op1] += (int32_t)ip->imm;
+	I2C_VM_NEXT();
 
-	vm_state->uavo.pc++;
+op_mul:
+	r[ip->op1] = r[ip->op2] * r[ip->imm];
+	I2C_VM_NEXT();
 
-	return (true);
-}
+op_mul_imm:
+	r[ip->op1] *= (int32_t)ip->imm;
+	I2C_VM_NEXT();
 
-/* Write I2C data from virtual machine RAM
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] ram_addr base address (in virtual RAM) where data will be read from
- * @param[in] len number of bytes to read from virtual RAM and write to the the i2c bus
- * @param[in] op3 unused
- */
-static bool i2c_vm_write (struct i2c_vm_regs * vm_state, uint8_t ram_addr, uint8_t len, uint8_t op3)
-{
-	if ((ram_addr + len) > sizeof(vm_state->uavo.ram)) {
-		return false;
+op_div:
+	/* The divisor is only known at run time */
+	if (r[ip->imm] == 0) {
+		fault = true;
+		goto done;
+	}
+	r[ip->op1] = (int32_t)r[ip->op2] / (int32_t)r[ip->imm];
+	I2C_VM_NEXT();
+
+op_div_imm:
+	r[ip->op1] = (int32_t)r[ip->op1] / ip->imm;
+	I2C_VM_NEXT();
+
+op_sl_imm:
+	r[ip->op1] <<= ip->imm;
+	I2C_VM_NEXT();
+
+op_lsr_imm:
+	r[ip->op1] >>= ip->imm;
+	I2C_VM_NEXT();
+
+op_asr_imm:
+	/* NOTE this must be a signed integer to force the >> to be an arithmetic shift */
+	r[ip->op1] = (int32_t)r[ip->op1] >> ip->imm;
+	I2C_VM_NEXT();
+
+op_or_imm:
+	r[ip->op1] |= (uint16_t)ip->imm;
+	I2C_VM_NEXT();
+
+op_and:
+	r[ip->op1] = r[ip->op2] & r[ip->imm];
+	I2C_VM_NEXT();
+
+op_set_dev_addr:
+	vm.i2c_dev_addr = ip->op1;
+	I2C_VM_NEXT();
+
+op_read:
+	if (!i2c_vm_transfer(&vm, PIOS_I2C_TXN_READ, ip->op1, ip->op2)) {
+		fault = true;
+		goto done;
 	}
+	I2C_VM_NEXT();
 
-	const struct pios_i2c_txn txn_list[] = {
-		{
-			.info = __func__,
-			.addr = vm_state->i2c_dev_addr,
-			.rw   = PIOS_I2C_TXN_WRITE,
-			.len  = len,
-			.buf  = vm_state->uavo.ram + ram_addr,
-		},
-	};
+op_write:
+	if (!i2c_vm_transfer(&vm, PIOS_I2C_TXN_WRITE, ip->op1, ip->op2)) {
+		fault = true;
+		goto done;
+	}
+	I2C_VM_NEXT();
 
-	int32_t rc = PIOS_I2C_Transfer(vm_state->i2c_adapter, txn_list, NELEMENTS(txn_list));
+op_send_uavo:
+	/* Push our local copy of the UAVO */
+	i2c_vm_sync_uavo(&vm, ip - prog);
+	I2CVMSet(&vm.uavo);
+	I2C_VM_NEXT();
 
-	/* Fault the VM if the I2C transfer fails */
-	if (rc < 0)
-		return false;
+op_end:
+	/* PC is just past the end of the code, program is completed */
+done:
+	i2c_vm_sync_uavo(&vm, ip - prog);
 
-	vm_state->uavo.pc++;
+#undef I2C_VM_NEXT
 
-	return (true);
+	return !fault;
 }
 
-/* Send UAVObject from virtual machine registers
+/* Load a program. It is verified and pre-decoded into a table of label
+ * addresses and operands once, so that i2c_vm_run() only has to dispatch.
+ * A program that fails to load replaces the one loaded before.
  *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1,op2,op3 unused
+ * @param[in] code pointer to program to load
+ * @param[in] code_len number of 32-bit instructions contained in the program
  */
-static bool i2c_vm_send_uavo (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3)
+bool i2c_vm_load (const uint32_t * code, uint8_t code_len)
 {
-	/* Push our local copy of the UAVO */
-	I2CVMSet(&vm_state->uavo);
+	i2c_vm_loaded = false;
 
-	vm_state->uavo.pc++;
-	return true;
-}
+	if (!i2c_vm_verify(code, code_len))
+		return false;
 
-/* Make virtual machine wait
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1 unused
- * @param[in] imm_hi,imm_lo number of ms to wait (short immediate data)
- */
-static bool i2c_vm_delay (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t imm_hi, uint8_t imm_lo)
-{
-#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
-	PIOS_Thread_Sleep(SIMM_VAL(imm_hi, imm_lo));
-#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+	/* One extra slot past the end of the code completes the program */
+	if (!i2c_vm_prog_reserve(code_len + 1))
+		return false;
 
-	vm_state->uavo.pc++;
-	return true;
-}
+	const void * const * dispatch;
+	i2c_vm_exec(NULL, 0, &dispatch);
 
-/* Reboot virtual machine
- *
- * @param[in,out] vm_state virtual machine state
- * @param[in] op1,op2,op3 unused
- */
-static bool i2c_vm_reboot (struct i2c_vm_regs * vm_state, uintptr_t i2c_adapter)
-{
-	vm_state->halted  = false;
-	vm_state->fault   = false;
+	/* Decode */
+	struct i2c_vm_inst * const prog = i2c_vm_prog;
 
-	/* Reset I2C configuration */
-	vm_state->i2c_dev_addr = 0;
-	vm_state->i2c_adapter  = i2c_adapter;
+	for (uint8_t pc = 0; pc < code_len; pc++) {
+		uint32_t instruction = code[pc];
+		uint8_t operator = (instruction & 0xFF000000) >> 24;
+		uint8_t op1      = (instruction & 0x00FF0000) >> 16;
+		uint8_t op2      = (instruction & 0x0000FF00) >>  8;
+		uint8_t op3      = (instruction & 0x000000FF);
+		struct i2c_vm_inst * inst = &prog[pc];
+
+		inst->handler = dispatch[operator];
+		inst->op1 = op1;
+		inst->op2 = op2;
+
+		switch (operator) {
+		case I2C_VM_OP_BNZ:
+		case I2C_VM_OP_JUMP:
+			/* Resolve relative branches to absolute addresses */
+			inst->imm = pc + SIMM_VAL(op2, op3);
+			break;
+		case I2C_VM_OP_SL_IMM:
+		case I2C_VM_OP_LSR_IMM:
+		case I2C_VM_OP_ASR_IMM:
+			inst->imm = SIMM_VAL(op2, op3) & 0x1F;
+			break;
+		case I2C_VM_OP_DELAY:
+		case I2C_VM_OP_SET_IMM:
+		case I2C_VM_OP_ADD_IMM:
+		case I2C_VM_OP_MUL_IMM:
+		case I2C_VM_OP_DIV_IMM:
+		case I2C_VM_OP_OR_IMM:
+			inst->imm = SIMM_VAL(op2, op3);
+			break;
+		default:
+			inst->imm = op3;
+			break;
+		}
+	}
+	prog[code_len].handler = dispatch[I2C_VM_OP_END];
 
-	/* Reset register state */
-	vm_state->uavo.pc = 0;
-	vm_state->uavo.r0 = 0;
-	vm_state->uavo.r1 = 0;
-	vm_state->uavo.r2 = 0;
-	vm_state->uavo.r3 = 0;
-	vm_state->uavo.r4 = 0;
-	vm_state->uavo.r5 = 0;
-	vm_state->uavo.r6 = 0;
-	memset(vm_state->uavo.ram, 0, sizeof(vm_state->uavo.ram));
+	i2c_vm_loaded = true;
 
 	return true;
 }
 
-
-typedef bool (*i2c_vm_inst_handler) (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3);
-
-const i2c_vm_inst_handler i2c_vm_handlers[] = {
-	/* Program flow operations */
-	[I2C_VM_OP_HALT]         = i2c_vm_halt,         /* Halt */
-	[I2C_VM_OP_NOP]          = i2c_vm_nop,          /* No operation */
-	[I2C_VM_OP_DELAY]        = i2c_vm_delay,        /* Wait (ms) */
-	[I2C_VM_OP_BNZ]          = i2c_vm_bnz,          /* Branch if register is not zero */
-	[I2C_VM_OP_JUMP]         = i2c_vm_jump,         /* Jump relative */
-
-	/* RAM operations */
-	[I2C_VM_OP_STORE]        = i2c_vm_store,        /* Store value */
-	[I2C_VM_OP_LOAD_BE]      = i2c_vm_load_be,      /* Load big endian */
-	[I2C_VM_OP_LOAD_LE]      = i2c_vm_load_le,      /* Load little endian */
-
-	/* Arithmetic operations */
-	[I2C_VM_OP_SET_IMM]      = i2c_vm_set_imm,      /* Set register to immediate data */
-	[I2C_VM_OP_ADD]          = i2c_vm_add_reg,      /* Add two registers */
-	[I2C_VM_OP_ADD_IMM]      = i2c_vm_add_imm,      /* Add immediate data to register */
-	[I2C_VM_OP_MUL]          = i2c_vm_mul_reg,      /* Multiply two registers */
-	[I2C_VM_OP_MUL_IMM]      = i2c_vm_mul_imm,      /* Multiply register by immediate data */
-	[I2C_VM_OP_DIV]          = i2c_vm_div_reg,      /* Divide two registers */
-	[I2C_VM_OP_DIV_IMM]      = i2c_vm_div_imm,      /* Divide register by immediate data */
-
-	/* Logical operations */
-	[I2C_VM_OP_SL_IMM]       = i2c_vm_sl_imm,       /* Shift left */
-	[I2C_VM_OP_LSR_IMM]      = i2c_vm_lsr_imm,      /* Logical Shift Right */
-	[I2C_VM_OP_ASR_IMM]      = i2c_vm_asr_imm,      /* Arithmetic Shift Right */
-	[I2C_VM_OP_OR_IMM]       = i2c_vm_or_imm,       /* Logical OR of register and immediate data */
-	[I2C_VM_OP_AND]          = i2c_vm_and_reg,      /* Logical AND of two registers */
-
-	/* I2C operations */
-	[I2C_VM_OP_SET_DEV_ADDR] = i2c_vm_set_dev_addr, /* Set I2C device address */
-	[I2C_VM_OP_READ]         = i2c_vm_read,         /* Read from I2C bus */
-	[I2C_VM_OP_WRITE]        = i2c_vm_write,        /* Write to I2C bus */
-
-	/* UAVO operations */
-	[I2C_VM_OP_SEND_UAVO]    = i2c_vm_send_uavo,    /* Send UAV Object */
-};
-
-/* Run virtual machine. This is the code that loops through and interprets all the instructions
+/* Run the loaded program from a freshly rebooted virtual machine
  *
- * @param[in] code pointer to program to execute
- * @param[in] code_len number of 32-bit instructions contained in the program
  * @param[in] i2c_adapter opaque I2C adapter handle to use for i2c transactions
- *
  */
-bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_adapter)
+bool i2c_vm_run (uintptr_t i2c_adapter)
 {
-	if (code == NULL || code_len == 0)
+	if (!i2c_vm_loaded)
 		return false;
 
-	static struct i2c_vm_regs vm;
-
-	i2c_vm_reboot (&vm, i2c_adapter);
-
-	while (!vm.halted) {
-		if (vm.uavo.pc > code_len) {
-			/* PC is entirely out of range */
-			vm.fault  = true;
-			vm.halted = true;
-			continue;
-		}
-		if (vm.uavo.pc == code_len) {
-			/* PC is just past the end of the code, assume program is completed */
-			vm.halted = true;
-			continue;
-		}
-		/* Fetch */
-		uint32_t instruction = code[vm.uavo.pc];
-
-		/* Decode */
-		uint8_t operator = (instruction & 0xFF000000) >> 24;
-		uint8_t op1      = (instruction & 0x00FF0000) >> 16;
-		uint8_t op2      = (instruction & 0x0000FF00) >>  8;
-		uint8_t op3      = (instruction & 0x000000FF);
-
-		if (operator > NELEMENTS(i2c_vm_handlers)) {
-			vm.fault = true;
-			vm.halted = true;
-			continue;
-		}
-		i2c_vm_inst_handler f = i2c_vm_handlers[operator];
-
-		/* Execute + Writeback */
-		if (!f || !f(&vm, op1, op2, op3)) {
-			vm.fault  = true;
-			vm.halted = true;
-			continue;
-		}
-	}
-
-	return (!vm.fault);
+	return i2c_vm_exec(i2c_vm_prog, i2c_adapter, NULL);
 }
 
 #endif /* PIOS_INCLUDE_I2C */
@@ -333,6 +333,9 @@ static void loggingTask(void *parameters)
 
 			LoggingStatsBytesLoggedSet(&written_bytes);
 
+			// Get a partial page that has been waiting for too long into flash
+			PIOS_STREAMFS_Flush_Stale(streamfs_id);
+
 			break;
 
 		case LOGGINGSTATS_OPERATION_DOWNLOAD:
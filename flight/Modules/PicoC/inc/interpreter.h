@@ -357,6 +357,7 @@ struct IncludeLibrary
 #define FREELIST_BUCKETS 8                          /* freelists for 4, 8, 12 ... 32 byte allocs */
 #define SPLIT_MEM_THRESHOLD 16                      /* don't split memory which is close in size */
 #define BREAKPOINT_TABLE_SIZE 21
+#define SCOPE_FILTER_SIZE 32                        /* bytes of the filter of scopes which define variables */
 
 
 /* the entire state of the picoc system */
@@ -384,6 +385,9 @@ struct Picoc_Struct
     /* the stack */
     struct StackFrame *TopStackFrame;
 
+    /* one bit per hashed scope id, set once a variable is defined in that scope */
+    unsigned char ScopeFilter[SCOPE_FILTER_SIZE];
+
     /* the value passed to exit() */
     int PicocExitValue;
 
@@ -483,6 +487,7 @@ void TableStrFree(Picoc *pc);
 void LexInit(Picoc *pc);
 void LexCleanup(Picoc *pc);
 void *LexAnalyse(Picoc *pc, const char *FileName, const char *Source, int SourceLen, int *TokenLen);
+int LexTokenSize(enum LexToken Token);
 void LexInitParser(struct ParseState *Parser, Picoc *pc, const char *SourceText, void *TokenSource, char *FileName, int RunIt, int SetDebugMode);
 enum LexToken LexGetToken(struct ParseState *Parser, struct Value **Value, int IncPos);
 enum LexToken LexRawPeekToken(struct ParseState *Parser);
@@ -564,6 +569,7 @@ void VariableStringLiteralDefine(Picoc *pc, char *Ident, struct Value *Val);
 void *VariableDereferencePointer(struct ParseState *Parser, struct Value *PointerValue, struct Value **DerefVal, int *DerefOffset, struct ValueType **DerefType, int *DerefIsLValue);
 int VariableScopeBegin(struct ParseState * Parser, int* PrevScopeID);
 void VariableScopeEnd(struct ParseState * Parser, int ScopeID, int PrevScopeID);
+void VariableScopeMark(Picoc *pc, int ScopeID);
 
 /* clibrary.c */
 void BasicIOInit(Picoc *pc);
@@ -165,6 +165,7 @@ struct Value *ParseFunctionDefinition(struct ParseState *Parser, struct ValueTyp
     if (!TableSet(pc, &pc->GlobalTable, Identifier, FuncValue, (char *)Parser->FileName, Parser->Line, Parser->CharacterPos))
         ProgramFail(Parser, "'%s' is already defined", Identifier);
         
+    VariableScopeMark(pc, FuncValue->ScopeID);
     return FuncValue;
 }
 
@@ -423,6 +424,8 @@ void ParseMacroDefinition(struct ParseState *Parser)
     
     if (!TableSet(Parser->pc, &Parser->pc->GlobalTable, MacroNameStr, MacroValue, (char *)Parser->FileName, Parser->Line, Parser->CharacterPos))
         ProgramFail(Parser, "'%s' is already defined", MacroNameStr);
+
+    VariableScopeMark(Parser->pc, MacroValue->ScopeID);
 }
 
 /* copy the entire parser state */
@@ -54,6 +54,10 @@ void PlatformFree(void *ptr);
 size_t PlatformHeapSize();
 void PlatformDebug(const char *format, ...);
 int picoc(const char *source, size_t stack_size);
+int32_t picoc_compile(const char *source, uint32_t source_len, uint8_t *image, uint32_t image_size, size_t stack_size);
+bool picoc_image_valid(const uint8_t *image, uint32_t image_size, const char *source, uint32_t source_len);
+uint32_t picoc_image_len(const uint8_t *image);
+int picoc_run(const uint8_t *image, const char *source, size_t stack_size);
 
 /* get all picoc definitions */
 #include "picoc.h"
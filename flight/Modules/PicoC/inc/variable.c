@@ -162,6 +162,29 @@ void VariableRealloc(struct ParseState *Parser, struct Value *FromValue, int New
     FromValue->AnyValOnHeap = TRUE;
 }
 
+/* position of a scope id in the scope filter. scope ids are products of
+ * pointers, so take the top bits of a multiplicative hash */
+static unsigned int VariableScopeBit(int ScopeID)
+{
+    return ((unsigned int)ScopeID * 2654435761u) >> (32 - 8) & (SCOPE_FILTER_SIZE * 8 - 1);
+}
+
+/* note that a variable was stored in a table with this scope id */
+void VariableScopeMark(Picoc *pc, int ScopeID)
+{
+    unsigned int Bit = VariableScopeBit(ScopeID);
+    pc->ScopeFilter[Bit / 8] |= 1 << (Bit % 8);
+}
+
+/* false if no variable was ever defined in this scope, so there is nothing
+ * to bring back into or take out of scope. this keeps loop bodies without
+ * declarations from walking the whole variable table on every iteration */
+static int VariableScopeMaybeUsed(Picoc *pc, int ScopeID)
+{
+    unsigned int Bit = VariableScopeBit(ScopeID);
+    return pc->ScopeFilter[Bit / 8] & (1 << (Bit % 8));
+}
+
 int VariableScopeBegin(struct ParseState * Parser, int* OldScopeID)
 {
     struct TableEntry *Entry;
@@ -182,6 +205,9 @@ int VariableScopeBegin(struct ParseState * Parser, int* OldScopeID)
     /* or maybe a more human-readable hash for debugging? */
     /* Parser->ScopeID = Parser->Line * 0x10000 + Parser->CharacterPos; */
     
+    if (!VariableScopeMaybeUsed(pc, Parser->ScopeID))
+        return Parser->ScopeID;
+
     for (Count = 0; Count < HashTable->Size; Count++)
     {
         for (Entry = HashTable->HashTable[Count]; Entry != NULL; Entry = NextEntry)
@@ -217,6 +243,12 @@ void VariableScopeEnd(struct ParseState * Parser, int ScopeID, int PrevScopeID)
 
     if (ScopeID == -1) return;
 
+    if (!VariableScopeMaybeUsed(pc, ScopeID))
+    {
+        Parser->ScopeID = PrevScopeID;
+        return;
+    }
+
     for (Count = 0; Count < HashTable->Size; Count++)
     {
         for (Entry = HashTable->HashTable[Count]; Entry != NULL; Entry = NextEntry)
@@ -278,6 +310,7 @@ struct Value *VariableDefine(Picoc *pc, struct ParseState *Parser, char *Ident,
     if (!TableSet(pc, currentTable, Ident, AssignValue, Parser ? ((char *)Parser->FileName) : NULL, Parser ? Parser->Line : 0, Parser ? Parser->CharacterPos : 0))
         ProgramFail(Parser, "'%s' is already defined", Ident);
     
+    VariableScopeMark(pc, ScopeID);
     return AssignValue;
 }
 
@@ -380,6 +413,8 @@ void VariableDefinePlatformVar(Picoc *pc, struct ParseState *Parser, char *Ident
     
     if (!TableSet(pc, (pc->TopStackFrame == NULL) ? &pc->GlobalTable : &pc->TopStackFrame->LocalTable, TableStrRegister(pc, Ident), SomeValue, Parser ? Parser->FileName : NULL, Parser ? Parser->Line : 0, Parser ? Parser->CharacterPos : 0))
         ProgramFail(Parser, "'%s' is already defined", Ident);
+
+    VariableScopeMark(pc, SomeValue->ScopeID);
 }
 
 /* free and/or pop the top value off the stack. Var must be the top value on the stack! */
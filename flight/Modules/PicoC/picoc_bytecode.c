@@ -0,0 +1,359 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules TauLabs Modules
+ * @{
+ * @addtogroup PicoC Interpreter Module
+ * @{
+ *
+ * @file       picoc_bytecode.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      c-interpreter module for autonomous user programmed tasks
+ *             precompiled script images
+ *
+ * picoc normally lexes the complete source every time a script is started.
+ * picoc_compile() does that once and stores the token stream in a compact,
+ * position independent image: identifiers and string literals are replaced
+ * by indices into a string pool, so the image can be saved to flash next to
+ * the source. picoc_run() rebuilds the token stream from the pool and hands
+ * it straight to the parser.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+// conditional compilation of the module
+#include "pios.h"
+#ifdef PIOS_INCLUDE_PICOC
+
+#include "openpilot.h"
+#include "picoc_port.h"
+#include "pios_crc.h"
+#include <setjmp.h>
+
+#include "picoc.h"
+#include "interpreter.h"
+
+// Private constants
+#define IMAGE_MAGIC				0x50434231		/* 'PCB1' */
+#define IMAGE_TOKEN_HEADER		2				/* token and character position, like TOKEN_DATA_OFFSET in lex.c */
+#define IMAGE_STRING_INDEX		sizeof(uint16_t)
+#define IMAGE_MAX_STRING_LEN	255
+
+// Private types
+
+/**
+ * The image starts with this header, followed by the string pool (each
+ * entry a length byte and the characters) and the compacted token stream.
+ */
+struct picoc_image_header {
+	uint32_t magic;
+	uint32_t image_crc;			/* CRC32 of everything after the header */
+	uint32_t source_crc;		/* CRC32 of the source the image was made from */
+	uint32_t source_len;
+	uint32_t pool_len;			/* bytes of string pool */
+	uint32_t token_len;			/* bytes of compact tokens */
+	uint32_t expanded_len;		/* bytes of the token stream the parser sees */
+	uint16_t num_strings;
+	uint8_t long_size;			/* numeric constants are kept in native format */
+	uint8_t double_size;
+};
+
+// Global variables
+extern jmp_buf PicocExitBuf;
+
+// Private functions
+
+/**
+ * size of a token value inside the image
+ */
+static int image_value_size(enum LexToken token)
+{
+	switch (token) {
+	case TokenIdentifier:
+	case TokenStringConstant:
+		return IMAGE_STRING_INDEX;
+	default:
+		return LexTokenSize(token);
+	}
+}
+
+/**
+ * find or add a registered string to the string pool index
+ * returns the index or -1 if the pool is full
+ */
+static int32_t pool_index(char **strings, uint16_t *num_strings, uint16_t max_strings, char *str)
+{
+	for (uint16_t i = 0; i < *num_strings; i++) {
+		/* registered strings are unique, so comparing pointers is enough */
+		if (strings[i] == str) {
+			return i;
+		}
+	}
+
+	if (*num_strings >= max_strings) {
+		return -1;
+	}
+	strings[*num_strings] = str;
+	return (*num_strings)++;
+}
+
+/**
+ * turn a lexed token stream into an image
+ * returns the image length or -1 if it does not fit
+ */
+static int32_t image_encode(Picoc *pc, const uint8_t *tokens, int token_len, const char *source, uint32_t source_len, uint8_t *image, uint32_t image_size)
+{
+	struct picoc_image_header header;
+	uint16_t max_strings = token_len / (IMAGE_TOKEN_HEADER + sizeof(char *)) + 1;
+	char **strings = HeapAllocStack(pc, max_strings * sizeof(char *));
+	uint32_t stream_len = 0;
+	int32_t retval = -1;
+
+	if (strings == NULL) {
+		return -1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic = IMAGE_MAGIC;
+	header.source_crc = PIOS_CRC32_updateCRC(0, (const uint8_t *) source, source_len);
+	header.source_len = source_len;
+	header.expanded_len = token_len;
+	header.long_size = sizeof(long);
+	header.double_size = sizeof(double);
+
+	/* first pass: collect the strings and size the compact tokens */
+	for (const uint8_t *pos = tokens; pos < tokens + token_len; ) {
+		enum LexToken token = (enum LexToken) *pos;
+		if ((token == TokenIdentifier) || (token == TokenStringConstant)) {
+			char *str;
+			memcpy(&str, pos + IMAGE_TOKEN_HEADER, sizeof(str));
+			if (pool_index(strings, &header.num_strings, max_strings, str) < 0) {
+				goto out;
+			}
+		}
+		stream_len += IMAGE_TOKEN_HEADER + image_value_size(token);
+		pos += IMAGE_TOKEN_HEADER + LexTokenSize(token);
+	}
+
+	for (uint16_t i = 0; i < header.num_strings; i++) {
+		uint32_t len = strlen(strings[i]);
+		if (len > IMAGE_MAX_STRING_LEN) {
+			goto out;
+		}
+		header.pool_len += 1 + len;
+	}
+	header.token_len = stream_len;
+
+	if (sizeof(header) + header.pool_len + header.token_len > image_size) {
+		goto out;
+	}
+
+	/* second pass: write the image */
+	uint8_t *dst = image;
+	memcpy(dst, &header, sizeof(header));
+	dst += sizeof(header);
+
+	for (uint16_t i = 0; i < header.num_strings; i++) {
+		uint8_t len = strlen(strings[i]);
+		*dst++ = len;
+		memcpy(dst, strings[i], len);
+		dst += len;
+	}
+
+	for (const uint8_t *pos = tokens; pos < tokens + token_len; ) {
+		enum LexToken token = (enum LexToken) *pos;
+		memcpy(dst, pos, IMAGE_TOKEN_HEADER);
+		if ((token == TokenIdentifier) || (token == TokenStringConstant)) {
+			char *str;
+			memcpy(&str, pos + IMAGE_TOKEN_HEADER, sizeof(str));
+			uint16_t index = pool_index(strings, &header.num_strings, max_strings, str);
+			memcpy(dst + IMAGE_TOKEN_HEADER, &index, IMAGE_STRING_INDEX);
+		} else {
+			memcpy(dst + IMAGE_TOKEN_HEADER, pos + IMAGE_TOKEN_HEADER, LexTokenSize(token));
+		}
+		dst += IMAGE_TOKEN_HEADER + image_value_size(token);
+		pos += IMAGE_TOKEN_HEADER + LexTokenSize(token);
+	}
+
+	header.image_crc = PIOS_CRC32_updateCRC(0, image + sizeof(header), dst - image - sizeof(header));
+	memcpy(image, &header, sizeof(header));
+
+	retval = dst - image;
+
+out:
+	HeapPopStack(pc, strings, max_strings * sizeof(char *));
+	return retval;
+}
+
+/**
+ * rebuild the token stream of an image on the picoc heap
+ * registers all strings and string literals like the lexer does
+ */
+static void *image_decode(Picoc *pc, const uint8_t *image)
+{
+	struct picoc_image_header header;
+	memcpy(&header, image, sizeof(header));
+
+	const uint8_t *src = image + sizeof(header);
+	char **strings = HeapAllocStack(pc, (header.num_strings + 1) * sizeof(char *));
+	uint8_t *tokens = HeapAllocMem(pc, header.expanded_len);
+	if ((strings == NULL) || (tokens == NULL)) {
+		ProgramFailNoParser(pc, "out of memory");
+	}
+
+	for (uint16_t i = 0; i < header.num_strings; i++) {
+		uint8_t len = *src++;
+		strings[i] = TableStrRegister2(pc, (const char *) src, len);
+		src += len;
+	}
+
+	uint8_t *dst = tokens;
+	const uint8_t *end = src + header.token_len;
+	while (src < end) {
+		enum LexToken token = (enum LexToken) *src;
+		memcpy(dst, src, IMAGE_TOKEN_HEADER);
+		if ((token == TokenIdentifier) || (token == TokenStringConstant)) {
+			uint16_t index;
+			memcpy(&index, src + IMAGE_TOKEN_HEADER, IMAGE_STRING_INDEX);
+			char *str = strings[index];
+			if ((token == TokenStringConstant) && (VariableStringLiteralGet(pc, str) == NULL)) {
+				/* string literals are arrays, same as LexGetStringConstant() */
+				struct Value *array = VariableAllocValueAndData(pc, NULL, 0, FALSE, NULL, TRUE);
+				array->Typ = pc->CharArrayType;
+				array->Val = (union AnyValue *) str;
+				VariableStringLiteralDefine(pc, str, array);
+			}
+			memcpy(dst + IMAGE_TOKEN_HEADER, &str, sizeof(str));
+		} else {
+			memcpy(dst + IMAGE_TOKEN_HEADER, src + IMAGE_TOKEN_HEADER, LexTokenSize(token));
+		}
+		src += IMAGE_TOKEN_HEADER + image_value_size(token);
+		dst += IMAGE_TOKEN_HEADER + LexTokenSize(token);
+	}
+
+	HeapPopStack(pc, strings, (header.num_strings + 1) * sizeof(char *));
+	return tokens;
+}
+
+/**
+ * compile a source into an image
+ * returns the image length or -1 on lexer errors or if the image buffer is too small
+ */
+int32_t picoc_compile(const char *source, uint32_t source_len, uint8_t *image, uint32_t image_size, size_t stack_size)
+{
+	Picoc pc;
+	int token_len;
+	int32_t retval;
+
+	if (image_size < sizeof(struct picoc_image_header)) {
+		return -1;
+	}
+
+	/* an aborted compile must not leave a valid looking image behind */
+	memset(image, 0, sizeof(struct picoc_image_header));
+
+	PicocInitialise(&pc, stack_size);
+
+	if (PicocPlatformSetExitPoint(&pc))
+	{	/* we get here on lexer errors */
+		PicocCleanup(&pc);
+		return -1;
+	}
+
+	void *tokens = LexAnalyse(&pc, TableStrRegister(&pc, "nofile"), source, source_len, &token_len);
+	retval = image_encode(&pc, tokens, token_len, source, source_len, image, image_size);
+	HeapFreeMem(&pc, tokens);
+
+	PicocCleanup(&pc);
+	return retval;
+}
+
+/**
+ * check if an image is intact and was made from the given source
+ * images that fail this check must not be passed to picoc_run()
+ */
+bool picoc_image_valid(const uint8_t *image, uint32_t image_size, const char *source, uint32_t source_len)
+{
+	struct picoc_image_header header;
+
+	if (image_size < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, image, sizeof(header));
+
+	return (header.magic == IMAGE_MAGIC) &&
+		(header.long_size == sizeof(long)) && (header.double_size == sizeof(double)) &&
+		(sizeof(header) + header.pool_len + header.token_len <= image_size) &&
+		(header.source_len == source_len) &&
+		(header.source_crc == PIOS_CRC32_updateCRC(0, (const uint8_t *) source, source_len)) &&
+		(header.image_crc == PIOS_CRC32_updateCRC(0, image + sizeof(header), header.pool_len + header.token_len));
+}
+
+/**
+ * length of a valid image
+ */
+uint32_t picoc_image_len(const uint8_t *image)
+{
+	struct picoc_image_header header;
+	memcpy(&header, image, sizeof(header));
+
+	return sizeof(header) + header.pool_len + header.token_len;
+}
+
+/**
+ * run a precompiled image
+ * the source the image was made from is needed for error messages and to
+ * tell block scopes apart (see VariableScopeBegin())
+ * returns the exit() value
+ */
+int picoc_run(const uint8_t *image, const char *source, size_t stack_size)
+{
+	Picoc pc;
+	struct ParseState Parser;
+	enum ParseResult Ok;
+
+	PicocInitialise(&pc, stack_size);
+
+	if (PicocPlatformSetExitPoint(&pc))
+	{	/* we get here, if an error occures or 'exit();' was called. */
+		PicocCleanup(&pc);
+		return pc.PicocExitValue;
+	}
+
+	void *tokens = image_decode(&pc, image);
+	LexInitParser(&Parser, &pc, source, tokens, TableStrRegister(&pc, "nofile"), TRUE, FALSE);
+
+	do {
+		Ok = ParseStatement(&Parser, TRUE);
+	} while (Ok == ParseResultOk);
+
+	if (Ok == ParseResultError)
+		ProgramFail(&Parser, "parse error");
+
+	HeapFreeMem(&pc, tokens);
+	PicocCleanup(&pc);
+	return pc.PicocExitValue;
+}
+
+#endif /* PIOS_INCLUDE_PICOC */
+
+/**
+ * @}
+ * @}
+ */
@@ -52,6 +52,8 @@ extern struct flashfs_logfs_cfg flashfs_waypoints_cfg;
 #define PICOC_STACKSIZE_MIN		(10*1024)
 #define PICOC_STACKSIZE_MAX		(128*1024)
 #define PICOC_SOURCE_FILE_TYPE	0X00704300		/* mark picoc sources with this ID */
+#define PICOC_IMAGE_FILE_TYPE	0X00704900		/* mark precompiled images of the sources with this ID */
+#define PICOC_HEAP_RESERVE		256				/* heap kept free for the task control block and padding */
 #define PICOC_SECTOR_SIZE		48				/* size of filesystem object (less than slot_size - sizeof(slot_header) */
 #define SOH	0x01	/* (^A) start of heading */
 #define STX	0x02	/* (^B) start of text */
@@ -65,17 +67,22 @@ static uintptr_t picocPort;
 static bool module_enabled;
 static char *sourcebuffer;
 static uint32_t sourcebuffer_size;
+static uint8_t *imagebuffer;
+static uint32_t imagebuffer_size;
 static PicoCSettingsData picocsettings;
 static PicoCStatusData picocstatus;
 
 // Private functions
 static void picocTask(void *parameters);
 static void updateSettings();
+static int16_t run_file();
 int32_t usart_cmd(char *buffer, uint32_t buffer_size);
 int32_t get_sector(uint16_t sector, char *buffer, uint32_t buffer_size);
 int32_t set_sector(uint16_t sector, char *buffer, uint32_t buffer_size);
 int32_t load_file(uint8_t file, char *buffer, uint32_t buffer_size);
 int32_t save_file(uint8_t file, char *buffer, uint32_t buffer_size);
+int32_t load_image(uint8_t file, uint8_t *buffer, uint32_t buffer_size);
+int32_t save_image(uint8_t file, uint8_t *buffer, uint32_t buffer_size);
 int32_t delete_file(uint8_t file);
 int32_t format_partition();
 
@@ -132,6 +139,14 @@ static int32_t picocInitialize(void)
 			return -1;
 		}
 
+		// the image buffer is optional. without it, scripts are run from source.
+		// a failed malloc is fatal, so it is only taken if the task stack and the
+		// picoc heap, which are allocated later, still fit next to it.
+		if (PIOS_heap_get_free_size() >= sourcebuffer_size + picocsettings.TaskStackSize + picocsettings.PicoCStackSize + PICOC_HEAP_RESERVE) {
+			imagebuffer = PIOS_malloc(sourcebuffer_size);
+			imagebuffer_size = sourcebuffer_size;
+		}
+
 #ifdef PIOS_COM_PICOC
 		// get picoc USART for stdIO communication
 		picocPort = PIOS_COM_PICOC;
@@ -161,9 +176,10 @@ static void picocTask(void *parameters) {
 	// clear source buffer
 	memset(sourcebuffer, 0, sourcebuffer_size);
 
-	// load boot file from flash
+	// load boot file and its image from flash
 	PicoCSettingsGet(&picocsettings);
 	picocstatus.CommandError = load_file(picocsettings.BootFileID, sourcebuffer, sourcebuffer_size);
+	load_image(picocsettings.BootFileID, imagebuffer, imagebuffer_size);
 	PicoCStatusCommandErrorSet(&picocstatus.CommandError);
 
 	while (1) {
@@ -178,7 +194,7 @@ static void picocTask(void *parameters) {
 				// external start request
 				picocstatus.ExitValue = 0;
 				PicoCStatusExitValueSet(&picocstatus.ExitValue);
-				picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
+				picocstatus.ExitValue = run_file();
 				PicoCStatusExitValueSet(&picocstatus.ExitValue);
 				picocstatus.CommandError = 0;
 				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
@@ -205,11 +221,15 @@ static void picocTask(void *parameters) {
 			case PICOCSTATUS_COMMAND_LOADFILE:
 				// fill buffer from flash file
 				picocstatus.CommandError = load_file(picocstatus.FileID, sourcebuffer, sourcebuffer_size);
+				load_image(picocstatus.FileID, imagebuffer, imagebuffer_size);
 				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
 				break;
 			case PICOCSTATUS_COMMAND_SAVEFILE:
 				// save buffer to flash file
 				picocstatus.CommandError = save_file(picocstatus.FileID, sourcebuffer, sourcebuffer_size);
+				if (picocstatus.CommandError == 0) {
+					save_image(picocstatus.FileID, imagebuffer, imagebuffer_size);
+				}
 				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
 				break;
 			case PICOCSTATUS_COMMAND_DELETEFILE:
@@ -266,10 +286,8 @@ static void picocTask(void *parameters) {
 				picocstatus.ExitValue = picoc(NULL, picocsettings.PicoCStackSize);
 				break;
 			case PICOCSETTINGS_SOURCE_FILE:
-				// terminate source for security.
-				sourcebuffer[sourcebuffer_size - 1] = 0;
 				// start picoc in file mode.
-				picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
+				picocstatus.ExitValue = run_file();
 				started = true;
 				break;
 			default:
@@ -319,6 +337,43 @@ static void updateSettings()
 	}
 }
 
+/**
+ * compile the source buffer into the image buffer, unless the image
+ * already belongs to the current source
+ * \return true if the image buffer holds a valid image
+ */
+static bool compile_file()
+{
+	uint32_t source_len = strlen(sourcebuffer);
+
+	if (imagebuffer == NULL) {
+		return false;
+	}
+
+	if (picoc_image_valid(imagebuffer, imagebuffer_size, sourcebuffer, source_len)) {
+		return true;
+	}
+
+	return picoc_compile(sourcebuffer, source_len, imagebuffer, imagebuffer_size, picocsettings.PicoCStackSize) > 0;
+}
+
+/**
+ * run the source buffer, from its precompiled image if possible
+ * \return the exit() value of the script
+ */
+static int16_t run_file()
+{
+	// terminate source for security.
+	sourcebuffer[sourcebuffer_size - 1] = 0;
+
+	if (compile_file()) {
+		return picoc_run(imagebuffer, sourcebuffer, picocsettings.PicoCStackSize);
+	}
+
+	// no image memory, image too large or a lexer error. the source run reports errors.
+	return picoc(sourcebuffer, picocsettings.PicoCStackSize);
+}
+
 /**
  * usart command
  */
@@ -465,12 +520,65 @@ int32_t save_file(uint8_t file, char *buffer, uint32_t buffer_size)
 }
 
 /**
- * delete a source file
+ * load a precompiled image from flash
+ * it is checked against the source before it is used, so a missing or
+ * stale image only means the source has to be compiled again.
+ */
+int32_t load_image(uint8_t file, uint8_t *buffer, uint32_t buffer_size)
+{
+	uint32_t file_id = PICOC_IMAGE_FILE_TYPE + file;
+	uint8_t sector[PICOC_SECTOR_SIZE];
+
+	if (buffer == NULL) {
+		return -1;
+	}
+
+	memset(buffer, 0, buffer_size);
+
+	for (uint32_t i = 0; i < buffer_size; i += PICOC_SECTOR_SIZE) {
+		if (PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, file_id, i / PICOC_SECTOR_SIZE, (uint8_t *) &sector, PICOC_SECTOR_SIZE) != 0) {
+			break;
+		}
+		uint32_t len = buffer_size - i;
+		memcpy(&buffer[i], sector, (len < PICOC_SECTOR_SIZE) ? len : PICOC_SECTOR_SIZE);
+	}
+	return 0;
+}
+
+/**
+ * compile the source buffer and save the image to flash
+ */
+int32_t save_image(uint8_t file, uint8_t *buffer, uint32_t buffer_size)
+{
+	uint32_t file_id = PICOC_IMAGE_FILE_TYPE + file;
+	uint8_t sector[PICOC_SECTOR_SIZE];
+	int32_t retval = 0;
+
+	if (!compile_file()) {
+		// drop an older image, so it is not loaded with the new source
+		PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, file_id, 0);
+		return -1;
+	}
+
+	uint32_t image_len = picoc_image_len(buffer);
+
+	for (uint32_t i = 0; (i < image_len) && (retval == 0); i += PICOC_SECTOR_SIZE) {
+		uint32_t len = image_len - i;
+		memset(sector, 0, sizeof(sector));
+		memcpy(sector, &buffer[i], (len < PICOC_SECTOR_SIZE) ? len : PICOC_SECTOR_SIZE);
+		retval = PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, file_id, i / PICOC_SECTOR_SIZE, (uint8_t *) &sector, PICOC_SECTOR_SIZE);
+	}
+	return retval;
+}
+
+/**
+ * delete a source file and its image
  */
 int32_t delete_file(uint8_t file)
 {
 	uint32_t file_id = PICOC_SOURCE_FILE_TYPE + file;
 	int32_t retval = PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, file_id, 0);
+	PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, PICOC_IMAGE_FILE_TYPE + file, 0);
 	return retval;
 }
 
@@ -48,6 +48,8 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 
+#include "uavtalk_framer.h"
+
 // ****************
 // Private constants
 
@@ -55,7 +57,7 @@
 #define TASK_PRIORITY     PIOS_THREAD_PRIO_LOW
 #define MAX_RETRIES       2
 #define RETRY_TIMEOUT_MS  20
-#define EVENT_QUEUE_SIZE  10
+#define EVENT_QUEUE_SIZE  20
 #define MAX_PORT_DELAY    200
 #define SERIAL_RX_BUF_LEN 100
 #define PPM_INPUT_TIMEOUT 100
@@ -63,30 +65,52 @@
 // ****************
 // Private types
 
+//! Counters for the frames relayed in one direction
+struct relay_stats {
+	uint32_t frames;
+	uint32_t tx_bytes;
+	uint32_t tx_failures;
+	uint32_t latency_sum;   //!< Sum of the relay latencies in us, wraps
+	uint32_t latency_max;   //!< Largest relay latency in us since the last stats update
+};
+
 typedef struct {
 	// The task handles.
-	struct pios_thread *telemetryTxTaskHandle;
+	struct pios_thread *eventTxTaskHandle;
 	struct pios_thread *telemetryRxTaskHandle;
-	struct pios_thread *radioTxTaskHandle;
 	struct pios_thread *radioRxTaskHandle;
 	struct pios_thread *PPMInputTaskHandle;
-	struct pios_thread *serialRxTaskHandle;
 
 	// The UAVTalk connection on the com side.
 	UAVTalkConnection telemUAVTalkCon;
 	UAVTalkConnection radioUAVTalkCon;
 
-	// Queue handles.
+	// Queue handle.
 	struct pios_queue *uavtalkEventQueue;
-	struct pios_queue *radioEventQueue;
 
-	// The raw serial Rx buffer
+	// The raw serial and radio Rx buffers
 	uint8_t serialRxBuf[SERIAL_RX_BUF_LEN];
+	uint8_t radioRxBuf[SERIAL_RX_BUF_LEN];
+
+	// Frames found on the telemetry and radio streams, the buffers hold
+	// the frames that are split over several reads
+	struct uavtalk_framer telemFramer;
+	struct uavtalk_framer radioFramer;
+	uint8_t telemFrameBuf[UAVTALK_MAX_PACKET_LENGTH];
+	uint8_t radioFrameBuf[UAVTALK_MAX_PACKET_LENGTH];
 
 	// Error statistics.
 	uint32_t telemetryTxRetries;
 	uint32_t radioTxRetries;
 
+	// Relay statistics, from the telemetry port to the radio and back
+	struct relay_stats telemetryRelay;
+	struct relay_stats radioRelay;
+
+	// Relay totals at the last stats update
+	uint32_t statsFrames;
+	uint32_t statsLatencySum;
+
 	// Is this modem the coordinator
 	bool isCoordinator;
 
@@ -97,20 +121,17 @@ typedef struct {
 // ****************
 // Private functions
 
-static void telemetryTxTask(void *parameters);
+static void eventTxTask(void *parameters);
 static void telemetryRxTask(void *parameters);
-static void serialRxTask(void *parameters);
-static void radioTxTask(void *parameters);
 static void radioRxTask(void *parameters);
 static void PPMInputTask(void *parameters);
 static int32_t UAVTalkSendHandler(uint8_t * buf, int32_t length);
 static int32_t RadioSendHandler(uint8_t * buf, int32_t length);
-static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
-				   UAVTalkConnection outConnectionHandle,
-				   uint8_t rxbyte);
-static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
-			       UAVTalkConnection outConnectionHandle,
-			       uint8_t rxbyte);
+static int32_t sendBuffer(uint32_t outputPort, const uint8_t * buf, uint16_t length);
+static void processStream(struct uavtalk_framer *framer, const uint8_t * buf, uint16_t length,
+			  void (*processFrame)(const uint8_t *, uint16_t, uint32_t));
+static void processTelemetryFrame(const uint8_t * frame, uint16_t frame_len, uint32_t rx_time);
+static void processRadioFrame(const uint8_t * frame, uint16_t frame_len, uint32_t rx_time);
 static void objectPersistenceUpdatedCb(UAVObjEvent * objEv);
 static void registerObject(UAVObjHandle obj);
 
@@ -138,13 +159,8 @@ static int32_t RadioComBridgeStart(void)
 				   EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ);
 		UAVObjConnectQueue(UAVObjGetByID(OBJECTPERSISTENCE_OBJID), data->uavtalkEventQueue,
 				   EV_UPDATED | EV_UPDATED_MANUAL);
-		if (data->isCoordinator) {
-			UAVObjConnectQueue(UAVObjGetByID(RFM22BRECEIVER_OBJID), data->radioEventQueue,
-					   EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ);
-		} else {
-			UAVObjConnectQueue(UAVObjGetByID(RFM22BRECEIVER_OBJID), data->uavtalkEventQueue,
-					   EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ);
-		}
+		UAVObjConnectQueue(UAVObjGetByID(RFM22BRECEIVER_OBJID), data->uavtalkEventQueue,
+				   EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ);
 
 		if (data->isCoordinator) {
 			registerObject(RadioComBridgeStatsHandle());
@@ -152,31 +168,22 @@ static int32_t RadioComBridgeStart(void)
 		// Configure the UAVObject callbacks
 		ObjectPersistenceConnectCallback(&objectPersistenceUpdatedCb);
 
-		// Start the primary tasks for receiving/sending UAVTalk packets from the GCS.
-		data->telemetryTxTaskHandle = PIOS_Thread_Create(telemetryTxTask, "telemetryTxTask", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+		// Start the tasks sending objects and relaying the streams in both directions.
+		data->eventTxTaskHandle = PIOS_Thread_Create(eventTxTask, "eventTxTask", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 		data->telemetryRxTaskHandle = PIOS_Thread_Create(telemetryRxTask, "telemetryRxTask", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-			    
+		data->radioRxTaskHandle = PIOS_Thread_Create(radioRxTask, "radioRxTask", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+
 		if (PIOS_PPM_RECEIVER != 0) {
 			data->PPMInputTaskHandle = PIOS_Thread_Create(PPMInputTask, "PPMInputTask",STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 #ifdef PIOS_INCLUDE_WDG
 			PIOS_WDG_RegisterFlag(PIOS_WDG_PPMINPUT);
 #endif
 		}
-		if (!data->parseUAVTalk) {
-			// If the user wants raw serial communication, we need to spawn another thread to handle it.
-			data->serialRxTaskHandle = PIOS_Thread_Create(serialRxTask, "serialRxTask", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-#ifdef PIOS_INCLUDE_WDG
-			PIOS_WDG_RegisterFlag(PIOS_WDG_SERIALRX);
-#endif
-		}
-		data->radioTxTaskHandle = PIOS_Thread_Create(radioTxTask, "radioTxTask", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		data->radioRxTaskHandle = PIOS_Thread_Create(radioRxTask, "radioRxTask", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 
 		// Register the watchdog timers.
 #ifdef PIOS_INCLUDE_WDG
 		PIOS_WDG_RegisterFlag(PIOS_WDG_TELEMETRYTX);
 		PIOS_WDG_RegisterFlag(PIOS_WDG_TELEMETRYRX);
-		PIOS_WDG_RegisterFlag(PIOS_WDG_RADIOTX);
 		PIOS_WDG_RegisterFlag(PIOS_WDG_RADIORX);
 #endif
 		return 0;
@@ -198,6 +205,11 @@ static int32_t RadioComBridgeInitialize(void)
 	if (!data) {
 		return -1;
 	}
+	memset(data, 0, sizeof(*data));
+
+	UAVTalkFramerInit(&data->telemFramer, data->telemFrameBuf, sizeof(data->telemFrameBuf));
+	UAVTalkFramerInit(&data->radioFramer, data->radioFrameBuf, sizeof(data->radioFrameBuf));
+
 	// Initialize the UAVObjects that we use
 	RFM22BStatusInitialize();
 	ObjectPersistenceInitialize();
@@ -208,13 +220,8 @@ static int32_t RadioComBridgeInitialize(void)
 	data->telemUAVTalkCon = UAVTalkInitialize(&UAVTalkSendHandler);
 	data->radioUAVTalkCon = UAVTalkInitialize(&RadioSendHandler);
 
-	// Initialize the queues.
+	// Initialize the queue.
 	data->uavtalkEventQueue = PIOS_Queue_Create(EVENT_QUEUE_SIZE, sizeof(UAVObjEvent));
-	data->radioEventQueue = PIOS_Queue_Create(EVENT_QUEUE_SIZE, sizeof(UAVObjEvent));
-
-	// Initialize the statistics.
-	data->telemetryTxRetries = 0;
-	data->radioTxRetries = 0;
 
 	data->parseUAVTalk = true;
 	PIOS_COM_RADIO = PIOS_COM_RFM22B;
@@ -267,102 +274,105 @@ static void updateRadioComBridgeStats()
 	radioComBridgeStats.TelemetryTxRetries = data->telemetryTxRetries;
 	radioComBridgeStats.RadioTxRetries = data->radioTxRetries;
 
-	// Update stats object
-	radioComBridgeStats.TelemetryTxBytes +=
-	    telemetryUAVTalkStats.txBytes;
-	radioComBridgeStats.TelemetryTxFailures +=
-	    telemetryUAVTalkStats.txErrors;
-
-	radioComBridgeStats.TelemetryRxBytes +=
-	    telemetryUAVTalkStats.rxBytes;
-	radioComBridgeStats.TelemetryRxFailures +=
-	    telemetryUAVTalkStats.rxErrors;
-
-	radioComBridgeStats.RadioTxBytes += radioUAVTalkStats.txBytes;
-	radioComBridgeStats.RadioTxFailures += radioUAVTalkStats.txErrors;
+	// Transmitted data is made of the objects of the modem and the relayed frames
+	radioComBridgeStats.TelemetryTxBytes =
+	    telemetryUAVTalkStats.txBytes + data->radioRelay.tx_bytes;
+	radioComBridgeStats.TelemetryTxFailures =
+	    telemetryUAVTalkStats.txErrors + data->radioRelay.tx_failures;
+
+	radioComBridgeStats.TelemetryRxBytes = data->telemFramer.stats.rx_bytes;
+	radioComBridgeStats.TelemetryRxFailures = telemetryUAVTalkStats.rxErrors;
+	radioComBridgeStats.TelemetryRxSyncErrors = data->telemFramer.stats.sync_errors;
+	radioComBridgeStats.TelemetryRxCrcErrors = data->telemFramer.stats.crc_errors;
+	radioComBridgeStats.TelemetryRelayFrames = data->telemetryRelay.frames;
+
+	radioComBridgeStats.RadioTxBytes =
+	    radioUAVTalkStats.txBytes + data->telemetryRelay.tx_bytes;
+	radioComBridgeStats.RadioTxFailures =
+	    radioUAVTalkStats.txErrors + data->telemetryRelay.tx_failures;
+
+	radioComBridgeStats.RadioRxBytes = data->radioFramer.stats.rx_bytes;
+	radioComBridgeStats.RadioRxFailures = radioUAVTalkStats.rxErrors;
+	radioComBridgeStats.RadioRxSyncErrors = data->radioFramer.stats.sync_errors;
+	radioComBridgeStats.RadioRxCrcErrors = data->radioFramer.stats.crc_errors;
+	radioComBridgeStats.RadioRelayFrames = data->radioRelay.frames;
+
+	// Relay latency of the frames since the last update, in both directions
+	uint32_t frames = data->telemetryRelay.frames + data->radioRelay.frames;
+	uint32_t latency_sum = data->telemetryRelay.latency_sum + data->radioRelay.latency_sum;
+
+	if (frames != data->statsFrames) {
+		radioComBridgeStats.RelayLatencyAvg =
+		    (latency_sum - data->statsLatencySum) / (frames - data->statsFrames);
+	} else {
+		radioComBridgeStats.RelayLatencyAvg = 0;
+	}
+	radioComBridgeStats.RelayLatencyMax =
+	    (data->telemetryRelay.latency_max > data->radioRelay.latency_max) ?
+	    data->telemetryRelay.latency_max : data->radioRelay.latency_max;
 
-	radioComBridgeStats.RadioRxBytes += radioUAVTalkStats.rxBytes;
-	radioComBridgeStats.RadioRxFailures += radioUAVTalkStats.rxErrors;
+	data->statsFrames = frames;
+	data->statsLatencySum = latency_sum;
+	data->telemetryRelay.latency_max = 0;
+	data->radioRelay.latency_max = 0;
 
 	// Update stats object data
 	RadioComBridgeStatsSet(&radioComBridgeStats);
 }
 
 /**
- * @brief Telemetry transmit task, regular priority
+ * @brief Send an object on a UAVTalk connection
  *
- * @param[in] parameters  The task parameters
+ * @param[in] connectionHandle  The connection to send on
+ * @param[in] ev  The event for the object
+ * @return the number of retries needed
  */
-static void telemetryTxTask( __attribute__ ((unused))
-			    void *parameters)
+static uint32_t sendObject(UAVTalkConnection connectionHandle, UAVObjEvent * ev)
 {
-	UAVObjEvent ev;
+	int32_t ret = -1;
+	uint32_t retries = 0;
 
-	// Loop forever
-	while (1) {
-#ifdef PIOS_INCLUDE_WDG
-		PIOS_WDG_UpdateFlag(PIOS_WDG_TELEMETRYTX);
-#endif
-		// Wait for queue message
-		if (PIOS_Queue_Receive(data->uavtalkEventQueue, &ev, MAX_PORT_DELAY)) {
-			if (ev.obj == RadioComBridgeStatsHandle()) {
-				updateRadioComBridgeStats();
-			}
-			// Send update (with retries)
-			int32_t ret = -1;
-			uint32_t retries = 0;
-			while (retries <= MAX_RETRIES && ret == -1) {
-				ret = UAVTalkSendObject(data->telemUAVTalkCon, ev.obj, ev.instId, 0, RETRY_TIMEOUT_MS);
-				if (ret == -1) {
-					++retries;
-				}
-			}
-			// Update stats
-			data->telemetryTxRetries += retries;
+	while (retries <= MAX_RETRIES && ret == -1) {
+		ret = UAVTalkSendObject(connectionHandle, ev->obj, ev->instId, 0, RETRY_TIMEOUT_MS);
+		if (ret == -1) {
+			++retries;
 		}
 	}
+
+	return retries;
 }
 
 /**
- * @brief Radio tx task.  Receive data packets from the com port and send to the radio.
+ * @brief Object transmit task, sends the objects of the modem to the
+ * telemetry port, or for the coordinator the receiver object to the radio.
  *
  * @param[in] parameters  The task parameters
  */
-static void radioTxTask( __attribute__ ((unused))
+static void eventTxTask( __attribute__ ((unused))
 			void *parameters)
 {
+	UAVObjEvent ev;
 
-	// Task loop
+	// Loop forever
 	while (1) {
 #ifdef PIOS_INCLUDE_WDG
-		PIOS_WDG_UpdateFlag(PIOS_WDG_RADIOTX);
+		PIOS_WDG_UpdateFlag(PIOS_WDG_TELEMETRYTX);
 #endif
-
-		// Process the radio event queue, sending UAVObjects over the radio link as necessary.
-		UAVObjEvent ev;
-
 		// Wait for queue message
-		if (PIOS_Queue_Receive(data->radioEventQueue, &ev, 20)) {
-			if ((ev.event == EV_UPDATED)
-			    || (ev.event == EV_UPDATE_REQ)) {
-				// Send update (with retries)
-				int32_t ret = -1;
-				uint32_t retries = 0;
-				while (retries <= MAX_RETRIES && ret == -1) {
-					ret =
-					    UAVTalkSendObject(data->
-							      radioUAVTalkCon,
-							      ev.obj,
-							      ev.instId, 0,
-							      RETRY_TIMEOUT_MS);
-					if (ret == -1) {
-						++retries;
-					}
+		if (PIOS_Queue_Receive(data->uavtalkEventQueue, &ev, MAX_PORT_DELAY)) {
+			if (ev.obj == RadioComBridgeStatsHandle()) {
+				updateRadioComBridgeStats();
+			}
+
+			if (data->isCoordinator && ev.obj == RFM22BReceiverHandle()) {
+				if ((ev.event == EV_UPDATED)
+				    || (ev.event == EV_UPDATE_REQ)) {
+					data->radioTxRetries += sendObject(data->radioUAVTalkCon, &ev);
 				}
-				data->radioTxRetries += retries;
+			} else {
+				data->telemetryTxRetries += sendObject(data->telemUAVTalkCon, &ev);
 			}
 		}
-
 	}
 }
 
@@ -380,37 +390,19 @@ static void radioRxTask( __attribute__ ((unused))
 		PIOS_WDG_UpdateFlag(PIOS_WDG_RADIORX);
 #endif
 		if (PIOS_COM_RADIO) {
-			uint8_t serial_data[1];
 			uint16_t bytes_to_process =
 			    PIOS_COM_ReceiveBuffer(PIOS_COM_RADIO,
-						   serial_data,
-						   sizeof(serial_data),
+						   data->radioRxBuf,
+						   sizeof(data->radioRxBuf),
 						   MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
 				if (data->parseUAVTalk) {
-					// Pass the data through the UAVTalk parser.
-					for (uint8_t i = 0;
-					     i < bytes_to_process; i++) {
-						ProcessRadioStream(data->
-								   radioUAVTalkCon,
-								   data->
-								   telemUAVTalkCon,
-								   serial_data
-								   [i]);
-					}
+					// Relay or receive the complete frames
+					processStream(&data->radioFramer, data->radioRxBuf,
+						      bytes_to_process, processRadioFrame);
 				} else if (PIOS_COM_TELEMETRY) {
 					// Send the data straight to the telemetry port.
-					// Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
-					// It is the caller responsibility to retry in such cases...
-					int32_t ret = -2;
-					uint8_t count = 5;
-					while (count-- > 0 && ret < -1) {
-						ret =
-						    PIOS_COM_SendBufferNonBlocking
-						    (PIOS_COM_TELEMETRY,
-						     serial_data,
-						     bytes_to_process);
-					}
+					sendBuffer(PIOS_COM_TELEMETRY, data->radioRxBuf, bytes_to_process);
 				}
 			}
 		} else {
@@ -420,7 +412,8 @@ static void radioRxTask( __attribute__ ((unused))
 }
 
 /**
- * @brief Receive telemetry from the USB/COM port.
+ * @brief Receive telemetry from the USB/COM port. Without UAVTalk parsing
+ * the data of the telemetry port is sent over the radio link as it is.
  *
  * @param[in] parameters  The task parameters
  */
@@ -429,8 +422,8 @@ static void telemetryRxTask( __attribute__ ((unused))
 {
 	// Task loop
 	while (1) {
-		uint32_t inputPort =
-		    data->parseUAVTalk ? PIOS_COM_TELEMETRY : 0;
+		uint32_t inputPort = PIOS_COM_TELEMETRY;
+		bool parseUAVTalk = data->parseUAVTalk;
 #ifdef PIOS_INCLUDE_WDG
 		PIOS_WDG_UpdateFlag(PIOS_WDG_TELEMETRYRX);
 #endif
@@ -438,24 +431,24 @@ static void telemetryRxTask( __attribute__ ((unused))
 		// Determine output port (USB takes priority over telemetry port)
 		if (PIOS_USB_CheckAvailable(PIOS_COM_TELEM_USB)) {
 			inputPort = PIOS_COM_TELEM_USB;
+			parseUAVTalk = true;
 		}
 #endif /* PIOS_INCLUDE_USB */
-		if (inputPort) {
-			uint8_t serial_data[1];
+		if (inputPort && (parseUAVTalk || PIOS_COM_RADIO)) {
 			uint16_t bytes_to_process =
-			    PIOS_COM_ReceiveBuffer(inputPort, serial_data,
-						   sizeof(serial_data),
+			    PIOS_COM_ReceiveBuffer(inputPort,
+						   data->serialRxBuf,
+						   sizeof(data->serialRxBuf),
 						   MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
-				PIOS_LED_Toggle(PIOS_LED_RX);
-				for (uint8_t i = 0; i < bytes_to_process;
-				     i++) {
-					ProcessTelemetryStream(data->
-							       telemUAVTalkCon,
-							       data->
-							       radioUAVTalkCon,
-							       serial_data
-							       [i]);
+				if (parseUAVTalk) {
+					PIOS_LED_Toggle(PIOS_LED_RX);
+					// Relay or receive the complete frames
+					processStream(&data->telemFramer, data->serialRxBuf,
+						      bytes_to_process, processTelemetryFrame);
+				} else {
+					// Send the data over the radio link.
+					sendBuffer(PIOS_COM_RADIO, data->serialRxBuf, bytes_to_process);
 				}
 			}
 		} else {
@@ -492,46 +485,57 @@ static void PPMInputTask( __attribute__ ((unused))
 }
 
 /**
- * @brief Receive raw serial data from the USB/COM port.
+ * @brief Transmit data buffer to a com port, retrying while the port is busy.
  *
- * @param[in] parameters  The task parameters
+ * @param[in] outputPort The port to send on
+ * @param[in] buf Data buffer to send
+ * @param[in] length Length of buffer
+ * @return negative on failure
+ * @return number of bytes transmitted on success
  */
-static void serialRxTask( __attribute__ ((unused))
-			 void *parameters)
+static int32_t sendBuffer(uint32_t outputPort, const uint8_t * buf, uint16_t length)
 {
-	// Task loop
-	while (1) {
-		uint32_t inputPort = PIOS_COM_TELEMETRY;
-#ifdef PIOS_INCLUDE_WDG
-		PIOS_WDG_UpdateFlag(PIOS_WDG_SERIALRX);
-#endif
-		if (inputPort && PIOS_COM_RADIO) {
-			// Receive some data.
-			uint16_t bytes_to_process =
-			    PIOS_COM_ReceiveBuffer(inputPort,
-						   data->serialRxBuf,
-						   sizeof(data->
-							  serialRxBuf),
-						   MAX_PORT_DELAY);
+	// Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
+	// It is the caller responsibility to retry in such cases...
+	int32_t ret = -2;
+	uint8_t count = 5;
+	while (count-- > 0 && ret < -1) {
+		ret = PIOS_COM_SendBufferNonBlocking(outputPort, buf, length);
+	}
+	return ret;
+}
 
-			if (bytes_to_process > 0) {
-				// Send the data over the radio link.
-				// Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
-				// It is the caller responsibility to retry in such cases...
-				int32_t ret = -2;
-				uint8_t count = 5;
-				while (count-- > 0 && ret < -1) {
-					ret =
-					    PIOS_COM_SendBufferNonBlocking
-					    (PIOS_COM_RADIO,
-					     data->serialRxBuf,
-					     bytes_to_process);
-				}
-			}
-		} else {
-			PIOS_Thread_Sleep(5);
-		}
+/**
+ * @brief Get the port UAVTalk is sent to on the ground side.
+ * @return the port, 0 if there is none
+ */
+static uint32_t telemetryOutputPort(void)
+{
+	uint32_t outputPort = data->parseUAVTalk ? PIOS_COM_TELEMETRY : 0;
+
+#if defined(PIOS_INCLUDE_USB)
+	// Determine output port (USB takes priority over telemetry port)
+	if (PIOS_COM_Available(PIOS_COM_TELEM_USB)) {
+		outputPort = PIOS_COM_TELEM_USB;
+	}
+#endif /* PIOS_INCLUDE_USB */
+
+	return outputPort;
+}
+
+/**
+ * @brief Get the radio port if it can take data.
+ * @return the port, 0 if it is not available
+ */
+static uint32_t radioOutputPort(void)
+{
+	uint32_t outputPort = PIOS_COM_RADIO;
+
+	// Don't send any data unless the radio port is available.
+	if (outputPort && PIOS_COM_Available(outputPort)) {
+		return outputPort;
 	}
+	return 0;
 }
 
 /**
@@ -544,29 +548,13 @@ static void serialRxTask( __attribute__ ((unused))
  */
 static int32_t UAVTalkSendHandler(uint8_t * buf, int32_t length)
 {
-	int32_t ret;
-	uint32_t outputPort = data->parseUAVTalk ? PIOS_COM_TELEMETRY : 0;
+	uint32_t outputPort = telemetryOutputPort();
 
-#if defined(PIOS_INCLUDE_USB)
-	// Determine output port (USB takes priority over telemetry port)
-	if (PIOS_COM_Available(PIOS_COM_TELEM_USB)) {
-		outputPort = PIOS_COM_TELEM_USB;
-	}
-#endif /* PIOS_INCLUDE_USB */
 	if (outputPort) {
-		// Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
-		// It is the caller responsibility to retry in such cases...
-		ret = -2;
-		uint8_t count = 5;
-		while (count-- > 0 && ret < -1) {
-			ret =
-			    PIOS_COM_SendBufferNonBlocking(outputPort, buf,
-							   length);
-		}
+		return sendBuffer(outputPort, buf, length);
 	} else {
-		ret = -1;
+		return -1;
 	}
-	return ret;
 }
 
 /**
@@ -582,146 +570,182 @@ static int32_t RadioSendHandler(uint8_t * buf, int32_t length)
 	if (!data->parseUAVTalk) {
 		return length;
 	}
-	uint32_t outputPort = PIOS_COM_RADIO;
+	uint32_t outputPort = radioOutputPort();
 
-	// Don't send any data unless the radio port is available.
-	if (outputPort && PIOS_COM_Available(outputPort)) {
-		// Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
-		// It is the caller responsibility to retry in such cases...
-		int32_t ret = -2;
-		uint8_t count = 5;
-		while (count-- > 0 && ret < -1) {
-			ret =
-			    PIOS_COM_SendBufferNonBlocking(outputPort, buf,
-							   length);
-		}
-		return ret;
+	if (outputPort) {
+		return sendBuffer(outputPort, buf, length);
 	} else {
 		return -1;
 	}
 }
 
-#define MetaObjectId(x) (x+1)
 /**
- * @brief Process a byte of data received on the telemetry stream
+ * @brief Forward a complete frame as it was received.
  *
- * @param[in] inConnectionHandle  The UAVTalk connection handle on the telemetry port
- * @param[in] outConnectionHandle  The UAVTalk connection handle on the radio port.
- * @param[in] rxbyte  The received byte.
+ * @param[in] outputPort The port to send the frame on, 0 if there is none
+ * @param[in] stats The statistics for this direction
+ * @param[in] frame The frame including its checksum
+ * @param[in] frame_len The length of the frame
+ * @param[in] rx_time Raw time the end of the frame was received
  */
-static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
-				   UAVTalkConnection outConnectionHandle,
-				   uint8_t rxbyte)
+static void relayFrame(uint32_t outputPort, struct relay_stats *stats,
+		       const uint8_t * frame, uint16_t frame_len, uint32_t rx_time)
 {
-	// Keep reading until we receive a completed packet.
-	UAVTalkRxState state =
-	    UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
-
-	if (state == UAVTALK_STATE_COMPLETE) {
-		// We only want to unpack certain telemetry objects
-		uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
-		switch (objId) {
-		case HWTAULINK_OBJID:
-		case RFM22BRECEIVER_OBJID:
-		case MetaObjectId(HWTAULINK_OBJID):
-		case MetaObjectId(RFM22BRECEIVER_OBJID):
-		case MetaObjectId(RFM22BSTATUS_OBJID):
-
-			// These objects are received here and only here
-			UAVTalkReceiveObject(inConnectionHandle);
-			break;
+	if (!outputPort || sendBuffer(outputPort, frame, frame_len) < 0) {
+		stats->tx_failures++;
+		return;
+	}
 
-		case OBJECTPERSISTENCE_OBJID:
-		case MetaObjectId(OBJECTPERSISTENCE_OBJID):
-			// Handle saving settings on modem
-			UAVTalkReceiveObject(inConnectionHandle);
-
-			ObjectPersistenceData objectPersistence;
-			ObjectPersistenceGet(&objectPersistence);
-			if (objectPersistence.ObjectID != HWTAULINK_OBJID &&
-				objectPersistence.ObjectID != MetaObjectId(HWTAULINK_OBJID)) {
-				// relay packet to remote modem except for requests to save
-				// the settings which happens locally
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
-			}
+	uint32_t latency = PIOS_DELAY_DiffuS(rx_time);
 
-			break;
+	stats->frames++;
+	stats->tx_bytes += frame_len;
+	stats->latency_sum += latency;
+	if (latency > stats->latency_max) {
+		stats->latency_max = latency;
+	}
+}
 
-		case RFM22BSTATUS_OBJID:
-		{
-			uint32_t inst_id = UAVTalkGetPacketInstId(inConnectionHandle);
-			if (inst_id == 0) {
-				// dealing with local modem
-				UAVTalkReceiveObject(inConnectionHandle);
-			} else {
-				// for remote modem
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
-			}
-		}
-			break;
-		default:
-			// all other packets are transparently relayed to the remote modem
-			UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
-			break;
+/**
+ * @brief Unpack a frame on a local UAVTalk connection, this also sends
+ * responses for requests and acked objects on that connection.
+ *
+ * @param[in] connectionHandle The UAVTalk connection the frame was received on
+ * @param[in] frame The frame including its checksum
+ * @param[in] frame_len The length of the frame
+ */
+static void receiveFrame(UAVTalkConnection connectionHandle, const uint8_t * frame, uint16_t frame_len)
+{
+	for (uint16_t i = 0; i < frame_len; i++) {
+		UAVTalkProcessInputStream(connectionHandle, frame[i]);
+	}
+}
+
+/**
+ * @brief Split data received from a port into frames and process them.
+ *
+ * @param[in] framer The framer for the port
+ * @param[in] buf The received data
+ * @param[in] length Number of bytes received
+ * @param[in] processFrame Called for each complete frame
+ */
+static void processStream(struct uavtalk_framer *framer, const uint8_t * buf, uint16_t length,
+			  void (*processFrame)(const uint8_t *, uint16_t, uint32_t))
+{
+	uint32_t rx_time = PIOS_DELAY_GetRaw();
+
+	while (length > 0) {
+		const uint8_t *frame;
+		uint16_t frame_len;
+		uint16_t used = UAVTalkFramerProcess(framer, buf, length, &frame, &frame_len);
+
+		buf += used;
+		length -= used;
+
+		if (frame) {
+			processFrame(frame, frame_len, rx_time);
 		}
 	}
 }
 
+#define MetaObjectId(x) (x+1)
 /**
- * @brief Process a byte of data received on the radio data stream.
+ * @brief Process a frame received on the telemetry stream
  *
- * @param[in] inConnectionHandle  The UAVTalk connection handle on the radio port.
- * @param[in] outConnectionHandle  The UAVTalk connection handle on the telemetry port.
- * @param[in] rxbyte  The received byte.
+ * @param[in] frame The frame including its checksum
+ * @param[in] frame_len The length of the frame
+ * @param[in] rx_time Raw time the end of the frame was received
  */
-static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
-			       UAVTalkConnection outConnectionHandle,
-			       uint8_t rxbyte)
+static void processTelemetryFrame(const uint8_t * frame, uint16_t frame_len, uint32_t rx_time)
 {
-	// Keep reading until we receive a completed packet.
-	UAVTalkRxState state =
-	    UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
-
-	if (state == UAVTALK_STATE_COMPLETE) {
-		// We only want to unpack certain objects from the remote modem
-		// Similarly we only want to relay certain objects to the telemetry port
-		uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
-		switch (objId) {
-		case HWTAULINK_OBJID:
-		case MetaObjectId(RFM22BSTATUS_OBJID):
-		case MetaObjectId(HWTAULINK_OBJID):
-			// Ignore object...
-			// These objects are shadowed by the modem and are not transmitted to the telemetry port
-			// - RFM22BSTATUS_OBJID : ground station will receive the OPLM link status instead
-			// - HWTAULINK_OBJID : ground station will read and write the OPLM settings instead
-			break;
-		case RFM22BRECEIVER_OBJID:
-		case MetaObjectId(RFM22BRECEIVER_OBJID):
-			// Receive object locally
-			// These objects are received by the modem and are not transmitted to the telemetry port
-			// - RFM22BRECEIVER_OBJID : sent periodically from flight controller, not needed to echo
-			// some objects will send back a response to the remote modem
-			UAVTalkReceiveObject(inConnectionHandle);
-			break;
-		case RFM22BSTATUS_OBJID:
-		{
-			uint32_t inst_id = UAVTalkGetPacketInstId(inConnectionHandle);
-			if (inst_id == 0) {
-				// instance 0 is from modem. do not pass this version
-			} else {
-				// for remote modem
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
-			}
+	// We only want to unpack certain telemetry objects
+	uint32_t objId = UAVTalkFramerObjId(frame);
+	switch (objId) {
+	case HWTAULINK_OBJID:
+	case RFM22BRECEIVER_OBJID:
+	case MetaObjectId(HWTAULINK_OBJID):
+	case MetaObjectId(RFM22BRECEIVER_OBJID):
+	case MetaObjectId(RFM22BSTATUS_OBJID):
+
+		// These objects are received here and only here
+		receiveFrame(data->telemUAVTalkCon, frame, frame_len);
+		break;
+
+	case OBJECTPERSISTENCE_OBJID:
+	case MetaObjectId(OBJECTPERSISTENCE_OBJID):
+	{
+		// Handle saving settings on modem
+		receiveFrame(data->telemUAVTalkCon, frame, frame_len);
+
+		ObjectPersistenceData objectPersistence;
+		ObjectPersistenceGet(&objectPersistence);
+		if (objectPersistence.ObjectID != HWTAULINK_OBJID &&
+			objectPersistence.ObjectID != MetaObjectId(HWTAULINK_OBJID)) {
+			// relay packet to remote modem except for requests to save
+			// the settings which happens locally
+			relayFrame(radioOutputPort(), &data->telemetryRelay, frame, frame_len, rx_time);
+		}
+	}
+		break;
 
+	case RFM22BSTATUS_OBJID:
+		if (UAVTalkFramerInstId(frame, frame_len) == 0) {
+			// dealing with local modem
+			receiveFrame(data->telemUAVTalkCon, frame, frame_len);
+		} else {
+			// for remote modem
+			relayFrame(radioOutputPort(), &data->telemetryRelay, frame, frame_len, rx_time);
 		}
-			break;
+		break;
+	default:
+		// all other packets are transparently relayed to the remote modem
+		relayFrame(radioOutputPort(), &data->telemetryRelay, frame, frame_len, rx_time);
+		break;
+	}
+}
 
-		default:
-			// all other packets are relayed to the telemetry port
-			UAVTalkRelayPacket(inConnectionHandle,
-					   outConnectionHandle);
-			break;
+/**
+ * @brief Process a frame received on the radio data stream.
+ *
+ * @param[in] frame The frame including its checksum
+ * @param[in] frame_len The length of the frame
+ * @param[in] rx_time Raw time the end of the frame was received
+ */
+static void processRadioFrame(const uint8_t * frame, uint16_t frame_len, uint32_t rx_time)
+{
+	// We only want to unpack certain objects from the remote modem
+	// Similarly we only want to relay certain objects to the telemetry port
+	uint32_t objId = UAVTalkFramerObjId(frame);
+	switch (objId) {
+	case HWTAULINK_OBJID:
+	case MetaObjectId(RFM22BSTATUS_OBJID):
+	case MetaObjectId(HWTAULINK_OBJID):
+		// Ignore object...
+		// These objects are shadowed by the modem and are not transmitted to the telemetry port
+		// - RFM22BSTATUS_OBJID : ground station will receive the OPLM link status instead
+		// - HWTAULINK_OBJID : ground station will read and write the OPLM settings instead
+		break;
+	case RFM22BRECEIVER_OBJID:
+	case MetaObjectId(RFM22BRECEIVER_OBJID):
+		// Receive object locally
+		// These objects are received by the modem and are not transmitted to the telemetry port
+		// - RFM22BRECEIVER_OBJID : sent periodically from flight controller, not needed to echo
+		// some objects will send back a response to the remote modem
+		receiveFrame(data->radioUAVTalkCon, frame, frame_len);
+		break;
+	case RFM22BSTATUS_OBJID:
+		if (UAVTalkFramerInstId(frame, frame_len) == 0) {
+			// instance 0 is from modem. do not pass this version
+		} else {
+			// for remote modem
+			relayFrame(telemetryOutputPort(), &data->radioRelay, frame, frame_len, rx_time);
 		}
+		break;
+
+	default:
+		// all other packets are relayed to the telemetry port
+		relayFrame(telemetryOutputPort(), &data->radioRelay, frame, frame_len, rx_time);
+		break;
 	}
 }
 
@@ -0,0 +1,63 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup RadioComBridgeModule Com Port to Radio Bridge Module
+ * @{
+ *
+ * @file       uavtalk_framer.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Finds complete UAVTalk frames in a byte stream
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVTALK_FRAMER_H
+#define UAVTALK_FRAMER_H
+
+#include <stdint.h>
+
+//! Counters kept by a framer
+struct uavtalk_framer_stats {
+	uint32_t rx_bytes;      //!< Bytes passed to the framer
+	uint32_t frames;        //!< Complete frames with a valid checksum
+	uint32_t sync_errors;   //!< Sync bytes followed by an invalid type or size
+	uint32_t crc_errors;    //!< Frames dropped because of their checksum
+};
+
+//! State of a framer, owned by the task reading the stream
+struct uavtalk_framer {
+	uint8_t *buf;           //!< Holds frames which span several reads
+	uint16_t buf_size;
+	uint16_t rx_len;        //!< Bytes of the current frame in buf
+	uint16_t frame_len;     //!< Length of the current frame, 0 until its header is complete
+	struct uavtalk_framer_stats stats;
+};
+
+void UAVTalkFramerInit(struct uavtalk_framer *framer, uint8_t *buf, uint16_t buf_size);
+uint16_t UAVTalkFramerProcess(struct uavtalk_framer *framer, const uint8_t *data, uint16_t len,
+			      const uint8_t **frame, uint16_t *frame_len);
+uint32_t UAVTalkFramerObjId(const uint8_t *frame);
+uint16_t UAVTalkFramerInstId(const uint8_t *frame, uint16_t frame_len);
+
+#endif /* UAVTALK_FRAMER_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,207 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup RadioComBridgeModule Com Port to Radio Bridge Module
+ * @{
+ *
+ * @file       uavtalk_framer.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Finds complete UAVTalk frames in a byte stream
+ *
+ * A relay only needs to know where a frame starts and ends and that it
+ * arrived intact. Every UAVTalk header carries the length of the frame, so
+ * unlike the full parser in uavtalk.c this does not have to look up the
+ * object, and frames of objects unknown to this board are found just as
+ * well. Frames which are completely contained in the data read from a port
+ * are handed out in place, only frames split over several reads are copied.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "uavtalk_priv.h"
+#include "uavtalk_framer.h"
+
+// Sync, type and size, enough to know the length of the frame
+#define FRAMER_SIZE_END   4
+// Offset of the instance id in the frames of multi instance objects
+#define FRAMER_INSTID     UAVTALK_MIN_HEADER_LENGTH
+
+/**
+ * Check the start of a frame and get its total length
+ * @param[in] hdr The first FRAMER_SIZE_END bytes of the frame
+ * @param[out] frame_len Length of the frame including the checksum
+ * @return true if this looks like the start of a frame
+ */
+static bool framer_frame_len(const struct uavtalk_framer *framer, const uint8_t *hdr, uint16_t *frame_len)
+{
+	if ((hdr[1] & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER)
+		return false;
+
+	uint16_t size = hdr[2] | (hdr[3] << 8);
+	if (size < UAVTALK_MIN_HEADER_LENGTH || size + UAVTALK_CHECKSUM_LENGTH > framer->buf_size)
+		return false;
+
+	*frame_len = size + UAVTALK_CHECKSUM_LENGTH;
+	return true;
+}
+
+static bool framer_crc_valid(struct uavtalk_framer *framer, const uint8_t *frame, uint16_t frame_len)
+{
+	uint16_t size = frame_len - UAVTALK_CHECKSUM_LENGTH;
+
+	if (PIOS_CRC_updateCRC(0, frame, size) != frame[size]) {
+		framer->stats.crc_errors++;
+		return false;
+	}
+
+	framer->stats.frames++;
+	return true;
+}
+
+/**
+ * Initialize a framer
+ * @param[in] buf Buffer for frames split over several reads, this limits the
+ * largest frame that is accepted
+ * @param[in] buf_size Size of the buffer, normally UAVTALK_MAX_PACKET_LENGTH
+ */
+void UAVTalkFramerInit(struct uavtalk_framer *framer, uint8_t *buf, uint16_t buf_size)
+{
+	memset(framer, 0, sizeof(*framer));
+	framer->buf = buf;
+	framer->buf_size = buf_size;
+}
+
+/**
+ * Consume data from a stream up to the end of the next complete frame.
+ * Call again with the remaining data until all of it is consumed.
+ *
+ * @param[in] data Data read from the stream
+ * @param[in] len Number of bytes in data
+ * @param[out] frame Set to the complete frame, or NULL if the data ended
+ * before one was found. The frame either points into data or into the
+ * framer buffer and is only valid until the next call.
+ * @param[out] frame_len Length of the frame, including its checksum
+ * @return number of bytes of data consumed
+ */
+uint16_t UAVTalkFramerProcess(struct uavtalk_framer *framer, const uint8_t *data, uint16_t len,
+			      const uint8_t **frame, uint16_t *frame_len)
+{
+	uint16_t i = 0;
+
+	*frame = NULL;
+
+	while (i < len) {
+		if (framer->rx_len == 0) {
+			// Look for the start of a frame
+			if (data[i] != UAVTALK_SYNC_VAL) {
+				i++;
+				continue;
+			}
+
+			if (len - i >= FRAMER_SIZE_END) {
+				uint16_t n;
+
+				if (!framer_frame_len(framer, &data[i], &n)) {
+					framer->stats.sync_errors++;
+					i++;
+					continue;
+				}
+
+				if (len - i >= n) {
+					// The whole frame is here, no need to copy it
+					if (framer_crc_valid(framer, &data[i], n)) {
+						*frame = &data[i];
+						*frame_len = n;
+						i += n;
+						break;
+					}
+
+					i++;
+					continue;
+				}
+
+				framer->frame_len = n;
+			}
+		}
+
+		// The frame continues in the next read, collect it in the buffer
+		if (framer->frame_len == 0) {
+			framer->buf[framer->rx_len++] = data[i++];
+
+			if (framer->rx_len == FRAMER_SIZE_END &&
+			    !framer_frame_len(framer, framer->buf, &framer->frame_len)) {
+				framer->stats.sync_errors++;
+				framer->rx_len = 0;
+			}
+			continue;
+		}
+
+		uint16_t copy = framer->frame_len - framer->rx_len;
+		if (copy > len - i)
+			copy = len - i;
+
+		memcpy(&framer->buf[framer->rx_len], &data[i], copy);
+		framer->rx_len += copy;
+		i += copy;
+
+		if (framer->rx_len < framer->frame_len)
+			continue;
+
+		uint16_t n = framer->frame_len;
+		framer->rx_len = 0;
+		framer->frame_len = 0;
+
+		if (framer_crc_valid(framer, framer->buf, n)) {
+			*frame = framer->buf;
+			*frame_len = n;
+			break;
+		}
+	}
+
+	framer->stats.rx_bytes += i;
+
+	return i;
+}
+
+/**
+ * Get the object id of a frame
+ */
+uint32_t UAVTalkFramerObjId(const uint8_t *frame)
+{
+	return frame[4] | (frame[5] << 8) | (frame[6] << 16) | ((uint32_t) frame[7] << 24);
+}
+
+/**
+ * Get the instance id of a frame of a multi instance object
+ * @return the instance id, 0 if the frame is too short to carry one
+ */
+uint16_t UAVTalkFramerInstId(const uint8_t *frame, uint16_t frame_len)
+{
+	if (frame_len < FRAMER_INSTID + 2 + UAVTALK_CHECKSUM_LENGTH)
+		return 0;
+
+	return frame[FRAMER_INSTID] | (frame[FRAMER_INSTID + 1] << 8);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -34,6 +34,7 @@
 #include "physical_constants.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "latencytrace.h"
 
 // UAVOs
 #include "accels.h"
@@ -198,6 +199,8 @@ static void SensorsTask(void *parameters)
 			continue;
 		}
 
+		LATENCY_TRACE(LATENCY_TRACE_SENSOR_READ);
+
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
 		if (queue == NULL || PIOS_Queue_Receive(queue, &accels, 0) == false) {
 			//If no new accels data is ready, reuse the latest sample
@@ -33,8 +33,10 @@
 #include "openpilot.h"
 #include "physical_constants.h"
 #include "pios_thread.h"
+#include "pios_queue.h"
 
 #include "accels.h"
+#include "actuatorcommand.h"
 #include "actuatordesired.h"
 #include "airspeedactual.h"
 #include "attitudeactual.h"
@@ -60,6 +62,13 @@
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
 #define SENSOR_PERIOD 2
 
+#if defined(PIOS_INCLUDE_SIL)
+//! Longest simulation time to wait for the control loop to answer a SIL step
+#define SIL_ACTUATOR_TIMEOUT_MS 20
+//! Simulation time after which the lower priority tasks get a tick to run
+#define SIL_BACKGROUND_PERIOD_US 10000
+#endif /* PIOS_INCLUDE_SIL */
+
 // Private types
 
 // Private variables
@@ -72,6 +81,9 @@ static void simulateModelAgnostic();
 static void simulateModelQuadcopter();
 static void simulateModelAirplane();
 static void simulateModelCar();
+#if defined(PIOS_INCLUDE_SIL)
+static void simulateLockstep();
+#endif /* PIOS_INCLUDE_SIL */
 
 static void magOffsetEstimation(MagnetometerData *mag);
 
@@ -143,6 +155,13 @@ static void SensorsTask(void *parameters)
 
 
 	PIOS_SENSORS_SetMaxGyro(500);
+
+#if defined(PIOS_INCLUDE_SIL)
+	// The model runs in the GCS, which also sets the pace
+	if (PIOS_SIL_Enabled())
+		simulateLockstep();
+#endif /* PIOS_INCLUDE_SIL */
+
 	// Main task loop
 	while (1) {
 		PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
@@ -535,6 +554,130 @@ static void simulateModelQuadcopter()
 	AttitudeSimulatedSet(&attitudeSimulated);
 }
 
+#if defined(PIOS_INCLUDE_SIL)
+/**
+ * Take the sensors from the SIL link and answer each step with the outputs
+ * the control loop computed from them.
+ *
+ * The sensors are published as they arrive, the attitude, stabilization and
+ * actuator modules then run from the resulting update events. The step is
+ * answered once ActuatorCommand is updated. Nothing else runs while the GCS
+ * computes the next step, except that every SIL_BACKGROUND_PERIOD_US of
+ * simulation time the lower priority tasks such as telemetry get a tick.
+ *
+ * All the waits here are in simulation time: the tick only advances with
+ * the sensor frames, or from the idle thread when every task is waiting.
+ */
+static void simulateLockstep()
+{
+	struct sil_sensor_frame sensors;
+	struct sil_actuator_frame actuators;
+	uint32_t background_time = 0;
+
+	struct pios_queue *queue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
+	ActuatorCommandConnectQueue(queue);
+
+	while (1) {
+		PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
+
+		if (PIOS_SIL_ReceiveSensors(&sensors) != 0)
+			continue;
+
+		// Drop an update left over from a step that timed out
+		UAVObjEvent ev;
+		PIOS_Queue_Receive(queue, &ev, 0);
+
+		if (sensors.updated & SIL_UPDATED_MAG) {
+			MagnetometerData mag;
+			mag.x = sensors.mag[0];
+			mag.y = sensors.mag[1];
+			mag.z = sensors.mag[2];
+			magOffsetEstimation(&mag);
+			MagnetometerSet(&mag);
+		}
+
+		if (sensors.updated & SIL_UPDATED_BARO) {
+			BaroAltitudeData baroAltitude;
+			BaroAltitudeGet(&baroAltitude);
+			baroAltitude.Altitude = sensors.baro_altitude;
+			BaroAltitudeSet(&baroAltitude);
+		}
+
+		if (sensors.updated & SIL_UPDATED_AIRSPEED) {
+			BaroAirspeedData baroAirspeed;
+			BaroAirspeedGet(&baroAirspeed);
+			baroAirspeed.BaroConnected = BAROAIRSPEED_BAROCONNECTED_TRUE;
+			baroAirspeed.CalibratedAirspeed = sensors.airspeed;
+			BaroAirspeedSet(&baroAirspeed);
+		}
+
+		if (sensors.updated & SIL_UPDATED_GPS) {
+			GPSPositionData gpsPosition;
+			GPSPositionGet(&gpsPosition);
+			gpsPosition.Latitude = sensors.latitude;
+			gpsPosition.Longitude = sensors.longitude;
+			gpsPosition.Altitude = sensors.altitude;
+			gpsPosition.Groundspeed = sqrtf(sensors.velocity[0] * sensors.velocity[0] +
+			                                sensors.velocity[1] * sensors.velocity[1]);
+			gpsPosition.Heading = RAD2DEG * atan2f(sensors.velocity[1], sensors.velocity[0]);
+			gpsPosition.Satellites = 7;
+			gpsPosition.PDOP = 1;
+			gpsPosition.Accuracy = 3.0;
+			gpsPosition.Status = GPSPOSITION_STATUS_FIX3D;
+			GPSPositionSet(&gpsPosition);
+
+			GPSVelocityData gpsVelocity;
+			GPSVelocityGet(&gpsVelocity);
+			gpsVelocity.North = sensors.velocity[0];
+			gpsVelocity.East = sensors.velocity[1];
+			gpsVelocity.Down = sensors.velocity[2];
+			gpsVelocity.Accuracy = 0.75;
+			GPSVelocitySet(&gpsVelocity);
+		}
+
+		// Accels before gyros, the attitude filter runs when both arrived
+		AccelsData accelsData; // Skip get as we set all the fields
+		accelsData.x = sensors.accel[0];
+		accelsData.y = sensors.accel[1];
+		accelsData.z = sensors.accel[2];
+		accelsData.temperature = 30;
+		AccelsSet(&accelsData);
+
+		GyrosData gyrosData; // Skip get as we set all the fields
+		gyrosData.x = sensors.gyro[0];
+		gyrosData.y = sensors.gyro[1];
+		gyrosData.z = sensors.gyro[2];
+		gyrosData.temperature = 30;
+		GyrosSet(&gyrosData);
+
+		// Wait for the control loop to finish this step
+		PIOS_Queue_Receive(queue, &ev, SIL_ACTUATOR_TIMEOUT_MS);
+
+		FlightStatusData flightStatus;
+		FlightStatusGet(&flightStatus);
+		ActuatorDesiredData actuatorDesired;
+		ActuatorDesiredGet(&actuatorDesired);
+		ActuatorCommandData actuatorCommand;
+		ActuatorCommandGet(&actuatorCommand);
+
+		actuators.armed = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED;
+		actuators.roll = actuatorDesired.Roll;
+		actuators.pitch = actuatorDesired.Pitch;
+		actuators.yaw = actuatorDesired.Yaw;
+		actuators.throttle = actuatorDesired.Throttle;
+		for (uint32_t i = 0; i < SIL_ACTUATOR_CHANNELS; i++)
+			actuators.channel[i] = actuatorCommand.Channel[i];
+
+		PIOS_SIL_SendActuators(&actuators);
+
+		if (sensors.time_us - background_time >= SIL_BACKGROUND_PERIOD_US) {
+			background_time = sensors.time_us;
+			PIOS_Thread_Sleep(1);
+		}
+	}
+}
+#endif /* PIOS_INCLUDE_SIL */
+
 /**
  * This method performs a simple simulation of an airplane
  * 
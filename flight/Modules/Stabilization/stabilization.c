@@ -40,6 +40,7 @@
 #include "stabilization.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "latencytrace.h"
 
 #include "accels.h"
 #include "actuatordesired.h"
@@ -742,6 +743,8 @@ static void stabilizationTask(void* parameters)
 		actuatorDesired.UpdateTime = dT * 1000;
 		actuatorDesired.Throttle = stabDesired.Throttle;
 
+		LATENCY_TRACE(LATENCY_TRACE_STABILIZATION_PID);
+
 		if(flightStatus.FlightMode != FLIGHTSTATUS_FLIGHTMODE_MANUAL) {
 			ActuatorDesiredSet(&actuatorDesired);
 		} else {
@@ -34,6 +34,7 @@
 #include "sanitycheck.h"
 #include "objectpersistence.h"
 #include "flightstatus.h"
+#include "heapledger.h"
 #include "manualcontrolsettings.h"
 #include "rfm22bstatus.h"
 #include "stabilizationsettings.h"
@@ -43,9 +44,14 @@
 #include "taskinfo.h"
 #include "watchdogstatus.h"
 #include "taskmonitor.h"
+#include "latencytrace.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+#include "pios_flashfs_logfs_priv.h"
+#endif
+
 //#define DEBUG_THIS_FILE
 
 #if defined(PIOS_INCLUDE_DEBUG_CONSOLE) && defined(DEBUG_THIS_FILE)
@@ -57,6 +63,7 @@
 // Private constants
 #define SYSTEM_UPDATE_PERIOD_MS 1000
 #define LED_BLINK_RATE_HZ 5
+#define SETTINGS_GC_STEPS 4
 
 #ifndef IDLE_COUNTS_PER_SEC_AT_NO_LOAD
 #define IDLE_COUNTS_PER_SEC_AT_NO_LOAD 995998	// calibrated by running tests/test_cpuload.c
@@ -96,6 +103,9 @@ static void updateRfm22bStats();
 #if defined(WDG_STATS_DIAGNOSTICS)
 static void updateWDGstats();
 #endif
+#if defined(DIAG_HEAP)
+static void updateHeapLedger();
+#endif
 /**
  * Create the module task.
  * \returns 0 on success or -1 if initialization failed
@@ -127,6 +137,12 @@ int32_t SystemModInitialize(void)
 #if defined(DIAG_TASKS)
 	TaskInfoInitialize();
 #endif
+#if defined(DIAG_LATENCY)
+	LatencyTraceInitialize();
+#endif
+#if defined(DIAG_HEAP)
+	HeapLedgerInitialize();
+#endif
 #if defined(WDG_STATS_DIAGNOSTICS)
 	WatchdogStatusInitialize();
 #endif
@@ -207,6 +223,16 @@ static void systemTask(void *parameters)
 		TaskMonitorUpdateAll();
 #endif
 
+#if defined(DIAG_LATENCY)
+		// Publish the control path latency histograms
+		LatencyTraceUpdate();
+#endif
+
+#if defined(DIAG_HEAP)
+		// Update the heap allocation ledger
+		updateHeapLedger();
+#endif
+
 		// Flash the heartbeat LED
 #if defined(PIOS_LED_HEARTBEAT)
 		PIOS_LED_Toggle(PIOS_LED_HEARTBEAT);
@@ -227,6 +253,14 @@ static void systemTask(void *parameters)
 		FlightStatusData flightStatus;
 		FlightStatusGet(&flightStatus);
 
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+		// Collect settings garbage a little at a time while it is safe to stall on flash
+		if (flightStatus.Armed == FLIGHTSTATUS_ARMED_DISARMED) {
+			extern uintptr_t pios_uavo_settings_fs_id;
+			PIOS_FLASHFS_Logfs_Background_GC(pios_uavo_settings_fs_id, SETTINGS_GC_STEPS);
+		}
+#endif
+
 		UAVObjEvent ev;
 		int delayTime = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED ?
 			SYSTEM_UPDATE_PERIOD_MS / (LED_BLINK_RATE_HZ * 2) :
@@ -356,6 +390,48 @@ static void updateWDGstats()
 }
 #endif
 
+/**
+ * Called periodically to publish the heap allocation ledger
+ */
+#if defined(DIAG_HEAP)
+static void updateHeapLedger()
+{
+	HeapLedgerData ledger;
+	struct pios_heap_ledger_entry entry;
+
+	for (uint8_t i = 0; i < HEAPLEDGER_CALLER_NUMELEM; i++) {
+		if (!PIOS_heap_get_ledger_entry(i, &entry))
+			memset(&entry, 0, sizeof(entry));
+
+		ledger.Caller[i] = entry.caller;
+		ledger.Bytes[i] = entry.bytes;
+		ledger.Allocations[i] = entry.allocations;
+		switch (entry.region) {
+		case PIOS_HEAP_REGION_FAST:
+			ledger.Region[i] = HEAPLEDGER_REGION_FAST;
+			break;
+		case PIOS_HEAP_REGION_MIXED:
+			ledger.Region[i] = HEAPLEDGER_REGION_MIXED;
+			break;
+		default:
+			ledger.Region[i] = HEAPLEDGER_REGION_STANDARD;
+			break;
+		}
+		if (entry.dma_mixed)
+			ledger.DMA[i] = HEAPLEDGER_DMA_MIXED;
+		else
+			ledger.DMA[i] = entry.no_dma ?
+				HEAPLEDGER_DMA_NOTREQUIRED : HEAPLEDGER_DMA_REQUIRED;
+	}
+
+	ledger.StandardRemaining = PIOS_heap_get_free_size();
+	ledger.FastRemaining = PIOS_heap_get_free_size_no_dma();
+	ledger.AlignmentPadding = PIOS_heap_get_padding();
+
+	HeapLedgerSet(&ledger);
+}
+#endif
+
 static void updateRfm22bStats() {
 	#if defined(PIOS_INCLUDE_RFM22B)
 
@@ -595,6 +671,11 @@ void vApplicationIdleHook(void)
 		idleCounter = 0;
 		idleCounterClear = 0;
 	}
+
+#if defined(PIOS_INCLUDE_SIL)
+	// Nothing else advances the tick while a SIL step waits
+	PIOS_SIL_Idle();
+#endif /* PIOS_INCLUDE_SIL */
 }
 
 /**
@@ -51,7 +51,11 @@
 // Private functions
 
 static void uavoMavlinkBridgeTask(void *parameters);
-static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
+static void send_extended_status(void);
+static void send_rc_channels(void);
+static void send_position(void);
+static void send_extra1(void);
+static void send_extra2(void);
 
 // ****************
 // Private constants
@@ -63,7 +67,21 @@ static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
 #endif
 
 #define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
-#define TASK_RATE_HZ				10
+
+/* Streams whose sources did not change are still sent this often, which
+ * also keeps the heartbeat going */
+#define STREAM_REFRESH_MS           1000
+
+/* Sources only listen to update requests, which are rare, while all the
+ * streams they feed are waiting to be sent anyway */
+#define EV_MASK_MUTED               EV_UPDATE_REQ
+#define EV_MASK_LISTEN              (EV_UPDATED | EV_UPDATED_MANUAL | EV_UNPACKED)
+
+#define MAX_SOURCES                 10
+
+/* Sources keep posting until the task got around to muting them, so leave
+ * room for a couple of events from each of them */
+#define MAX_QUEUE_SIZE              (MAX_SOURCES * 2)
 
 static const uint8_t mav_rates[] =
 	 { [MAV_DATA_STREAM_RAW_SENSORS]=0x02, //2Hz
@@ -75,6 +93,27 @@ static const uint8_t mav_rates[] =
 
 #define MAXSTREAMS sizeof(mav_rates)
 
+static void (* const stream_senders[MAXSTREAMS])(void) =
+	 { [MAV_DATA_STREAM_EXTENDED_STATUS]=send_extended_status,
+	   [MAV_DATA_STREAM_RC_CHANNELS]=send_rc_channels,
+	   [MAV_DATA_STREAM_POSITION]=send_position,
+	   [MAV_DATA_STREAM_EXTRA1]=send_extra1,
+	   [MAV_DATA_STREAM_EXTRA2]=send_extra2 };
+
+#define STREAM(x) (1 << (x))
+
+// ****************
+// Private types
+
+/**
+ * An object the streams are encoded from
+ */
+struct stream_source {
+	UAVObjHandle obj;
+	uint16_t streams;       //!< Streams encoded (partly) from this object
+	bool muted;
+};
+
 // ****************
 // Private variables
 
@@ -84,12 +123,27 @@ static uint32_t mavlink_port;
 
 static bool module_enabled = false;
 
-static uint8_t * stream_ticks;
+static struct pios_queue *queue;
+
+static struct stream_source sources[MAX_SOURCES];
+
+static uint8_t num_sources;
+
+/* Streams with source data that changed since they were last sent */
+static uint16_t dirty_streams;
+
+/* Streams encoded since the serial buffer was last written out */
+static uint16_t sent_streams;
+
+static uint32_t * stream_last_sent;
 
 static mavlink_message_t mavMsg;
 
+/* Messages are collected here and written to the port together */
 static uint8_t * serial_buf;
 
+static uint16_t serial_len;
+
 static void updateSettings();
 
 /**
@@ -126,10 +180,10 @@ static int32_t uavoMavlinkBridgeInitialize(void) {
 		updateSettings();
 
 		serial_buf = PIOS_malloc(MAVLINK_MAX_PACKET_LEN);
-		stream_ticks = PIOS_malloc(MAXSTREAMS);
-		for (int x = 0; x < MAXSTREAMS; ++x) {
-			stream_ticks[x] = (TASK_RATE_HZ / mav_rates[x]);
-		}
+		stream_last_sent = PIOS_malloc(MAXSTREAMS * sizeof(*stream_last_sent));
+		queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+		if (serial_buf == NULL || stream_last_sent == NULL || queue == NULL)
+			module_enabled = false;
 	} else {
 		module_enabled = false;
 	}
@@ -138,382 +192,470 @@ static int32_t uavoMavlinkBridgeInitialize(void) {
 MODULE_INITCALL( uavoMavlinkBridgeInitialize, uavoMavlinkBridgeStart)
 
 /**
- * Main task. It does not return.
+ * Subscribe to an object the given streams are encoded from
  */
+static void add_source(UAVObjHandle obj, uint16_t streams)
+{
+	if (obj == NULL || num_sources >= NELEMENTS(sources))
+		return;
 
-static void uavoMavlinkBridgeTask(void *parameters) {
-	FlightBatterySettingsData batSettings;
-	FlightBatteryStateData batState;
-	GPSPositionData gpsPosData;
-	ManualControlCommandData manualState;
-	AttitudeActualData attActual;
-	AirspeedActualData airspeedActual;
-	ActuatorDesiredData actDesired;
-	FlightStatusData flightStatus;
-	SystemStatsData systemStats;
-	HomeLocationData homeLocation;
-	BaroAltitudeData baroAltitude;
+	sources[num_sources].obj = obj;
+	sources[num_sources].streams = streams;
+	sources[num_sources].muted = false;
+	num_sources++;
 
-	if (FlightBatterySettingsHandle() != NULL )
-		FlightBatterySettingsGet(&batSettings);
-	else {
-		batSettings.Capacity = 0;
-		batSettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_CURRENT] = 0;
-		batSettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_VOLTAGE] = 0;
-		batSettings.VoltageThresholds[FLIGHTBATTERYSETTINGS_VOLTAGETHRESHOLDS_WARNING] = 0;
-		batSettings.VoltageThresholds[FLIGHTBATTERYSETTINGS_VOLTAGETHRESHOLDS_ALARM] = 0;
-		batSettings.VoltagePin = FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE;
-		batSettings.CurrentPin = FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE;
-	}
+	UAVObjConnectQueue(obj, queue, EV_MASK_LISTEN);
+}
 
-	if (GPSPositionHandle() == NULL ){
-		gpsPosData.Altitude = 0;
-		gpsPosData.GeoidSeparation = 0;
-		gpsPosData.Groundspeed = 0;
-		gpsPosData.HDOP = 0;
-		gpsPosData.Heading = 0;
-		gpsPosData.Latitude = 0;
-		gpsPosData.Longitude = 0;
-		gpsPosData.PDOP = 0;
-		gpsPosData.Satellites = 0;
-		gpsPosData.Status = 0;
-		gpsPosData.VDOP = 0;
+/**
+ * A source object changed, mark its streams as dirty. Once all of them are
+ * dirty there is nothing more to learn from it until one has been sent.
+ */
+static void source_updated(UAVObjHandle obj)
+{
+	for (uint8_t i = 0; i < num_sources; i++) {
+		if (sources[i].obj != obj)
+			continue;
+
+		dirty_streams |= sources[i].streams;
+		if (!sources[i].muted) {
+			sources[i].muted = true;
+			UAVObjConnectQueue(obj, queue, EV_MASK_MUTED);
+		}
 	}
+}
 
-	if (FlightBatteryStateHandle() == NULL ) {
-		batState.AvgCurrent = 0;
-		batState.BoardSupplyVoltage = 0;
-		batState.ConsumedEnergy = 0;
-		batState.Current = 0;
-		batState.EstimatedFlightTime = 0;
-		batState.PeakCurrent = 0;
-		batState.Voltage = 0;
+/**
+ * The streams were written to the port, listen to their sources again.
+ * Sources stay muted during the write so that they don't fill the queue
+ * while the task is blocked on the port. A change made during the write is
+ * sent with the next update of the source or at the latest after
+ * STREAM_REFRESH_MS.
+ */
+static void streams_sent(uint16_t streams)
+{
+	for (uint8_t i = 0; i < num_sources; i++) {
+		if (sources[i].muted && (sources[i].streams & streams)) {
+			sources[i].muted = false;
+			UAVObjConnectQueue(sources[i].obj, queue, EV_MASK_LISTEN);
+		}
 	}
+}
 
-	if (AirspeedActualHandle() == NULL ) {
-		airspeedActual.CalibratedAirspeed = 0;
-		airspeedActual.TrueAirspeed = 0;
-		airspeedActual.alpha = 0;
-		airspeedActual.beta = 0;
-	}
+/**
+ * Append the message in mavMsg to the serial buffer, writing out what is
+ * already there first if it doesn't fit
+ */
+static void queue_message(void)
+{
+	uint16_t msg_length = mavMsg.len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 
-	if (HomeLocationHandle() == NULL ) {
-		homeLocation.Set=HOMELOCATION_SET_FALSE;
-		homeLocation.Latitude = 0;
-		homeLocation.Longitude = 0;
-		homeLocation.Altitude = 0;
-		homeLocation.Be[0] = 0;
-		homeLocation.Be[1] = 0;
-		homeLocation.Be[2] = 0;
-		homeLocation.GroundTemperature = (STANDARD_AIR_TEMPERATURE - CELSIUS2KELVIN) * 10;
-		homeLocation.SeaLevelPressure = STANDARD_AIR_SEA_LEVEL_PRESSURE/1000;
+	if (serial_len + msg_length > MAVLINK_MAX_PACKET_LEN) {
+		PIOS_COM_SendBuffer(mavlink_port, serial_buf, serial_len);
+		serial_len = 0;
 	}
 
-	uint16_t msg_length;
-	uint32_t lastSysTime;
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
+	serial_len += mavlink_msg_to_send_buffer(&serial_buf[serial_len], &mavMsg);
+}
+
+/**
+ * Main task. It does not return.
+ *
+ * Streams are sent as soon as their source data changed and their rate
+ * allows it, or after STREAM_REFRESH_MS without changes. All messages due
+ * at the same time go out in a single write.
+ */
+static void uavoMavlinkBridgeTask(void *parameters) {
+	// Objects are registered by now, subscribe to the ones we send
+	add_source(FlightBatteryStateHandle(), STREAM(MAV_DATA_STREAM_EXTENDED_STATUS));
+	add_source(SystemStatsHandle(), STREAM(MAV_DATA_STREAM_EXTENDED_STATUS));
+	add_source(ManualControlCommandHandle(), STREAM(MAV_DATA_STREAM_RC_CHANNELS));
+	add_source(GPSPositionHandle(), STREAM(MAV_DATA_STREAM_POSITION) | STREAM(MAV_DATA_STREAM_EXTRA2));
+	add_source(HomeLocationHandle(), STREAM(MAV_DATA_STREAM_POSITION));
+	add_source(AttitudeActualHandle(), STREAM(MAV_DATA_STREAM_EXTRA1) | STREAM(MAV_DATA_STREAM_EXTRA2));
+	add_source(AirspeedActualHandle(), STREAM(MAV_DATA_STREAM_EXTRA2));
+	add_source(BaroAltitudeHandle(), STREAM(MAV_DATA_STREAM_EXTRA2));
+	add_source(ActuatorDesiredHandle(), STREAM(MAV_DATA_STREAM_EXTRA2));
+	add_source(FlightStatusHandle(), STREAM(MAV_DATA_STREAM_EXTRA2));
+
+	// Send everything right away
+	uint32_t now = PIOS_Thread_Systime();
+	for (int x = 0; x < MAXSTREAMS; ++x)
+		stream_last_sent[x] = now - STREAM_REFRESH_MS;
+
+	uint32_t wait_ms = 0;
 
 	while (1) {
-		PIOS_Thread_Sleep_Until(&lastSysTime, 1000 / TASK_RATE_HZ);
-
-		if (stream_trigger(MAV_DATA_STREAM_EXTENDED_STATUS)) {
-			if (FlightBatteryStateHandle() != NULL )
-				FlightBatteryStateGet(&batState);
-			SystemStatsGet(&systemStats);
-
-			int8_t battery_remaining = 0;
-			if (batSettings.Capacity != 0) {
-				if (batState.ConsumedEnergy < batSettings.Capacity) {
-					battery_remaining = 100 - lroundf(batState.ConsumedEnergy / batSettings.Capacity * 100);
-				}
-			}
+		UAVObjEvent ev;
 
-			uint16_t voltage = 0;
-			if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-				voltage = lroundf(batState.Voltage * 1000);
-
-			uint16_t current = 0;
-			if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
-				current = lroundf(batState.Current * 100);
-
-			mavlink_msg_sys_status_pack(0, 200, &mavMsg,
-					// onboard_control_sensors_present Bitmask showing which onboard controllers and sensors are present. Value of 0: not present. Value of 1: present. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// onboard_control_sensors_enabled Bitmask showing which onboard controllers and sensors are enabled:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// onboard_control_sensors_health Bitmask showing which onboard controllers and sensors are operational or have an error:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// load Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000) should be always below 1000
-					(uint16_t)systemStats.CPULoad * 10,
-					// voltage_battery Battery voltage, in millivolts (1 = 1 millivolt)
-					voltage,
-					// current_battery Battery current, in 10*milliamperes (1 = 10 milliampere), -1: autopilot does not measure the current
-					current,
-					// battery_remaining Remaining battery energy: (0%: 0, 100%: 100), -1: autopilot estimate the remaining battery
-					battery_remaining,
-					// drop_rate_comm Communication drops in percent, (0%: 0, 100%: 10'000), (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
-					0,
-					// errors_comm Communication errors (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
-					0,
-					// errors_count1 Autopilot-specific errors
-					0,
-					// errors_count2 Autopilot-specific errors
-					0,
-					// errors_count3 Autopilot-specific errors
-					0,
-					// errors_count4 Autopilot-specific errors
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+		// Take in everything that changed before deciding what to send
+		if (PIOS_Queue_Receive(queue, &ev, wait_ms)) {
+			do {
+				source_updated(ev.obj);
+			} while (PIOS_Queue_Receive(queue, &ev, 0));
 		}
 
-		if (stream_trigger(MAV_DATA_STREAM_RC_CHANNELS)) {
-			ManualControlCommandGet(&manualState);
-			FlightStatusGet(&flightStatus);
-			SystemStatsGet(&systemStats);
-
-			//TODO connect with RSSI object and pass in last argument
-			mavlink_msg_rc_channels_raw_pack(0, 200, &mavMsg,
-					// time_boot_ms Timestamp (milliseconds since system boot)
-					systemStats.FlightTime,
-					// port Servo output port (set of 8 outputs = 1 port). Most MAVs will just use one, but this allows to encode more than 8 servos.
-					0,
-					// chan1_raw RC channel 1 value, in microseconds
-					manualState.Channel[0],
-					// chan2_raw RC channel 2 value, in microseconds
-					manualState.Channel[1],
-					// chan3_raw RC channel 3 value, in microseconds
-					manualState.Channel[2],
-					// chan4_raw RC channel 4 value, in microseconds
-					manualState.Channel[3],
-					// chan5_raw RC channel 5 value, in microseconds
-					manualState.Channel[4],
-					// chan6_raw RC channel 6 value, in microseconds
-					manualState.Channel[5],
-					// chan7_raw RC channel 7 value, in microseconds
-					manualState.Channel[6],
-					// chan8_raw RC channel 8 value, in microseconds
-					manualState.Channel[7],
-					// rssi Receive signal strength indicator, 0: 0%, 255: 100%
-					manualState.Rssi);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-		}
+		now = PIOS_Thread_Systime();
+		wait_ms = STREAM_REFRESH_MS;
 
-		if (stream_trigger(MAV_DATA_STREAM_POSITION)) {
-			if (GPSPositionHandle() != NULL )
-				GPSPositionGet(&gpsPosData);
-			if (HomeLocationHandle() != NULL )
-				HomeLocationGet(&homeLocation);
-			SystemStatsGet(&systemStats);
-
-			uint8_t gps_fix_type;
-			switch (gpsPosData.Status)
-			{
-			case GPSPOSITION_STATUS_NOGPS:
-				gps_fix_type = 0;
-				break;
-			case GPSPOSITION_STATUS_NOFIX:
-				gps_fix_type = 1;
-				break;
-			case GPSPOSITION_STATUS_FIX2D:
-				gps_fix_type = 2;
-				break;
-			case GPSPOSITION_STATUS_FIX3D:
-			case GPSPOSITION_STATUS_DIFF3D:
-				gps_fix_type = 3;
-				break;
-			default:
-				gps_fix_type = 0;
-				break;
+		for (int x = 0; x < MAXSTREAMS; ++x) {
+			if (mav_rates[x] == 0 || stream_senders[x] == NULL)
+				continue;
+
+			uint32_t period_ms = 1000 / mav_rates[x];
+			uint32_t since_ms = now - stream_last_sent[x];
+			bool dirty = (dirty_streams & STREAM(x)) != 0;
+
+			if ((dirty && since_ms >= period_ms) || since_ms >= STREAM_REFRESH_MS) {
+				dirty_streams &= ~STREAM(x);
+				sent_streams |= STREAM(x);
+				stream_senders[x]();
+				stream_last_sent[x] = now;
+				since_ms = 0;
+				dirty = false;
 			}
 
-			mavlink_msg_gps_raw_int_pack(0, 200, &mavMsg,
-					// time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
-					(uint64_t)systemStats.FlightTime * 1000,
-					// fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
-					gps_fix_type,
-					// lat Latitude in 1E7 degrees
-					gpsPosData.Latitude,
-					// lon Longitude in 1E7 degrees
-					gpsPosData.Longitude,
-					// alt Altitude in 1E3 meters (millimeters) above MSL
-					gpsPosData.Altitude * 1000,
-					// eph GPS HDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
-					gpsPosData.HDOP * 100,
-					// epv GPS VDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
-					gpsPosData.VDOP * 100,
-					// vel GPS ground speed (m/s * 100). If unknown, set to: 65535
-					gpsPosData.Groundspeed * 100,
-					// cog Course over ground (NOT heading, but direction of movement) in degrees * 100, 0.0..359.99 degrees. If unknown, set to: 65535
-					gpsPosData.Heading * 100,
-					// satellites_visible Number of satellites visible. If unknown, set to 255
-					gpsPosData.Satellites);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
-					// latitude Latitude (WGS84), expressed as * 1E7
-					homeLocation.Latitude,
-					// longitude Longitude (WGS84), expressed as * 1E7
-					homeLocation.Longitude,
-					// altitude Altitude(WGS84), expressed as * 1000
-					homeLocation.Altitude * 1000);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			//TODO add waypoint nav stuff
-			//wp_target_bearing
-			//wp_dist = mavlink_msg_nav_controller_output_get_wp_dist(&msg);
-			//alt_error = mavlink_msg_nav_controller_output_get_alt_error(&msg);
-			//aspd_error = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
-			//xtrack_error = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
-			//mavlink_msg_nav_controller_output_pack
-			//wp_number
-			//mavlink_msg_mission_current_pack
+			// Sleep until the next stream is due. Clean streams are woken up
+			// by their sources before that if they change.
+			uint32_t due_ms = (dirty ? period_ms : STREAM_REFRESH_MS) - since_ms;
+			if (due_ms < wait_ms)
+				wait_ms = due_ms;
 		}
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTRA1)) {
-			AttitudeActualGet(&attActual);
-			SystemStatsGet(&systemStats);
-
-			mavlink_msg_attitude_pack(0, 200, &mavMsg,
-					// time_boot_ms Timestamp (milliseconds since system boot)
-					systemStats.FlightTime,
-					// roll Roll angle (rad)
-					attActual.Roll * DEG2RAD,
-					// pitch Pitch angle (rad)
-					attActual.Pitch * DEG2RAD,
-					// yaw Yaw angle (rad)
-					attActual.Yaw * DEG2RAD,
-					// rollspeed Roll angular speed (rad/s)
-					0,
-					// pitchspeed Pitch angular speed (rad/s)
-					0,
-					// yawspeed Yaw angular speed (rad/s)
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+		if (serial_len > 0) {
+			PIOS_COM_SendBuffer(mavlink_port, serial_buf, serial_len);
+			serial_len = 0;
 		}
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTRA2)) {
-			if (AirspeedActualHandle() != NULL )
-				AirspeedActualGet(&airspeedActual);
-			if (GPSPositionHandle() != NULL )
-				GPSPositionGet(&gpsPosData);
-			if (BaroAltitudeHandle() != NULL )
-				BaroAltitudeGet(&baroAltitude);
-			ActuatorDesiredGet(&actDesired);
-			AttitudeActualGet(&attActual);
-
-			float altitude = 0;
-			if (BaroAltitudeHandle() != NULL)
-				altitude = baroAltitude.Altitude;
-			else if (GPSPositionHandle() != NULL)
-				altitude = gpsPosData.Altitude;
-
-			// round attActual.Yaw to nearest int and transfer from (-180 ... 180) to (0 ... 360)
-			int16_t heading = lroundf(attActual.Yaw);
-			if (heading < 0)
-				heading += 360;
-
-			mavlink_msg_vfr_hud_pack(0, 200, &mavMsg,
-					// airspeed Current airspeed in m/s
-					airspeedActual.TrueAirspeed,
-					// groundspeed Current ground speed in m/s
-					gpsPosData.Groundspeed,
-					// heading Current heading in degrees, in compass units (0..360, 0=north)
-					heading,
-					// throttle Current throttle setting in integer percent, 0 to 100
-					actDesired.Throttle * 100,
-					// alt Current altitude (MSL), in meters
-					altitude,
-					// climb Current climb rate in meters/second
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			uint8_t armed_mode = 0;
-			if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
-				armed_mode |= MAV_MODE_FLAG_SAFETY_ARMED;
-
-			uint8_t custom_mode = CUSTOM_MODE_STAB;
-
-			switch (flightStatus.FlightMode) {
-				case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
-				case FLIGHTSTATUS_FLIGHTMODE_MWRATE:
-				case FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR:
-				case FLIGHTSTATUS_FLIGHTMODE_HORIZON:
-					/* Kinda a catch all */
-					custom_mode = CUSTOM_MODE_SPORT;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_ACRO:
-				case FLIGHTSTATUS_FLIGHTMODE_AXISLOCK:
-					custom_mode = CUSTOM_MODE_ACRO;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
-					/* May want these three to try and
-					 * infer based on roll axis */
-				case FLIGHTSTATUS_FLIGHTMODE_LEVELING:
-					custom_mode = CUSTOM_MODE_STAB;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
-					custom_mode = CUSTOM_MODE_DRIFT;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD:
-					custom_mode = CUSTOM_MODE_ALTH;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
-					custom_mode = CUSTOM_MODE_RTL;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL:
-				case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
-					custom_mode = CUSTOM_MODE_POSH;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
-					custom_mode = CUSTOM_MODE_AUTO;
-					break;
-			}
+		if (sent_streams) {
+			streams_sent(sent_streams);
+			sent_streams = 0;
+		}
+	}
+}
 
-			mavlink_msg_heartbeat_pack(0, 200, &mavMsg,
-					// type Type of the MAV (quadrotor, helicopter, etc., up to 15 types, defined in MAV_TYPE ENUM)
-					MAV_TYPE_GENERIC,
-					// autopilot Autopilot type / class. defined in MAV_AUTOPILOT ENUM
-					MAV_AUTOPILOT_GENERIC,
-					// base_mode System mode bitfield, see MAV_MODE_FLAGS ENUM in mavlink/include/mavlink_types.h
-					armed_mode,
-					// custom_mode A bitfield for use for autopilot-specific flags.
-					custom_mode,
-					// system_status System status flag, see MAV_STATE ENUM
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+/**
+ * SYS_STATUS with the battery state and the CPU load
+ */
+static void send_extended_status(void)
+{
+	FlightBatterySettingsData batSettings;
+	FlightBatteryStateData batState;
+	SystemStatsData systemStats;
+
+	memset(&batSettings, 0, sizeof(batSettings));
+	memset(&batState, 0, sizeof(batState));
+	batSettings.VoltagePin = FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE;
+	batSettings.CurrentPin = FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE;
+
+	if (FlightBatterySettingsHandle() != NULL )
+		FlightBatterySettingsGet(&batSettings);
+	if (FlightBatteryStateHandle() != NULL )
+		FlightBatteryStateGet(&batState);
+	SystemStatsGet(&systemStats);
+
+	int8_t battery_remaining = 0;
+	if (batSettings.Capacity != 0) {
+		if (batState.ConsumedEnergy < batSettings.Capacity) {
+			battery_remaining = 100 - lroundf(batState.ConsumedEnergy / batSettings.Capacity * 100);
 		}
 	}
+
+	uint16_t voltage = 0;
+	if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
+		voltage = lroundf(batState.Voltage * 1000);
+
+	uint16_t current = 0;
+	if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
+		current = lroundf(batState.Current * 100);
+
+	mavlink_msg_sys_status_pack(0, 200, &mavMsg,
+			// onboard_control_sensors_present Bitmask showing which onboard controllers and sensors are present. Value of 0: not present. Value of 1: present. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+			0,
+			// onboard_control_sensors_enabled Bitmask showing which onboard controllers and sensors are enabled:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+			0,
+			// onboard_control_sensors_health Bitmask showing which onboard controllers and sensors are operational or have an error:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
+			0,
+			// load Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000) should be always below 1000
+			(uint16_t)systemStats.CPULoad * 10,
+			// voltage_battery Battery voltage, in millivolts (1 = 1 millivolt)
+			voltage,
+			// current_battery Battery current, in 10*milliamperes (1 = 10 milliampere), -1: autopilot does not measure the current
+			current,
+			// battery_remaining Remaining battery energy: (0%: 0, 100%: 100), -1: autopilot estimate the remaining battery
+			battery_remaining,
+			// drop_rate_comm Communication drops in percent, (0%: 0, 100%: 10'000), (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
+			0,
+			// errors_comm Communication errors (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
+			0,
+			// errors_count1 Autopilot-specific errors
+			0,
+			// errors_count2 Autopilot-specific errors
+			0,
+			// errors_count3 Autopilot-specific errors
+			0,
+			// errors_count4 Autopilot-specific errors
+			0);
+	queue_message();
 }
 
-static bool stream_trigger(enum MAV_DATA_STREAM stream_num) {
-	uint8_t rate = (uint8_t) mav_rates[stream_num];
+/**
+ * RC_CHANNELS_RAW with the first eight receiver channels
+ */
+static void send_rc_channels(void)
+{
+	ManualControlCommandData manualState;
+	SystemStatsData systemStats;
+
+	ManualControlCommandGet(&manualState);
+	SystemStatsGet(&systemStats);
+
+	//TODO connect with RSSI object and pass in last argument
+	mavlink_msg_rc_channels_raw_pack(0, 200, &mavMsg,
+			// time_boot_ms Timestamp (milliseconds since system boot)
+			systemStats.FlightTime,
+			// port Servo output port (set of 8 outputs = 1 port). Most MAVs will just use one, but this allows to encode more than 8 servos.
+			0,
+			// chan1_raw RC channel 1 value, in microseconds
+			manualState.Channel[0],
+			// chan2_raw RC channel 2 value, in microseconds
+			manualState.Channel[1],
+			// chan3_raw RC channel 3 value, in microseconds
+			manualState.Channel[2],
+			// chan4_raw RC channel 4 value, in microseconds
+			manualState.Channel[3],
+			// chan5_raw RC channel 5 value, in microseconds
+			manualState.Channel[4],
+			// chan6_raw RC channel 6 value, in microseconds
+			manualState.Channel[5],
+			// chan7_raw RC channel 7 value, in microseconds
+			manualState.Channel[6],
+			// chan8_raw RC channel 8 value, in microseconds
+			manualState.Channel[7],
+			// rssi Receive signal strength indicator, 0: 0%, 255: 100%
+			manualState.Rssi);
+	queue_message();
+}
+
+/**
+ * GPS_RAW_INT and GPS_GLOBAL_ORIGIN
+ */
+static void send_position(void)
+{
+	GPSPositionData gpsPosData;
+	HomeLocationData homeLocation;
+	SystemStatsData systemStats;
 
-	if (rate == 0) {
-		return false;
+	memset(&gpsPosData, 0, sizeof(gpsPosData));
+	memset(&homeLocation, 0, sizeof(homeLocation));
+
+	if (GPSPositionHandle() != NULL )
+		GPSPositionGet(&gpsPosData);
+	if (HomeLocationHandle() != NULL )
+		HomeLocationGet(&homeLocation);
+	SystemStatsGet(&systemStats);
+
+	uint8_t gps_fix_type;
+	switch (gpsPosData.Status)
+	{
+	case GPSPOSITION_STATUS_NOGPS:
+		gps_fix_type = 0;
+		break;
+	case GPSPOSITION_STATUS_NOFIX:
+		gps_fix_type = 1;
+		break;
+	case GPSPOSITION_STATUS_FIX2D:
+		gps_fix_type = 2;
+		break;
+	case GPSPOSITION_STATUS_FIX3D:
+	case GPSPOSITION_STATUS_DIFF3D:
+		gps_fix_type = 3;
+		break;
+	default:
+		gps_fix_type = 0;
+		break;
 	}
 
-	if (stream_ticks[stream_num] == 0) {
-		// we're triggering now, setup the next trigger point
-		if (rate > TASK_RATE_HZ) {
-			rate = TASK_RATE_HZ;
-		}
-		stream_ticks[stream_num] = (TASK_RATE_HZ / rate);
-		return true;
+	mavlink_msg_gps_raw_int_pack(0, 200, &mavMsg,
+			// time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
+			(uint64_t)systemStats.FlightTime * 1000,
+			// fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
+			gps_fix_type,
+			// lat Latitude in 1E7 degrees
+			gpsPosData.Latitude,
+			// lon Longitude in 1E7 degrees
+			gpsPosData.Longitude,
+			// alt Altitude in 1E3 meters (millimeters) above MSL
+			gpsPosData.Altitude * 1000,
+			// eph GPS HDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
+			gpsPosData.HDOP * 100,
+			// epv GPS VDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
+			gpsPosData.VDOP * 100,
+			// vel GPS ground speed (m/s * 100). If unknown, set to: 65535
+			gpsPosData.Groundspeed * 100,
+			// cog Course over ground (NOT heading, but direction of movement) in degrees * 100, 0.0..359.99 degrees. If unknown, set to: 65535
+			gpsPosData.Heading * 100,
+			// satellites_visible Number of satellites visible. If unknown, set to 255
+			gpsPosData.Satellites);
+	queue_message();
+
+	mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
+			// latitude Latitude (WGS84), expressed as * 1E7
+			homeLocation.Latitude,
+			// longitude Longitude (WGS84), expressed as * 1E7
+			homeLocation.Longitude,
+			// altitude Altitude(WGS84), expressed as * 1000
+			homeLocation.Altitude * 1000);
+	queue_message();
+
+	//TODO add waypoint nav stuff
+	//wp_target_bearing
+	//wp_dist = mavlink_msg_nav_controller_output_get_wp_dist(&msg);
+	//alt_error = mavlink_msg_nav_controller_output_get_alt_error(&msg);
+	//aspd_error = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
+	//xtrack_error = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
+	//mavlink_msg_nav_controller_output_pack
+	//wp_number
+	//mavlink_msg_mission_current_pack
+}
+
+/**
+ * ATTITUDE
+ */
+static void send_extra1(void)
+{
+	AttitudeActualData attActual;
+	SystemStatsData systemStats;
+
+	AttitudeActualGet(&attActual);
+	SystemStatsGet(&systemStats);
+
+	mavlink_msg_attitude_pack(0, 200, &mavMsg,
+			// time_boot_ms Timestamp (milliseconds since system boot)
+			systemStats.FlightTime,
+			// roll Roll angle (rad)
+			attActual.Roll * DEG2RAD,
+			// pitch Pitch angle (rad)
+			attActual.Pitch * DEG2RAD,
+			// yaw Yaw angle (rad)
+			attActual.Yaw * DEG2RAD,
+			// rollspeed Roll angular speed (rad/s)
+			0,
+			// pitchspeed Pitch angular speed (rad/s)
+			0,
+			// yawspeed Yaw angular speed (rad/s)
+			0);
+	queue_message();
+}
+
+/**
+ * VFR_HUD and HEARTBEAT
+ */
+static void send_extra2(void)
+{
+	AirspeedActualData airspeedActual;
+	GPSPositionData gpsPosData;
+	BaroAltitudeData baroAltitude;
+	ActuatorDesiredData actDesired;
+	AttitudeActualData attActual;
+	FlightStatusData flightStatus;
+
+	memset(&airspeedActual, 0, sizeof(airspeedActual));
+	memset(&gpsPosData, 0, sizeof(gpsPosData));
+	memset(&baroAltitude, 0, sizeof(baroAltitude));
+
+	if (AirspeedActualHandle() != NULL )
+		AirspeedActualGet(&airspeedActual);
+	if (GPSPositionHandle() != NULL )
+		GPSPositionGet(&gpsPosData);
+	if (BaroAltitudeHandle() != NULL )
+		BaroAltitudeGet(&baroAltitude);
+	ActuatorDesiredGet(&actDesired);
+	AttitudeActualGet(&attActual);
+	FlightStatusGet(&flightStatus);
+
+	float altitude = 0;
+	if (BaroAltitudeHandle() != NULL)
+		altitude = baroAltitude.Altitude;
+	else if (GPSPositionHandle() != NULL)
+		altitude = gpsPosData.Altitude;
+
+	// round attActual.Yaw to nearest int and transfer from (-180 ... 180) to (0 ... 360)
+	int16_t heading = lroundf(attActual.Yaw);
+	if (heading < 0)
+		heading += 360;
+
+	mavlink_msg_vfr_hud_pack(0, 200, &mavMsg,
+			// airspeed Current airspeed in m/s
+			airspeedActual.TrueAirspeed,
+			// groundspeed Current ground speed in m/s
+			gpsPosData.Groundspeed,
+			// heading Current heading in degrees, in compass units (0..360, 0=north)
+			heading,
+			// throttle Current throttle setting in integer percent, 0 to 100
+			actDesired.Throttle * 100,
+			// alt Current altitude (MSL), in meters
+			altitude,
+			// climb Current climb rate in meters/second
+			0);
+	queue_message();
+
+	uint8_t armed_mode = 0;
+	if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
+		armed_mode |= MAV_MODE_FLAG_SAFETY_ARMED;
+
+	uint8_t custom_mode = CUSTOM_MODE_STAB;
+
+	switch (flightStatus.FlightMode) {
+		case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
+		case FLIGHTSTATUS_FLIGHTMODE_MWRATE:
+		case FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR:
+		case FLIGHTSTATUS_FLIGHTMODE_HORIZON:
+			/* Kinda a catch all */
+			custom_mode = CUSTOM_MODE_SPORT;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_ACRO:
+		case FLIGHTSTATUS_FLIGHTMODE_AXISLOCK:
+			custom_mode = CUSTOM_MODE_ACRO;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
+			/* May want these three to try and
+			 * infer based on roll axis */
+		case FLIGHTSTATUS_FLIGHTMODE_LEVELING:
+			custom_mode = CUSTOM_MODE_STAB;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
+			custom_mode = CUSTOM_MODE_DRIFT;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD:
+			custom_mode = CUSTOM_MODE_ALTH;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
+			custom_mode = CUSTOM_MODE_RTL;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL:
+		case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
+			custom_mode = CUSTOM_MODE_POSH;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
+			custom_mode = CUSTOM_MODE_AUTO;
+			break;
 	}
 
-	// count down at 50Hz
-	stream_ticks[stream_num]--;
-	return false;
+	mavlink_msg_heartbeat_pack(0, 200, &mavMsg,
+			// type Type of the MAV (quadrotor, helicopter, etc., up to 15 types, defined in MAV_TYPE ENUM)
+			MAV_TYPE_GENERIC,
+			// autopilot Autopilot type / class. defined in MAV_AUTOPILOT ENUM
+			MAV_AUTOPILOT_GENERIC,
+			// base_mode System mode bitfield, see MAV_MODE_FLAGS ENUM in mavlink/include/mavlink_types.h
+			armed_mode,
+			// custom_mode A bitfield for use for autopilot-specific flags.
+			custom_mode,
+			// system_status System status flag, see MAV_STATE ENUM
+			0);
+	queue_message();
 }
 
 static void updateSettings()
@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VibrationAnalysisModule Vibration analysis module
+ * @{
+ *
+ * @file       spectrum.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Streaming amplitude spectrum of three axis samples
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arm_math.h"
+
+#define SPECTRUM_AXES 3
+
+//! State of a spectrum, allocated by spectrum_init()
+struct spectrum {
+	uint16_t fft_size;          //!< Samples per frame
+	uint16_t averages;          //!< Frames averaged into one spectrum
+	uint16_t head;              //!< Next sample to write in the history
+	uint16_t filled;            //!< Samples in the history, up to fft_size
+	uint16_t hop;               //!< New samples since the last frame
+	uint16_t frames;            //!< Frames in the current average
+	float window_sum;           //!< Sum of the window, the coherent gain times fft_size
+
+	float *history;             //!< Last fft_size samples of each axis
+	float *frame;               //!< Windowed frame, transformed in place
+	float *window;              //!< First half of the Hann window
+	float *twiddle;             //!< cos and sin of the real FFT split
+	float *power;               //!< Power, or amplitude once an average completes
+
+	arm_cfft_radix4_instance_f32 cfft;
+};
+
+int32_t spectrum_init(struct spectrum *s, uint16_t fft_size, uint16_t averages);
+bool spectrum_add_sample(struct spectrum *s, const float sample[SPECTRUM_AXES]);
+const float *spectrum_get(const struct spectrum *s, uint8_t axis);
+
+#endif /* SPECTRUM_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,206 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VibrationAnalysisModule Vibration analysis module
+ * @{
+ *
+ * @file       spectrum.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Streaming amplitude spectrum of three axis samples
+ *
+ * Samples are kept in a history of one frame per axis. Every half frame the
+ * history is windowed with a Hann window and transformed, so consecutive
+ * frames overlap by 50%. The power of a number of frames is averaged (Welch's
+ * method) before it is turned into an amplitude spectrum, scaled such that a
+ * sine of amplitude A shows up as a peak of A in its bin.
+ *
+ * The real FFT of a frame of N samples is done as a complex FFT of N/2 points
+ * followed by a split step. The twiddles of the split step are computed for
+ * the one size in use instead of taking them from the large tables used by
+ * arm_rfft_f32().
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "spectrum.h"
+
+/**
+ * Allocate and initialize a spectrum
+ * @param[in] fft_size Samples per frame, 32, 128, 512 or 2048
+ * @param[in] averages Number of frames averaged into each spectrum
+ * @return 0 if successful, -1 if the size is not supported or out of memory
+ */
+int32_t spectrum_init(struct spectrum *s, uint16_t fft_size, uint16_t averages)
+{
+	uint16_t half = fft_size / 2;
+
+	memset(s, 0, sizeof(*s));
+
+	if (arm_cfft_radix4_init_f32(&s->cfft, half, 0, 1) != ARM_MATH_SUCCESS)
+		return -1;
+
+	s->fft_size = fft_size;
+	s->averages = averages > 0 ? averages : 1;
+
+	s->history = PIOS_malloc(SPECTRUM_AXES * fft_size * sizeof(*s->history));
+	s->frame = PIOS_malloc(fft_size * sizeof(*s->frame));
+	s->window = PIOS_malloc((half + 1) * sizeof(*s->window));
+	s->twiddle = PIOS_malloc(fft_size * sizeof(*s->twiddle));
+	s->power = PIOS_malloc(SPECTRUM_AXES * half * sizeof(*s->power));
+	if (s->history == NULL || s->frame == NULL || s->window == NULL ||
+	    s->twiddle == NULL || s->power == NULL)
+		return -1;
+
+	memset(s->power, 0, SPECTRUM_AXES * half * sizeof(*s->power));
+
+	// Periodic Hann window, symmetric about half
+	for (uint16_t i = 0; i <= half; i++) {
+		s->window[i] = 0.5f - 0.5f * cosf(2 * PI * i / fft_size);
+		s->window_sum += (i == 0 || i == half) ? s->window[i] : 2 * s->window[i];
+	}
+
+	for (uint16_t k = 0; k < half; k++) {
+		s->twiddle[2 * k] = cosf(2 * PI * k / fft_size);
+		s->twiddle[2 * k + 1] = sinf(2 * PI * k / fft_size);
+	}
+
+	return 0;
+}
+
+/**
+ * Window the history of an axis into the frame, removing its mean
+ */
+static void spectrum_window(struct spectrum *s, const float *history)
+{
+	uint16_t n = s->fft_size;
+	float mean = 0;
+
+	// Oldest sample first
+	for (uint16_t i = 0, j = s->head; i < n; i++) {
+		s->frame[i] = history[j];
+		mean += history[j];
+		if (++j == n)
+			j = 0;
+	}
+	mean /= n;
+
+	s->frame[0] = (s->frame[0] - mean) * s->window[0];
+	for (uint16_t i = 1; i <= n / 2; i++) {
+		s->frame[i] = (s->frame[i] - mean) * s->window[i];
+		if (i < n / 2)
+			s->frame[n - i] = (s->frame[n - i] - mean) * s->window[i];
+	}
+}
+
+/**
+ * Transform the frame and add the power of its bins to power
+ *
+ * The frame is transformed as N/2 complex samples Z. The spectrum X of the
+ * real frame follows from X[k] = E[k] + W^k O[k], where E and O are the
+ * transforms of the even and odd samples:
+ *   E[k] = (Z[k] + conj(Z[N/2-k])) / 2
+ *   O[k] = -i (Z[k] - conj(Z[N/2-k])) / 2
+ */
+static void spectrum_accumulate(struct spectrum *s, float *power, bool first)
+{
+	uint16_t half = s->fft_size / 2;
+	const float *z = s->frame;
+
+	arm_cfft_radix4_f32(&s->cfft, s->frame);
+
+	for (uint16_t k = 0; k < half; k++) {
+		uint16_t m = k ? half - k : 0;
+		float a = z[2 * k], b = z[2 * k + 1];
+		float c = z[2 * m], d = z[2 * m + 1];
+
+		float e_re = 0.5f * (a + c);
+		float e_im = 0.5f * (b - d);
+		float o_re = 0.5f * (b + d);
+		float o_im = -0.5f * (a - c);
+
+		float cs = s->twiddle[2 * k];
+		float sn = s->twiddle[2 * k + 1];
+
+		float x_re = e_re + cs * o_re + sn * o_im;
+		float x_im = e_im + cs * o_im - sn * o_re;
+		float p = x_re * x_re + x_im * x_im;
+
+		power[k] = first ? p : power[k] + p;
+	}
+}
+
+/**
+ * Add a sample of each axis
+ * @return true when a new spectrum is available from spectrum_get()
+ */
+bool spectrum_add_sample(struct spectrum *s, const float sample[SPECTRUM_AXES])
+{
+	uint16_t n = s->fft_size;
+	uint16_t half = n / 2;
+
+	for (uint8_t axis = 0; axis < SPECTRUM_AXES; axis++)
+		s->history[axis * n + s->head] = sample[axis];
+
+	if (++s->head == n)
+		s->head = 0;
+	if (s->filled < n)
+		s->filled++;
+	s->hop++;
+
+	if (s->filled < n || s->hop < half)
+		return false;
+
+	s->hop = 0;
+
+	for (uint8_t axis = 0; axis < SPECTRUM_AXES; axis++) {
+		spectrum_window(s, &s->history[axis * n]);
+		spectrum_accumulate(s, &s->power[axis * half], s->frames == 0);
+	}
+
+	if (++s->frames < s->averages)
+		return false;
+
+	// Amplitude of the averaged power, a sine of amplitude A has |X| = A * window_sum / 2
+	float scale = 1.0f / s->averages;
+	for (uint16_t i = 0; i < SPECTRUM_AXES * half; i++) {
+		float amplitude = 2 * sqrtf(s->power[i] * scale) / s->window_sum;
+		s->power[i] = (i % half) ? amplitude : amplitude / 2;
+	}
+
+	s->frames = 0;
+
+	return true;
+}
+
+/**
+ * Get the last spectrum of an axis
+ * @return fft_size / 2 amplitudes from DC up to below the Nyquist frequency,
+ * valid until spectrum_add_sample() is called again
+ */
+const float *spectrum_get(const struct spectrum *s, uint8_t axis)
+{
+	return &s->power[axis * (s->fft_size / 2)];
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SIL Lockstep software in the loop link
+ * @{
+ *
+ * @file       pios_sil.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Exchange sensor and actuator frames with the GCS SIL backend
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_SIL_H
+#define PIOS_SIL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sil_protocol.h"
+
+/* Public Functions */
+extern int32_t PIOS_SIL_Init(uint16_t port);
+extern bool PIOS_SIL_Enabled(void);
+extern int32_t PIOS_SIL_ReceiveSensors(struct sil_sensor_frame *frame);
+extern int32_t PIOS_SIL_SendActuators(struct sil_actuator_frame *frame);
+extern uint32_t PIOS_SIL_GetTime(uint32_t host_us);
+extern void PIOS_SIL_Idle(void);
+
+#endif /* PIOS_SIL_H */
+
+/**
+  * @}
+  * @}
+  */
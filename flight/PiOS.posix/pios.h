@@ -80,6 +80,9 @@
 #include <pios_irq.h>
 #include <pios_sensors.h>
 #include <pios_sim.h>
+#if defined(PIOS_INCLUDE_SIL)
+#include <pios_sil.h>
+#endif
 #include <pios_flashfs.h>
 
 #if defined(PIOS_INCLUDE_IAP)
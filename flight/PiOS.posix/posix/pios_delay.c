@@ -99,13 +99,28 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 
 uint32_t PIOS_DELAY_GetRaw()
 {
-	uint32_t raw_us = clock();
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint32_t raw_us = now.tv_sec * 1000000 + now.tv_nsec / 1000;
+
+#if defined(PIOS_INCLUDE_SIL)
+	// Lockstep SIL runs on the time of the model
+	raw_us = PIOS_SIL_GetTime(raw_us);
+#endif /* PIOS_INCLUDE_SIL */
+
 	return raw_us;
 }
 
 uint32_t PIOS_DELAY_DiffuS(uint32_t ref)
 {
-	uint32_t diff_clock = clock() - ref;
+	uint32_t diff_clock = PIOS_DELAY_GetRaw() - ref;
+	uint32_t diff_us = diff_clock; // (CLOCKS_PER_SEC / 1000);
+	return diff_us;
+}
+
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+	uint32_t diff_clock = later - raw;
 	uint32_t diff_us = diff_clock; // (CLOCKS_PER_SEC / 1000);
 	return diff_us;
 }
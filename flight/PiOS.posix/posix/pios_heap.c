@@ -88,6 +88,22 @@ size_t PIOS_heap_get_free_size(void)
 	return 1024;
 }
 
+size_t PIOS_heap_get_free_size_no_dma(void)
+{
+	return 0;
+}
+
+bool PIOS_heap_get_ledger_entry(uint8_t idx, struct pios_heap_ledger_entry *entry)
+{
+	/* The ledger is only kept by the simple allocator */
+	return false;
+}
+
+size_t PIOS_heap_get_padding(void)
+{
+	return 0;
+}
+
 /**
  * @}
  * @}
@@ -0,0 +1,339 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SIL Lockstep software in the loop link
+ * @{
+ *
+ * @file       pios_sil.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Exchange sensor and actuator frames with the GCS SIL backend
+ *
+ * The GCS connects to a local TCP port and sends one sensor frame per step.
+ * A frame is read with the scheduler suspended, so no task runs and no time
+ * passes for the flight code while the GCS computes the next step.
+ *
+ * While a connection is up the flight code runs on simulation time only:
+ * PIOS_DELAY reports the time of the last sensor frame, and the host timer
+ * is stopped so the RTOS tick, and with it PIOS_Thread_Systime() and every
+ * timeout, is advanced from the sensor frames instead. When all tasks wait
+ * during a step the idle thread lends them ticks from the next step, which
+ * the next sensor frame then does not deliver again.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_SIL)
+
+#if !defined(PIOS_INCLUDE_CHIBIOS)
+#error "PIOS_SIL drives the ChibiOS tick and requires PIOS_INCLUDE_CHIBIOS"
+#endif
+
+#include "pios_thread.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+//! Time to wait between attempts to accept a connection
+#define PIOS_SIL_ACCEPT_PERIOD_MS 10
+//! Host time after which a GCS that stopped sending or reading is dropped
+#define PIOS_SIL_TRANSFER_TIMEOUT_MS 1000
+//! Length of an RTOS tick
+#define PIOS_SIL_TICK_US (1000000 / CH_FREQUENCY)
+
+static struct {
+	int listen_socket;
+	int socket;
+	bool active;            //!< The flight code runs on simulation time
+	bool resync;            //!< Next frame is the first of a new connection
+	uint32_t step;          //!< Step of the last sensor frame
+	uint32_t time_base;     //!< Raw time of simulation time 0
+	uint32_t time_us;       //!< Simulation time of the last sensor frame
+	uint32_t tick_time;     //!< Raw time of the last tick delivered
+	uint32_t host_offset;   //!< Added to the host time while not active
+} sil = {
+	.listen_socket = -1,
+	.socket = -1,
+};
+
+/**
+ * Listen for the GCS on a local port
+ * @param[in] port TCP port on the loopback interface
+ * @return 0 if successful, -1 if the port could not be opened
+ */
+int32_t PIOS_SIL_Init(uint16_t port)
+{
+	struct sockaddr_in server;
+	int optval = 1;
+
+	sil.listen_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sil.listen_socket < 0)
+		return -1;
+
+	setsockopt(sil.listen_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+
+	memset(&server, 0, sizeof(server));
+	server.sin_family = AF_INET;
+	server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	server.sin_port = htons(port);
+
+	if (bind(sil.listen_socket, (struct sockaddr *)&server, sizeof(server)) == -1 ||
+	    listen(sil.listen_socket, 1) == -1) {
+		perror("SIL socket");
+		close(sil.listen_socket);
+		sil.listen_socket = -1;
+		return -1;
+	}
+
+	/* Accept is polled from the sensors task */
+	int flags = fcntl(sil.listen_socket, F_GETFL, 0);
+	fcntl(sil.listen_socket, F_SETFL, flags | O_NONBLOCK);
+
+	printf("SIL listening on port %u\n", port);
+
+	return 0;
+}
+
+/**
+ * Whether the simulator was started with a SIL port, the sensors then come
+ * from PIOS_SIL_ReceiveSensors()
+ */
+bool PIOS_SIL_Enabled(void)
+{
+	return sil.listen_socket >= 0;
+}
+
+/**
+ * Start or stop the host timer that ticks the RTOS outside of SIL
+ */
+static void sil_host_timer(bool enable)
+{
+	struct itimerval itimer;
+
+	memset(&itimer, 0, sizeof(itimer));
+	if (enable) {
+		itimer.it_interval.tv_usec = PIOS_SIL_TICK_US;
+		itimer.it_value.tv_usec = PIOS_SIL_TICK_US;
+	}
+
+	setitimer(PORT_TIMER_TYPE, &itimer, NULL);
+}
+
+/**
+ * Deliver one RTOS tick, waking the tasks whose timeouts expire
+ */
+static void sil_tick(void)
+{
+	chSysLock();
+	chSysTimerHandlerI();
+	chSchRescheduleS();
+	chSysUnlock();
+
+	sil.tick_time += PIOS_SIL_TICK_US;
+}
+
+/**
+ * Switch the flight code between host and simulation time, keeping the
+ * raw time monotonic over the switch
+ */
+static void sil_set_active(bool active, uint32_t time_us)
+{
+	if (active == sil.active)
+		return;
+
+	if (active) {
+		sil.time_base = PIOS_DELAY_GetRaw() - time_us;
+		sil.time_us = time_us;
+		sil.tick_time = sil.time_base + time_us;
+		sil.active = true;
+		sil_host_timer(false);
+	} else {
+		uint32_t now = sil.time_base + sil.time_us;
+		sil.active = false;
+		sil.host_offset += now - PIOS_DELAY_GetRaw();
+		sil_host_timer(true);
+	}
+}
+
+static void sil_close(void)
+{
+	if (sil.socket >= 0) {
+		close(sil.socket);
+		sil.socket = -1;
+		fprintf(stderr, "SIL connection closed\n");
+	}
+
+	sil_set_active(false, 0);
+}
+
+static bool sil_accept(void)
+{
+	/* Polling the fd has to be executed in thread suspended mode
+	 * to get a correct errno value. */
+	PIOS_Thread_Scheduler_Suspend();
+	int fd = accept(sil.listen_socket, NULL, NULL);
+	PIOS_Thread_Scheduler_Resume();
+
+	if (fd < 0)
+		return false;
+
+	int optval = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+
+	sil.socket = fd;
+	sil.resync = true;
+	fprintf(stderr, "SIL connection accepted\n");
+
+	return true;
+}
+
+/**
+ * Transfer a whole frame, retrying when the tick signal interrupts the call.
+ * Fails if the GCS does not move any data for PIOS_SIL_TRANSFER_TIMEOUT_MS,
+ * as nothing else runs meanwhile.
+ */
+static bool sil_transfer(void *buf, size_t length, bool receive)
+{
+	uint8_t *p = buf;
+	struct pollfd pfd = {
+		.fd = sil.socket,
+		.events = receive ? POLLIN : POLLOUT,
+	};
+
+	PIOS_Thread_Scheduler_Suspend();
+
+	while (length > 0) {
+		int ready = poll(&pfd, 1, PIOS_SIL_TRANSFER_TIMEOUT_MS);
+		if (ready < 0 && errno == EINTR)
+			continue;
+		if (ready <= 0) {
+			if (ready == 0)
+				fprintf(stderr, "SIL %s timed out\n", receive ? "receive" : "send");
+			break;
+		}
+
+		ssize_t n = receive ? read(sil.socket, p, length) : write(sil.socket, p, length);
+		if (n > 0) {
+			p += n;
+			length -= n;
+		} else if (n < 0 && errno == EINTR) {
+			continue;
+		} else {
+			break;
+		}
+	}
+
+	PIOS_Thread_Scheduler_Resume();
+
+	return length == 0;
+}
+
+/**
+ * Wait for the sensor frame of the next step
+ * @param[out] frame The received frame
+ * @return 0 if a frame was received, -1 if there is no connection
+ */
+int32_t PIOS_SIL_ReceiveSensors(struct sil_sensor_frame *frame)
+{
+	if (sil.socket < 0 && !sil_accept()) {
+		PIOS_Thread_Sleep(PIOS_SIL_ACCEPT_PERIOD_MS);
+		return -1;
+	}
+
+	if (!sil_transfer(frame, sizeof(*frame), true) ||
+	    !sil_header_valid(&frame->header, SIL_FRAME_SENSORS, sizeof(*frame))) {
+		sil_close();
+		return -1;
+	}
+
+	if (sil.resync) {
+		sil_set_active(true, frame->time_us);
+		sil.resync = false;
+	}
+
+	sil.step = frame->header.step;
+	sil.time_us = frame->time_us;
+
+	/* Catch the tick up with the frame, less what the idle thread lent */
+	uint32_t now = sil.time_base + sil.time_us;
+	while ((int32_t)(now - sil.tick_time) >= PIOS_SIL_TICK_US)
+		sil_tick();
+
+	return 0;
+}
+
+/**
+ * Answer the last sensor frame
+ * @param[in] frame The outputs, the header is filled in here
+ * @return 0 if successful, -1 if the connection was lost
+ */
+int32_t PIOS_SIL_SendActuators(struct sil_actuator_frame *frame)
+{
+	if (sil.socket < 0)
+		return -1;
+
+	sil_header_init(&frame->header, SIL_FRAME_ACTUATORS, sizeof(*frame), sil.step);
+
+	if (!sil_transfer(frame, sizeof(*frame), false)) {
+		sil_close();
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Get the time the flight code runs on in the units of PIOS_DELAY_GetRaw()
+ * @param[in] host_us Time of the host clock
+ * @return the time of the last sensor frame while a connection is up,
+ * otherwise the host time moved on by the time spent on simulation time
+ */
+uint32_t PIOS_SIL_GetTime(uint32_t host_us)
+{
+	if (sil.active)
+		return sil.time_base + sil.time_us;
+
+	return host_us + sil.host_offset;
+}
+
+/**
+ * Called from the idle thread. With no task able to run during a step the
+ * remaining timeouts would never expire, so give them the next tick.
+ */
+void PIOS_SIL_Idle(void)
+{
+	if (sil.active)
+		sil_tick();
+}
+
+#endif /* PIOS_INCLUDE_SIL */
+
+/**
+  * @}
+  * @}
+  */
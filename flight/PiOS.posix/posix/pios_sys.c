@@ -40,23 +40,53 @@
 
 static bool debug_fpe=false;
 
+//! Port distance between two instances, leaves room for the 900x ports
+#define PIOS_SYS_INSTANCE_PORT_STRIDE 20
+
+static struct {
+	uint16_t instance;
+	char flash_file[32];
+} sys_instance = {
+	.flash_file = "theflash.bin",
+};
+
 static void Usage(char *cmdName) {
-	printf( "usage: %s [-f]\n"
+	printf( "usage: %s [-f] [-i instance] [-r seed] [-s port]\n"
 		"\n"
-		"\t-f\tEnables floating point exception trapping mode\n",
-		cmdName);
+		"\t-f\tEnables floating point exception trapping mode\n"
+		"\t-i\tRuns as instance n of a fleet, the ports move up by %d * n\n"
+		"\t  \tand the settings are kept in theflash<n>.bin\n"
+		"\t-r\tSeeds the sensor noise, defaults to instance + 1\n"
+		"\t-s\tTakes the sensors from a lockstep SIL link on port\n",
+		cmdName, PIOS_SYS_INSTANCE_PORT_STRIDE);
 
 	exit(1);
 }
 
 void PIOS_SYS_Args(int argc, char *argv[]) {
 	int opt;
+	int sil_port = -1;
+	int instance = 0;
+	long seed = -1;
 
-	while ((opt = getopt(argc, argv, "f")) != -1) {
+	while ((opt = getopt(argc, argv, "fi:r:s:")) != -1) {
 		switch (opt) {
 			case 'f':
 				debug_fpe=true;
 				break;
+			case 'i':
+				instance = atoi(optarg);
+				if (instance < 0 ||
+				    9000 + (instance + 1) * PIOS_SYS_INSTANCE_PORT_STRIDE > 65535) {
+					Usage(argv[0]);
+				}
+				break;
+			case 'r':
+				seed = atol(optarg);
+				break;
+			case 's':
+				sil_port = atoi(optarg);
+				break;
 			default:
 				Usage(argv[0]);
 				break;
@@ -66,6 +96,51 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 	if (optind < argc) {
 		Usage(argv[0]);
 	}
+
+	sys_instance.instance = instance;
+	if (instance > 0) {
+		snprintf(sys_instance.flash_file, sizeof(sys_instance.flash_file),
+			"theflash%d.bin", instance);
+	}
+
+	/* Instances started with the same seed see the same sensor noise */
+	srand(seed >= 0 ? (unsigned int)seed : (unsigned int)instance + 1);
+
+	if (sil_port >= 0) {
+#if defined(PIOS_INCLUDE_SIL)
+		if (PIOS_SIL_Init(sil_port + PIOS_SYS_PortOffset()) != 0) {
+			exit(1);
+		}
+#else
+		Usage(argv[0]);
+#endif /* PIOS_INCLUDE_SIL */
+	}
+}
+
+/**
+ * Instance number within a fleet of simulators on the same host, 0 when
+ * the simulator runs alone
+ */
+uint16_t PIOS_SYS_Instance(void)
+{
+	return sys_instance.instance;
+}
+
+/**
+ * Offset added to every port the simulator opens, so that the instances of
+ * a fleet do not collide
+ */
+uint16_t PIOS_SYS_PortOffset(void)
+{
+	return sys_instance.instance * PIOS_SYS_INSTANCE_PORT_STRIDE;
+}
+
+/**
+ * File that backs the flash of this instance
+ */
+const char *PIOS_SYS_FlashFile(void)
+{
+	return sys_instance.flash_file;
 }
 
 /**
@@ -156,6 +231,10 @@ int32_t PIOS_SYS_SerialNumberGetBinary(uint8_t *array)
 		array[i] = 0xff;
 	}
 
+	/* Tell the instances of a fleet apart */
+	array[PIOS_SYS_SERIAL_NUM_BINARY_LEN - 2] -= sys_instance.instance >> 8;
+	array[PIOS_SYS_SERIAL_NUM_BINARY_LEN - 1] -= sys_instance.instance & 0xff;
+
 	/* No error */
 	return 0;
 }
@@ -169,11 +248,12 @@ int32_t PIOS_SYS_SerialNumberGetBinary(uint8_t *array)
 int32_t PIOS_SYS_SerialNumberGet(char *str)
 {
 	/* Stored in the so called "electronic signature" */
-	int i;
-	for (i = 0; i < PIOS_SYS_SERIAL_NUM_ASCII_LEN; ++i) {
-		str[i] = 'F';
+	uint8_t array[PIOS_SYS_SERIAL_NUM_BINARY_LEN];
+	PIOS_SYS_SerialNumberGetBinary(array);
+
+	for (int i = 0; i < PIOS_SYS_SERIAL_NUM_BINARY_LEN; ++i) {
+		snprintf(&str[i * 2], 3, "%02X", array[i]);
 	}
-	str[i] = '\0';
 
 	/* No error */
 	return 0;
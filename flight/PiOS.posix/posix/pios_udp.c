@@ -149,7 +149,7 @@ int32_t PIOS_UDP_Init(uint32_t * udp_id, const struct pios_udp_cfg * cfg)
   memset(&udp_dev->client,0,sizeof(udp_dev->client));
   udp_dev->server.sin_family = AF_INET;
   udp_dev->server.sin_addr.s_addr = inet_addr(udp_dev->cfg->ip);
-  udp_dev->server.sin_port = htons(udp_dev->cfg->port);
+  udp_dev->server.sin_port = htons(udp_dev->cfg->port + PIOS_SYS_PortOffset());
   int res= bind(udp_dev->socket, (struct sockaddr *)&udp_dev->server,sizeof(udp_dev->server));
 
   /* Create transmit thread for this connection */
@@ -184,6 +184,18 @@ uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
 	return diff / us_ticks;
 }
 
+/**
+ * @brief Compare two raw times and convert the difference to us
+ * @param[in] raw the earlier raw time
+ * @param[in] later the later raw time
+ * @return A microsecond value
+ */
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+	uint32_t diff = later - raw;
+	return diff / us_ticks;
+}
+
 #endif
 
 /**
@@ -242,6 +242,40 @@ int32_t PIOS_FLASH_get_partition_size(uintptr_t partition_id, uint32_t *partitio
 	return 0;
 }
 
+/**
+ * @brief Find the size of the chip sector containing an offset within a partition
+ * @param[in] partition_id opaque handle for a specific partition
+ * @param[in] offset offset (in bytes) from beginning of partition
+ * @param[out] sector_size size (in bytes) of the sector containing the offset
+ * @return 0 if success or error code
+ * @retval -20 if partition_id is not a valid partition identifier
+ * @retval -22 if failed to find beginning of partition within the partition table
+ * @retval -23 if offset is beyond the end of the partition
+ */
+int32_t PIOS_FLASH_get_sector_size(uintptr_t partition_id, uint32_t offset, uint32_t *sector_size)
+{
+	PIOS_Assert(sector_size);
+
+	struct pios_flash_partition *partition = (struct pios_flash_partition *)partition_id;
+
+	if (!PIOS_FLASH_validate_partition(partition))
+		return -20;
+
+	struct pios_flash_sector_desc sector_desc;
+	if (!pios_flash_get_partition_first_sector(partition, &sector_desc))
+		return -22;
+
+	do {
+		if ((offset >= sector_desc.partition_offset) &&
+			(offset < sector_desc.partition_offset + sector_desc.sector_size)) {
+			*sector_size = sector_desc.sector_size;
+			return 0;
+		}
+	} while (pios_flash_get_partition_next_sector(partition, &sector_desc));
+
+	return -23;
+}
+
 /**
  * @brief Start an atomic transaction on the flash chip underlying this partition
  * @param[in] partition_id opaque handle for a specific partition
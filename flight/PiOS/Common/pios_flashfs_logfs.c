@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file       pios_flashfs_logfs.c
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
  * @addtogroup PIOS PIOS Core hardware abstraction layer
  * @{
  * @addtogroup PIOS_FLASHFS Flash Filesystem Function
@@ -32,6 +32,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memset */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
@@ -43,6 +44,16 @@ enum pios_flashfs_logfs_dev_magic {
 	PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
 
+/*
+ * Garbage collection copies the active slots into the next arena a few
+ * at a time while the current arena stays mounted.
+ */
+enum logfs_gc_state {
+	LOGFS_GC_IDLE,
+	LOGFS_GC_ERASING,	/* erasing the destination arena one sector at a time */
+	LOGFS_GC_COPYING,	/* copying active slots into the destination arena */
+};
+
 struct logfs_state {
 	enum pios_flashfs_logfs_dev_magic magic;
 	const struct flashfs_logfs_cfg *cfg;
@@ -59,8 +70,28 @@ struct logfs_state {
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
+
+	/*
+	 * RAM index of the mounted arena, one tag per slot.  Active slots
+	 * hold a hash of their (obj_id, obj_inst_id), all other slots hold
+	 * SLOT_TAG_NONE.  Lookups only read the headers of slots with a
+	 * matching tag.  NULL if there wasn't enough RAM for the index, in
+	 * which case every lookup scans the slot headers in flash.
+	 */
+	uint8_t *slot_tags;
+
+	/* Incremental garbage collection progress */
+	enum logfs_gc_state gc_state;
+	uint8_t gc_dst_arena_id;
+	uint32_t gc_erase_offset;	/* next byte of the destination arena to erase */
+	uint16_t gc_src_slot_id;	/* next slot of the mounted arena to copy */
+	uint16_t gc_dst_slot_id;	/* next unused slot in the destination arena */
+
+	struct flashfs_logfs_stats stats;
 };
 
+#define SLOT_TAG_NONE 0
+
 /*
  * Internal Utility functions
  */
@@ -78,6 +109,27 @@ static uintptr_t logfs_get_addr(const struct logfs_state *logfs, uint8_t arena_i
 		(slot_id  * logfs->cfg->slot_size));
 }
 
+/**
+ * @brief Compute the RAM index tag of an object, never SLOT_TAG_NONE
+ */
+static uint8_t logfs_slot_tag(uint32_t obj_id, uint16_t obj_inst_id)
+{
+	/* Multiplicative hashing, the top byte depends on all input bits */
+	uint32_t hash = (obj_id * 2654435761u) ^ obj_inst_id;
+	hash *= 2654435761u;
+
+	return (hash >> 24) ? (hash >> 24) : 1;
+}
+
+/**
+ * @brief Update the RAM index tag of a slot in the mounted arena
+ */
+static void logfs_set_slot_tag(const struct logfs_state *logfs, uint16_t slot_id, uint8_t tag)
+{
+	if (logfs->slot_tags)
+		logfs->slot_tags[slot_id] = tag;
+}
+
 /*
  * The bits within these enum values must progress ONLY
  * from 1 -> 0 so that we can write later ones on top
@@ -440,12 +492,17 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 		switch (slot_hdr.state) {
 		case SLOT_STATE_EMPTY:
 			logfs->num_free_slots++;
+			logfs_set_slot_tag(logfs, slot_id, SLOT_TAG_NONE);
 			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+			logfs_set_slot_tag(logfs, slot_id,
+				logfs_slot_tag(slot_hdr.obj_id, slot_hdr.obj_inst_id));
 			break;
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
+		default:
+			logfs_set_slot_tag(logfs, slot_id, SLOT_TAG_NONE);
 			break;
 		}
 	}
@@ -476,6 +533,8 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	if (logfs->slot_tags)
+		PIOS_free(logfs->slot_tags);
 	PIOS_free(logfs);
 }
 
@@ -520,6 +579,18 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->partition_id   = partition_id; /* underlying partition */
 	logfs->partition_size = partition_size; /* size of underlying partition */
 	logfs->mounted        = false;
+	logfs->gc_state       = LOGFS_GC_IDLE;
+	memset(&logfs->stats, 0, sizeof(logfs->stats));
+
+	/*
+	 * The index is optional, fall back to scanning flash if RAM is short.
+	 * A failed PIOS_malloc is fatal, so only ask for it when it fits.
+	 */
+	size_t slot_tags_size = cfg->arena_size / cfg->slot_size;
+	if (PIOS_heap_get_free_size() >= slot_tags_size + sizeof(uintptr_t))
+		logfs->slot_tags = (uint8_t *)PIOS_malloc(slot_tags_size);
+	else
+		logfs->slot_tags = NULL;
 
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
@@ -587,72 +658,223 @@ out_exit:
 	return rc;
 }
 
+/*
+ * Should a background garbage collection be started?
+ * true = the log is running low on unwritten slots and a collection would
+ *        reclaim at least 1/8th of the arena
+ *
+ * A collection erases a whole arena, so in a log that is mostly live objects
+ * it is not worth starting one for every slot that becomes obsolete.
+ */
+static bool logfs_gc_wanted(const struct logfs_state *logfs)
+{
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+	uint16_t num_obsolete_slots = (num_slots - 1) - logfs->num_free_slots - logfs->num_active_slots;
+	uint16_t min_obsolete_slots = (num_slots >= 8) ? (num_slots / 8) : 1;
+
+	return (num_obsolete_slots >= min_obsolete_slots) && (logfs->num_free_slots <= num_slots / 4);
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
-static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
-	PIOS_Assert (logfs->mounted);
+static void logfs_gc_start(struct logfs_state *logfs)
+{
+	PIOS_Assert(logfs->gc_state == LOGFS_GC_IDLE);
 
-	/* Source arena is the active arena */
-	uint8_t src_arena_id = logfs->active_arena_id;
+	logfs->gc_dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+	logfs->gc_erase_offset = 0;
+	logfs->gc_src_slot_id  = 1;
+	logfs->gc_dst_slot_id  = 1;
+	logfs->gc_state        = LOGFS_GC_ERASING;
+}
 
-	/* Compute destination arena */
-	uint8_t dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_gc_erase_step(struct logfs_state *logfs)
+{
+	uintptr_t arena_addr = logfs_get_addr(logfs, logfs->gc_dst_arena_id, 0);
+
+	if (logfs->gc_erase_offset < logfs->cfg->arena_size) {
+		/* Erase the next sector of the destination arena */
+		uint32_t sector_size;
+		if (PIOS_FLASH_get_sector_size(logfs->partition_id,
+						arena_addr + logfs->gc_erase_offset,
+						&sector_size) != 0) {
+			return -1;
+		}
 
-	/* Erase destination arena */
-	if (logfs_erase_arena (logfs, dst_arena_id) != 0) {
-		return -1;
+		if (PIOS_FLASH_erase_range(logfs->partition_id,
+						arena_addr + logfs->gc_erase_offset,
+						sector_size) != 0) {
+			return -2;
+		}
+
+		logfs->gc_erase_offset += sector_size;
+		logfs->stats.gc_erases++;
+		return 0;
 	}
 
-	/* Reserve the destination arena so we can start filling it */
-	if (logfs_reserve_arena (logfs, dst_arena_id) != 0) {
-		/* Unable to reserve the arena */
-		return -2;
+	/* Whole arena is erased, mark it as such and reserve it for filling */
+	struct arena_header arena_hdr = {
+		.magic = logfs->cfg->fs_magic,
+		.state = ARENA_STATE_ERASED,
+	};
+
+	if (PIOS_FLASH_write_data(logfs->partition_id,
+					arena_addr,
+					(uint8_t *)&arena_hdr,
+					sizeof(arena_hdr)) != 0) {
+		return -3;
 	}
 
-	/* Copy active slots from active arena to destination arena */
-	uint16_t dst_slot_id = 1;
-	for (uint16_t src_slot_id = 1;
-	     src_slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     src_slot_id++) {
-		struct slot_header slot_hdr;
-		uintptr_t src_addr = logfs_get_addr (logfs, src_arena_id, src_slot_id);
-		if (PIOS_FLASH_read_data(logfs->partition_id,
-						src_addr,
-						(uint8_t *)&slot_hdr,
-						sizeof (slot_hdr)) != 0) {
-			return -3;
-		}
+	if (logfs_reserve_arena(logfs, logfs->gc_dst_arena_id) != 0) {
+		return -4;
+	}
 
-		if (slot_hdr.state == SLOT_STATE_ACTIVE) {
-			uintptr_t dst_addr = logfs_get_addr (logfs, dst_arena_id, dst_slot_id);
-			if (logfs_raw_copy_bytes(logfs,
-							src_addr,
-							sizeof(slot_hdr) + slot_hdr.obj_size,
-							dst_addr) != 0) {
-				/* Failed to copy all bytes */
-				return -4;
-			}
-			dst_slot_id++;
+	logfs->gc_state = LOGFS_GC_COPYING;
+	return 0;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_gc_copy_step(struct logfs_state *logfs)
+{
+	struct slot_header slot_hdr;
+	uintptr_t src_addr = logfs_get_addr(logfs, logfs->active_arena_id, logfs->gc_src_slot_id);
+	if (PIOS_FLASH_read_data(logfs->partition_id,
+					src_addr,
+					(uint8_t *)&slot_hdr,
+					sizeof(slot_hdr)) != 0) {
+		return -1;
+	}
+
+	if (slot_hdr.state == SLOT_STATE_ACTIVE) {
+		uintptr_t dst_addr = logfs_get_addr(logfs, logfs->gc_dst_arena_id, logfs->gc_dst_slot_id);
+		if (logfs_raw_copy_bytes(logfs,
+						src_addr,
+						sizeof(slot_hdr) + slot_hdr.obj_size,
+						dst_addr) != 0) {
+			/* Failed to copy all bytes */
+			return -2;
 		}
+		logfs->gc_dst_slot_id++;
+		logfs->stats.gc_copies++;
 	}
 
+	logfs->gc_src_slot_id++;
+	return 0;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_gc_finish(struct logfs_state *logfs)
+{
+	uint8_t src_arena_id = logfs->active_arena_id;
+
 	/* Activate the destination arena */
-	if (logfs_activate_arena (logfs, dst_arena_id) != 0) {
-		return -5;
+	if (logfs_activate_arena(logfs, logfs->gc_dst_arena_id) != 0) {
+		return -1;
 	}
 
 	/* Unmount the source arena */
-	if (logfs_unmount_log (logfs) != 0) {
-		return -6;
+	if (logfs_unmount_log(logfs) != 0) {
+		return -2;
 	}
 
 	/* Obsolete the source arena */
-	if (logfs_obsolete_arena (logfs, src_arena_id) != 0) {
-		return -7;
+	if (logfs_obsolete_arena(logfs, src_arena_id) != 0) {
+		return -3;
 	}
 
 	/* Mount the new arena */
-	if (logfs_mount_log (logfs, dst_arena_id) != 0) {
-		return -8;
+	if (logfs_mount_log(logfs, logfs->gc_dst_arena_id) != 0) {
+		return -4;
+	}
+
+	logfs->gc_state = LOGFS_GC_IDLE;
+	logfs->stats.gc_runs++;
+	return 0;
+}
+
+/**
+ * @brief Do a bounded amount of garbage collection work
+ * @param[in] max_steps maximum number of sectors to erase plus slots to visit
+ * @return 0 if no collection is in progress anymore, 1 if there is more work to do, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_step(struct logfs_state *logfs, uint32_t max_steps)
+{
+	PIOS_Assert(logfs->mounted);
+
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+	int32_t rc = 0;
+
+#if defined(PIOS_INCLUDE_DELAY)
+	uint32_t start_time = PIOS_DELAY_GetRaw();
+#endif
+
+	for (uint32_t step = 0; step < max_steps && logfs->gc_state != LOGFS_GC_IDLE; step++) {
+		switch (logfs->gc_state) {
+		case LOGFS_GC_ERASING:
+			rc = logfs_gc_erase_step(logfs);
+			break;
+		case LOGFS_GC_COPYING:
+			/*
+			 * Slots keep getting appended to the mounted arena while we
+			 * copy, switch arenas once we've caught up with the end of the log
+			 */
+			if (logfs->gc_src_slot_id < num_slots - logfs->num_free_slots)
+				rc = logfs_gc_copy_step(logfs);
+			else
+				rc = logfs_gc_finish(logfs);
+			break;
+		case LOGFS_GC_IDLE:
+			break;
+		}
+
+		if (rc != 0) {
+			/* Give up, the next collection starts over with a fresh erase */
+			logfs->gc_state = LOGFS_GC_IDLE;
+			break;
+		}
+	}
+
+#if defined(PIOS_INCLUDE_DELAY)
+	uint32_t pause_us = PIOS_DELAY_DiffuS(start_time);
+	if (pause_us > logfs->stats.gc_max_pause_us)
+		logfs->stats.gc_max_pause_us = pause_us;
+#endif
+
+	if (rc != 0)
+		return rc;
+
+	return (logfs->gc_state == LOGFS_GC_IDLE) ? 0 : 1;
+}
+
+/**
+ * @brief Obsolete the copy of an object that has already been moved to the destination arena
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_drop_copy(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	for (uint16_t slot_id = 1; slot_id < logfs->gc_dst_slot_id; slot_id++) {
+		struct slot_header slot_hdr;
+		uintptr_t slot_addr = logfs_get_addr(logfs, logfs->gc_dst_arena_id, slot_id);
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)&slot_hdr,
+						sizeof(slot_hdr)) != 0) {
+			return -1;
+		}
+
+		if (slot_hdr.state == SLOT_STATE_ACTIVE &&
+			slot_hdr.obj_id      == obj_id &&
+			slot_hdr.obj_inst_id == obj_inst_id) {
+			slot_hdr.state = SLOT_STATE_OBSOLETE;
+			if (PIOS_FLASH_write_data(logfs->partition_id,
+							slot_addr,
+							(uint8_t *)&slot_hdr,
+							sizeof(slot_hdr)) != 0) {
+				return -2;
+			}
+		}
 	}
 
 	return 0;
@@ -667,9 +889,22 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	/* First slot in the arena is reserved for arena header, skip it. */
 	if (*curr_slot == 0) *curr_slot = 1;
 
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+	uint8_t tag = logfs_slot_tag(obj_id, obj_inst_id);
+
 	for (uint16_t slot_id = *curr_slot;
-	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
+	     slot_id < num_slots;
 	     slot_id++) {
+		if (logfs->slot_tags) {
+			/* Free slots are always at the end of the log */
+			if (slot_id >= num_slots - logfs->num_free_slots)
+				break;
+
+			/* Only look at slots which may hold this object */
+			if (logfs->slot_tags[slot_id] != tag)
+				continue;
+		}
+
 		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
 
 		if (PIOS_FLASH_read_data(logfs->partition_id,
@@ -720,6 +955,15 @@ static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, u
 			}
 			/* Object has been successfully obsoleted and is no longer active */
 			logfs->num_active_slots--;
+			logfs_set_slot_tag(logfs, curr_slot_id, SLOT_TAG_NONE);
+
+			/* Garbage collection may already have copied this slot */
+			if (logfs->gc_state == LOGFS_GC_COPYING &&
+				curr_slot_id < logfs->gc_src_slot_id &&
+				logfs_gc_drop_copy(logfs, obj_id, obj_inst_id) != 0) {
+				rc = -2;
+				goto out_exit;
+			}
 			break;
 		case -1:
 			/* Search completed, object not found */
@@ -832,6 +1076,8 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	logfs->stats.obj_writes++;
+	logfs_set_slot_tag(logfs, free_slot_id, logfs_slot_tag(obj_id, obj_inst_id));
 	return 0;
 }
 
@@ -897,9 +1143,21 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	/* Is garbage collection required? */
 	if (logfs_log_is_full(logfs)) {
 		/* Note: Log Full means the log is full but may contain obsolete slots so gc may free some space */
-		if (logfs_garbage_collect(logfs) != 0) {
-			rc = -5;
-			goto out_end_trans;
+		logfs->stats.gc_forced++;
+
+		/*
+		 * Finish the background collection in progress, if any.  It may
+		 * have copied slots that were obsoleted afterwards so run one
+		 * more complete collection if that didn't free up a slot.
+		 */
+		for (uint8_t run = 0; run < 2 && logfs_log_is_full(logfs); run++) {
+			if (logfs->gc_state == LOGFS_GC_IDLE)
+				logfs_gc_start(logfs);
+
+			if (logfs_gc_step(logfs, UINT32_MAX) != 0) {
+				rc = -5;
+				goto out_end_trans;
+			}
 		}
 		/* Check one more time just to be sure we actually free'd some space */
 		if (logfs_log_is_full(logfs)) {
@@ -1068,6 +1326,9 @@ int32_t PIOS_FLASHFS_Format(uintptr_t fs_id)
 		logfs_unmount_log(logfs);
 	}
 
+	/* Any collection in progress is moot now */
+	logfs->gc_state = LOGFS_GC_IDLE;
+
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -2;
 		goto out_exit;
@@ -1100,6 +1361,71 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Do some garbage collection in the background
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] max_steps Upper bound on the work done, in sectors erased plus slots visited
+ * @return 0 if no collection is in progress or error code
+ * @retval 1 if the collection needs more steps to complete
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if garbage collection failed
+ * @note Starts a new collection once the log is running low on unwritten
+ *       slots so that saves rarely have to wait for a complete one.
+ */
+int32_t PIOS_FLASHFS_Logfs_Background_GC(uintptr_t fs_id, uint16_t max_steps)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	if (logfs->gc_state == LOGFS_GC_IDLE) {
+		if (!logfs_gc_wanted(logfs)) {
+			rc = 0;
+			goto out_end_trans;
+		}
+		logfs_gc_start(logfs);
+	}
+
+	rc = logfs_gc_step(logfs, max_steps);
+	if (rc < 0)
+		rc = -3;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
+/**
+ * @brief Get the write and garbage collection statistics of a filesystem
+ * @param[in] fs_id The filesystem to query
+ * @param[out] stats The statistics since the filesystem was initialized
+ * @return 0 if success, -1 if fs_id is not a valid filesystem instance
+ */
+int32_t PIOS_FLASHFS_Logfs_Get_Stats(uintptr_t fs_id, struct flashfs_logfs_stats *stats)
+{
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs))
+		return -1;
+
+	*stats = logfs->stats;
+
+	return 0;
+}
+
 /**
  * @}
  * @}
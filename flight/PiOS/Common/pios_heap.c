@@ -62,6 +62,55 @@ struct pios_heap {
 	uintptr_t free_addr;
 };
 
+#if defined(DIAG_HEAP)
+/*
+ * Allocation ledger.  Allocations are summed up per caller, region and
+ * DMA requirement so the table stays small.  The last entry collects
+ * everything that doesn't fit anymore with a caller of 0.
+ */
+static struct pios_heap_ledger_entry ledger[PIOS_HEAP_LEDGER_LEN];
+static size_t ledger_padding;
+
+static void ledger_record(uintptr_t caller, enum pios_heap_region region, bool no_dma, size_t size, uint32_t align_pad)
+{
+	struct pios_heap_ledger_entry *entry = &ledger[PIOS_HEAP_LEDGER_LEN - 1];
+
+	for (uint8_t i = 0; i < PIOS_HEAP_LEDGER_LEN - 1; i++) {
+		if (ledger[i].allocations == 0) {
+			ledger[i].caller = caller;
+			ledger[i].region = region;
+			ledger[i].no_dma = no_dma;
+			entry = &ledger[i];
+			break;
+		}
+		if (ledger[i].caller == caller && ledger[i].region == region && ledger[i].no_dma == no_dma) {
+			entry = &ledger[i];
+			break;
+		}
+	}
+
+	if (entry == &ledger[PIOS_HEAP_LEDGER_LEN - 1]) {
+		/* The overflow entry describes whatever lands in it */
+		if (entry->allocations == 0) {
+			entry->region = region;
+			entry->no_dma = no_dma;
+		} else {
+			if (entry->region != region)
+				entry->region = PIOS_HEAP_REGION_MIXED;
+			if (entry->no_dma != no_dma)
+				entry->dma_mixed = true;
+		}
+	}
+
+	entry->bytes += size;
+	if (entry->allocations < UINT16_MAX)
+		entry->allocations++;
+	ledger_padding += align_pad;
+}
+#endif	/* DIAG_HEAP */
+
+static struct pios_heap pios_standard_heap;	/* defined below */
+
 static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
 {
 	uintptr_t buf_addr = (uintptr_t)buf;
@@ -69,7 +118,7 @@ static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
 	return ((buf_addr >= heap->start_addr) && (buf_addr <= heap->end_addr));
 }
 
-static void * simple_malloc(struct pios_heap *heap, size_t size)
+static void * simple_malloc(struct pios_heap *heap, size_t size, uintptr_t caller, bool no_dma)
 {
 	if (heap == NULL)
 		return NULL;
@@ -84,6 +133,10 @@ static void * simple_malloc(struct pios_heap *heap, size_t size)
 	if (heap->free_addr + size <= heap->end_addr) {
 		buf = (void *)heap->free_addr;
 		heap->free_addr += size + align_pad;
+#if defined(DIAG_HEAP)
+		ledger_record(caller, heap == &pios_standard_heap ? PIOS_HEAP_REGION_STANDARD : PIOS_HEAP_REGION_FAST,
+			no_dma, size, align_pad);
+#endif	/* DIAG_HEAP */
 	}
 
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
@@ -125,10 +178,9 @@ static struct pios_heap pios_standard_heap = {
 };
 
 
-void * pvPortMalloc(size_t size) __attribute__((alias ("PIOS_malloc"), weak));
-void * PIOS_malloc(size_t size)
+static void * standard_malloc(size_t size, uintptr_t caller, bool no_dma)
 {
-	void *buf = simple_malloc(&pios_standard_heap, size);
+	void *buf = simple_malloc(&pios_standard_heap, size, caller, no_dma);
 
 	if (buf == NULL)
 		malloc_failed_hook();
@@ -136,6 +188,12 @@ void * PIOS_malloc(size_t size)
 	return buf;
 }
 
+void * pvPortMalloc(size_t size) __attribute__((alias ("PIOS_malloc"), weak));
+void * PIOS_malloc(size_t size)
+{
+	return standard_malloc(size, (uintptr_t)__builtin_return_address(0), false);
+}
+
 /*
  * Fast heap.  Memory in this heap is NOT DMA-safe.
  * Note: This should not be used to allocate RAM for task stacks since a task may pass
@@ -153,10 +211,11 @@ static struct pios_heap pios_nodma_heap = {
 };
 void * PIOS_malloc_no_dma(size_t size)
 {
-	void * buf = simple_malloc(&pios_nodma_heap, size);
+	uintptr_t caller = (uintptr_t)__builtin_return_address(0);
+	void * buf = simple_malloc(&pios_nodma_heap, size, caller, true);
 
 	if (buf == NULL)
-		buf = PIOS_malloc(size);
+		buf = standard_malloc(size, caller, true);
 
 	if (buf == NULL)
 		malloc_failed_hook();
@@ -169,7 +228,7 @@ void * PIOS_malloc_no_dma(size_t size)
 /* This platform only has a standard heap.  Fall back directly to that */
 void * PIOS_malloc_no_dma(size_t size)
 {
-	return PIOS_malloc(size);
+	return standard_malloc(size, (uintptr_t)__builtin_return_address(0), true);
 }
 
 #endif	/* PIOS_INCLUDE_FASTHEAP */
@@ -202,6 +261,63 @@ size_t PIOS_heap_get_free_size(void)
 	return free_bytes;
 }
 
+size_t PIOS_heap_get_free_size_no_dma(void)
+{
+#if defined(PIOS_INCLUDE_FASTHEAP)
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Scheduler_Suspend();
+#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	size_t free_bytes = simple_get_free_bytes(&pios_nodma_heap);
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Scheduler_Resume();
+#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	return free_bytes;
+#else
+	return 0;
+#endif	/* PIOS_INCLUDE_FASTHEAP */
+}
+
+/**
+ * Copy one entry of the allocation ledger
+ * @param[in] idx index of the entry, 0 to PIOS_HEAP_LEDGER_LEN - 1
+ * @param[out] entry the ledger entry
+ * @return true if the entry is in use, false if it is empty or the ledger is not compiled in
+ */
+bool PIOS_heap_get_ledger_entry(uint8_t idx, struct pios_heap_ledger_entry *entry)
+{
+#if defined(DIAG_HEAP)
+	if (idx >= PIOS_HEAP_LEDGER_LEN)
+		return false;
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Scheduler_Suspend();
+#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+	*entry = ledger[idx];
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Scheduler_Resume();
+#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	return entry->allocations > 0;
+#else
+	return false;
+#endif	/* DIAG_HEAP */
+}
+
+/**
+ * Bytes lost to aligning allocations, only tracked with DIAG_HEAP
+ */
+size_t PIOS_heap_get_padding(void)
+{
+#if defined(DIAG_HEAP)
+	return ledger_padding;
+#else
+	return 0;
+#endif	/* DIAG_HEAP */
+}
+
 void vPortInitialiseBlocks(void) __attribute__((alias ("PIOS_heap_initialize_blocks")));
 void PIOS_heap_initialize_blocks(void)
 {
@@ -26,6 +26,7 @@
 
 #include "pios.h"
 #include "pios_queue.h"
+#include "pios_thread.h"
 
 #if !defined(PIOS_INCLUDE_FREERTOS) && !defined(PIOS_INCLUDE_CHIBIOS)
 #error "pios_queue.c requires PIOS_INCLUDE_FREERTOS or PIOS_INCLUDE_CHIBIOS"
@@ -129,7 +130,15 @@ bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep, const void *itemp, bool
  */
 bool PIOS_Queue_Receive(struct pios_queue *queuep, void *itemp, uint32_t timeout_ms)
 {
+#if defined(DIAG_TASKS)
+	uint32_t wait_start = PIOS_Thread_Trace_Counter();
+	bool received = xQueueReceive((xQueueHandle)queuep->queue_handle, itemp, MS2TICKS(timeout_ms)) == pdTRUE;
+	PIOS_Thread_Trace_Queue_Wait(wait_start);
+
+	return received;
+#else
 	return xQueueReceive((xQueueHandle)queuep->queue_handle, itemp, MS2TICKS(timeout_ms)) == pdTRUE;
+#endif /* defined(DIAG_TASKS) */
 }
 
 #elif defined(PIOS_INCLUDE_CHIBIOS)
@@ -278,7 +287,13 @@ bool PIOS_Queue_Receive(struct pios_queue *queuep, void *itemp, uint32_t timeout
 	else
 		timeout = MS2ST(timeout_ms);
 
+#if defined(DIAG_TASKS)
+	uint32_t wait_start = PIOS_Thread_Trace_Counter();
+	msg_t result = chMBFetch(&queuep->mb, &buf, timeout);
+	PIOS_Thread_Trace_Queue_Wait(wait_start);
+#else
 	msg_t result = chMBFetch(&queuep->mb, &buf, timeout);
+#endif /* defined(DIAG_TASKS) */
 
 	if (result != RDY_OK)
 		return false;
@@ -469,9 +469,6 @@ int32_t PIOS_RFM22B_Init(uint32_t * rfm22b_id, uint32_t spi_id,
 	PIOS_WDG_RegisterFlag(PIOS_WDG_RFM22B);
 #endif /* PIOS_WDG_RFM22B */
 
-	// Initialize the ECC library.
-	initialize_ecc();
-
 	// Set the state to initializing.
 	rfm22b_dev->state = RADIO_STATE_UNINITIALIZED;
 
@@ -1854,7 +1851,7 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev
 	// Add the error correcting code.
 	if (!radio_dev->ppm_only_mode) {
 		if (len != 0) {
-			encode_data((unsigned char *)p, len, (unsigned char *)p);
+			rs_encode((unsigned char *)p, len, (unsigned char *)p);
 		} else {
 			for (uint32_t i = 0; i < RS_ECC_NPARITY; i++)
 				p[i] = EMPTY_PACKET + i;
@@ -1940,14 +1937,16 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev
 
 		// Attempt to correct any errors in the packet.
 		if (data_len > 0) {
-			decode_data((unsigned char *)p, rx_len);
-			good_packet = check_syndrome() == 0;
-
-			// We have an error.  Try to correct it.
-			if (!good_packet &&
-			    (correct_errors_erasures((unsigned char *)p, rx_len, 0, 0) != 0)) {
-				// We corrected it
+			switch (rs_decode((unsigned char *)p, rx_len)) {
+			case RS_DECODE_OK:
+				good_packet = true;
+				break;
+			case RS_DECODE_CORRECTED:
+				// We had an error and corrected it
 				corrected_packet = true;
+				break;
+			default:
+				break;
 			}
 		} else {
 			// Empty packets have specific code for ECC
@@ -47,8 +47,19 @@
  * sector has a footer to indicate the file id and the sector id.
  *
  * Arenas map onto sectors. 
+ *
+ * Appends are collected in a RAM buffer of cfg->write_size bytes (the flash
+ * page size) so that the many small frames coming in through PIOS_COM end up
+ * as page aligned writes of whole pages. The buffer is written out when the
+ * page fills up, when the file is closed or when data has been sitting in it
+ * for longer than STREAMFS_FLUSH_TIMEOUT_US. The timeout is checked on every
+ * append and by PIOS_STREAMFS_Flush_Stale, which the writer should call
+ * periodically so that the tail of a stream which went quiet gets to flash.
  */
 
+/* Write out a partially filled page after this long (needs PIOS_INCLUDE_DELAY) */
+#define STREAMFS_FLUSH_TIMEOUT_US 1000000
+
 #include <pios_com.h>
 
 /* Provide a COM driver */
@@ -92,6 +103,14 @@ struct streamfs_state {
 	int32_t active_file_arena;
 	int32_t active_file_arena_offset;
 
+	/* Data appended to the open file which is not in flash yet. It belongs
+	 * at active_file_arena_offset and never crosses a page boundary. */
+	uint8_t *write_buffer;
+	uint32_t write_buffer_len;
+	uint32_t write_buffer_time;
+
+	struct streamfs_stats stats;
+
 	/* Information about file system contents */
 	int32_t min_file_id;
 	int32_t max_file_id;
@@ -135,7 +154,7 @@ struct streamfs_footer {
  * @return 0 if success, < 0 on failure
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t streamfs_erase_arena(const struct streamfs_state *streamfs, uint16_t arena_id)
+static int32_t streamfs_erase_arena(struct streamfs_state *streamfs, uint16_t arena_id)
 {
 	uintptr_t arena_addr = streamfs_get_addr(streamfs, arena_id, 0);
 
@@ -144,6 +163,8 @@ static int32_t streamfs_erase_arena(const struct streamfs_state *streamfs, uint1
 		return -1;
 	}
 
+	streamfs->stats.arena_erases++;
+
 	/* Arena is ready to be written to */
 	return 0;
 }
@@ -153,7 +174,7 @@ static int32_t streamfs_erase_arena(const struct streamfs_state *streamfs, uint1
  * @return 0 if success, < 0 on failure
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t streamfs_erase_all_arenas(const struct streamfs_state *streamfs)
+static int32_t streamfs_erase_all_arenas(struct streamfs_state *streamfs)
 {
 	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
 
@@ -177,6 +198,7 @@ static struct streamfs_state *streamfs_alloc(void)
 	streamfs = (struct streamfs_state *)PIOS_malloc(sizeof(*streamfs));
 	if (!streamfs) return (NULL);
 
+	memset(streamfs, 0, sizeof(*streamfs));
 	streamfs->magic = PIOS_FLASHFS_STREAMFS_DEV_MAGIC;
 	return(streamfs);
 }
@@ -185,9 +207,30 @@ static void streamfs_free(struct streamfs_state *streamfs)
 {
 	/* Invalidate the magic */
 	streamfs->magic = ~PIOS_FLASHFS_STREAMFS_DEV_MAGIC;
+	if (streamfs->com_buffer)
+		PIOS_free(streamfs->com_buffer);
+	if (streamfs->write_buffer)
+		PIOS_free(streamfs->write_buffer);
 	PIOS_free(streamfs);
 }
 
+/**
+ * @brief Write data to the partition and account for it
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_write_flash(struct streamfs_state *streamfs, uint32_t addr, const uint8_t *data, uint32_t len)
+{
+	if (PIOS_FLASH_write_data(streamfs->partition_id, addr, data, len) != 0) {
+		return -1;
+	}
+
+	streamfs->stats.flash_writes++;
+	streamfs->stats.flash_bytes += len;
+
+	return 0;
+}
+
 /**
  * Write footer to current sector and reset pointers for writing to
  * next sector
@@ -204,7 +247,7 @@ static int32_t streamfs_new_sector(struct streamfs_state *streamfs)
 	uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
 			                                   streamfs->cfg->arena_size - sizeof(footer));
 
-	if (PIOS_FLASH_write_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+	if (streamfs_write_flash(streamfs, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
 		return -1;
 	}
 
@@ -235,7 +278,7 @@ static int32_t streamfs_close_sector(struct streamfs_state *streamfs)
 	uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
 			                                   streamfs->cfg->arena_size - sizeof(footer));
 
-	if (PIOS_FLASH_write_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+	if (streamfs_write_flash(streamfs, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
 		return -1;
 	}
 
@@ -346,6 +389,77 @@ static int32_t streamfs_find_new_sector(struct streamfs_state *streamfs)
 	return (last_sector + 1) % num_arenas;
 }
 
+/**
+ * Number of bytes that fit in the write buffer for the current position,
+ * which is up to the next page boundary or the footer, whichever comes first
+ */
+static uint32_t streamfs_page_space(const struct streamfs_state *streamfs)
+{
+	uint32_t data_end = streamfs->cfg->arena_size - sizeof(struct streamfs_footer);
+	uint32_t page_end = (streamfs->active_file_arena_offset / streamfs->cfg->write_size + 1) * streamfs->cfg->write_size;
+
+	return MIN(page_end, data_end) - streamfs->active_file_arena_offset;
+}
+
+/**
+ * Write (part of) a page at the current position of the file and move on,
+ * starting a new sector when the current one is full
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t streamfs_write_page(struct streamfs_state *streamfs, const uint8_t *data, uint32_t len)
+{
+	uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
+		                                       streamfs->active_file_arena_offset);
+
+	if (streamfs_write_flash(streamfs, start_address, data, len) != 0) {
+		return -1;
+	}
+
+	streamfs->active_file_arena_offset += len;
+
+	if (streamfs->active_file_arena_offset >= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
+		if (streamfs_new_sector(streamfs) != 0) {
+			return -2;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Write out whatever is in the write buffer, even if the page is not full
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t streamfs_flush_buffer(struct streamfs_state *streamfs)
+{
+	if (streamfs->write_buffer_len == 0)
+		return 0;
+
+	if (streamfs->write_buffer_len < streamfs_page_space(streamfs))
+		streamfs->stats.partial_flushes++;
+
+	uint32_t len = streamfs->write_buffer_len;
+	streamfs->write_buffer_len = 0;
+
+	return streamfs_write_page(streamfs, streamfs->write_buffer, len);
+}
+
+/**
+ * Write out the write buffer if data has been sitting in it for too long
+ */
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t streamfs_flush_stale_buffer(struct streamfs_state *streamfs)
+{
+#if defined(PIOS_INCLUDE_DELAY)
+	if (streamfs->write_buffer_len > 0 &&
+	    PIOS_DELAY_DiffuS(streamfs->write_buffer_time) > STREAMFS_FLUSH_TIMEOUT_US) {
+		return streamfs_flush_buffer(streamfs);
+	}
+#endif
+
+	return 0;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t *data, uint32_t len)
 {
@@ -358,31 +472,42 @@ static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t
 	uint32_t total_written = 0;
 
 	while (len > 0) {
-		uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
-			                                                 streamfs->active_file_arena_offset);
+		uint32_t space = streamfs_page_space(streamfs);
+		uint32_t bytes_to_write = MIN(len, space - streamfs->write_buffer_len);
 
-		// Make sure not to write into the space for the footer
-		uint32_t bytes_to_write = len;
-		if ((streamfs->active_file_arena_offset + bytes_to_write) > (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
-			bytes_to_write = streamfs->cfg->arena_size - sizeof(struct streamfs_footer) - streamfs->active_file_arena_offset;
-		}
+		if (streamfs->write_buffer_len == 0 && bytes_to_write == space) {
+			// A whole page from the caller, no need to copy it
+			if (streamfs_write_page(streamfs, data, bytes_to_write) != 0) {
+				return -3;
+			}
+		} else {
+			if (streamfs->write_buffer_len == 0) {
+#if defined(PIOS_INCLUDE_DELAY)
+				streamfs->write_buffer_time = PIOS_DELAY_GetRaw();
+#endif
+			}
 
-		if (PIOS_FLASH_write_data(streamfs->partition_id, start_address, data, bytes_to_write) != 0) {
-			return -3;
+			memcpy(&streamfs->write_buffer[streamfs->write_buffer_len], data, bytes_to_write);
+			streamfs->write_buffer_len += bytes_to_write;
+
+			if (streamfs->write_buffer_len == space) {
+				if (streamfs_flush_buffer(streamfs) != 0) {
+					return -4;
+				}
+			}
 		}
 
 		// Increment pointers
-		streamfs->active_file_arena_offset += bytes_to_write;
 		len -= bytes_to_write;
 		total_written += bytes_to_write;
 		data = &data[bytes_to_write];
+	}
 
+	streamfs->stats.bytes_appended += total_written;
 
-		if (streamfs->active_file_arena_offset >= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
-			if (streamfs_new_sector(streamfs) != 0) {
-				return -4;
-			}
-		}
+	// Don't let a slow trickle of data sit in RAM indefinitely
+	if (streamfs_flush_stale_buffer(streamfs) != 0) {
+		return -4;
 	}
 
 	return total_written;
@@ -532,6 +657,9 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	/* sector_size must exceed write_size */
 	PIOS_Assert(cfg->arena_size > cfg->write_size);
 
+	/* and be a whole number of pages so buffered writes stay page aligned */
+	PIOS_Assert((cfg->arena_size % cfg->write_size) == 0);
+
 	int8_t rc;
 
 	struct streamfs_state *streamfs;
@@ -543,8 +671,9 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	}
 
 	streamfs->com_buffer = (uint8_t *)PIOS_malloc(cfg->write_size);
-	if (!streamfs->com_buffer) {
-		PIOS_free(streamfs);
+	streamfs->write_buffer = (uint8_t *)PIOS_malloc(cfg->write_size);
+	if (!streamfs->com_buffer || !streamfs->write_buffer) {
+		streamfs_free(streamfs);
 		return -1;
 	}
 
@@ -559,6 +688,9 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 	streamfs->active_file_id           = 0;
 	streamfs->active_file_arena        = 0;
 	streamfs->active_file_arena_offset = 0;
+	streamfs->write_buffer_len         = 0;
+
+	memset(&streamfs->stats, 0, sizeof(streamfs->stats));
 
 	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
 		rc = -1;
@@ -683,6 +815,7 @@ int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id)
 	streamfs->active_file_segment = 0;
 	streamfs->active_file_arena = streamfs_find_new_sector(streamfs);
 	streamfs->active_file_arena_offset = 0;
+	streamfs->write_buffer_len = 0;
 	streamfs->file_open_writing = true;
 
 	// Erase this sector to prepare for streaming
@@ -797,7 +930,13 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		goto out_exit;
 	}
 
-	if (streamfs->active_file_segment != 0 && streamfs->active_file_arena_offset != 0) {
+	// Write out the tail of the file still in RAM
+	if (streamfs_flush_buffer(streamfs) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
+	if (streamfs->active_file_arena_offset != 0) {
 		// Close segment when something has been written. This avoids creating
 		// null files with an open/close operation
 		if (streamfs_close_sector(streamfs) != 0) {
@@ -806,8 +945,6 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		}
 	}
 
-
-	// TODO: make sure to flush remaining data
 	streamfs->file_open_writing = false;
 
 	if (streamfs_scan_filesystem(streamfs) != 0) {
@@ -824,6 +961,67 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Write out a partially filled page that has been buffered for too long
+ * @param[in] fs_id The filesystem to flush
+ * @return 0 if success or nothing to do, -1 if fs_id is not a valid filesystem
+ * instance, -2 if failed to start transaction, -3 if the flash write failed
+ * @note Call this periodically while a file is open for writing, appends
+ *       only check the timeout when more data arrives
+ */
+int32_t PIOS_STREAMFS_Flush_Stale(uintptr_t fs_id)
+{
+	int32_t rc;
+
+	struct streamfs_state *streamfs = (struct streamfs_state *)fs_id;
+
+	if (!streamfs_validate(streamfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (!streamfs->file_open_writing) {
+		rc = 0;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	if (streamfs_flush_stale_buffer(streamfs) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
+	rc = 0;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(streamfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
+/**
+ * @brief Get the write statistics of a filesystem
+ * @param[in] fs_id The filesystem to query
+ * @param[out] stats The statistics since the filesystem was initialized
+ * @return 0 if success, -1 if fs_id is not a valid filesystem instance
+ */
+int32_t PIOS_STREAMFS_Get_Stats(uintptr_t fs_id, struct streamfs_stats *stats)
+{
+	struct streamfs_state *streamfs = (struct streamfs_state *)fs_id;
+
+	if (!streamfs_validate(streamfs))
+		return -1;
+
+	*stats = streamfs->stats;
+
+	return 0;
+}
+
 // Testing methods for unit tests
 
 int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len)
@@ -956,11 +1154,14 @@ static void PIOS_STREAMFS_TxStart(uintptr_t fs_id, uint16_t tx_bytes_avail)
 		if (bytes_to_write <= 0)
 			break;
 
-		if (streamfs_append_to_file (streamfs, streamfs->com_buffer, bytes_to_write) != 0) {
+		if (streamfs_append_to_file (streamfs, streamfs->com_buffer, bytes_to_write) < 0) {
 			goto out_end_trans;
 		}
 	}
 
+	// Also flush when this start did not bring in any new data
+	streamfs_flush_stale_buffer(streamfs);
+
 out_end_trans:
 	PIOS_FLASH_end_transaction(streamfs->partition_id);
 }
@@ -65,12 +65,23 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 
 	thread->task_handle = (uintptr_t)NULL;
 
+#if (configUSE_APPLICATION_TASK_TAG == 1)
+	thread->switched_in = 0;
+	thread->switch_count = 0;
+	thread->max_activation = 0;
+	thread->queue_wait = 0;
+#endif /* (configUSE_APPLICATION_TASK_TAG == 1) */
+
 	if (xTaskCreate(fp, (signed char*)namep, stack_bytes / 4, argp, prio, (xTaskHandle*)&thread->task_handle) != pdPASS)
 	{
 		PIOS_free(thread);
 		return NULL;
 	}
 
+#if (configUSE_APPLICATION_TASK_TAG == 1)
+	vTaskSetApplicationTaskTag((xTaskHandle)thread->task_handle, (pdTASK_HOOK_CODE)thread);
+#endif /* (configUSE_APPLICATION_TASK_TAG == 1) */
+
 	return thread;
 }
 
@@ -181,6 +192,119 @@ uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp)
 #endif /* (INCLUDE_uxTaskGetRunTime == 1) */
 }
 
+#if (configUSE_APPLICATION_TASK_TAG == 1)
+static void *last_switched_out;
+
+/**
+ *
+ * @brief   Scheduler hook, called before a task is switched out.
+ *
+ * @param[in] tag          the @p struct pios_thread of the task, or NULL
+ *
+ */
+void PIOS_Thread_Trace_Switched_Out(void *tag)
+{
+	struct pios_thread *threadp = (struct pios_thread *)tag;
+
+	last_switched_out = tag;
+	if (threadp == NULL)
+		return;
+
+	uint32_t run = portGET_RUN_TIME_COUNTER_VALUE() - threadp->switched_in;
+	if (run > threadp->max_activation)
+		threadp->max_activation = run;
+}
+
+/**
+ *
+ * @brief   Scheduler hook, called after a task has been selected to run.
+ *
+ * @param[in] tag          the @p struct pios_thread of the task, or NULL
+ *
+ */
+void PIOS_Thread_Trace_Switched_In(void *tag)
+{
+	struct pios_thread *threadp = (struct pios_thread *)tag;
+
+	/* The scheduler may pick the task that was already running */
+	if (threadp == NULL || tag == last_switched_out)
+		return;
+
+	threadp->switched_in = portGET_RUN_TIME_COUNTER_VALUE();
+	threadp->switch_count++;
+}
+#endif /* (configUSE_APPLICATION_TASK_TAG == 1) */
+
+/**
+ *
+ * @brief   Returns and resets the scheduler statistics of a thread.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[out] stats       statistics since the previous call
+ *
+ * @return true if the statistics are collected on this build
+ *
+ */
+bool PIOS_Thread_Get_Sched_Stats(struct pios_thread *threadp, struct pios_thread_sched_stats *stats)
+{
+#if (configUSE_APPLICATION_TASK_TAG == 1)
+	taskENTER_CRITICAL();
+
+	uint32_t max_activation = threadp->max_activation;
+	stats->switches = threadp->switch_count;
+	stats->queue_wait = threadp->queue_wait;
+	threadp->max_activation = 0;
+	threadp->switch_count = 0;
+	threadp->queue_wait = 0;
+
+	taskEXIT_CRITICAL();
+
+	stats->max_activation_us = (uint64_t)max_activation * 1000000 / configCPU_CLOCK_HZ;
+
+	return true;
+#else
+	memset(stats, 0, sizeof(*stats));
+
+	return false;
+#endif /* (configUSE_APPLICATION_TASK_TAG == 1) */
+}
+
+/**
+ *
+ * @brief   Returns the counter used for run time statistics.
+ *
+ */
+uint32_t PIOS_Thread_Trace_Counter(void)
+{
+#if (configGENERATE_RUN_TIME_STATS == 1)
+	return portGET_RUN_TIME_COUNTER_VALUE();
+#else
+	return 0;
+#endif /* (configGENERATE_RUN_TIME_STATS == 1) */
+}
+
+/**
+ *
+ * @brief   Charges the calling thread with the time spent waiting on a queue.
+ *
+ * @param[in] start        value of @p PIOS_Thread_Trace_Counter when the wait began
+ *
+ */
+void PIOS_Thread_Trace_Queue_Wait(uint32_t start)
+{
+#if (configUSE_APPLICATION_TASK_TAG == 1)
+	struct pios_thread *threadp = (struct pios_thread *)xTaskGetApplicationTaskTag(NULL);
+	if (threadp == NULL)
+		return;
+
+	uint32_t wait = portGET_RUN_TIME_COUNTER_VALUE() - start;
+
+	taskENTER_CRITICAL();
+	threadp->queue_wait += wait;
+	taskEXIT_CRITICAL();
+#endif /* (configUSE_APPLICATION_TASK_TAG == 1) */
+}
+
 /**
  *
  * @brief   Suspends execution of all threads.
@@ -406,6 +530,60 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 	return result;
 }
 
+/**
+ *
+ * @brief   Returns and resets the scheduler statistics of a thread.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ * @param[out] stats       statistics since the previous call
+ *
+ * @return true if the statistics are collected on this build
+ *
+ */
+bool PIOS_Thread_Get_Sched_Stats(struct pios_thread *threadp, struct pios_thread_sched_stats *stats)
+{
+	chSysLock();
+
+	halrtcnt_t max_activation = threadp->threadp->ticks_max_activation;
+	stats->switches = threadp->threadp->switch_count;
+	stats->queue_wait = threadp->threadp->ticks_queue_wait;
+	threadp->threadp->ticks_max_activation = 0;
+	threadp->threadp->switch_count = 0;
+	threadp->threadp->ticks_queue_wait = 0;
+
+	chSysUnlock();
+
+	stats->max_activation_us = (uint64_t)max_activation * 1000000 / halGetCounterFrequency();
+
+	return true;
+}
+
+/**
+ *
+ * @brief   Returns the counter used for run time statistics.
+ *
+ */
+uint32_t PIOS_Thread_Trace_Counter(void)
+{
+	return halGetCounterValue();
+}
+
+/**
+ *
+ * @brief   Charges the calling thread with the time spent waiting on a queue.
+ *
+ * @param[in] start        value of @p PIOS_Thread_Trace_Counter when the wait began
+ *
+ */
+void PIOS_Thread_Trace_Queue_Wait(uint32_t start)
+{
+	halrtcnt_t wait = halGetCounterValue() - start;
+
+	chSysLock();
+	chThdSelf()->ticks_queue_wait += wait;
+	chSysUnlock();
+}
+
 /**
  *
  * @brief   Suspends execution of all threads.
@@ -42,8 +42,25 @@ struct flashfs_logfs_cfg {
 	uint32_t slot_size;	/* Max size of a "file" within the filesystem */
 };
 
+/**
+ * Write and garbage collection statistics of a logfs filesystem.  The write
+ * amplification is (obj_writes + gc_copies) / obj_writes.
+ */
+struct flashfs_logfs_stats {
+	uint32_t obj_writes;		/* objects written on behalf of callers */
+	uint32_t gc_copies;		/* objects copied by garbage collection */
+	uint32_t gc_erases;		/* sectors erased by garbage collection */
+	uint32_t gc_runs;		/* completed garbage collections */
+	uint32_t gc_forced;		/* saves that had to wait for garbage collection */
+	uint32_t gc_max_pause_us;	/* longest single garbage collection call, needs PIOS_INCLUDE_DELAY */
+};
+
 int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t * fs_id, const struct flashfs_logfs_cfg * cfg, enum pios_flash_partition_labels partition_label);
 
 int32_t PIOS_FLASHFS_Logfs_Destroy(uintptr_t fs_id);
 
+int32_t PIOS_FLASHFS_Logfs_Background_GC(uintptr_t fs_id, uint16_t max_steps);
+
+int32_t PIOS_FLASHFS_Logfs_Get_Stats(uintptr_t fs_id, struct flashfs_logfs_stats *stats);
+
 #endif	/* PIOS_FLASHFS_LOGFS_PRIV_H_ */
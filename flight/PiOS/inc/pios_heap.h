@@ -28,6 +28,7 @@
 #define PIOS_HEAP_H
 
 #include <stdlib.h>		/* size_t */
+#include <stdint.h>		/* uintptr_t */
 #include <stdbool.h>		/* bool */
 
 extern bool PIOS_heap_malloc_failed_p(void);
@@ -38,7 +39,29 @@ extern void * PIOS_malloc(size_t size);
 extern void PIOS_free(void * buf);
 
 extern size_t PIOS_heap_get_free_size(void);
+extern size_t PIOS_heap_get_free_size_no_dma(void);
 extern void PIOS_heap_initialize_blocks(void);
 extern void PIOS_heap_increase_size(size_t bytes);
 
+/* Allocation ledger, only filled in when built with DIAG_HEAP */
+#define PIOS_HEAP_LEDGER_LEN 16
+
+enum pios_heap_region {
+	PIOS_HEAP_REGION_STANDARD,
+	PIOS_HEAP_REGION_FAST,
+	PIOS_HEAP_REGION_MIXED,	/* overflow entry holding both regions */
+};
+
+struct pios_heap_ledger_entry {
+	uintptr_t caller;	/* return address into the allocating function, 0 for the overflow entry */
+	uint32_t bytes;		/* bytes requested, without alignment padding */
+	uint16_t allocations;
+	uint8_t region;		/* enum pios_heap_region the memory came from */
+	bool no_dma;		/* requested through PIOS_malloc_no_dma */
+	bool dma_mixed;		/* overflow entry holding both kinds of request */
+};
+
+extern bool PIOS_heap_get_ledger_entry(uint8_t idx, struct pios_heap_ledger_entry *entry);
+extern size_t PIOS_heap_get_padding(void);
+
 #endif	/* PIOS_HEAP_H */
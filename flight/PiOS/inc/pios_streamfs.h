@@ -35,6 +35,7 @@ int32_t PIOS_STREAMFS_OpenRead(uintptr_t fs_id, uint32_t file_id);
 int32_t PIOS_STREAMFS_MinFileId(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_MaxFileId(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Close(uintptr_t fs_id);
+int32_t PIOS_STREAMFS_Flush_Stale(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Destroy(uintptr_t fs_id);
 
 #endif	/* PIOS_FLASHFS_STREAMFS_H_ */
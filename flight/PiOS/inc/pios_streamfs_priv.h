@@ -36,11 +36,26 @@
 struct streamfs_cfg {
 	uint32_t fs_magic;
 	uint32_t arena_size; /* The size chunk that is erased (must equal sector size) */
-	uint32_t write_size;  /* The size to buffer between writes */
+	uint32_t write_size;  /* The size to buffer between writes (flash page size) */
+};
+
+/**
+ * Counters kept by a streamfs instance since it was initialized. Appends are
+ * collected in a page sized buffer, so the average flash write is
+ * flash_bytes / flash_writes bytes long.
+ */
+struct streamfs_stats {
+	uint32_t bytes_appended;	/* bytes handed to the filesystem by writers */
+	uint32_t flash_writes;		/* flash write operations, including footers */
+	uint32_t flash_bytes;		/* bytes programmed, including footers */
+	uint32_t partial_flushes;	/* buffers written before a page filled up (close or timeout) */
+	uint32_t arena_erases;		/* arenas erased to make room for files */
 };
 
 int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enum pios_flash_partition_labels partition_label);
 
+int32_t PIOS_STREAMFS_Get_Stats(uintptr_t fs_id, struct streamfs_stats *stats);
+
 extern const struct pios_com_driver pios_streamfs_com_driver;
 
 #endif	/* PIOS_FLASHFS_STREAMFS_PRIV_H_ */
@@ -49,6 +49,13 @@ enum pios_thread_prio_e
 struct pios_thread
 {
 	uintptr_t task_handle;
+#if (configUSE_APPLICATION_TASK_TAG == 1)
+	/* Updated from the trace hooks in FreeRTOSConfig.h */
+	uint32_t switched_in;
+	uint32_t switch_count;
+	uint32_t max_activation;
+	uint32_t queue_wait;
+#endif /* (configUSE_APPLICATION_TASK_TAG == 1) */
 };
 
 #elif defined(PIOS_INCLUDE_CHIBIOS)
@@ -72,6 +79,17 @@ struct pios_thread
 
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
 
+/*
+ * Scheduler statistics of a thread accumulated since the previous call
+ * to PIOS_Thread_Get_Sched_Stats.
+ */
+struct pios_thread_sched_stats
+{
+	uint32_t switches;          /* number of times the thread was switched in */
+	uint32_t max_activation_us; /* longest single run before being switched out */
+	uint32_t queue_wait;        /* time blocked in PIOS_Queue_Receive, same units as PIOS_Thread_Get_Runtime */
+};
+
 /*
  * The following functions implement the concept of a thread usable
  * with PIOS_INCLUDE_FREERTOS.
@@ -86,6 +104,9 @@ void PIOS_Thread_Sleep(uint32_t time_ms);
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms);
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp);
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp);
+bool PIOS_Thread_Get_Sched_Stats(struct pios_thread *threadp, struct pios_thread_sched_stats *stats);
+uint32_t PIOS_Thread_Trace_Counter(void);
+void PIOS_Thread_Trace_Queue_Wait(uint32_t start);
 void PIOS_Thread_Scheduler_Suspend(void);
 void PIOS_Thread_Scheduler_Resume(void);
 
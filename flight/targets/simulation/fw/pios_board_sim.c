@@ -117,11 +117,16 @@ void PIOS_Board_Init(void) {
 	/* Delay system */
 	PIOS_DELAY_Init();
 
-	int32_t retval = PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config);
+	/* Every instance of a fleet keeps its settings in its own file */
+	static struct pios_flash_posix_cfg instance_flash_config;
+	instance_flash_config = flash_config;
+	instance_flash_config.file_name = PIOS_SYS_FlashFile();
+
+	int32_t retval = PIOS_Flash_Posix_Init(&pios_posix_flash_id, &instance_flash_config);
 	if (retval != 0) {
 
 	    /* create an empty, appropriately sized flash filesystem */
-	    FILE * theflash = fopen("theflash.bin", "w");
+	    FILE * theflash = fopen(instance_flash_config.file_name, "w");
 	    uint8_t sector[flash_config.size_of_sector];
 	    memset(sector, 0xFF, sizeof(sector));
 	    for (uint32_t i = 0; i < flash_config.size_of_flash / flash_config.size_of_sector; i++) {
@@ -129,7 +134,7 @@ void PIOS_Board_Init(void) {
 	    }
 	    fclose(theflash);
 
-		retval = PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config);
+		retval = PIOS_Flash_Posix_Init(&pios_posix_flash_id, &instance_flash_config);
 
 		if (retval != 0) {
 			fprintf(stderr, "Unable to initialize flash posix simulator: %d\n", retval);
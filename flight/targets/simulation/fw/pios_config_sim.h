@@ -44,6 +44,7 @@
 #define PIOS_INCLUDE_TELEMETRY_RF
 #define PIOS_INCLUDE_TCP
 #define PIOS_INCLUDE_UDP
+#define PIOS_INCLUDE_SIL
 #define PIOS_INCLUDE_SERVO
 #define PIOS_INCLUDE_RCVR
 #define PIOS_INCLUDE_GCSRCVR
@@ -486,6 +486,9 @@ typedef uint32_t halrtcnt_t;
 #define THREAD_EXT_FIELDS                                                   \
   halrtcnt_t ticks_switched_in;                                             \
   halrtcnt_t ticks_total;                                                   \
+  halrtcnt_t ticks_max_activation;                                          \
+  halrtcnt_t ticks_queue_wait;                                              \
+  uint32_t switch_count;                                                    \
   /* Add threads custom fields here.*/
 #endif
 
@@ -498,7 +501,11 @@ typedef uint32_t halrtcnt_t;
  */
 #if !defined(THREAD_EXT_INIT_HOOK) || defined(__DOXYGEN__)
 #define THREAD_EXT_INIT_HOOK(tp) {                                          \
-  /* Add threads initialization code here.*/                                \
+  tp->ticks_switched_in = 0;                                                \
+  tp->ticks_total = 0;                                                      \
+  tp->ticks_max_activation = 0;                                             \
+  tp->ticks_queue_wait = 0;                                                 \
+  tp->switch_count = 0;                                                     \
 }
 #endif
 
@@ -523,8 +530,11 @@ typedef uint32_t halrtcnt_t;
 #if !defined(THREAD_CONTEXT_SWITCH_HOOK) || defined(__DOXYGEN__)
 #define THREAD_CONTEXT_SWITCH_HOOK(ntp, otp) {                              \
   ntp->ticks_switched_in = halGetCounterValue();                            \
-  otp->ticks_total += ntp->ticks_switched_in - otp->ticks_switched_in;      \
-  /* System halt code here.*/                                               \
+  halrtcnt_t ticks_run = ntp->ticks_switched_in - otp->ticks_switched_in;   \
+  otp->ticks_total += ticks_run;                                            \
+  if (ticks_run > otp->ticks_max_activation)                                \
+    otp->ticks_max_activation = ticks_run;                                  \
+  ntp->switch_count++;                                                      \
 }
 #endif
 
@@ -95,6 +95,15 @@ NVIC value of 255. */
   } while(0)
 #define portGET_RUN_TIME_COUNTER_VALUE()      (*(unsigned long *)0xe0001004)  /* DWT_CYCCNT */
 
+#if defined(DIAG_TASKS)
+/* Per task scheduler statistics, the task tag points at the owning pios_thread */
+#define configUSE_APPLICATION_TASK_TAG 1
+extern void PIOS_Thread_Trace_Switched_In(void *tag);
+extern void PIOS_Thread_Trace_Switched_Out(void *tag);
+#define traceTASK_SWITCHED_IN() PIOS_Thread_Trace_Switched_In((void *)pxCurrentTCB->pxTaskTag)
+#define traceTASK_SWITCHED_OUT() PIOS_Thread_Trace_Switched_Out((void *)pxCurrentTCB->pxTaskTag)
+#endif
+
 
 /**
   * @}
@@ -0,0 +1,11 @@
+/* The shared kernels built with a single table slice, as on the 128k F1 targets */
+#define CRC_SLICES 1
+
+#define crc8_table   crc8_table_slice1
+#define crc16_table  crc16_table_slice1
+#define crc32_table  crc32_table_slice1
+#define crc8_update  crc8_update_slice1
+#define crc16_update crc16_update_slice1
+#define crc32_update crc32_update_slice1
+
+#include "crc.c"
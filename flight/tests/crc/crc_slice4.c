@@ -0,0 +1,11 @@
+/* The shared kernels built with four table slices, as on the F3 and F4 targets */
+#define CRC_SLICES 4
+
+#define crc8_table   crc8_table_slice4
+#define crc16_table  crc16_table_slice4
+#define crc32_table  crc32_table_slice4
+#define crc8_update  crc8_update_slice4
+#define crc16_update crc16_update_slice4
+#define crc32_update crc32_update_slice4
+
+#include "crc.c"
@@ -0,0 +1,243 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the slice-by-N CRC kernels
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memcpy */
+#include <time.h>		/* clock */
+
+extern "C" {
+
+#include "pios_crc.h"
+#include "crc.h"
+
+uint8_t crc8_update_slice1(uint8_t crc, const uint8_t *data, uint32_t length);
+uint16_t crc16_update_slice1(uint16_t crc, const uint8_t *data, uint32_t length);
+uint32_t crc32_update_slice1(uint32_t crc, const uint8_t *data, uint32_t length);
+
+uint8_t crc8_update_slice4(uint8_t crc, const uint8_t *data, uint32_t length);
+uint16_t crc16_update_slice4(uint16_t crc, const uint8_t *data, uint32_t length);
+uint32_t crc32_update_slice4(uint32_t crc, const uint8_t *data, uint32_t length);
+
+}
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#define MAX_LENGTH 300
+#define MAX_OFFSET 8
+
+/* Bit at a time reference implementations of the three CRCs */
+static uint8_t crc8_ref(uint8_t crc, const uint8_t *data, uint32_t length)
+{
+  while (length--) {
+    crc ^= *data++;
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  }
+  return crc;
+}
+
+static uint16_t crc16_ref(uint16_t crc, const uint8_t *data, uint32_t length)
+{
+  while (length--) {
+    crc ^= *data++;
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+  }
+  return crc;
+}
+
+static uint32_t crc32_ref(uint32_t crc, const uint8_t *data, uint32_t length)
+{
+  while (length--) {
+    crc ^= (uint32_t)*data++ << 24;
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+  }
+  return crc;
+}
+
+struct kernels {
+  const char *name;
+  uint8_t (*crc8)(uint8_t crc, const uint8_t *data, uint32_t length);
+  uint16_t (*crc16)(uint16_t crc, const uint8_t *data, uint32_t length);
+  uint32_t (*crc32)(uint32_t crc, const uint8_t *data, uint32_t length);
+};
+
+static const struct kernels all_kernels[] = {
+  { "slice-by-1", crc8_update_slice1, crc16_update_slice1, crc32_update_slice1 },
+  { "slice-by-4", crc8_update_slice4, crc16_update_slice4, crc32_update_slice4 },
+  { "slice-by-8", crc8_update, crc16_update, crc32_update },
+};
+
+class CRC : public testing::Test {
+protected:
+  virtual void SetUp() {
+    /* Reproducible pseudo random data */
+    uint32_t x = 0x12345678;
+    for (uint32_t i = 0; i < sizeof(buf); i++) {
+      x = x * 1103515245 + 12345;
+      buf[i] = x >> 16;
+    }
+  }
+
+  uint8_t buf[MAX_LENGTH + MAX_OFFSET];
+};
+
+TEST_F(CRC, CheckValues) {
+  const uint8_t check[] = "123456789";
+  const uint32_t len = sizeof(check) - 1;
+
+  for (uint32_t k = 0; k < NELEMENTS(all_kernels); k++) {
+    /* CRC-8 */
+    EXPECT_EQ(0xF4, all_kernels[k].crc8(0, check, len)) << all_kernels[k].name;
+    /* CRC-16/KERMIT */
+    EXPECT_EQ(0x2189, all_kernels[k].crc16(0, check, len)) << all_kernels[k].name;
+    /* CRC-32/MPEG-2 */
+    EXPECT_EQ(0x0376E6E7u, all_kernels[k].crc32(0xFFFFFFFF, check, len)) << all_kernels[k].name;
+  }
+}
+
+TEST_F(CRC, AllLengthsAndAlignments) {
+  for (uint32_t k = 0; k < NELEMENTS(all_kernels); k++) {
+    const struct kernels *kern = &all_kernels[k];
+
+    for (uint32_t offset = 0; offset < MAX_OFFSET; offset++) {
+      for (uint32_t len = 0; len <= MAX_LENGTH; len++) {
+        const uint8_t *p = buf + offset;
+
+        ASSERT_EQ(crc8_ref(0x5A, p, len), kern->crc8(0x5A, p, len))
+          << kern->name << " offset " << offset << " length " << len;
+        ASSERT_EQ(crc16_ref(0xA55A, p, len), kern->crc16(0xA55A, p, len))
+          << kern->name << " offset " << offset << " length " << len;
+        ASSERT_EQ(crc32_ref(0xDEADBEEF, p, len), kern->crc32(0xDEADBEEF, p, len))
+          << kern->name << " offset " << offset << " length " << len;
+      }
+    }
+  }
+}
+
+TEST_F(CRC, IncrementalUpdates) {
+  const uint32_t len = 77;
+
+  for (uint32_t k = 0; k < NELEMENTS(all_kernels); k++) {
+    const struct kernels *kern = &all_kernels[k];
+
+    for (uint32_t split = 0; split <= len; split++) {
+      EXPECT_EQ(kern->crc8(0, buf, len),
+        kern->crc8(kern->crc8(0, buf, split), buf + split, len - split));
+      EXPECT_EQ(kern->crc16(0, buf, len),
+        kern->crc16(kern->crc16(0, buf, split), buf + split, len - split));
+      EXPECT_EQ(kern->crc32(0, buf, len),
+        kern->crc32(kern->crc32(0, buf, split), buf + split, len - split));
+    }
+  }
+}
+
+TEST_F(CRC, PiosApi) {
+  uint8_t crc8 = 0;
+  uint16_t crc16 = 0;
+  uint32_t crc32 = 0;
+
+  for (uint32_t i = 0; i < MAX_LENGTH; i++) {
+    crc8 = PIOS_CRC_updateByte(crc8, buf[i]);
+    crc16 = PIOS_CRC16_updateByte(crc16, buf[i]);
+    crc32 = PIOS_CRC32_updateByte(crc32, buf[i]);
+  }
+
+  EXPECT_EQ(crc8_ref(0, buf, MAX_LENGTH), crc8);
+  EXPECT_EQ(crc16_ref(0, buf, MAX_LENGTH), crc16);
+  EXPECT_EQ(crc32_ref(0, buf, MAX_LENGTH), crc32);
+
+  EXPECT_EQ(crc8, PIOS_CRC_updateCRC(0, buf, MAX_LENGTH));
+  EXPECT_EQ(crc16, PIOS_CRC16_updateCRC(0, buf, MAX_LENGTH));
+  EXPECT_EQ(crc32, PIOS_CRC32_updateCRC(0, buf, MAX_LENGTH));
+
+  /* Empty and negative lengths leave the CRC alone */
+  EXPECT_EQ(0x42, PIOS_CRC_updateCRC(0x42, buf, 0));
+  EXPECT_EQ(0x42, PIOS_CRC_updateCRC(0x42, buf, -1));
+  EXPECT_EQ(0x4242, PIOS_CRC16_updateCRC(0x4242, buf, -1));
+  EXPECT_EQ(0x42424242u, PIOS_CRC32_updateCRC(0x42424242, buf, -1));
+}
+
+/*
+ * Throughput of each kernel on a typical UAVTalk frame and on a flash
+ * sector sized buffer.
+ */
+TEST_F(CRC, Benchmark) {
+  static uint8_t large[4096];
+  const struct {
+    const uint8_t *data;
+    uint32_t len;
+    uint32_t runs;
+  } sizes[] = {
+    { buf + 1, 64, 40000 },
+    { large, sizeof(large), 600 },
+  };
+
+  memcpy(large, buf, sizeof(buf));
+
+  for (uint32_t s = 0; s < NELEMENTS(sizes); s++) {
+    for (uint32_t k = 0; k < NELEMENTS(all_kernels); k++) {
+      const struct kernels *kern = &all_kernels[k];
+      volatile uint32_t sink = 0;
+      double mb = (double) sizes[s].len * sizes[s].runs / 1e6;
+      clock_t start;
+
+      start = clock();
+      for (uint32_t i = 0; i < sizes[s].runs; i++)
+        sink += kern->crc8(i, sizes[s].data, sizes[s].len);
+      double t8 = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+      start = clock();
+      for (uint32_t i = 0; i < sizes[s].runs; i++)
+        sink += kern->crc16(i, sizes[s].data, sizes[s].len);
+      double t16 = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+      start = clock();
+      for (uint32_t i = 0; i < sizes[s].runs; i++)
+        sink += kern->crc32(i, sizes[s].data, sizes[s].len);
+      double t32 = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+      printf("%4u bytes %s: crc8 %7.1f MB/s, crc16 %7.1f MB/s, crc32 %7.1f MB/s\n",
+        (unsigned) sizes[s].len, kern->name, mb / t8, mb / t16, mb / t32);
+    }
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
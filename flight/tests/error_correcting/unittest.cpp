@@ -37,11 +37,14 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
 
 extern "C" {
 
 #include <ecc.h>
 
+extern int genPoly[];
+
 }
 
 #include <math.h>   /* fabs() */
@@ -104,3 +107,193 @@ TEST_F(EncodeDecode, Recover) {
     EXPECT_EQ(p[i], p2[i]);
 
 };
+
+/* Tests for the table driven codec in rs_table.c */
+class TableCodec : public testing::Test {
+protected:
+  virtual void SetUp() {
+    initialize_ecc();
+    srand(1234);
+  }
+
+  virtual void TearDown() {
+  }
+
+  void random_message(unsigned char *msg, int len) {
+    for (int i = 0; i < len; i++)
+      msg[i] = rand();
+  }
+
+  /* Flip nerrors distinct bytes to random different values */
+  void inject_errors(unsigned char *codeword, int csize, int nerrors) {
+    bool hit[255] = { false };
+    for (int e = 0; e < nerrors; e++) {
+      int pos;
+      do {
+        pos = rand() % csize;
+      } while (hit[pos]);
+      hit[pos] = true;
+      codeword[pos] ^= 1 + rand() % 255;
+    }
+  }
+};
+
+TEST_F(TableCodec, TableMatchesGenerator) {
+  for (int d = 0; d < 256; d++) {
+    for (int k = 0; k < RS_ECC_NPARITY; k++) {
+      EXPECT_EQ(gmult(genPoly[k], d), (int)((rs_encode_table[d] >> (8 * k)) & 0xff));
+    }
+  }
+}
+
+TEST_F(TableCodec, CorrectEncode) {
+  unsigned char p[10] = {'a', 'b', 'c', 'd', 'e', 'f'};
+  rs_encode(p, 6, p);
+  EXPECT_EQ(0x1f, p[6]);
+  EXPECT_EQ(0xa3, p[7]);
+  EXPECT_EQ(0x9a, p[8]);
+  EXPECT_EQ(0x3b, p[9]);
+}
+
+TEST_F(TableCodec, EncodeMatchesReference) {
+  unsigned char msg[251];
+  unsigned char ref[255];
+  unsigned char out[255];
+
+  for (int len = 0; len <= 251; len++) {
+    random_message(msg, len);
+    encode_data(msg, len, ref);
+    rs_encode(msg, len, out);
+    EXPECT_EQ(0, memcmp(ref, out, len + RS_ECC_NPARITY)) << "length " << len;
+  }
+}
+
+TEST_F(TableCodec, Decode) {
+  const int lengths[] = { 1, 6, 60, 251 };
+
+  for (unsigned l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+    int csize = lengths[l] + RS_ECC_NPARITY;
+
+    for (int trial = 0; trial < 200; trial++) {
+      unsigned char sent[255];
+      unsigned char received[255];
+
+      random_message(sent, lengths[l]);
+      rs_encode(sent, lengths[l], sent);
+
+      /* Intact */
+      memcpy(received, sent, csize);
+      EXPECT_EQ(RS_DECODE_OK, rs_decode(received, csize));
+      EXPECT_EQ(0, memcmp(sent, received, csize));
+
+      /* Up to two errors are always corrected, the reference decoder agrees */
+      for (int nerrors = 1; nerrors <= RS_ECC_NPARITY / 2 && nerrors <= csize; nerrors++) {
+        memcpy(received, sent, csize);
+        inject_errors(received, csize, nerrors);
+
+        unsigned char reference[255];
+        memcpy(reference, received, csize);
+        decode_data(reference, csize);
+        EXPECT_EQ(1, check_syndrome());
+        EXPECT_EQ(1, correct_errors_erasures(reference, csize, 0, 0));
+
+        EXPECT_EQ(RS_DECODE_CORRECTED, rs_decode(received, csize));
+        EXPECT_EQ(0, memcmp(sent, received, csize));
+        EXPECT_EQ(0, memcmp(reference, received, csize));
+      }
+
+      /* More errors are either detected or turned into some other valid codeword */
+      if (csize > RS_ECC_NPARITY / 2 + 1) {
+        memcpy(received, sent, csize);
+        inject_errors(received, csize, RS_ECC_NPARITY / 2 + 1);
+
+        int rc = rs_decode(received, csize);
+        EXPECT_NE(RS_DECODE_OK, rc);
+        if (rc == RS_DECODE_CORRECTED) {
+          EXPECT_EQ(RS_DECODE_OK, rs_decode(received, csize));
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TableCodec, DecodeShortCodeword) {
+  unsigned char p[RS_ECC_NPARITY - 1] = { 0 };
+  EXPECT_EQ(RS_DECODE_FAILED, rs_decode(p, sizeof(p)));
+}
+
+/*
+ * Packets per second through the reference and the table driven codecs for
+ * a typical RFM22B packet, with 0 up to RS_ECC_NPARITY injected errors.
+ */
+#define BENCH_PACKET_LEN 64
+#define BENCH_PACKETS 20000
+
+static double packets_per_s(const struct timespec *start, int packets)
+{
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double s = (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+  return packets / s;
+}
+
+TEST_F(TableCodec, Benchmark) {
+  static unsigned char sent[BENCH_PACKETS][BENCH_PACKET_LEN + RS_ECC_NPARITY];
+  static unsigned char received[BENCH_PACKETS][BENCH_PACKET_LEN + RS_ECC_NPARITY];
+  const int csize = BENCH_PACKET_LEN + RS_ECC_NPARITY;
+  struct timespec start;
+
+  for (int i = 0; i < BENCH_PACKETS; i++)
+    random_message(sent[i], BENCH_PACKET_LEN);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < BENCH_PACKETS; i++)
+    encode_data(sent[i], BENCH_PACKET_LEN, received[i]);
+  double ref_encode = packets_per_s(&start, BENCH_PACKETS);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < BENCH_PACKETS; i++)
+    rs_encode(sent[i], BENCH_PACKET_LEN, sent[i]);
+  double table_encode = packets_per_s(&start, BENCH_PACKETS);
+
+  EXPECT_EQ(0, memcmp(sent, received, sizeof(sent)));
+
+  printf("encode         : reference %9.0f packets/s, table %9.0f packets/s\n", ref_encode, table_encode);
+
+  for (int nerrors = 0; nerrors <= RS_ECC_NPARITY; nerrors++) {
+    for (int i = 0; i < BENCH_PACKETS; i++) {
+      memcpy(received[i], sent[i], csize);
+      inject_errors(received[i], csize, nerrors);
+    }
+
+    static unsigned char work[BENCH_PACKETS][BENCH_PACKET_LEN + RS_ECC_NPARITY];
+    memcpy(work, received, sizeof(work));
+
+    int ref_good = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_PACKETS; i++) {
+      decode_data(work[i], csize);
+      if (check_syndrome() == 0 || correct_errors_erasures(work[i], csize, 0, 0) != 0)
+        ref_good++;
+    }
+    double ref_decode = packets_per_s(&start, BENCH_PACKETS);
+
+    memcpy(work, received, sizeof(work));
+
+    int table_good = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_PACKETS; i++) {
+      if (rs_decode(work[i], csize) != RS_DECODE_FAILED)
+        table_good++;
+    }
+    double table_decode = packets_per_s(&start, BENCH_PACKETS);
+
+    if (nerrors <= RS_ECC_NPARITY / 2) {
+      EXPECT_EQ(BENCH_PACKETS, table_good);
+      EXPECT_EQ(0, memcmp(sent, work, sizeof(sent)));
+    }
+
+    printf("decode %d errors: reference %9.0f packets/s, table %9.0f packets/s, accepted %5d / %5d\n",
+      nerrors, ref_decode, table_decode, ref_good, table_good);
+  }
+}
@@ -0,0 +1,179 @@
+#include "gps_ut.h"
+#include "UBX.h"
+#include <string.h>		/* memcpy */
+
+GPSPositionData gps_ut_position;
+GPSVelocityData gps_ut_velocity;
+GPSSatellitesData gps_ut_satellites;
+GPSTimeData gps_ut_time;
+static UBloxInfoData ubloxinfo;
+
+uint32_t gps_ut_position_updates;
+uint32_t gps_ut_satellites_updates;
+
+void gps_ut_reset(void)
+{
+	memset(&gps_ut_position, 0, sizeof(gps_ut_position));
+	memset(&gps_ut_velocity, 0, sizeof(gps_ut_velocity));
+	memset(&gps_ut_satellites, 0, sizeof(gps_ut_satellites));
+	memset(&gps_ut_time, 0, sizeof(gps_ut_time));
+	gps_ut_position_updates = 0;
+	gps_ut_satellites_updates = 0;
+}
+
+int32_t GPSPositionSet(const GPSPositionData *dataIn)
+{
+	memcpy(&gps_ut_position, dataIn, sizeof(gps_ut_position));
+	gps_ut_position_updates++;
+	return 0;
+}
+
+int32_t GPSVelocitySet(const GPSVelocityData *dataIn)
+{
+	memcpy(&gps_ut_velocity, dataIn, sizeof(gps_ut_velocity));
+	return 0;
+}
+
+int32_t GPSSatellitesSet(const GPSSatellitesData *dataIn)
+{
+	memcpy(&gps_ut_satellites, dataIn, sizeof(gps_ut_satellites));
+	gps_ut_satellites_updates++;
+	return 0;
+}
+
+int32_t GPSTimeGet(GPSTimeData *dataOut)
+{
+	memcpy(dataOut, &gps_ut_time, sizeof(gps_ut_time));
+	return 0;
+}
+
+int32_t GPSTimeSet(const GPSTimeData *dataIn)
+{
+	memcpy(&gps_ut_time, dataIn, sizeof(gps_ut_time));
+	return 0;
+}
+
+int32_t UBloxInfoGet(UBloxInfoData *dataOut)
+{
+	memcpy(dataOut, &ubloxinfo, sizeof(ubloxinfo));
+	return 0;
+}
+
+int32_t UBloxInfoSet(const UBloxInfoData *dataIn)
+{
+	memcpy(&ubloxinfo, dataIn, sizeof(ubloxinfo));
+	return 0;
+}
+
+void UBloxInfoParseErrorsSet(uint32_t *NewParseErrors)
+{
+	ubloxinfo.ParseErrors = *NewParseErrors;
+}
+
+/* Wrap a payload in UBX sync characters, header and checksum */
+static size_t ubx_frame(uint8_t *buf, uint8_t class, uint8_t id, const void *payload, uint16_t len)
+{
+	buf[0] = UBX_SYNC1;
+	buf[1] = UBX_SYNC2;
+	buf[2] = class;
+	buf[3] = id;
+	buf[4] = len & 0xff;
+	buf[5] = len >> 8;
+	memcpy(&buf[6], payload, len);
+
+	uint8_t ck_a = 0, ck_b = 0;
+	for (uint16_t i = 2; i < len + 6; i++) {
+		ck_a += buf[i];
+		ck_b += ck_a;
+	}
+	buf[len + 6] = ck_a;
+	buf[len + 7] = ck_b;
+
+	return len + 8;
+}
+
+/*
+ * One navigation epoch the way a u-blox 6 configured by ubx_cfg.c sends it:
+ * position, solution, DOP, velocity, time and the satellite info for 16
+ * channels, which makes up most of the traffic.
+ */
+size_t gps_ut_ubx_epoch(uint8_t *buf, uint32_t tow)
+{
+	size_t len = 0;
+	uint32_t step = tow / 100;
+
+	struct UBX_NAV_POSLLH posllh = {
+		.iTOW = tow,
+		.lon = 85455940 + step * 90,
+		.lat = 473977420 + step * 120,
+		.height = 536000,
+		.hMSL = 488300,
+		.hAcc = 1800,
+		.vAcc = 2500,
+	};
+	len += ubx_frame(&buf[len], UBX_CLASS_NAV, UBX_ID_POSLLH, &posllh, sizeof(posllh));
+
+	struct UBX_NAV_SOL sol = {
+		.iTOW = tow,
+		.gpsFix = STATUS_GPSFIX_3DFIX,
+		.flags = STATUS_FLAGS_GPSFIX_OK,
+		.pAcc = 250,
+		.pDOP = 172,
+		.numSV = 9,
+	};
+	len += ubx_frame(&buf[len], UBX_CLASS_NAV, UBX_ID_SOL, &sol, sizeof(sol));
+
+	struct UBX_NAV_DOP dop = {
+		.iTOW = tow,
+		.gDOP = 190,
+		.pDOP = 172,
+		.tDOP = 90,
+		.vDOP = 144,
+		.hDOP = 94,
+		.nDOP = 70,
+		.eDOP = 60,
+	};
+	len += ubx_frame(&buf[len], UBX_CLASS_NAV, UBX_ID_DOP, &dop, sizeof(dop));
+
+	struct UBX_NAV_VELNED velned = {
+		.iTOW = tow,
+		.velN = 132,
+		.velE = 98,
+		.velD = -4,
+		.speed = 165,
+		.gSpeed = 164,
+		.heading = 3650000,
+		.sAcc = 40,
+		.cAcc = 250000,
+	};
+	len += ubx_frame(&buf[len], UBX_CLASS_NAV, UBX_ID_VELNED, &velned, sizeof(velned));
+
+	struct UBX_NAV_TIMEUTC timeutc = {
+		.iTOW = tow,
+		.year = 2026,
+		.month = 10,
+		.day = 18,
+		.hour = (tow / 3600000) % 24,
+		.min = (tow / 60000) % 60,
+		.sec = (tow / 1000) % 60,
+		.valid = TIMEUTC_VALIDTOW | TIMEUTC_VALIDWKN | TIMEUTC_VALIDUTC,
+	};
+	len += ubx_frame(&buf[len], UBX_CLASS_NAV, UBX_ID_TIMEUTC, &timeutc, sizeof(timeutc));
+
+	struct UBX_NAV_SVINFO svinfo = {
+		.iTOW = tow,
+		.numCh = 16,
+	};
+	for (uint8_t i = 0; i < svinfo.numCh; i++) {
+		svinfo.sv[i].chn = i;
+		svinfo.sv[i].svid = 2 + i * 2;
+		svinfo.sv[i].flags = i < 9 ? SVUSED : 0;
+		svinfo.sv[i].cno = i < 12 ? 30 + i : 0;
+		svinfo.sv[i].elev = 5 + i * 5;
+		svinfo.sv[i].azim = i * 22;
+	}
+	uint16_t svinfo_len = sizeof(svinfo) - sizeof(svinfo.sv) + svinfo.numCh * sizeof(svinfo.sv[0]);
+	len += ubx_frame(&buf[len], UBX_CLASS_NAV, UBX_ID_SVINFO, &svinfo, svinfo_len);
+
+	return len;
+}
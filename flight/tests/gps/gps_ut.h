@@ -0,0 +1,26 @@
+#ifndef GPS_UT_H
+#define GPS_UT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "GPS.h"
+
+/* Latest contents of the UAVOs written by the parsers */
+extern GPSPositionData gps_ut_position;
+extern GPSVelocityData gps_ut_velocity;
+extern GPSSatellitesData gps_ut_satellites;
+extern GPSTimeData gps_ut_time;
+
+/* Number of updates to each UAVO */
+extern uint32_t gps_ut_position_updates;
+extern uint32_t gps_ut_satellites_updates;
+
+void gps_ut_reset(void);
+
+/* Worst case size of one epoch built by gps_ut_ubx_epoch() */
+#define GPS_UT_UBX_EPOCH_MAX_LEN 512
+
+size_t gps_ut_ubx_epoch(uint8_t *buf, uint32_t tow);
+
+#endif /* GPS_UT_H */
@@ -0,0 +1,34 @@
+/* Stand-in for the generated GPSPosition UAVObject header */
+#ifndef GPSPOSITION_H
+#define GPSPOSITION_H
+
+#include <stdint.h>
+
+#define GPSPOSITION_OBJID 0x1D5D6A4C
+
+typedef enum {
+	GPSPOSITION_STATUS_NOGPS = 0,
+	GPSPOSITION_STATUS_NOFIX = 1,
+	GPSPOSITION_STATUS_FIX2D = 2,
+	GPSPOSITION_STATUS_FIX3D = 3,
+	GPSPOSITION_STATUS_DIFF3D = 4,
+} GPSPositionStatusOptions;
+
+typedef struct {
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+	float GeoidSeparation;
+	float Heading;
+	float Groundspeed;
+	float Accuracy;
+	float PDOP;
+	float HDOP;
+	float VDOP;
+	uint8_t Status;
+	uint8_t Satellites;
+} __attribute__((packed)) __attribute__((aligned(4))) GPSPositionData;
+
+int32_t GPSPositionSet(const GPSPositionData *dataIn);
+
+#endif /* GPSPOSITION_H */
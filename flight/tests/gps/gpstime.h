@@ -0,0 +1,19 @@
+/* Stand-in for the generated GPSTime UAVObject header */
+#ifndef GPSTIME_H
+#define GPSTIME_H
+
+#include <stdint.h>
+
+typedef struct {
+	int16_t Year;
+	int8_t Month;
+	int8_t Day;
+	int8_t Hour;
+	int8_t Minute;
+	int8_t Second;
+} __attribute__((packed)) __attribute__((aligned(4))) GPSTimeData;
+
+int32_t GPSTimeGet(GPSTimeData *dataOut);
+int32_t GPSTimeSet(const GPSTimeData *dataIn);
+
+#endif /* GPSTIME_H */
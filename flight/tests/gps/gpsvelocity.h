@@ -0,0 +1,16 @@
+/* Stand-in for the generated GPSVelocity UAVObject header */
+#ifndef GPSVELOCITY_H
+#define GPSVELOCITY_H
+
+#include <stdint.h>
+
+typedef struct {
+	float North;
+	float East;
+	float Down;
+	float Accuracy;
+} __attribute__((packed)) __attribute__((aligned(4))) GPSVelocityData;
+
+int32_t GPSVelocitySet(const GPSVelocityData *dataIn);
+
+#endif /* GPSVELOCITY_H */
@@ -0,0 +1,22 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#include "pios_config.h"
+
+/* C Lib Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,6 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include "openpilot.h"
+
+#endif /* PIOS_H */
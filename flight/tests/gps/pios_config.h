@@ -0,0 +1,7 @@
+#ifndef PIOS_CONFIG_H
+#define PIOS_CONFIG_H
+
+#define PIOS_INCLUDE_GPS_NMEA_PARSER
+#define PIOS_INCLUDE_GPS_UBX_PARSER
+
+#endif /* PIOS_CONFIG_H */
@@ -0,0 +1,17 @@
+/* Stand-in for the generated UBloxInfo UAVObject header */
+#ifndef UBLOXINFO_H
+#define UBLOXINFO_H
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t swVersion;
+	uint32_t ParseErrors;
+	uint16_t hwVersion;
+} __attribute__((packed)) __attribute__((aligned(4))) UBloxInfoData;
+
+int32_t UBloxInfoGet(UBloxInfoData *dataOut);
+int32_t UBloxInfoSet(const UBloxInfoData *dataIn);
+void UBloxInfoParseErrorsSet(uint32_t *NewParseErrors);
+
+#endif /* UBLOXINFO_H */
@@ -0,0 +1,307 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test and benchmark for the block oriented GPS parsers
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <vector>
+
+extern "C" {
+
+#include "NMEA.h"
+#include "gps_ut.h"
+
+int parse_ubx_block(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+
+}
+
+/* The com port rx fifo on most boards */
+#define RX_CHUNK_LEN 32
+
+#define UBX_EPOCH_MS 100
+#define UBX_MSGS_PER_EPOCH 6
+#define NMEA_CAPTURE "nmea_capture.txt"
+
+// To use a test fixture, derive a class from testing::Test.
+class GpsParserTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    gps_ut_reset();
+    memset(&position, 0, sizeof(position));
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  virtual void TearDown() {
+  }
+
+  /* u-blox time of week keeps moving forward across tests so no epoch is dropped as outdated */
+  void build_ubx(std::vector<uint8_t> &corpus, uint32_t epochs) {
+    uint8_t epoch[GPS_UT_UBX_EPOCH_MAX_LEN];
+
+    for (uint32_t i = 0; i < epochs; i++) {
+      size_t len = gps_ut_ubx_epoch(epoch, next_tow);
+      corpus.insert(corpus.end(), epoch, epoch + len);
+      next_tow += UBX_EPOCH_MS;
+    }
+  }
+
+  /* The capture is stored with bare line feeds, the receiver sends \r\n */
+  void load_nmea(std::vector<uint8_t> &corpus, uint32_t *sentences) {
+    FILE *fid = fopen(NMEA_CAPTURE, "r");
+    ASSERT_TRUE(fid != NULL);
+
+    char line[256];
+    *sentences = 0;
+    while (fgets(line, sizeof(line), fid)) {
+      size_t len = strcspn(line, "\r\n");
+      corpus.insert(corpus.end(), line, line + len);
+      corpus.push_back('\r');
+      corpus.push_back('\n');
+      (*sentences)++;
+    }
+
+    fclose(fid);
+  }
+
+  /* Feed a corpus to a parser the way the GPS task does, a com port read at a time */
+  int replay(const std::vector<uint8_t> &corpus, size_t chunk, bool ubx) {
+    int res = PARSER_INCOMPLETE;
+
+    for (size_t i = 0; i < corpus.size(); i += chunk) {
+      uint16_t len = (corpus.size() - i) < chunk ? (corpus.size() - i) : chunk;
+      if (ubx)
+        res = parse_ubx_block(&corpus[i], len, rx_buffer, &position, &stats);
+      else
+        res = parse_nmea_block(&corpus[i], len, rx_buffer, &position, &stats);
+    }
+
+    return res;
+  }
+
+  static uint32_t next_tow;
+
+  char rx_buffer[1024] __attribute__((aligned(4)));
+  GPSPositionData position;
+  struct GPS_RX_STATS stats;
+};
+
+uint32_t GpsParserTest::next_tow = 300000;
+
+TEST_F(GpsParserTest, UbxChunked) {
+  const size_t chunks[] = { 1, 7, RX_CHUNK_LEN, 1024 };
+
+  for (uint32_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+    std::vector<uint8_t> corpus;
+    build_ubx(corpus, 20);
+
+    gps_ut_reset();
+    memset(&stats, 0, sizeof(stats));
+
+    replay(corpus, chunks[c], true);
+
+    /* Every message is framed and each epoch completes one position update */
+    EXPECT_EQ(20 * UBX_MSGS_PER_EPOCH, stats.gpsRxReceived);
+    EXPECT_EQ(0, stats.gpsRxChkSumError);
+    EXPECT_EQ(0, stats.gpsRxOverflow);
+    EXPECT_EQ(20U, gps_ut_position_updates);
+    EXPECT_EQ(20U, gps_ut_satellites_updates);
+
+    EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, gps_ut_position.Status);
+    EXPECT_EQ(9, gps_ut_position.Satellites);
+    EXPECT_EQ(473977420 + (next_tow / UBX_EPOCH_MS - 1) * 120, (uint32_t)gps_ut_position.Latitude);
+    EXPECT_FLOAT_EQ(488.3f, gps_ut_position.Altitude);
+    EXPECT_FLOAT_EQ(0.94f, gps_ut_position.HDOP);
+    EXPECT_FLOAT_EQ(1.32f, gps_ut_velocity.North);
+    EXPECT_EQ(16, gps_ut_satellites.SatsInView);
+    EXPECT_EQ(2, gps_ut_satellites.PRN[0]);
+    EXPECT_EQ(2026, gps_ut_time.Year);
+  }
+}
+
+TEST_F(GpsParserTest, UbxResync) {
+  std::vector<uint8_t> corpus;
+
+  /* Line noise, including a stray sync character, ahead of the first frame */
+  const uint8_t noise[] = { 0x00, 0xb5, 0x13, 0x62, 0xff, 0xb5 };
+  corpus.insert(corpus.end(), noise, noise + sizeof(noise));
+  build_ubx(corpus, 3);
+
+  /* Corrupt the payload of the first message of the second epoch */
+  size_t epoch_len = (corpus.size() - sizeof(noise)) / 3;
+  corpus[sizeof(noise) + epoch_len + 10] ^= 0x55;
+
+  EXPECT_EQ(PARSER_COMPLETE, replay(corpus, RX_CHUNK_LEN, true));
+
+  EXPECT_EQ(1, stats.gpsRxChkSumError);
+  EXPECT_EQ(3 * UBX_MSGS_PER_EPOCH - 1, stats.gpsRxReceived);
+  EXPECT_EQ(2U, gps_ut_position_updates);
+}
+
+TEST_F(GpsParserTest, UbxPartialFrame) {
+  std::vector<uint8_t> corpus;
+  build_ubx(corpus, 1);
+
+  /* Everything but the last checksum byte */
+  EXPECT_EQ(PARSER_COMPLETE, parse_ubx_block(&corpus[0], corpus.size() - 1, rx_buffer, &position, &stats));
+  EXPECT_EQ(UBX_MSGS_PER_EPOCH - 1, stats.gpsRxReceived);
+
+  EXPECT_EQ(PARSER_COMPLETE, parse_ubx_block(&corpus[corpus.size() - 1], 1, rx_buffer, &position, &stats));
+  EXPECT_EQ(UBX_MSGS_PER_EPOCH, stats.gpsRxReceived);
+
+  const uint8_t garbage[] = { 0x12, 0x34 };
+  EXPECT_EQ(PARSER_ERROR, parse_ubx_block(garbage, sizeof(garbage), rx_buffer, &position, &stats));
+
+  const uint8_t sync[] = { 0xb5, 0x62, 0x01 };
+  EXPECT_EQ(PARSER_INCOMPLETE, parse_ubx_block(sync, sizeof(sync), rx_buffer, &position, &stats));
+
+  /* Bad length, drop back to looking for a sync character */
+  const uint8_t oversize[] = { 0x30, 0xff, 0xff };
+  EXPECT_EQ(PARSER_ERROR, parse_ubx_block(oversize, sizeof(oversize), rx_buffer, &position, &stats));
+  EXPECT_EQ(1, stats.gpsRxOverflow);
+}
+
+TEST_F(GpsParserTest, NmeaChunked) {
+  const size_t chunks[] = { 1, 7, RX_CHUNK_LEN, 1024 };
+
+  for (uint32_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+    std::vector<uint8_t> corpus;
+    uint32_t sentences;
+    load_nmea(corpus, &sentences);
+
+    gps_ut_reset();
+    memset(&stats, 0, sizeof(stats));
+
+    EXPECT_EQ(PARSER_COMPLETE, replay(corpus, chunks[c], false));
+
+    /* The capture has one GLL sentence per epoch that we have no parser for */
+    EXPECT_EQ(sentences, (uint32_t)(stats.gpsRxReceived + stats.gpsRxParserError));
+    EXPECT_EQ(sentences / 9, stats.gpsRxParserError);
+    EXPECT_EQ(0, stats.gpsRxChkSumError);
+    EXPECT_EQ(0, stats.gpsRxOverflow);
+    EXPECT_EQ(sentences / 9, gps_ut_position_updates);
+    EXPECT_EQ(sentences / 9, gps_ut_satellites_updates);
+
+    EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, position.Status);
+    EXPECT_EQ(8, position.Satellites);
+    EXPECT_NEAR(47.398210, position.Latitude * 1e-7, 1e-6);
+    EXPECT_NEAR(8.545945, position.Longitude * 1e-7, 1e-6);
+    EXPECT_EQ(10, gps_ut_satellites.SatsInView);
+    EXPECT_EQ(2026, gps_ut_time.Year);
+  }
+}
+
+TEST_F(GpsParserTest, NmeaErrors) {
+  const char bad_checksum[] = "$GPZDA,123400.00,18,10,2026,00,00*6D\r\n";
+  EXPECT_EQ(PARSER_ERROR, parse_nmea_block((const uint8_t *)bad_checksum, strlen(bad_checksum), rx_buffer, &position, &stats));
+  EXPECT_EQ(1, stats.gpsRxChkSumError);
+
+  /* A bare line feed doesn't end a sentence */
+  const char split[] = "$GPZDA,123400.00,18,\n10,2026,00,00*";
+  EXPECT_EQ(PARSER_INCOMPLETE, parse_nmea_block((const uint8_t *)split, strlen(split), rx_buffer, &position, &stats));
+  const char split_end[] = "00\r\n";
+  EXPECT_EQ(PARSER_ERROR, parse_nmea_block((const uint8_t *)split_end, strlen(split_end), rx_buffer, &position, &stats));
+  EXPECT_EQ(2, stats.gpsRxChkSumError);
+
+  /* Overlong sentence followed by a good one in the same block */
+  std::string block = "$GP";
+  block.append(NMEA_MAX_PACKET_LENGTH, 'x');
+  block.append("\r\n$GPZDA,123400.00,18,10,2026,00,00*6C\r\n");
+  EXPECT_EQ(PARSER_COMPLETE, parse_nmea_block((const uint8_t *)block.data(), block.size(), rx_buffer, &position, &stats));
+  EXPECT_EQ(1, stats.gpsRxOverflow);
+  EXPECT_EQ(1, stats.gpsRxReceived);
+
+  const char noise[] = "\r\n\x00\xff";
+  EXPECT_EQ(PARSER_ERROR, parse_nmea_block((const uint8_t *)noise, sizeof(noise), rx_buffer, &position, &stats));
+}
+
+/*
+ * Replay a large corpus through both parsers one byte at a time, the way the
+ * GPS task used to read the com port, and in fifo sized chunks.
+ */
+#define BENCH_UBX_EPOCHS 6000
+#define BENCH_NMEA_REPEAT 150
+
+static uint64_t elapsed_ns_since(const struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) * 1000000000ULL + (end.tv_nsec - start->tv_nsec);
+}
+
+TEST_F(GpsParserTest, Benchmark) {
+  const size_t chunks[] = { 1, RX_CHUNK_LEN };
+
+  for (uint32_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+    std::vector<uint8_t> corpus;
+    build_ubx(corpus, BENCH_UBX_EPOCHS);
+    memset(&stats, 0, sizeof(stats));
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    replay(corpus, chunks[c], true);
+    uint64_t ns = elapsed_ns_since(&start);
+
+    EXPECT_EQ((uint16_t)(BENCH_UBX_EPOCHS * UBX_MSGS_PER_EPOCH), stats.gpsRxReceived);
+
+    printf("ubx  %2u byte reads: %7u bytes %6u msgs %8.1f MB/s %6llu ns/msg\n",
+      (unsigned)chunks[c], (unsigned)corpus.size(), BENCH_UBX_EPOCHS * UBX_MSGS_PER_EPOCH,
+      corpus.size() * 1e3 / ns, (unsigned long long)(ns / (BENCH_UBX_EPOCHS * UBX_MSGS_PER_EPOCH)));
+  }
+
+  std::vector<uint8_t> capture;
+  uint32_t sentences;
+  load_nmea(capture, &sentences);
+
+  std::vector<uint8_t> corpus;
+  for (uint32_t i = 0; i < BENCH_NMEA_REPEAT; i++)
+    corpus.insert(corpus.end(), capture.begin(), capture.end());
+
+  for (uint32_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+    memset(&stats, 0, sizeof(stats));
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    replay(corpus, chunks[c], false);
+    uint64_t ns = elapsed_ns_since(&start);
+
+    EXPECT_EQ((uint16_t)(sentences * BENCH_NMEA_REPEAT), (uint16_t)(stats.gpsRxReceived + stats.gpsRxParserError));
+
+    printf("nmea %2u byte reads: %7u bytes %6u msgs %8.1f MB/s %6llu ns/msg\n",
+      (unsigned)chunks[c], (unsigned)corpus.size(), sentences * BENCH_NMEA_REPEAT,
+      corpus.size() * 1e3 / ns, (unsigned long long)(ns / (sentences * BENCH_NMEA_REPEAT)));
+  }
+}
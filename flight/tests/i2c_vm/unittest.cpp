@@ -37,11 +37,14 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock */
 
 extern "C" {
 
 #include "i2c_vm_asm.h"
-extern bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_adapter);
+extern bool i2c_vm_load (const uint32_t * code, uint8_t code_len);
+extern bool i2c_vm_run (uintptr_t i2c_adapter);
+extern bool i2c_vm_verify (const uint32_t * code, uint8_t code_len);
 
 #include "i2cvm.h"		// uavo_data
 
@@ -60,14 +63,16 @@ protected:
 };
 
 TEST_F(I2CVMTest, NullProgram) {
-  EXPECT_FALSE(i2c_vm_run (NULL, 1, 0));
+  EXPECT_FALSE(i2c_vm_load (NULL, 1));
+  EXPECT_FALSE(i2c_vm_run (0));
 }
 
 TEST_F(I2CVMTest, ZeroLengthProgram) {
   const uint32_t program[] = {
   };
 
-  EXPECT_FALSE(i2c_vm_run (program, NELEMENTS(program), 0));
+  EXPECT_FALSE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_FALSE(i2c_vm_run (0));
 }
 
 TEST_F(I2CVMTest, InvalidOpCodeProgram) {
@@ -75,7 +80,8 @@ TEST_F(I2CVMTest, InvalidOpCodeProgram) {
     0xFFFFFFFF,
   };
 
-  EXPECT_FALSE(i2c_vm_run (program, NELEMENTS(program), 0));
+  EXPECT_FALSE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_FALSE(i2c_vm_run (0));
 }
 
 TEST_F(I2CVMTest, NopProgram) {
@@ -83,7 +89,8 @@ TEST_F(I2CVMTest, NopProgram) {
     I2C_VM_ASM_NOP(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 }
 
 TEST_F(I2CVMTest, SendInitialUAVO) {
@@ -91,7 +98,8 @@ TEST_F(I2CVMTest, SendInitialUAVO) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0, uavo_data.pc);
   EXPECT_EQ(0, uavo_data.r0);
@@ -115,7 +123,8 @@ TEST_F(I2CVMTest, RegisterIndependence) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(7,  uavo_data.pc);
   EXPECT_EQ(10, uavo_data.r0);
@@ -133,7 +142,8 @@ TEST_F(I2CVMTest, SetImmMax) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(32767, uavo_data.r0);
 }
@@ -144,7 +154,8 @@ TEST_F(I2CVMTest, SetImmSignExtension) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0xFFFFFFFFu, (uint32_t)uavo_data.r0);
 }
@@ -155,7 +166,8 @@ TEST_F(I2CVMTest, SetImmMin) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(-32768, uavo_data.r0);
 }
@@ -166,7 +178,8 @@ TEST_F(I2CVMTest, SetImmTruncatesAt16Bit) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0x00000001, uavo_data.r0);
 }
@@ -185,7 +198,8 @@ TEST_F(I2CVMTest, Store) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   const uint8_t ram[I2CVM_RAM_NUMELEMENTS] = {
     0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
@@ -199,7 +213,8 @@ TEST_F(I2CVMTest, StoreBadAddress) {
     I2C_VM_ASM_STORE(0x01, sizeof(uavo_data.ram)),
   };
 
-  EXPECT_FALSE(i2c_vm_run (program, NELEMENTS(program), 0));
+  EXPECT_FALSE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_FALSE(i2c_vm_run (0));
 }
 
 TEST_F(I2CVMTest, LoadEndianConversions) {
@@ -222,7 +237,8 @@ TEST_F(I2CVMTest, LoadEndianConversions) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0x00000B0Au, (uint32_t)uavo_data.r0);
   EXPECT_EQ(0x000C0B0Au, (uint32_t)uavo_data.r1);
@@ -237,7 +253,8 @@ TEST_F(I2CVMTest, LoadBadAddress) {
     I2C_VM_ASM_LOAD_LE(sizeof(uavo_data.ram), 2, VM_R0),
   };
 
-  EXPECT_FALSE(i2c_vm_run (program, NELEMENTS(program), 0));
+  EXPECT_FALSE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_FALSE(i2c_vm_run (0));
 }
 
 TEST_F(I2CVMTest, LoadBadLength) {
@@ -245,7 +262,8 @@ TEST_F(I2CVMTest, LoadBadLength) {
     I2C_VM_ASM_LOAD_LE(0, sizeof(uavo_data.ram) + 1, VM_R0),
   };
 
-  EXPECT_FALSE(i2c_vm_run (program, NELEMENTS(program), 0));
+  EXPECT_FALSE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_FALSE(i2c_vm_run (0));
 }
 
 TEST_F(I2CVMTest, LSL_ASR_SignExtend) {
@@ -273,7 +291,8 @@ TEST_F(I2CVMTest, LSL_ASR_SignExtend) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0xFFFFFF80u, (uint32_t)uavo_data.r0);
   EXPECT_EQ(0xFFFF8081u, (uint32_t)uavo_data.r1);
@@ -305,7 +324,8 @@ TEST_F(I2CVMTest, LSL_ASR_ZeroExtend) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0x00000070u, (uint32_t)uavo_data.r0);
   EXPECT_EQ(0x00007071u, (uint32_t)uavo_data.r1);
@@ -346,7 +366,8 @@ TEST_F(I2CVMTest, LogicalShiftLeft) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0x00000000u, (uint32_t)uavo_data.r0);
   EXPECT_EQ(0x00000100u, (uint32_t)uavo_data.r1);
@@ -390,7 +411,8 @@ TEST_F(I2CVMTest, LogicalShiftRight) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0x00000000u, (uint32_t)uavo_data.r0);
   EXPECT_EQ(0x00000100u, (uint32_t)uavo_data.r1);
@@ -434,7 +456,8 @@ TEST_F(I2CVMTest, ArithmeticShiftRight) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0x00000000u, (uint32_t)uavo_data.r0);
   EXPECT_EQ(0x00000100u, (uint32_t)uavo_data.r1);
@@ -454,7 +477,8 @@ TEST_F(I2CVMTest, OrImm) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0x0A0B0C0Du, (uint32_t)uavo_data.r0);
 }
@@ -494,7 +518,8 @@ TEST_F(I2CVMTest, And) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0xAAAA5555u, (uint32_t)uavo_data.r0);
   EXPECT_EQ(0x5555AAAAu, (uint32_t)uavo_data.r1);
@@ -512,7 +537,8 @@ TEST_F(I2CVMTest, AddImmPositive) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(1335, uavo_data.r0);
 }
@@ -524,7 +550,8 @@ TEST_F(I2CVMTest, AddImmNegative) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(-1133, uavo_data.r0);
 }
@@ -536,7 +563,8 @@ TEST_F(I2CVMTest, AddImmDoesNotOverflowAt16Bit) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(32768, uavo_data.r0);
 }
@@ -549,7 +577,8 @@ TEST_F(I2CVMTest, Add) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(1335, uavo_data.r2);
 }
@@ -562,7 +591,8 @@ TEST_F(I2CVMTest, MulPosPos) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(9434826, uavo_data.r2);
 }
@@ -575,7 +605,8 @@ TEST_F(I2CVMTest, MulPosNeg) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(-9434826, uavo_data.r2);
 }
@@ -588,7 +619,8 @@ TEST_F(I2CVMTest, MulNegNeg) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(9434826, uavo_data.r2);
 }
@@ -600,7 +632,8 @@ TEST_F(I2CVMTest, MulImm) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(9434826, uavo_data.r0);
 }
@@ -613,7 +646,8 @@ TEST_F(I2CVMTest, DivPosPos) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(465, uavo_data.r2);
 }
@@ -626,7 +660,8 @@ TEST_F(I2CVMTest, DivPosNeg) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(-465, uavo_data.r2);
 }
@@ -639,7 +674,8 @@ TEST_F(I2CVMTest, DivNegNeg) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(465, uavo_data.r2);
 }
@@ -651,11 +687,46 @@ TEST_F(I2CVMTest, DivImm) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(465, uavo_data.r0);
 }
 
+TEST_F(I2CVMTest, DivImmNegative) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, -10233),
+    I2C_VM_ASM_DIV_IMM(VM_R0,     22),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
+
+  EXPECT_EQ(-465, uavo_data.r0);
+}
+
+TEST_F(I2CVMTest, DivByZero) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, 10233),
+    I2C_VM_ASM_SET_IMM(VM_R1,     0),
+    I2C_VM_ASM_DIV(VM_R2, VM_R0, VM_R1),
+  };
+
+  /* The divisor is only known at run time */
+  EXPECT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_FALSE(i2c_vm_run (0));
+
+  const uint32_t program_imm[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, 10233),
+    I2C_VM_ASM_DIV_IMM(VM_R0,     0),
+  };
+
+  EXPECT_FALSE(i2c_vm_verify (program_imm, NELEMENTS(program_imm)));
+  EXPECT_FALSE(i2c_vm_load (program_imm, NELEMENTS(program_imm)));
+  EXPECT_FALSE(i2c_vm_run (0));
+}
+
 TEST_F(I2CVMTest, JumpForward) {
   const uint32_t program[] = {
     I2C_VM_ASM_SET_IMM(VM_R0, 1),
@@ -667,7 +738,8 @@ TEST_F(I2CVMTest, JumpForward) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(1, uavo_data.r0);
 }
@@ -688,7 +760,8 @@ TEST_F(I2CVMTest, JumpBackward) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(2, uavo_data.r0);
 }
@@ -710,7 +783,8 @@ TEST_F(I2CVMTest, BNZNotTaken) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(1, uavo_data.r0);
 }
@@ -732,11 +806,118 @@ TEST_F(I2CVMTest, BNZTaken) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(2, uavo_data.r0);
 }
 
+TEST_F(I2CVMTest, JumpToEnd) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_JUMP(2),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  EXPECT_TRUE(i2c_vm_verify (program, NELEMENTS(program)));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
+}
+
+TEST_F(I2CVMTest, VerifyBadJumpTarget) {
+  const uint32_t past_end[] = {
+    I2C_VM_ASM_JUMP(3),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  EXPECT_FALSE(i2c_vm_verify (past_end, NELEMENTS(past_end)));
+  EXPECT_FALSE(i2c_vm_load (past_end, NELEMENTS(past_end)));
+  EXPECT_FALSE(i2c_vm_run (0));
+
+  const uint32_t before_start[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, 1),
+    I2C_VM_ASM_BNZ(VM_R0, -2),
+  };
+
+  EXPECT_FALSE(i2c_vm_verify (before_start, NELEMENTS(before_start)));
+  EXPECT_FALSE(i2c_vm_load (before_start, NELEMENTS(before_start)));
+  EXPECT_FALSE(i2c_vm_run (0));
+}
+
+TEST_F(I2CVMTest, VerifyBadRegister) {
+  const uint32_t pc_reg[] = {
+    I2C_VM_ASM_SET_IMM(VM_PC, 1),
+  };
+
+  EXPECT_FALSE(i2c_vm_verify (pc_reg, NELEMENTS(pc_reg)));
+
+  const uint32_t past_r6[] = {
+    I2C_VM_ASM_ADD(VM_R0, VM_R1, VM_R6 + 1),
+  };
+
+  EXPECT_FALSE(i2c_vm_verify (past_r6, NELEMENTS(past_r6)));
+
+  const uint32_t bnz_reg[] = {
+    I2C_VM_ASM_BNZ(VM_PC, 0),
+  };
+
+  EXPECT_FALSE(i2c_vm_verify (bnz_reg, NELEMENTS(bnz_reg)));
+}
+
+TEST_F(I2CVMTest, VerifyBadRamRange) {
+  /* The load would run off the end of RAM */
+  const uint32_t load[] = {
+    I2C_VM_ASM_LOAD_LE(sizeof(uavo_data.ram) - 1, 2, VM_R0),
+  };
+
+  EXPECT_FALSE(i2c_vm_verify (load, NELEMENTS(load)));
+
+  const uint32_t read[] = {
+    I2C_VM_ASM_READ_I2C(2, sizeof(uavo_data.ram) - 1),
+  };
+
+  EXPECT_FALSE(i2c_vm_verify (read, NELEMENTS(read)));
+
+  const uint32_t write[] = {
+    I2C_VM_ASM_WRITE_I2C(0, sizeof(uavo_data.ram)),
+  };
+
+  EXPECT_TRUE(i2c_vm_verify (write, NELEMENTS(write)));
+}
+
+TEST_F(I2CVMTest, VerifyUnreachableCode) {
+  /* Invalid code is rejected even if it would never be executed */
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, 3),
+    I2C_VM_ASM_SEND_UAVO(),
+    I2C_VM_ASM_HALT(),
+    0xFFFFFFFF,
+  };
+
+  uavo_data.r0 = 0;
+
+  EXPECT_FALSE(i2c_vm_verify (program, NELEMENTS(program)));
+  EXPECT_FALSE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_FALSE(i2c_vm_run (0));
+
+  EXPECT_EQ(0, uavo_data.r0);
+}
+
+TEST_F(I2CVMTest, HaltKeepsPC) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_NOP(),
+    I2C_VM_ASM_HALT(),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  uavo_data.pc = 0xFF;
+
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
+
+  /* Halting stops the program before the UAVO is sent */
+  EXPECT_EQ(0xFF, uavo_data.pc);
+}
+
 TEST_F(I2CVMTest, CleanReboot) {
   /* Run a program to scribble all over the machine state */
   const uint32_t program[] = {
@@ -760,7 +941,8 @@ TEST_F(I2CVMTest, CleanReboot) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(15, uavo_data.pc);
   EXPECT_EQ(10, uavo_data.r0);
@@ -783,7 +965,8 @@ TEST_F(I2CVMTest, CleanReboot) {
     I2C_VM_ASM_SEND_UAVO(),
   };
 
-  EXPECT_TRUE(i2c_vm_run (program2, NELEMENTS(program2), 0));
+  ASSERT_TRUE(i2c_vm_load (program2, NELEMENTS(program2)));
+  EXPECT_TRUE(i2c_vm_run (0));
 
   EXPECT_EQ(0, uavo_data.pc);
   EXPECT_EQ(0, uavo_data.r0);
@@ -800,3 +983,65 @@ TEST_F(I2CVMTest, CleanReboot) {
 
   EXPECT_EQ(0, memcmp(ram2, uavo_data.ram, sizeof(ram)));
 }
+
+TEST_F(I2CVMTest, LoadOnceRunMany) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, 7),
+    I2C_VM_ASM_ADD_IMM(VM_R0, 5),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+
+  /* Every run starts from a rebooted machine */
+  for (uint32_t i = 0; i < 3; i++) {
+    EXPECT_TRUE(i2c_vm_run (0));
+    EXPECT_EQ(12, uavo_data.r0);
+  }
+
+  /* A program that fails to load leaves nothing to run */
+  const uint32_t bad[] = {
+    0xFFFFFFFF,
+  };
+
+  EXPECT_FALSE(i2c_vm_load (bad, NELEMENTS(bad)));
+  EXPECT_FALSE(i2c_vm_run (0));
+}
+
+/*
+ * Instruction throughput of the interpreter on a register/RAM heavy loop,
+ * similar in mix to the scaling done by the sensor programs.
+ */
+TEST_F(I2CVMTest, Benchmark) {
+  const int16_t iterations = 30000;
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_IMM(VM_R0, iterations),
+    I2C_VM_ASM_SET_IMM(VM_R1, 0),
+    I2C_VM_ASM_SET_IMM(VM_R2, 3),
+
+    /* Loop body */
+    I2C_VM_ASM_ADD(VM_R1, VM_R1, VM_R2),
+    I2C_VM_ASM_MUL_IMM(VM_R1, 3),
+    I2C_VM_ASM_ASR_IMM(VM_R1, 1),
+    I2C_VM_ASM_STORE(0x5A, 0),
+    I2C_VM_ASM_LOAD_LE(0, 2, VM_R3),
+    I2C_VM_ASM_ADD_IMM(VM_R0, -1),
+    I2C_VM_ASM_BNZ(VM_R0, -6),
+
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+  const uint32_t runs = 50;
+  const double instructions = runs * (4.0 + 7.0 * iterations);
+
+  clock_t start = clock();
+  ASSERT_TRUE(i2c_vm_load (program, NELEMENTS(program)));
+  for (uint32_t i = 0; i < runs; i++)
+    ASSERT_TRUE(i2c_vm_run (0));
+  double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+  EXPECT_EQ(0, uavo_data.r0);
+  EXPECT_EQ(0x5A, uavo_data.r3);
+
+  printf("%.0f instructions in %.3f s, %.2f M instructions/s\n",
+    instructions, elapsed, instructions / elapsed / 1e6);
+}
@@ -17,6 +17,8 @@ struct flash_posix_dev {
 	const struct pios_flash_posix_cfg * cfg;
 	bool transaction_in_progress;
 	FILE * flash_file;
+	uint32_t read_count;
+	uint32_t erase_count;
 };
 
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
@@ -42,8 +44,10 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 
 	flash_dev->cfg = cfg;
 	flash_dev->transaction_in_progress = false;
+	flash_dev->read_count = 0;
+	flash_dev->erase_count = 0;
 
-	flash_dev->flash_file = fopen ("theflash.bin", "r+");
+	flash_dev->flash_file = fopen (cfg->file_name ? cfg->file_name : "theflash.bin", "r+");
 	if (flash_dev->flash_file == NULL) {
 		return -1;
 	}
@@ -66,6 +70,29 @@ void PIOS_Flash_Posix_Destroy(uintptr_t chip_id)
 	free(flash_dev);
 }
 
+/* Number of read operations issued since init or the last reset */
+uint32_t PIOS_Flash_Posix_GetReadCount(uintptr_t chip_id)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	return flash_dev->read_count;
+}
+
+void PIOS_Flash_Posix_ResetReadCount(uintptr_t chip_id)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	flash_dev->read_count = 0;
+}
+
+/* Number of sector erases issued since init */
+uint32_t PIOS_Flash_Posix_GetEraseCount(uintptr_t chip_id)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	return flash_dev->erase_count;
+}
+
 /**********************************
  *
  * Provide a PIOS flash driver API
@@ -116,6 +143,8 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	assert (s == flash_dev->cfg->size_of_sector);
 
+	flash_dev->erase_count++;
+
 	return 0;
 }
 
@@ -149,6 +178,8 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 
 	assert(flash_dev->transaction_in_progress);
 
+	flash_dev->read_count++;
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
@@ -67,6 +67,14 @@ void PIOS_free(void * buf)
 	vPortFree(buf);
 }
 
+/* Lets the tests pretend the heap is nearly full */
+size_t pios_heap_test_free_size = 1024 * 1024;
+
+size_t PIOS_heap_get_free_size(void)
+{
+	return pios_heap_test_free_size;
+}
+
 /**
  * @}
  * @}
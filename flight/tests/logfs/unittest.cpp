@@ -37,6 +37,7 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
 
 extern "C" {
 
@@ -59,6 +60,8 @@ extern struct flashfs_logfs_cfg flashfs_config_waypoints;
 
 #include "pios_flashfs.h"	/* PIOS_FLASHFS_* */
 
+extern size_t pios_heap_test_free_size;
+
 }
 
 #define OBJ0_ID 0xAA55AA55
@@ -144,6 +147,29 @@ TEST_F(LogfsTestRaw, LogfsInit) {
   PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
 }
 
+TEST_F(LogfsTestRaw, LogfsInitWithoutIndexRam) {
+  EXPECT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+
+  /* Too little heap left for the slot index, the mount must fall back to scanning */
+  size_t saved_free_size = pios_heap_test_free_size;
+  pios_heap_test_free_size = 0;
+
+  uintptr_t fs_id;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  pios_heap_test_free_size = saved_free_size;
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+}
+
 class LogfsTestCooked : public LogfsTestRaw {
 protected:
   virtual void SetUp() {
@@ -333,6 +359,179 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
   EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+/*
+ * Boot time benchmark: mount a settings log the way a board with external
+ * flash finds it at power up and load every object once, as
+ * UAVObjLoadSettings() does.
+ */
+#define BENCH_NUM_OBJS 100
+#define BENCH_NUM_RESAVES 100
+
+TEST_F(LogfsTestCooked, BootLoadBenchmark) {
+  /* Save one instance of each object, then save some of them again to leave obsolete slots behind */
+  for (uint32_t i = 0; i < BENCH_NUM_OBJS; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i * 0x01010101, 0, obj1, sizeof(obj1)));
+  }
+  for (uint32_t i = 0; i < BENCH_NUM_RESAVES; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + (i % 10) * 0x01010101, 0, obj1_alt, sizeof(obj1_alt)));
+  }
+
+  /* Reboot */
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  PIOS_Flash_Posix_ResetReadCount(pios_posix_flash_id);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  uint32_t mount_reads = PIOS_Flash_Posix_GetReadCount(pios_posix_flash_id);
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  for (uint32_t i = 0; i < BENCH_NUM_OBJS; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i * 0x01010101, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(i < 10 ? obj1_alt : obj1, obj1_check, sizeof(obj1_check)));
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint32_t load_reads = PIOS_Flash_Posix_GetReadCount(pios_posix_flash_id) - mount_reads;
+  uint64_t elapsed_us = (end.tv_sec - start.tv_sec) * 1000000ULL + (end.tv_nsec - start.tv_nsec) / 1000;
+
+  printf("logfs boot: %u objects, %u mount reads, %u load reads, %llu us\n",
+    BENCH_NUM_OBJS, mount_reads, load_reads, (unsigned long long)elapsed_us);
+
+  /* Each load should only need the slot header and the data, plus the odd tag collision */
+  EXPECT_LE(load_reads, 3U * BENCH_NUM_OBJS);
+}
+
+/*
+ * Fill the log until a background collection is wanted, then run it in small
+ * steps while saves keep coming in. The collection must spread over several
+ * steps and no save may ever have to wait for a sector erase.
+ */
+#define GC_NUM_OBJS 10
+#define GC_NUM_SAVES 200
+
+TEST_F(LogfsTestCooked, IncrementalGarbageCollect) {
+  bool resaved[GC_NUM_OBJS] = { false };
+
+  for (uint32_t i = 0; i < GC_NUM_SAVES; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + (i % GC_NUM_OBJS) * 0x01010101, 0, obj1, sizeof(obj1)));
+  }
+
+  uint32_t step_erases = 0;
+  uint32_t max_save_erases = 0;
+  uint32_t steps = 0;
+  int32_t rc;
+
+  do {
+    uint32_t erases = PIOS_Flash_Posix_GetEraseCount(pios_posix_flash_id);
+    rc = PIOS_FLASHFS_Logfs_Background_GC(fs_id, 8);
+    step_erases += PIOS_Flash_Posix_GetEraseCount(pios_posix_flash_id) - erases;
+    ASSERT_LE(0, rc);
+
+    /* Keep the log busy while the collection is in progress */
+    uint32_t obj = steps++ % GC_NUM_OBJS;
+    erases = PIOS_Flash_Posix_GetEraseCount(pios_posix_flash_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + obj * 0x01010101, 0, obj1_alt, sizeof(obj1_alt)));
+    uint32_t save_erases = PIOS_Flash_Posix_GetEraseCount(pios_posix_flash_id) - erases;
+    if (save_erases > max_save_erases)
+      max_save_erases = save_erases;
+    resaved[obj] = true;
+  } while (rc > 0);
+
+  struct flashfs_logfs_stats stats;
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Get_Stats(fs_id, &stats));
+
+  printf("logfs gc: %u steps, %u erases in steps, %u max erases in a save, %u writes, %u copies, %u erases\n",
+    steps, step_erases, max_save_erases, stats.obj_writes, stats.gc_copies, stats.gc_erases);
+
+  EXPECT_EQ(1U, stats.gc_runs);
+  EXPECT_EQ(0U, stats.gc_forced);
+  EXPECT_EQ(1U, stats.gc_erases);
+  EXPECT_LE(stats.gc_copies, GC_NUM_OBJS + steps);
+  EXPECT_EQ(0U, max_save_erases);
+  EXPECT_EQ(stats.gc_erases, step_erases);
+  EXPECT_GT(steps, 1U);
+
+  /* Nothing left to collect */
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Background_GC(fs_id, 8));
+
+  /* Deleting an object must not leave a stale copy behind, even across a reboot */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 0));
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  for (uint32_t i = 1; i < GC_NUM_OBJS; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i * 0x01010101, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(resaved[i] ? obj1_alt : obj1, obj1_check, sizeof(obj1_check)));
+  }
+}
+
+/*
+ * Fill most of the log with distinct objects, then keep saving one of them
+ * while running the background collection to completion after every save.
+ * A few obsolete slots must not cost an arena erase on each save.
+ */
+#define GC_FULL_NUM_OBJS 200
+#define GC_FULL_NUM_SAVES 40
+
+TEST_F(LogfsTestCooked, NearlyFullArenaGarbageCollect) {
+  uint16_t num_slots = flashfs_config_settings.arena_size / flashfs_config_settings.slot_size;
+
+  for (uint32_t i = 0; i < GC_FULL_NUM_OBJS; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i, 0, obj1, sizeof(obj1)));
+  }
+
+  struct flashfs_logfs_stats stats;
+  for (uint32_t i = 0; i < GC_FULL_NUM_SAVES; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+
+    int32_t rc;
+    do {
+      rc = PIOS_FLASHFS_Logfs_Background_GC(fs_id, 8);
+      ASSERT_LE(0, rc);
+    } while (rc > 0);
+  }
+
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Get_Stats(fs_id, &stats));
+  EXPECT_EQ(0U, stats.gc_forced);
+  EXPECT_LE(stats.gc_runs, (uint32_t)(GC_FULL_NUM_SAVES / (num_slots / 8)));
+  EXPECT_EQ(stats.gc_runs, stats.gc_erases);
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + GC_FULL_NUM_OBJS - 1, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1_check)));
+}
+
+TEST_F(LogfsTestCooked, ForcedGarbageCollect) {
+  struct flashfs_logfs_stats stats;
+
+  /* Never run the background collection so that a save eventually has to */
+  uint32_t saves = 0;
+  do {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + (saves % GC_NUM_OBJS) * 0x01010101, 0, obj1, sizeof(obj1)));
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Get_Stats(fs_id, &stats));
+    saves++;
+  } while (stats.gc_forced == 0 && saves < 1000);
+
+  EXPECT_EQ(1U, stats.gc_forced);
+  EXPECT_EQ(1U, stats.gc_runs);
+  EXPECT_EQ(saves, stats.obj_writes);
+  /* The object being saved was already obsoleted so only the others get copied */
+  EXPECT_EQ((uint32_t)GC_NUM_OBJS - 1, stats.gc_copies);
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  for (uint32_t i = 0; i < GC_NUM_OBJS; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i * 0x01010101, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1_check)));
+  }
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
   virtual void SetUp() {
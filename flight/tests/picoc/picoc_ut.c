@@ -0,0 +1,65 @@
+#include "picoc_ut.h"
+#include "openpilot.h"
+#include "pios_thread.h"
+
+/* picoc_port.h redirects malloc, so only the type is declared here */
+typedef struct Picoc_Struct Picoc;
+void PlatformLibraryInit(Picoc *pc);
+
+#define OUTPUT_SIZE 4096
+
+char picoc_ut_output[OUTPUT_SIZE];
+static uint32_t output_len;
+
+void picoc_ut_reset(void)
+{
+	output_len = 0;
+	picoc_ut_output[0] = '\0';
+}
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+}
+
+uint16_t PIOS_COM_ReceiveBuffer(uintptr_t com_id, uint8_t *buf, uint16_t buf_len, uint32_t timeout_ms)
+{
+	return 0;
+}
+
+int32_t PIOS_COM_SendChar(uintptr_t com_id, char c)
+{
+	if (output_len < OUTPUT_SIZE - 1) {
+		picoc_ut_output[output_len++] = c;
+		picoc_ut_output[output_len] = '\0';
+	}
+	return 0;
+}
+
+int32_t PIOS_COM_SendString(uintptr_t com_id, const char *str)
+{
+	while (*str)
+		PIOS_COM_SendChar(com_id, *str++);
+	return 0;
+}
+
+int32_t PIOS_COM_SendFormattedString(uintptr_t com_id, const char *format, ...)
+{
+	char buffer[256];
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	return PIOS_COM_SendString(com_id, buffer);
+}
+
+/* the flight library (UAVObjects, receiver, ...) is not available on the host */
+void PlatformLibraryInit(Picoc *pc)
+{
+}
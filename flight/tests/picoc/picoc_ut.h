@@ -0,0 +1,19 @@
+#ifndef PICOC_UT_H
+#define PICOC_UT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* everything the script printed since the last reset */
+extern char picoc_ut_output[];
+
+void picoc_ut_reset(void);
+
+/* pios functions used by the interpreter */
+void *PIOS_malloc(size_t size);
+uint16_t PIOS_COM_ReceiveBuffer(uintptr_t com_id, uint8_t *buf, uint16_t buf_len, uint32_t timeout_ms);
+int32_t PIOS_COM_SendChar(uintptr_t com_id, char c);
+int32_t PIOS_COM_SendString(uintptr_t com_id, const char *str);
+int32_t PIOS_COM_SendFormattedString(uintptr_t com_id, const char *format, ...);
+
+#endif /* PICOC_UT_H */
@@ -0,0 +1,6 @@
+#ifndef PICOCSTATUS_H
+#define PICOCSTATUS_H
+
+/* picoc_platform.c only needs the header to exist */
+
+#endif /* PICOCSTATUS_H */
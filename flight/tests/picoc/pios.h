@@ -0,0 +1,7 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include "openpilot.h"
+#include "picoc_ut.h"
+
+#endif /* PIOS_H */
@@ -0,0 +1,7 @@
+#ifndef PIOS_CONFIG_H
+#define PIOS_CONFIG_H
+
+#define PIOS_INCLUDE_PICOC
+#define PIOS_COM_PICOC 1
+
+#endif /* PIOS_CONFIG_H */
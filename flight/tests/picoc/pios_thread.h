@@ -0,0 +1,8 @@
+#ifndef PIOS_THREAD_H_
+#define PIOS_THREAD_H_
+
+#include <stdint.h>
+
+void PIOS_Thread_Sleep(uint32_t time_ms);
+
+#endif /* PIOS_THREAD_H_ */
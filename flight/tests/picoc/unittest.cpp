@@ -0,0 +1,353 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for precompiled picoc script images and block scopes
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* strlen */
+#include <string>		/* std::string */
+#include <time.h>		/* clock */
+
+extern "C" {
+
+#include "picoc_ut.h"
+
+int picoc(const char *source, size_t stack_size);
+int32_t picoc_compile(const char *source, uint32_t source_len, uint8_t *image, uint32_t image_size, size_t stack_size);
+bool picoc_image_valid(const uint8_t *image, uint32_t image_size, const char *source, uint32_t source_len);
+uint32_t picoc_image_len(const uint8_t *image);
+int picoc_run(const uint8_t *image, const char *source, size_t stack_size);
+
+}
+
+#define STACK_SIZE (16 * 1024)
+#define IMAGE_SIZE 4096
+
+static const char script_features[] =
+	"#define SCALE 3\n"
+	"struct point { int x; int y; };\n"
+	"char *name = \"picoc\";\n"
+	"int square(int v) { return v * v; }\n"
+	"void show(char *label, int v) { printf(\"%s=%d\\n\", label, v); }\n"
+	"struct point p;\n"
+	"p.x = square(SCALE); p.y = 'A';\n"
+	"show(\"x\", p.x);\n"
+	"show(\"y\", p.y);\n"
+	"show(name, name[1]);\n"
+	"double f = 1.5 * SCALE;\n"
+	"printf(\"%f %s\\n\", f, \"picoc\");\n"
+	"{ int a = 1; { int b = 2; show(\"inner\", a + b); } show(\"outer\", a); }\n"
+	"exit(7);\n";
+
+// Loop heavy scripts for the benchmark, all ending with the same checksum print
+static const char script_loop[] =
+	"int sum = 0;\n"
+	"for (int i = 0; i < 200; i++) {\n"
+	"	if (i % 3 == 0)\n"
+	"		sum += i * 2;\n"
+	"	else\n"
+	"		sum -= 1;\n"
+	"}\n"
+	"printf(\"%d\\n\", sum);\n";
+
+static const char script_nested[] =
+	"int table[16];\n"
+	"int sum = 0;\n"
+	"for (int i = 0; i < 16; i++) table[i] = i * i;\n"
+	"for (int j = 0; j < 8; j++) {\n"
+	"	for (int k = 0; k < 16; k++) {\n"
+	"		sum += table[k] ^ j;\n"
+	"	}\n"
+	"}\n"
+	"printf(\"%d\\n\", sum);\n";
+
+static const char script_functions[] =
+	"/* a filter and a controller, similar to what a user task would run */\n"
+	"double lowpass(double state, double input, double alpha)\n"
+	"{\n"
+	"	return state + alpha * (input - state);\n"
+	"}\n"
+	"\n"
+	"double pid(double error, double *integral, double kp, double ki)\n"
+	"{\n"
+	"	*integral = *integral + error * ki;\n"
+	"	if (*integral > 10.0) *integral = 10.0;\n"
+	"	if (*integral < -10.0) *integral = -10.0;\n"
+	"	return error * kp + *integral;\n"
+	"}\n"
+	"\n"
+	"double state = 0;\n"
+	"double integral = 0;\n"
+	"double output = 0;\n"
+	"int step;\n"
+	"for (step = 0; step < 50; step++) {\n"
+	"	double setpoint = (step < 25) ? 1.0 : -1.0;\n"
+	"	state = lowpass(state, output, 0.1);\n"
+	"	output = pid(setpoint - state, &integral, 0.8, 0.05);\n"
+	"}\n"
+	"printf(\"%d\\n\", (int)(state * 1000));\n";
+
+// Blocks entered over and over, some of them declaring variables
+static const char script_scopes[] =
+	"int x = 1;\n"
+	"int total = 0;\n"
+	"for (int i = 0; i < 4; i++) {\n"
+	"	int xi = i * 10;\n"
+	"	{ int y = xi + 1; total += y; }\n"
+	"	if (i == 3) { int z = xi; total += z; }\n"
+	"	while (0) { int w = 5; }\n"
+	"}\n"
+	"int twice(int v) { int r = v * 2; { int r2 = r; return r2; } }\n"
+	"for (int j = 0; j < 3; j++) total += twice(j);\n"
+	"printf(\"%d %d\\n\", x, total);\n";
+
+class PicoC : public testing::Test {
+protected:
+  virtual void SetUp() {
+    picoc_ut_reset();
+    memset(image, 0, sizeof(image));
+  };
+
+  int compile(const char *source) {
+    return picoc_compile(source, strlen(source), image, sizeof(image), STACK_SIZE);
+  }
+
+  /* run a script from source and return its output */
+  std::string run_source(const char *source, int *exit_value) {
+    picoc_ut_reset();
+    *exit_value = picoc(source, STACK_SIZE);
+    return std::string(picoc_ut_output);
+  }
+
+  /* run the compiled image and return its output */
+  std::string run_image(const char *source, int *exit_value) {
+    picoc_ut_reset();
+    *exit_value = picoc_run(image, source, STACK_SIZE);
+    return std::string(picoc_ut_output);
+  }
+
+  uint8_t image[IMAGE_SIZE];
+};
+
+TEST_F(PicoC, ImageMatchesSource) {
+  const char *scripts[] = { script_features, script_loop, script_nested, script_functions, script_scopes };
+
+  for (uint32_t i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++) {
+    int source_exit, image_exit;
+
+    ASSERT_GT(compile(scripts[i]), 0);
+    ASSERT_TRUE(picoc_image_valid(image, sizeof(image), scripts[i], strlen(scripts[i])));
+
+    std::string source_output = run_source(scripts[i], &source_exit);
+    std::string image_output = run_image(scripts[i], &image_exit);
+
+    EXPECT_FALSE(source_output.empty());
+    EXPECT_EQ(source_output, image_output) << "script " << i;
+    EXPECT_EQ(source_exit, image_exit) << "script " << i;
+  }
+}
+
+TEST_F(PicoC, ImageFeatures) {
+  int exit_value;
+
+  ASSERT_GT(compile(script_features), 0);
+  std::string output = run_image(script_features, &exit_value);
+
+  EXPECT_EQ(7, exit_value);
+  EXPECT_NE(std::string::npos, output.find("x=9\n"));
+  EXPECT_NE(std::string::npos, output.find("y=65\n"));
+  EXPECT_NE(std::string::npos, output.find("picoc=105\n"));
+  EXPECT_NE(std::string::npos, output.find("inner=3\nouter=1\n"));
+}
+
+TEST_F(PicoC, BlockScopes) {
+  int exit_value;
+
+  /* 1+11+21+31 from the inner blocks, 30 from the last if, 0+2+4 from twice() */
+  ASSERT_GT(compile(script_scopes), 0);
+  EXPECT_EQ("1 100\n", run_image(script_scopes, &exit_value));
+  EXPECT_EQ(0, exit_value);
+}
+
+TEST_F(PicoC, OutOfScopeVariable) {
+  int exit_value;
+  const char *source = "for (int i = 0; i < 2; i++) { int inner = i; }\nprintf(\"%d\\n\", inner);\n";
+
+  ASSERT_GT(compile(source), 0);
+  std::string output = run_image(source, &exit_value);
+
+  EXPECT_EQ(1, exit_value);
+  EXPECT_NE(std::string::npos, output.find("'inner' is out of scope"));
+}
+
+TEST_F(PicoC, LoopResults) {
+  int exit_value;
+
+  ASSERT_GT(compile(script_loop), 0);
+  EXPECT_EQ("13133\n", run_image(script_loop, &exit_value));
+  ASSERT_GT(compile(script_nested), 0);
+  EXPECT_EQ("10176\n", run_image(script_nested, &exit_value));
+}
+
+TEST_F(PicoC, ImageCanRunRepeatedly) {
+  int first_exit, exit_value;
+
+  ASSERT_GT(compile(script_loop), 0);
+  std::string first = run_image(script_loop, &first_exit);
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(first, run_image(script_loop, &exit_value));
+    EXPECT_EQ(first_exit, exit_value);
+  }
+}
+
+TEST_F(PicoC, ImageLength) {
+  int32_t len = compile(script_functions);
+
+  ASSERT_GT(len, 0);
+  EXPECT_EQ((uint32_t) len, picoc_image_len(image));
+
+  /* the image fits into a buffer of exactly its length */
+  memset(image, 0, sizeof(image));
+  EXPECT_EQ(len, picoc_compile(script_functions, strlen(script_functions), image, len, STACK_SIZE));
+  EXPECT_TRUE(picoc_image_valid(image, len, script_functions, strlen(script_functions)));
+  EXPECT_EQ(-1, picoc_compile(script_functions, strlen(script_functions), image, len - 1, STACK_SIZE));
+}
+
+TEST_F(PicoC, StaleImageRejected) {
+  std::string source(script_loop);
+
+  ASSERT_GT(compile(source.c_str()), 0);
+  EXPECT_TRUE(picoc_image_valid(image, sizeof(image), source.c_str(), source.length()));
+
+  /* an edit of the source invalidates the image */
+  source[source.find("200")] = '3';
+  EXPECT_FALSE(picoc_image_valid(image, sizeof(image), source.c_str(), source.length()));
+
+  /* so does a truncated source */
+  EXPECT_FALSE(picoc_image_valid(image, sizeof(image), script_loop, strlen(script_loop) - 1));
+}
+
+TEST_F(PicoC, CorruptImageRejected) {
+  int32_t len = compile(script_loop);
+  ASSERT_GT(len, 0);
+
+  /* a flipped bit in the token stream */
+  image[len - 3] ^= 0x10;
+  EXPECT_FALSE(picoc_image_valid(image, sizeof(image), script_loop, strlen(script_loop)));
+  image[len - 3] ^= 0x10;
+  EXPECT_TRUE(picoc_image_valid(image, sizeof(image), script_loop, strlen(script_loop)));
+
+  /* an image that was only partly loaded */
+  EXPECT_FALSE(picoc_image_valid(image, len - 1, script_loop, strlen(script_loop)));
+
+  /* an empty (erased) buffer */
+  memset(image, 0, sizeof(image));
+  EXPECT_FALSE(picoc_image_valid(image, sizeof(image), script_loop, strlen(script_loop)));
+}
+
+TEST_F(PicoC, CompileFailures) {
+  /* a lexer error */
+  const char *bad = "int i = 0; i = i @ 2;";
+  EXPECT_EQ(-1, compile(bad));
+  EXPECT_FALSE(picoc_image_valid(image, sizeof(image), bad, strlen(bad)));
+
+  /* an image buffer which is too small */
+  EXPECT_EQ(-1, picoc_compile(script_functions, strlen(script_functions), image, 64, STACK_SIZE));
+  EXPECT_FALSE(picoc_image_valid(image, sizeof(image), script_functions, strlen(script_functions)));
+}
+
+TEST_F(PicoC, RuntimeErrorReportsSourceLine) {
+  const char *source = "int a = 1;\nint b = 2;\nint c = a + undefined;\n";
+  int source_exit, image_exit;
+
+  ASSERT_GT(compile(source), 0);
+  std::string source_output = run_source(source, &source_exit);
+  std::string image_output = run_image(source, &image_exit);
+
+  EXPECT_EQ(1, image_exit);
+  EXPECT_EQ(source_output, image_output);
+  EXPECT_NE(std::string::npos, image_output.find("nofile:3:"));
+}
+
+/*
+ * Starts per second for each script, run from source (lexing the source
+ * every time) and from the precompiled image.
+ */
+TEST_F(PicoC, Benchmark) {
+  const struct {
+    const char *name;
+    const char *source;
+    int runs;
+  } scripts[] = {
+    { "loop     ", script_loop, 300 },
+    { "nested   ", script_nested, 300 },
+    { "functions", script_functions, 300 },
+    { "scopes   ", script_scopes, 300 },
+    { "features ", script_features, 1000 },
+  };
+
+  for (uint32_t i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++) {
+    int exit_value;
+    clock_t start;
+
+    start = clock();
+    int32_t image_len = compile(scripts[i].source);
+    double compile_time = (double) (clock() - start) / CLOCKS_PER_SEC;
+    ASSERT_GT(image_len, 0);
+
+    start = clock();
+    for (int run = 0; run < scripts[i].runs; run++) {
+      picoc_ut_reset();
+      picoc(scripts[i].source, STACK_SIZE);
+    }
+    double source_time = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int run = 0; run < scripts[i].runs; run++) {
+      picoc_ut_reset();
+      exit_value = picoc_run(image, scripts[i].source, STACK_SIZE);
+    }
+    double image_time = (double) (clock() - start) / CLOCKS_PER_SEC;
+    (void) exit_value;
+
+    printf("%s: source %4u bytes %8.0f runs/s, image %4d bytes %8.0f runs/s, compile %.3f ms\n",
+      scripts[i].name, (unsigned) strlen(scripts[i].source), scripts[i].runs / source_time,
+      image_len, scripts[i].runs / image_time, compile_time * 1000);
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -25,5 +25,9 @@
 #define PIOS_Assert(x) if (!(x)) { while (1) ; }
 #define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
 
+#if defined(PIOS_INCLUDE_DELAY)
+#include <pios_delay.h>
+#endif
+
 // These tests are all single threaded
 #define PIOS_DELAY_WaitmS(x)
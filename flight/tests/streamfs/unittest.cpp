@@ -37,6 +37,8 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock */
+#include <algorithm>		/* std::min */
 
 extern "C" {
 
@@ -67,6 +69,17 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS) {
   return mS;
 }
 
+// A clock the tests advance by hand, in microseconds
+static uint32_t fake_time_us;
+
+uint32_t PIOS_DELAY_GetRaw() {
+  return fake_time_us;
+}
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw) {
+  return fake_time_us - raw;
+}
+
 }
 
 // To use a test fixture, derive a class from testing::Test.
@@ -462,3 +475,146 @@ TEST_F(StreamfsComTest, ComRead) {
   EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
   CompareArray(data1, data_read, DATA_LEN);
 }
+
+TEST_F(StreamfsTestCooked, ShortFile) {
+  /* a file smaller than a page and an arena is kept on close */
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+  EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, data1, 100));
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+  int32_t file_id = PIOS_STREAMFS_MaxFileId(fs_id);
+  EXPECT_EQ(0, file_id);
+
+  uint8_t data_read[200];
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id, file_id));
+  EXPECT_EQ(100, PIOS_STREAMFS_Testing_Read(fs_id, data_read, sizeof(data_read)));
+  CompareArray(data1, data_read, 100);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+}
+
+TEST_F(StreamfsTestCooked, WritesArePageSized) {
+  struct streamfs_stats stats;
+
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+
+  /* small appends, like UAVTalk frames from the logger */
+  uint32_t total_write = 0;
+  for (uint32_t i = 0; total_write < DATA_LEN; i++) {
+    uint32_t len = std::min<uint32_t>(13 + (i * 7) % 60, DATA_LEN - total_write);
+    EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, &data1[total_write], len));
+    total_write += len;
+  }
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Get_Stats(fs_id, &stats));
+  EXPECT_EQ((uint32_t) DATA_LEN, stats.bytes_appended);
+  EXPECT_EQ(0U, stats.partial_flushes);
+
+  /* everything but the last partial page is in flash: 255 whole pages and
+   * the short page in front of the footer, the footer, then 134 whole pages */
+  EXPECT_EQ(255U + 1 + 1 + 134, stats.flash_writes);
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+  EXPECT_EQ(0, PIOS_STREAMFS_Get_Stats(fs_id, &stats));
+  EXPECT_EQ(1U, stats.partial_flushes);
+
+  uint8_t data_read[DATA_LEN];
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id, PIOS_STREAMFS_MaxFileId(fs_id)));
+  EXPECT_EQ(DATA_LEN, PIOS_STREAMFS_Testing_Read(fs_id, data_read, DATA_LEN));
+  CompareArray(data1, data_read, DATA_LEN);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+}
+
+TEST_F(StreamfsTestCooked, FlushTimeout) {
+  struct streamfs_stats stats;
+
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, data1, 10));
+  fake_time_us += 500000;
+  EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, &data1[10], 10));
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Get_Stats(fs_id, &stats));
+  EXPECT_EQ(0U, stats.flash_writes);
+
+  /* data buffered for too long is written out with the next append */
+  fake_time_us += 600000;
+  EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, &data1[20], 10));
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Get_Stats(fs_id, &stats));
+  EXPECT_EQ(1U, stats.flash_writes);
+  EXPECT_EQ(30U, stats.flash_bytes);
+  EXPECT_EQ(1U, stats.partial_flushes);
+
+  /* the rest of that page is filled up before going back to whole pages */
+  EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, &data1[30], 256 - 30 + 256));
+  EXPECT_EQ(0, PIOS_STREAMFS_Get_Stats(fs_id, &stats));
+  EXPECT_EQ(3U, stats.flash_writes);
+  EXPECT_EQ(512U, stats.flash_bytes);
+
+  /* a stream that goes quiet is written out by the periodic flush */
+  EXPECT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, &data1[512], 20));
+  fake_time_us += 500000;
+  EXPECT_EQ(0, PIOS_STREAMFS_Flush_Stale(fs_id));
+  EXPECT_EQ(0, PIOS_STREAMFS_Get_Stats(fs_id, &stats));
+  EXPECT_EQ(3U, stats.flash_writes);
+
+  fake_time_us += 600000;
+  EXPECT_EQ(0, PIOS_STREAMFS_Flush_Stale(fs_id));
+  EXPECT_EQ(0, PIOS_STREAMFS_Get_Stats(fs_id, &stats));
+  EXPECT_EQ(4U, stats.flash_writes);
+  EXPECT_EQ(532U, stats.flash_bytes);
+  EXPECT_EQ(2U, stats.partial_flushes);
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+  /* nothing to flush once the file is closed */
+  EXPECT_EQ(0, PIOS_STREAMFS_Flush_Stale(fs_id));
+
+  uint8_t data_read[1024];
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id, PIOS_STREAMFS_MaxFileId(fs_id)));
+  EXPECT_EQ(532, PIOS_STREAMFS_Testing_Read(fs_id, data_read, sizeof(data_read)));
+  CompareArray(data1, data_read, 532);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+}
+
+/*
+ * Log a stream of UAVTalk sized frames through PIOS_COM the way the Logging
+ * module does, and report the throughput and the flash operations it took
+ */
+TEST_F(StreamfsComTest, LoggingBenchmark) {
+  const uint32_t runs = 10;
+  struct streamfs_stats stats;
+  uint32_t frames = 0;
+
+  clock_t start = clock();
+  for (uint32_t run = 0; run < runs; run++) {
+    EXPECT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+
+    uint32_t total_write = 0;
+    for (uint32_t i = 0; total_write < DATA_LEN; i++) {
+      uint32_t len = std::min<uint32_t>(13 + (i * 7) % 38, DATA_LEN - total_write);
+      ASSERT_EQ((int32_t) len, PIOS_COM_SendBuffer(com_id, &data2[total_write], len));
+      total_write += len;
+      frames++;
+    }
+
+    EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+  }
+  double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Get_Stats(fs_id, &stats));
+  EXPECT_EQ(runs * DATA_LEN, stats.bytes_appended);
+
+  printf("%u frames, %.0f kB/s, %u flash writes (%.1f bytes each), %u arena erases\n",
+    frames, runs * DATA_LEN / elapsed / 1024, stats.flash_writes,
+    (double) stats.flash_bytes / stats.flash_writes, stats.arena_erases);
+
+  /* every frame would have been a flash write of its own without buffering */
+  EXPECT_LT(stats.flash_writes * 5, frames);
+
+  uint8_t data_read[DATA_LEN];
+  EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id, PIOS_STREAMFS_MaxFileId(fs_id)));
+  EXPECT_EQ(DATA_LEN, PIOS_STREAMFS_Testing_Read(fs_id, data_read, DATA_LEN));
+  CompareArray(data2, data_read, DATA_LEN);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+}
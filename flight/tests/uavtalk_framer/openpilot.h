@@ -0,0 +1,10 @@
+/* Would be from openpilot.h but that file pulls on way too many dependencies */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "pios.h"
+
+typedef void *UAVObjHandle;
+
+#include "uavtalk.h"
@@ -0,0 +1,5 @@
+/* Would be from pios.h but that file pulls on way too many dependencies */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pios_crc.h"
@@ -0,0 +1,2 @@
+/* Would be generated, only the size of the largest object is needed */
+#define UAVOBJECTS_LARGEST 128
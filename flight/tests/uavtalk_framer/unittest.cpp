@@ -0,0 +1,248 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the UAVTalk framer of the radio bridge
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memcpy */
+#include <time.h>		/* clock */
+#include <vector>		/* std::vector */
+
+extern "C" {
+
+#include "openpilot.h"
+#include "uavtalk_priv.h"
+#include "uavtalk_framer.h"
+
+}
+
+typedef std::vector<uint8_t> frame_t;
+
+/* Build a frame the way uavtalk.c sends it */
+static frame_t make_frame(uint8_t type, uint32_t obj_id, bool multi_inst, uint16_t inst_id, uint16_t data_len)
+{
+  frame_t frame;
+
+  frame.push_back(UAVTALK_SYNC_VAL);
+  frame.push_back(type);
+  frame.push_back(0);
+  frame.push_back(0);
+  for (int i = 0; i < 4; i++)
+    frame.push_back(obj_id >> (8 * i));
+  if (multi_inst) {
+    frame.push_back(inst_id);
+    frame.push_back(inst_id >> 8);
+  }
+  for (uint16_t i = 0; i < data_len; i++)
+    frame.push_back(obj_id + i);
+
+  frame[2] = frame.size();
+  frame[3] = frame.size() >> 8;
+  frame.push_back(PIOS_CRC_updateCRC(0, &frame[0], frame.size()));
+
+  return frame;
+}
+
+class UAVTalkFramer : public testing::Test {
+protected:
+  virtual void SetUp() {
+    UAVTalkFramerInit(&framer, buf, sizeof(buf));
+
+    frames.push_back(make_frame(UAVTALK_TYPE_OBJ, 0x12345678, false, 0, 20));
+    frames.push_back(make_frame(UAVTALK_TYPE_OBJ_REQ, 0x0badf00d, false, 0, 0));
+    frames.push_back(make_frame(UAVTALK_TYPE_OBJ_ACK, 0xcafe0001, true, 3, UAVOBJECTS_LARGEST));
+    frames.push_back(make_frame(UAVTALK_TYPE_ACK, 0x12345678, false, 0, 0));
+    frames.push_back(make_frame(UAVTALK_TYPE_OBJ, 0x3c3c3c3c, true, 0x3c3c, 7));
+
+    for (uint32_t i = 0; i < frames.size(); i++)
+      stream.insert(stream.end(), frames[i].begin(), frames[i].end());
+  };
+
+  /* Feed data in reads of chunk bytes, collecting the frames found */
+  std::vector<frame_t> feed(const frame_t &data, uint16_t chunk) {
+    std::vector<frame_t> found;
+
+    for (uint32_t start = 0; start < data.size(); start += chunk) {
+      const uint8_t *p = &data[start];
+      uint16_t len = std::min<uint32_t>(chunk, data.size() - start);
+
+      while (len > 0) {
+        const uint8_t *frame;
+        uint16_t frame_len;
+        uint16_t used = UAVTalkFramerProcess(&framer, p, len, &frame, &frame_len);
+
+        EXPECT_LE(used, len);
+        p += used;
+        len -= used;
+
+        if (frame)
+          found.push_back(frame_t(frame, frame + frame_len));
+        else
+          EXPECT_EQ(0u, len);
+      }
+    }
+
+    return found;
+  }
+
+  struct uavtalk_framer framer;
+  uint8_t buf[UAVTALK_MAX_PACKET_LENGTH];
+  std::vector<frame_t> frames;
+  frame_t stream;
+};
+
+TEST_F(UAVTalkFramer, FrameInPlace) {
+  const uint8_t *frame;
+  uint16_t frame_len;
+
+  /* a frame completely in the read is not copied */
+  EXPECT_EQ(frames[0].size(), UAVTalkFramerProcess(&framer, &frames[0][0], frames[0].size(), &frame, &frame_len));
+  EXPECT_EQ(&frames[0][0], frame);
+  EXPECT_EQ(frames[0].size(), frame_len);
+  EXPECT_EQ(1u, framer.stats.frames);
+  EXPECT_EQ(frames[0].size(), framer.stats.rx_bytes);
+
+  /* the framer stops after a frame and leaves the rest of the read */
+  EXPECT_EQ(frames[0].size(), UAVTalkFramerProcess(&framer, &stream[0], stream.size(), &frame, &frame_len));
+  EXPECT_EQ(&stream[0], frame);
+}
+
+TEST_F(UAVTalkFramer, FramesSplitOverReads) {
+  for (uint16_t chunk = 1; chunk <= stream.size(); chunk++) {
+    std::vector<frame_t> found = feed(stream, chunk);
+
+    ASSERT_EQ(frames.size(), found.size()) << "chunk " << chunk;
+    for (uint32_t i = 0; i < frames.size(); i++)
+      EXPECT_EQ(frames[i], found[i]) << "chunk " << chunk << " frame " << i;
+  }
+
+  EXPECT_EQ(0u, framer.stats.sync_errors);
+  EXPECT_EQ(0u, framer.stats.crc_errors);
+}
+
+TEST_F(UAVTalkFramer, GarbageBetweenFrames) {
+  const uint8_t noise[] = { 0x00, 0xff, UAVTALK_SYNC_VAL, 0x11, UAVTALK_SYNC_VAL, UAVTALK_TYPE_OBJ, 0xff, 0xff, 0x42 };
+  frame_t data(noise, noise + sizeof(noise));
+
+  for (uint32_t i = 0; i < frames.size(); i++) {
+    data.insert(data.end(), frames[i].begin(), frames[i].end());
+    data.insert(data.end(), noise, noise + sizeof(noise));
+  }
+
+  for (uint16_t chunk = 1; chunk <= 64; chunk++) {
+    std::vector<frame_t> found = feed(data, chunk);
+
+    ASSERT_EQ(frames.size(), found.size()) << "chunk " << chunk;
+    for (uint32_t i = 0; i < frames.size(); i++)
+      EXPECT_EQ(frames[i], found[i]) << "chunk " << chunk << " frame " << i;
+  }
+
+  EXPECT_GT(framer.stats.sync_errors, 0u);
+}
+
+TEST_F(UAVTalkFramer, CorruptFrameDropped) {
+  for (uint16_t chunk = 1; chunk <= stream.size(); chunk++) {
+    frame_t data = stream;
+
+    /* corrupt the payload of the first frame */
+    data[10] ^= 0x01;
+
+    UAVTalkFramerInit(&framer, buf, sizeof(buf));
+    std::vector<frame_t> found = feed(data, chunk);
+
+    ASSERT_EQ(frames.size() - 1, found.size()) << "chunk " << chunk;
+    for (uint32_t i = 1; i < frames.size(); i++)
+      EXPECT_EQ(frames[i], found[i - 1]) << "chunk " << chunk << " frame " << i;
+    EXPECT_EQ(1u, framer.stats.crc_errors);
+    EXPECT_EQ(data.size(), framer.stats.rx_bytes);
+  }
+}
+
+TEST_F(UAVTalkFramer, InvalidHeaders) {
+  /* unknown protocol version */
+  frame_t bad_type = make_frame(0x10, 0x12345678, false, 0, 4);
+  EXPECT_EQ(0u, feed(bad_type, bad_type.size()).size());
+  EXPECT_EQ(1u, framer.stats.sync_errors);
+
+  /* larger than any object */
+  frame_t too_long = make_frame(UAVTALK_TYPE_OBJ, 0x12345678, false, 0, UAVTALK_MAX_PACKET_LENGTH);
+  EXPECT_EQ(0u, feed(too_long, 3).size());
+  EXPECT_EQ(2u, framer.stats.sync_errors);
+
+  /* shorter than a header */
+  frame_t too_short = make_frame(UAVTALK_TYPE_OBJ, 0x12345678, false, 0, 0);
+  too_short[2] = UAVTALK_MIN_HEADER_LENGTH - 1;
+  EXPECT_EQ(0u, feed(too_short, too_short.size()).size());
+  EXPECT_EQ(3u, framer.stats.sync_errors);
+
+  /* the framer recovers afterwards */
+  EXPECT_EQ(frames.size(), feed(stream, 13).size());
+}
+
+TEST_F(UAVTalkFramer, Ids) {
+  EXPECT_EQ(0x12345678u, UAVTalkFramerObjId(&frames[0][0]));
+  EXPECT_EQ(0xcafe0001u, UAVTalkFramerObjId(&frames[2][0]));
+  EXPECT_EQ(3u, UAVTalkFramerInstId(&frames[2][0], frames[2].size()));
+  EXPECT_EQ(0x3c3cu, UAVTalkFramerInstId(&frames[4][0], frames[4].size()));
+
+  /* a request without instance field */
+  EXPECT_EQ(0u, UAVTalkFramerInstId(&frames[1][0], frames[1].size()));
+}
+
+/*
+ * Throughput of the framer for typical telemetry read sizes
+ */
+TEST_F(UAVTalkFramer, Benchmark) {
+  frame_t data;
+
+  while (data.size() < 64 * 1024)
+    data.insert(data.end(), stream.begin(), stream.end());
+
+  const uint16_t chunks[] = { 1, 16, 100 };
+  for (uint32_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+    clock_t start = clock();
+    uint32_t frames_found = 0;
+
+    for (int run = 0; run < 20; run++)
+      frames_found += feed(data, chunks[i]).size();
+
+    double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+    printf("reads of %3u bytes: %6.1f MB/s, %u frames\n", chunks[i],
+      20 * data.size() / elapsed / 1e6, frames_found);
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
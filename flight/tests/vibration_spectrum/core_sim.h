@@ -0,0 +1,4 @@
+/* Minimal core header for building the CMSIS DSP library on the host */
+#define __INLINE inline
+#define __STATIC_INLINE static inline
+#define __ASM __asm
@@ -0,0 +1,7 @@
+/* Would be from openpilot.h but that file pulls on way too many dependencies */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+extern void * PIOS_malloc(size_t size);
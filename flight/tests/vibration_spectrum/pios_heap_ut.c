@@ -0,0 +1,7 @@
+#include <stdlib.h>
+#include "openpilot.h"
+
+void * PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
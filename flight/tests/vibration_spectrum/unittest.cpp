@@ -0,0 +1,227 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the spectrum of the vibration analysis
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <math.h>		/* sinf */
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <time.h>		/* clock */
+
+extern "C" {
+
+#include "openpilot.h"
+#include "spectrum.h"
+
+}
+
+#define SAMPLE_RATE 1000.0f
+
+class Spectrum : public testing::Test {
+protected:
+  virtual void SetUp() {
+    sample_count = 0;
+  };
+
+  /* Add the next sample of a tone on each axis */
+  bool add_sample(const float freq[3], const float amplitude[3], float offset) {
+    float sample[3];
+
+    for (int axis = 0; axis < 3; axis++)
+      sample[axis] = offset + amplitude[axis] * sinf(2 * M_PI * freq[axis] * sample_count / SAMPLE_RATE + axis);
+    sample_count++;
+
+    return spectrum_add_sample(&s, sample);
+  }
+
+  /* Feed samples, returns the number of spectra completed */
+  uint32_t feed(uint32_t samples, const float freq[3], const float amplitude[3], float offset) {
+    uint32_t spectra = 0;
+
+    for (uint32_t i = 0; i < samples; i++)
+      if (add_sample(freq, amplitude, offset))
+        spectra++;
+
+    return spectra;
+  }
+
+  /* Feed samples until the next spectrum is complete */
+  void next_spectrum(const float freq[3], const float amplitude[3], float offset) {
+    while (!add_sample(freq, amplitude, offset))
+      ;
+  }
+
+  struct spectrum s;
+  uint32_t sample_count;
+};
+
+TEST_F(Spectrum, UnsupportedSize) {
+  EXPECT_EQ(-1, spectrum_init(&s, 256, 1));
+  EXPECT_EQ(-1, spectrum_init(&s, 100, 1));
+  EXPECT_EQ(0, spectrum_init(&s, 128, 1));
+  EXPECT_EQ(0, spectrum_init(&s, 512, 1));
+}
+
+TEST_F(Spectrum, OnBinTone) {
+  const uint16_t n = 512;
+  const float freq[3] = { 40 * SAMPLE_RATE / n, 100 * SAMPLE_RATE / n, 0 };
+  const float amplitude[3] = { 2.0f, 0.5f, 0 };
+
+  ASSERT_EQ(0, spectrum_init(&s, n, 2));
+  feed(4 * n, freq, amplitude, -9.81f);
+  next_spectrum(freq, amplitude, -9.81f);
+
+  const float *x = spectrum_get(&s, 0);
+  const float *y = spectrum_get(&s, 1);
+  const float *z = spectrum_get(&s, 2);
+
+  /* a tone in the middle of a bin shows its amplitude */
+  EXPECT_NEAR(2.0f, x[40], 0.02f);
+  EXPECT_NEAR(0.5f, y[100], 0.005f);
+
+  /* the Hann window spreads it over the neighbouring bins only */
+  EXPECT_NEAR(1.0f, x[39], 0.01f);
+  EXPECT_NEAR(1.0f, x[41], 0.01f);
+  for (uint16_t k = 0; k < n / 2; k++) {
+    if (k < 39 || k > 41) {
+      EXPECT_LT(x[k], 1e-3f) << "bin " << k;
+    }
+    if (k < 99 || k > 101) {
+      EXPECT_LT(y[k], 1e-3f) << "bin " << k;
+    }
+
+    /* the offset is removed */
+    EXPECT_LT(z[k], 1e-3f) << "bin " << k;
+  }
+}
+
+TEST_F(Spectrum, OffBinTone) {
+  const uint16_t n = 128;
+  const float freq[3] = { 20.5f * SAMPLE_RATE / n, 10.25f * SAMPLE_RATE / n, 0 };
+  const float amplitude[3] = { 1.0f, 1.0f, 0 };
+
+  ASSERT_EQ(0, spectrum_init(&s, n, 4));
+  feed(8 * n, freq, amplitude, 0);
+  next_spectrum(freq, amplitude, 0);
+
+  const float *x = spectrum_get(&s, 0);
+  const float *y = spectrum_get(&s, 1);
+
+  /* the worst case scalloping loss of the Hann window is 1.42 dB */
+  EXPECT_GT(x[20], 0.84f);
+  EXPECT_GT(x[21], 0.84f);
+  EXPECT_LT(x[20], 0.86f);
+  EXPECT_GT(y[10], 0.95f);
+  EXPECT_LT(y[10], 1.0f);
+}
+
+TEST_F(Spectrum, OverlapAndAveraging) {
+  const uint16_t n = 128;
+  const float freq[3] = { 100, 200, 300 };
+  const float amplitude[3] = { 1, 1, 1 };
+
+  ASSERT_EQ(0, spectrum_init(&s, n, 4));
+
+  /* the first frame needs a full history, then one frame every half frame */
+  EXPECT_EQ(0u, feed(n + 3 * n / 2 - 1, freq, amplitude, 0));
+  EXPECT_EQ(1u, feed(1, freq, amplitude, 0));
+  EXPECT_EQ(0u, feed(4 * n / 2 - 1, freq, amplitude, 0));
+  EXPECT_EQ(1u, feed(1, freq, amplitude, 0));
+  EXPECT_EQ(10u, feed(10 * 4 * n / 2, freq, amplitude, 0));
+
+  /* no averaging */
+  ASSERT_EQ(0, spectrum_init(&s, n, 0));
+  EXPECT_EQ(1u + 10u, feed(n + 10 * n / 2, freq, amplitude, 0));
+}
+
+TEST_F(Spectrum, NoiseAveraging) {
+  const uint16_t n = 512;
+  const float sigma = 0.5f;
+  float spread[2];
+
+  const uint16_t averages[2] = { 1, 32 };
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(0, spectrum_init(&s, n, averages[i]));
+    srand(42);
+
+    for (bool done = false; !done; ) {
+      float sample[3];
+      /* uniform noise with standard deviation sigma */
+      for (int axis = 0; axis < 3; axis++)
+        sample[axis] = sigma * sqrtf(12.0f) * ((float) rand() / RAND_MAX - 0.5f);
+      done = spectrum_add_sample(&s, sample);
+    }
+
+    /* mean square amplitude of a bin is 4 sigma^2 sum(w^2) / sum(w)^2 = 6 sigma^2 / n */
+    const float *x = spectrum_get(&s, 0);
+    double mean = 0, var = 0;
+    for (uint16_t k = 1; k < n / 2; k++)
+      mean += x[k] * x[k];
+    mean /= n / 2 - 1;
+    for (uint16_t k = 1; k < n / 2; k++)
+      var += (x[k] * x[k] - mean) * (x[k] * x[k] - mean);
+    spread[i] = sqrt(var / (n / 2 - 2)) / mean;
+
+    EXPECT_NEAR(6 * sigma * sigma / n, mean, 6 * sigma * sigma / n * (i ? 0.1f : 0.3f));
+  }
+
+  /* averaging 32 frames reduces the spread of the estimate */
+  EXPECT_NEAR(1.0f, spread[0], 0.3f);
+  EXPECT_LT(spread[1], spread[0] / 3);
+}
+
+/*
+ * Time spent on the frames of the three axes
+ */
+TEST_F(Spectrum, Benchmark) {
+  const uint16_t sizes[] = { 128, 512 };
+  const float freq[3] = { 100, 200, 300 };
+  const float amplitude[3] = { 1, 1, 1 };
+
+  for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    ASSERT_EQ(0, spectrum_init(&s, sizes[i], 1));
+
+    uint32_t samples = 200 * sizes[i];
+    clock_t start = clock();
+    uint32_t spectra = feed(samples, freq, amplitude, 0);
+    double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("window %4u: %6.1f us per sample, %u spectra\n", sizes[i],
+      elapsed / samples * 1e6, spectra);
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
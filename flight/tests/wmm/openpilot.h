@@ -0,0 +1,13 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+/* C Lib Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,250 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the World Magnetic Model and its cached evaluation
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <math.h>		/* fabsf */
+#include <stdint.h>		/* uint*_t */
+#include <stdbool.h>		/* bool */
+#include <time.h>		/* clock */
+
+extern "C" {
+
+#include "WorldMagModel.h"
+
+}
+
+// Results are in units of 100 nT, see WMM_GetMagVector
+#define NT 1e-2f
+
+class WorldMagModel : public testing::Test {
+protected:
+  virtual void SetUp() {
+    WMM_Initialize();
+  }
+
+  /* magnitude of the difference between two field vectors */
+  float error(const float a[3], const float b[3]) {
+    return sqrtf((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+  }
+};
+
+/* Test values from the WMM2015 technical report */
+TEST_F(WorldMagModel, ReferenceValues) {
+  const struct {
+    float lat, lon, alt;
+    float X, Y, Z;
+  } points[] = {
+    { 80, 0, 0, 6627.1f, -445.9f, 54432.3f },
+    { 0, 120, 0, 39518.2f, 392.9f, -11252.4f },
+    { -80, -120, 0, 5797.3f, 15761.1f, -52919.1f },
+  };
+
+  for (uint32_t i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+    float B[3];
+
+    ASSERT_EQ(0, WMM_GetMagVector(points[i].lat, points[i].lon, points[i].alt, 1, 1, 2015, B));
+
+    /* single precision costs a few nT */
+    EXPECT_NEAR(points[i].X * NT, B[0], 10 * NT);
+    EXPECT_NEAR(points[i].Y * NT, B[1], 10 * NT);
+    EXPECT_NEAR(points[i].Z * NT, B[2], 10 * NT);
+  }
+}
+
+TEST_F(WorldMagModel, InvalidInput) {
+  float B[3] = { 1, 2, 3 };
+  struct wmm_field field;
+
+  EXPECT_EQ(-1, WMM_GetMagVector(-90.5f, 0, 0, 1, 1, 2015, B));
+  EXPECT_EQ(-2, WMM_GetMagVector(90.5f, 0, 0, 1, 1, 2015, B));
+  EXPECT_EQ(-3, WMM_GetMagVector(0, -180.5f, 0, 1, 1, 2015, B));
+  EXPECT_EQ(-4, WMM_GetMagVector(0, 180.5f, 0, 1, 1, 2015, B));
+  EXPECT_EQ(-8, WMM_GetMagVector(0, 0, 0, 13, 1, 2015, B));
+  EXPECT_EQ(-8, WMM_GetMagVector(0, 0, 0, 2, 29, 2015, B));
+
+  /* the output is left alone on errors */
+  EXPECT_EQ(1, B[0]);
+  EXPECT_EQ(2, B[1]);
+  EXPECT_EQ(3, B[2]);
+
+  EXPECT_EQ(-2, WMM_GetMagField(90.5f, 0, 0, 1, 1, 2015, &field));
+  EXPECT_EQ(-8, WMM_GetMagField(0, 0, 0, 0, 1, 2015, &field));
+
+  EXPECT_EQ(-3, WMM_GetMagVectorCached(0, -180.5f, 0, 1, 1, 2015, B));
+  EXPECT_EQ(0, WMM_GetMagVectorCached(0, 0, 0, 1, 1, 2015, B));
+  EXPECT_EQ(-8, WMM_GetMagVectorCached(0, 0, 0, 2, 30, 2016, B));
+}
+
+TEST_F(WorldMagModel, FieldMatchesVector) {
+  float B[3];
+  struct wmm_field field;
+
+  ASSERT_EQ(0, WMM_GetMagVector(47.3f, 8.5f, 500, 10, 18, 2016, B));
+  ASSERT_EQ(0, WMM_GetMagField(47.3f, 8.5f, 500, 10, 18, 2016, &field));
+
+  for (int i = 0; i < 3; i++)
+    EXPECT_EQ(B[i], field.B[i]);
+
+  EXPECT_EQ(47.3f, field.lat);
+  EXPECT_EQ(8.5f, field.lon);
+  EXPECT_EQ(500, field.alt);
+  EXPECT_NEAR(2016.79f, field.year, 0.01f);
+}
+
+/* The model is linear in time so the secular variation extrapolates exactly */
+TEST_F(WorldMagModel, SecularVariation) {
+  float B[3], extrapolated[3];
+  struct wmm_field field;
+
+  ASSERT_EQ(0, WMM_GetMagField(-33.9f, 151.2f, 50, 1, 1, 2015, &field));
+  ASSERT_EQ(0, WMM_GetMagVector(-33.9f, 151.2f, 50, 1, 1, 2019, B));
+
+  WMM_FieldExtrapolate(&field, -33.9f, 151.2f, 50, 4, extrapolated);
+  EXPECT_LT(error(B, extrapolated), 1 * NT);
+
+  /* and so does the cached path */
+  ASSERT_EQ(0, WMM_GetMagVectorCached(-33.9f, 151.2f, 50, 1, 1, 2015, extrapolated));
+  ASSERT_EQ(0, WMM_GetMagVectorCached(-33.9f, 151.2f, 50, 1, 1, 2019, extrapolated));
+  EXPECT_LT(error(B, extrapolated), 1 * NT);
+}
+
+/* First order extrapolation against full evaluations inside the cache radius */
+TEST_F(WorldMagModel, ExtrapolationAccuracy) {
+  const float anchors[][3] = {
+    { 47.3f, 8.5f, 500 },
+    { -33.9f, 151.2f, 50 },
+    { 65, -20, 0 },
+    { 0, 120, 3000 },
+    { 85, 60, 0 },
+    { -70, 140, 2000 },
+  };
+  float worst = 0;
+
+  for (uint32_t i = 0; i < sizeof(anchors) / sizeof(anchors[0]); i++) {
+    struct wmm_field field;
+    ASSERT_EQ(0, WMM_GetMagField(anchors[i][0], anchors[i][1], anchors[i][2], 6, 1, 2016, &field));
+
+    for (float dlat = -0.5f; dlat <= 0.5f; dlat += 0.25f) {
+      for (float dlon = -0.5f; dlon <= 0.5f; dlon += 0.25f) {
+        for (float dalt = -5000; dalt <= 5000; dalt += 2500) {
+          float lat = anchors[i][0] + dlat, lon = anchors[i][1] + dlon, alt = anchors[i][2] + dalt;
+          float B[3], extrapolated[3];
+
+          ASSERT_TRUE(WMM_FieldValid(&field, lat, lon, alt));
+          ASSERT_EQ(0, WMM_GetMagVector(lat, lon, alt, 6, 1, 2016, B));
+          WMM_FieldExtrapolate(&field, lat, lon, alt, 0, extrapolated);
+
+          float err = error(B, extrapolated);
+          if (err > worst)
+            worst = err;
+        }
+      }
+    }
+  }
+
+  printf("worst extrapolation error %.1f nT\n", worst / NT);
+  EXPECT_LT(worst, 20 * NT);
+}
+
+TEST_F(WorldMagModel, CacheValidity) {
+  struct wmm_field field;
+
+  ASSERT_EQ(0, WMM_GetMagField(10, 179.9f, 1000, 1, 1, 2016, &field));
+
+  EXPECT_TRUE(WMM_FieldValid(&field, 10, 179.9f, 1000));
+  EXPECT_TRUE(WMM_FieldValid(&field, 10.4f, 179.5f, 5000));
+  EXPECT_FALSE(WMM_FieldValid(&field, 10.6f, 179.9f, 1000));
+  EXPECT_FALSE(WMM_FieldValid(&field, 10, 179.3f, 1000));
+  EXPECT_FALSE(WMM_FieldValid(&field, 10, 179.9f, 7000));
+
+  /* across the date line */
+  EXPECT_TRUE(WMM_FieldValid(&field, 10, -179.8f, 1000));
+  EXPECT_FALSE(WMM_FieldValid(&field, 10, -179.3f, 1000));
+}
+
+TEST_F(WorldMagModel, CachedMatchesFull) {
+  float B[3], cached[3];
+
+  /* a fresh evaluation is exact */
+  ASSERT_EQ(0, WMM_GetMagVectorCached(12, 179.9f, 3000, 3, 3, 2017, cached));
+  ASSERT_EQ(0, WMM_GetMagVector(12, 179.9f, 3000, 3, 3, 2017, B));
+  for (int i = 0; i < 3; i++)
+    EXPECT_EQ(B[i], cached[i]);
+
+  /* an extrapolated one across the date line is close */
+  ASSERT_EQ(0, WMM_GetMagVectorCached(12.2f, -179.8f, 3500, 3, 3, 2017, cached));
+  ASSERT_EQ(0, WMM_GetMagVector(12.2f, -179.8f, 3500, 3, 3, 2017, B));
+  EXPECT_LT(error(B, cached), 10 * NT);
+
+  /* leaving the radius evaluates the model again */
+  ASSERT_EQ(0, WMM_GetMagVectorCached(-45, 20, 0, 3, 3, 2017, cached));
+  ASSERT_EQ(0, WMM_GetMagVector(-45, 20, 0, 3, 3, 2017, B));
+  for (int i = 0; i < 3; i++)
+    EXPECT_EQ(B[i], cached[i]);
+}
+
+/*
+ * Evaluations per second of the full model and of the cached model along a
+ * track which moves ~100 m between calls
+ */
+TEST_F(WorldMagModel, Benchmark) {
+  const int runs = 2000;
+  float B[3], sum = 0;
+  clock_t start;
+
+  start = clock();
+  for (int i = 0; i < runs; i++) {
+    WMM_GetMagVector(47 + i * 1e-3f, 8 + i * 1e-3f, 500, 6, 1, 2016, B);
+    sum += B[2];
+  }
+  double full_time = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  for (int i = 0; i < runs; i++) {
+    WMM_GetMagVectorCached(47 + i * 1e-3f, 8 + i * 1e-3f, 500, 6, 1, 2016, B);
+    sum -= B[2];
+  }
+  double cached_time = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+  printf("full %8.0f calls/s, cached %8.0f calls/s\n", runs / full_time, runs / cached_time);
+
+  /* the track is 2 degrees long, so both agree closely on average */
+  EXPECT_LT(fabsf(sum / runs), 10 * NT);
+}
+
+/**
+ * @}
+ * @}
+ */
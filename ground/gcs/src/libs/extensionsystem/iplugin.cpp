@@ -195,7 +195,10 @@
     found, the plugin loading is done in three phases:
     \list 1
     \o All plugin libraries are loaded in 'root-to-leaf' order of the
-       dependency tree.
+       dependency tree. The libraries themselves are opened on worker
+       threads, all libraries of one level of the tree at once, see
+       \l {Static Initialization}{Static Initialization}. The IPlugin
+       instances are then created on the main thread.
     \o All plugins' initialize methods are called in 'root-to-leaf' order
        of the dependency tree. This is a good place to put
        objects in the plugin manager's object pool.
@@ -212,6 +215,19 @@
     Plugins have access to the plugin manager
     (and its object pool) via the PluginManager::instance()
     method.
+
+    \section2 Static Initialization
+    A plugin library, and any library it links that is not loaded yet, is
+    opened on a worker thread of the global thread pool. The constructors of
+    its static and global objects therefore run on that thread, concurrently
+    with other plugin libraries and before any plugin is initialized. They
+    must not create QObjects, which would belong to the worker thread, nor
+    widgets, pixmaps, icons, fonts or anything else that needs the GUI
+    thread, and must not depend on other plugins. Plain values such as
+    strings, colors and null pointers are fine. Create anything else in
+    initialize(), or in a function local static that is first used on the
+    main thread. Q_GLOBAL_STATIC objects are created on first use too, and
+    have the same restriction on where that first use is.
 */
 
 /*!
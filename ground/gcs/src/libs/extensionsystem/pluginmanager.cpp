@@ -37,10 +37,12 @@
 
 #include <QtCore/QMetaProperty>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QTextStream>
 #include <QtCore/QWriteLocker>
 #include <QtDebug>
 #include <QMetaMethod>
+#include <QtConcurrent/QtConcurrentMap>
 
 #ifdef WITH_TESTS
 #include <QTest>
@@ -383,6 +385,9 @@ void PluginManager::formatOptions(QTextStream &str, int optionIndentation, int d
     formatOption(str, QLatin1String(OptionsParser::NO_LOAD_OPTION),
                  QLatin1String("plugin"), QLatin1String("Do not load <plugin>"),
                  optionIndentation, descriptionIndentation);
+    formatOption(str, QLatin1String(OptionsParser::PROFILE_OPTION),
+                 QString(), QLatin1String("Report the load and initialization time of each plugin"),
+                 optionIndentation, descriptionIndentation);
 }
 
 /*!
@@ -451,6 +456,18 @@ bool PluginManager::runningTests() const
     return !d->testSpecs.isEmpty();
 }
 
+/*!
+    \fn void PluginManager::profilingReport(const QString &what, qint64 elapsed) const
+    Prints that \a what took \a elapsed microseconds when the application
+    was started with -profile. Plugins use it for the work they defer until
+    after startup, such as creating the first gadget of a kind.
+*/
+void PluginManager::profilingReport(const QString &what, qint64 elapsed) const
+{
+    if (d->profiling)
+        qDebug("%s: %.1f ms", qPrintable(what), elapsed / 1000.0);
+}
+
 /*!
  * \fn QString PluginManager::testDataDirectory() const
  * \internal
@@ -492,7 +509,7 @@ PluginSpecPrivate *PluginManagerPrivate::privateSpec(PluginSpec *spec)
     \internal
 */
 PluginManagerPrivate::PluginManagerPrivate(PluginManager *pluginManager)
-    : extension("xml"), q(pluginManager)
+    : extension("xml"), profiling(false), q(pluginManager)
 {
 }
 
@@ -578,25 +595,151 @@ void PluginManagerPrivate::removeObject(QObject *obj)
 void PluginManagerPrivate::loadPlugins()
 {
     QList<PluginSpec *> queue = loadQueue();
+    profileTimer.start();
+
+    emit q->splashMessages(QObject::tr("Loading plugin libraries"));
+    openLibraries(queue);
+    profilingPhase(QLatin1String("Opening libraries"));
+
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Loading %1 plugin")).arg(spec->name()));
         loadPlugin(spec, PluginSpec::Loaded);
         if(spec->name() == "Core")
             QObject::connect(spec->plugin(),SIGNAL(splashMessages(QString)),q,SIGNAL(splashMessages(QString)));
     }
+    profilingPhase(QLatin1String("Creating plugins"));
 
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Initializing %1 plugin")).arg(spec->name()));
         loadPlugin(spec, PluginSpec::Initialized);
     }
+    profilingPhase(QLatin1String("Initializing plugins"));
+
     QListIterator<PluginSpec *> it(queue);
     it.toBack();
     while (it.hasPrevious()) {
         loadPlugin(it.previous(), PluginSpec::Running);
     }
+    profilingPhase(QLatin1String("Initializing extensions"));
+
     emit q->pluginsChanged();
     q->m_allPluginsLoaded=true;
     emit q->pluginsLoadEnded();
+    profilingPhase(QLatin1String("Plugins loaded handlers"));
+
+    profilingSummary();
+}
+
+/*!
+    \fn QList<QList<PluginSpec *> > PluginManagerPrivate::loadLevels(const QList<PluginSpec *> &queue)
+    \internal
+
+    Splits the load queue into levels. Every plugin is one level after the
+    deepest of its dependencies, so the plugins of a level only depend on
+    plugins of the levels before it.
+*/
+QList<QList<PluginSpec *> > PluginManagerPrivate::loadLevels(const QList<PluginSpec *> &queue)
+{
+    QList<QList<PluginSpec *> > levels;
+    QHash<PluginSpec *, int> levelOf;
+    foreach (PluginSpec *spec, queue) {
+        int level = 0;
+        foreach (PluginSpec *depSpec, spec->dependencySpecs())
+            level = qMax(level, levelOf.value(depSpec, -1) + 1);
+        levelOf.insert(spec, level);
+        // The queue has the dependencies before the plugin, so this is at
+        // most one level after the last one
+        if (level == levels.size())
+            levels.append(QList<PluginSpec *>());
+        levels[level].append(spec);
+    }
+    return levels;
+}
+
+static qint64 openLibrary(PluginSpec *spec)
+{
+    QElapsedTimer timer;
+    timer.start();
+    PluginManagerPrivate::privateSpec(spec)->openLibrary();
+    return timer.nsecsElapsed() / 1000;
+}
+
+/*!
+    \fn void PluginManagerPrivate::openLibraries(const QList<PluginSpec *> &queue)
+    \internal
+
+    Reads the libraries of all plugins on the global thread pool, one
+    dependency level after the other. The plugin instances are still created
+    and initialized in queue order on the main thread by loadPlugin(), as
+    they are QObjects that belong to it.
+*/
+void PluginManagerPrivate::openLibraries(const QList<PluginSpec *> &queue)
+{
+    foreach (const QList<PluginSpec *> &level, loadLevels(queue)) {
+        QList<PluginSpec *> open;
+        foreach (PluginSpec *spec, level) {
+            bool dependenciesOpen = !spec->hasError();
+            foreach (PluginSpec *depSpec, spec->dependencySpecs())
+                dependenciesOpen = dependenciesOpen && !depSpec->hasError();
+            // loadPlugin() reports the failed dependency
+            if (dependenciesOpen)
+                open.append(spec);
+        }
+
+        QList<qint64> times = QtConcurrent::blockingMapped<QList<qint64> >(open, openLibrary);
+        for (int i = 0; i < open.size(); ++i)
+            pluginTimes[open.at(i)].open = times.at(i);
+    }
+}
+
+/*!
+    \fn void PluginManagerPrivate::profilingPhase(const QString &what)
+    \internal
+*/
+void PluginManagerPrivate::profilingPhase(const QString &what)
+{
+    phaseTimes.append(qMakePair(what, profileTimer.nsecsElapsed() / 1000));
+    profileTimer.restart();
+}
+
+static bool slowerOnMainThread(const QPair<PluginSpec *, qint64> &a, const QPair<PluginSpec *, qint64> &b)
+{
+    return a.second > b.second;
+}
+
+/*!
+    \fn void PluginManagerPrivate::profilingSummary() const
+    \internal
+
+    Prints the time each plugin took to load and initialize, the slowest on
+    the main thread first, and the time of each startup phase.
+*/
+void PluginManagerPrivate::profilingSummary() const
+{
+    if (!profiling)
+        return;
+
+    QList<QPair<PluginSpec *, qint64> > specs;
+    for (QHash<PluginSpec *, PluginTimes>::const_iterator it = pluginTimes.constBegin();
+         it != pluginTimes.constEnd(); ++it)
+        specs.append(qMakePair(it.key(), it->load + it->initialize + it->extensions));
+    qStableSort(specs.begin(), specs.end(), slowerOnMainThread);
+
+    qDebug("Plugin startup profile [ms], open runs in parallel, the rest on the main thread:");
+    qDebug("  %-24s %8s %8s %8s %8s %8s", "plugin", "open", "create", "init", "ext", "main");
+    for (int i = 0; i < specs.size(); ++i) {
+        const PluginTimes &times = pluginTimes[specs.at(i).first];
+        qDebug("  %-24s %8.1f %8.1f %8.1f %8.1f %8.1f", qPrintable(specs.at(i).first->name()),
+               times.open / 1000.0, times.load / 1000.0, times.initialize / 1000.0,
+               times.extensions / 1000.0, specs.at(i).second / 1000.0);
+    }
+
+    qint64 total = 0;
+    for (int i = 0; i < phaseTimes.size(); ++i) {
+        qDebug("  %-24s %8.1f", qPrintable(phaseTimes.at(i).first), phaseTimes.at(i).second / 1000.0);
+        total += phaseTimes.at(i).second;
+    }
+    qDebug("  %-24s %8.1f", "Total", total / 1000.0);
 }
 
 /*!
@@ -666,7 +809,10 @@ void PluginManagerPrivate::loadPlugin(PluginSpec *spec, PluginSpec::State destSt
     if (spec->hasError())
         return;
     if (destState == PluginSpec::Running) {
+        QElapsedTimer timer;
+        timer.start();
         spec->d->initializeExtensions();
+        pluginTimes[spec].extensions = timer.nsecsElapsed() / 1000;
         return;
     } else if (destState == PluginSpec::Deleted) {
         spec->d->kill();
@@ -681,11 +827,15 @@ void PluginManagerPrivate::loadPlugin(PluginSpec *spec, PluginSpec::State destSt
             return;
         }
     }
-    if (destState == PluginSpec::Loaded)
+    QElapsedTimer timer;
+    timer.start();
+    if (destState == PluginSpec::Loaded) {
         spec->d->loadLibrary();
-    else if (destState == PluginSpec::Initialized)
+        pluginTimes[spec].load = timer.nsecsElapsed() / 1000;
+    } else if (destState == PluginSpec::Initialized) {
         spec->d->initializePlugin();
-    else if (destState == PluginSpec::Stopped)
+        pluginTimes[spec].initialize = timer.nsecsElapsed() / 1000;
+    } else if (destState == PluginSpec::Stopped)
         spec->d->stop();
 }
 
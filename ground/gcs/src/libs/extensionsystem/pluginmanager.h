@@ -112,6 +112,8 @@ public:
     bool runningTests() const;
     QString testDataDirectory() const;
 
+    void profilingReport(const QString &what, qint64 elapsed) const;
+
 signals:
     void objectAdded(QObject *obj);
     void aboutToRemoveObject(QObject *obj);
@@ -31,10 +31,13 @@
 
 #include "pluginspec.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QSet>
 #include <QtCore/QStringList>
 #include <QtCore/QObject>
+#include <QtCore/QPair>
 
 namespace ExtensionSystem {
 
@@ -58,6 +61,8 @@ public:
     void loadPlugins();
     void setPluginPaths(const QStringList &paths);
     QList<PluginSpec *> loadQueue();
+    QList<QList<PluginSpec *> > loadLevels(const QList<PluginSpec *> &queue);
+    void openLibraries(const QList<PluginSpec *> &queue);
     void loadPlugin(PluginSpec *spec, PluginSpec::State destState);
     void resolveDependencies();
 
@@ -69,6 +74,21 @@ public:
 
     QStringList arguments;
 
+    // Startup profile, reported with -profile
+    struct PluginTimes {
+        PluginTimes() : open(0), load(0), initialize(0), extensions(0) {}
+        qint64 open;        // reading the library, in a worker thread
+        qint64 load;        // creating the plugin instance
+        qint64 initialize;  // IPlugin::initialize()
+        qint64 extensions;  // IPlugin::extensionsInitialized()
+    };
+    bool profiling;
+    QElapsedTimer profileTimer;
+    QHash<PluginSpec *, PluginTimes> pluginTimes;
+    QList<QPair<QString, qint64> > phaseTimes;
+    void profilingPhase(const QString &what);
+    void profilingSummary() const;
+
     // Look in argument descriptions of the specs for the option.
     PluginSpec *pluginForOption(const QString &option, bool *requiresArgument) const;
     PluginSpec *pluginByName(const QString &name) const;
@@ -747,41 +747,75 @@ bool PluginSpecPrivate::resolveDependencies(const QList<PluginSpec *> &specs)
 }
 
 /*!
-    \fn bool PluginSpecPrivate::loadLibrary()
+    \fn QString PluginSpecPrivate::libraryName() const
     \internal
 */
-bool PluginSpecPrivate::loadLibrary()
+QString PluginSpecPrivate::libraryName() const
 {
-    if (hasError)
-        return false;
-    if (state != PluginSpec::Resolved) {
-        if (state == PluginSpec::Loaded)
-            return true;
-        errorString = QCoreApplication::translate("PluginSpec", "Loading the library failed because state != Resolved");
-        hasError = true;
-        return false;
-    }
 #ifdef QT_NO_DEBUG
 
 #ifdef Q_OS_WIN
-    QString libName = QString("%1/%2.dll").arg(location).arg(name);
+    return QString("%1/%2.dll").arg(location).arg(name);
 #elif defined(Q_OS_MAC)
-    QString libName = QString("%1/lib%2.dylib").arg(location).arg(name);
+    return QString("%1/lib%2.dylib").arg(location).arg(name);
 #else
-    QString libName = QString("%1/lib%2.so").arg(location).arg(name);
+    return QString("%1/lib%2.so").arg(location).arg(name);
 #endif
 
 #else //Q_NO_DEBUG
 
 #ifdef Q_OS_WIN
-    QString libName = QString("%1/%2d.dll").arg(location).arg(name);
+    return QString("%1/%2d.dll").arg(location).arg(name);
 #elif defined(Q_OS_MAC)
-    QString libName = QString("%1/lib%2_debug.dylib").arg(location).arg(name);
+    return QString("%1/lib%2_debug.dylib").arg(location).arg(name);
 #else
-    QString libName = QString("%1/lib%2.so").arg(location).arg(name);
+    return QString("%1/lib%2.so").arg(location).arg(name);
 #endif
 
 #endif
+}
+
+/*!
+    \fn bool PluginSpecPrivate::openLibrary()
+    \internal
+
+    Reads and maps the library of the plugin without creating the plugin
+    instance. Only touches this spec, so the plugin manager calls it from
+    worker threads for all plugins whose dependencies are already open. The
+    static constructors of the library run on that thread, see the Static
+    Initialization section of IPlugin. The shared library stays loaded,
+    loadLibrary() then finds it in memory.
+*/
+bool PluginSpecPrivate::openLibrary()
+{
+    if (hasError || state != PluginSpec::Resolved)
+        return false;
+    QString libName = libraryName();
+    PluginLoader loader(libName);
+    if (!loader.load()) {
+        hasError = true;
+        errorString = libName + QString::fromLatin1(": ") + loader.errorString();
+        return false;
+    }
+    return true;
+}
+
+/*!
+    \fn bool PluginSpecPrivate::loadLibrary()
+    \internal
+*/
+bool PluginSpecPrivate::loadLibrary()
+{
+    if (hasError)
+        return false;
+    if (state != PluginSpec::Resolved) {
+        if (state == PluginSpec::Loaded)
+            return true;
+        errorString = QCoreApplication::translate("PluginSpec", "Loading the library failed because state != Resolved");
+        hasError = true;
+        return false;
+    }
+    QString libName = libraryName();
 
     PluginLoader loader(libName);
     if (!loader.load()) {
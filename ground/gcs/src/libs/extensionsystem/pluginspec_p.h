@@ -52,6 +52,8 @@ public:
     bool read(const QString &fileName);
     bool provides(const QString &pluginName, const QString &version) const;
     bool resolveDependencies(const QList<PluginSpec *> &specs);
+    QString libraryName() const;
+    bool openLibrary();
     bool loadLibrary();
     bool initializePlugin();
     bool initializeExtensions();
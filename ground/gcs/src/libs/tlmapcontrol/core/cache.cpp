@@ -46,6 +46,11 @@ namespace core {
         geoCache = cache + "GeocoderCache"+ QDir::separator();
         placemarkCache = cache + "PlacemarkCache" + QDir::separator();
         ImageCache.setGtileCache(value);
+
+        // Tile packages dropped in the cache directory are used automatically
+        QDir dir(cache);
+        foreach(QString file,dir.entryList(QStringList()<<"*.tlpack",QDir::Files,QDir::Name))
+            AddTilePack(dir.absoluteFilePath(file));
     }
     QString Cache::CacheLocation()
     {
@@ -59,6 +64,49 @@ namespace core {
             setCacheLocation(cache);
         }
     }
+    /**
+    * @brief Adds a tile package, its tiles are used before the tiles in the
+    *        database. Adding a package a second time does nothing.
+    *
+    * @return false if the package could not be opened
+    */
+    bool Cache::AddTilePack(const QString &file)
+    {
+        QString path=QFileInfo(file).absoluteFilePath();
+        QWriteLocker locker(&tilePacksLock);
+        foreach(TilePack *pack,tilePacks)
+        {
+            if(pack->FileName()==path)
+                return true;
+        }
+        TilePack *pack=new TilePack;
+        if(!pack->Open(path))
+        {
+            delete pack;
+            return false;
+        }
+        tilePacks.append(pack);
+        return true;
+    }
+    QStringList Cache::TilePacks()
+    {
+        QReadLocker locker(&tilePacksLock);
+        QStringList files;
+        foreach(TilePack *pack,tilePacks)
+            files.append(pack->FileName());
+        return files;
+    }
+    QByteArray Cache::GetImageFromTilePacks(const MapType::Types &type,const core::Point &pos,const int &zoom)
+    {
+        QReadLocker locker(&tilePacksLock);
+        foreach(TilePack *pack,tilePacks)
+        {
+            QByteArray img=pack->GetImage(type,pos,zoom);
+            if(!img.isEmpty())
+                return img;
+        }
+        return QByteArray();
+    }
     QString Cache::GetGeocoderFromCache(const QString &urlEnd)
     {
 #ifdef DEBUG_GetGeocoderFromCache
@@ -29,6 +29,7 @@
 #define CACHE_H
 
 #include "pureimagecache.h"
+#include "tilepack.h"
 #include "debugheader.h"
 #include "corecommon.h"
 
@@ -48,6 +49,9 @@ namespace core {
         QString GetPlacemarkFromCache(const QString &urlEnd);
         void CacheRoute(const QString &urlEnd,const QString &content);
         QString GetRouteFromCache(const QString &urlEnd);
+        bool AddTilePack(const QString &file);
+        QStringList TilePacks();
+        QByteArray GetImageFromTilePacks(const MapType::Types &type,const core::Point &pos,const int &zoom);
 
     private:
         Cache();
@@ -58,6 +62,12 @@ namespace core {
         QString routeCache;
         QString geoCache;
         QString placemarkCache;
+        /**
+        * @brief The tile packages in use. Images from a package point into
+        *        its mapping, so packages are never closed once opened.
+        */
+        QList<TilePack*> tilePacks;
+        QReadWriteLock tilePacksLock;
     };
 
 }
@@ -0,0 +1,97 @@
+/**
+******************************************************************************
+*
+* @file       pixmapcache.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Least recently used cache of decoded tile images
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "pixmapcache.h"
+#include "pureimage.h"
+
+namespace core {
+    PixmapCache::PixmapCache():capacity(64*1048576),size(0)
+    {
+
+    }
+
+    /**
+    * @brief Returns the decoded image of a tile, decoding it if it is not
+    *        cached yet
+    *
+    * @param tile the tile the image belongs to
+    * @param img the encoded image of the tile
+    */
+    QPixmap PixmapCache::Pixmap(const RawTile &tile, const QByteArray &img)
+    {
+        QHash<RawTile, Entry>::iterator it=entries.find(tile);
+        if(it!=entries.end())
+        {
+            // The entry holds a reference to the data it was decoded from,
+            // so the same data pointer means the tile still has that image
+            if(it->img.constData()==img.constData())
+            {
+                uses.splice(uses.begin(),uses,it->use);
+                return it->pixmap;
+            }
+            size-=it->bytes;
+            uses.erase(it->use);
+            entries.erase(it);
+        }
+
+        Entry entry;
+        entry.img=img;
+        entry.pixmap=PureImageProxy::FromStream(img);
+        entry.bytes=img.size()+(qint64)entry.pixmap.width()*entry.pixmap.height()*entry.pixmap.depth()/8;
+        entry.use=uses.insert(uses.begin(),tile);
+        entries.insert(tile,entry);
+        size+=entry.bytes;
+
+        QPixmap pixmap=entry.pixmap;
+        RemoveOverload();
+        return pixmap;
+    }
+
+    void PixmapCache::setCapacity(const qint64 &bytes)
+    {
+        capacity=bytes;
+        RemoveOverload();
+    }
+
+    void PixmapCache::Clear()
+    {
+        entries.clear();
+        uses.clear();
+        size=0;
+    }
+
+    void PixmapCache::RemoveOverload()
+    {
+        // The tile just drawn always stays
+        while(size>capacity && uses.size()>1)
+        {
+            QHash<RawTile, Entry>::iterator it=entries.find(uses.back());
+            size-=it->bytes;
+            entries.erase(it);
+            uses.pop_back();
+        }
+    }
+}
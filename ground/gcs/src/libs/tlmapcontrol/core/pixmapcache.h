@@ -0,0 +1,68 @@
+/**
+******************************************************************************
+*
+* @file       pixmapcache.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Least recently used cache of decoded tile images
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef PIXMAPCACHE_H
+#define PIXMAPCACHE_H
+
+#include "rawtile.h"
+#include <QByteArray>
+#include <QHash>
+#include <QPixmap>
+#include <list>
+
+namespace core {
+    /**
+    * @brief Keeps the decoded pixmaps of the tiles last drawn, so repainting
+    *        does not decode the PNG or JPEG data of a tile again.
+    *
+    * An entry is only used while it was decoded from the very same data the
+    * tile holds, a tile that got reloaded is decoded again. Pixmaps can only
+    * be used in the GUI thread, and so can this cache.
+    */
+    class PixmapCache
+    {
+    public:
+        PixmapCache();
+        QPixmap Pixmap(const RawTile &tile, const QByteArray &img);
+        void setCapacity(const qint64 &bytes);
+        qint64 Capacity()const{return capacity;}
+        qint64 Size()const{return size;}
+        void Clear();
+    private:
+        struct Entry {
+            QByteArray img;
+            QPixmap pixmap;
+            qint64 bytes;
+            std::list<RawTile>::iterator use;
+        };
+        void RemoveOverload();
+        QHash<RawTile, Entry> entries;
+        std::list<RawTile> uses;
+        qint64 capacity;
+        qint64 size;
+    };
+}
+#endif // PIXMAPCACHE_H
@@ -32,11 +32,90 @@
 namespace core {
     qlonglong PureImageCache::ConnCounter=0;
 
+    /**
+    * @brief A connection to the cache database that stays open for the
+    *        lifetime of the thread using it, with its statements prepared once
+    */
+    class PureImageCache::Connection
+    {
+    public:
+        Connection(const QString &file,qlonglong id);
+        ~Connection();
+        QString file;
+        QString name;
+        QSqlDatabase db;
+        QSqlQuery select;
+        QSqlQuery insertTile;
+        QSqlQuery insertData;
+    };
+
+    PureImageCache::Connection::Connection(const QString &file,qlonglong id):file(file),name(QString::number(id))
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE",name);
+        db.setDatabaseName(file);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=1000");
+        if(db.open())
+        {
+            // Databases created by older versions lack the index for the tile lookup
+            QSqlQuery(db).exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+
+            select=QSqlQuery(db);
+            select.setForwardOnly(true);
+            select.prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+            insertTile=QSqlQuery(db);
+            insertTile.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+            insertData=QSqlQuery(db);
+            insertData.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
+        }
+    }
+
+    PureImageCache::Connection::~Connection()
+    {
+        // The queries and the database handle have to be gone before the
+        // connection can be removed
+        select=QSqlQuery();
+        insertTile=QSqlQuery();
+        insertData=QSqlQuery();
+        db.close();
+        db=QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+
     PureImageCache::PureImageCache()
     {
 
     }
 
+    /**
+    * @brief Returns the connection of the calling thread, opening it the first
+    *        time or when the cache moved. The read lock has to be held.
+    *
+    * @return the connection or 0 if the database could not be opened
+    */
+    PureImageCache::Connection *PureImageCache::connection()
+    {
+        QString file=gtilecache+"Data.qmdb";
+        Connection *cn=connections.localData();
+        if(cn && cn->file==file)
+            return cn;
+
+        Mcounter.lock();
+        qlonglong id=++ConnCounter;
+        Mcounter.unlock();
+        // Replacing the local data deletes a connection to an old location
+        cn=new Connection(file,id);
+        if(!cn->db.isOpen())
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Unable to open cache database "<<file<<cn->db.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+            delete cn;
+            cn=0;
+        }
+        connections.setLocalData(cn);
+        return cn;
+    }
+
     void PureImageCache::setGtileCache(const QString &value)
     {
         lock.lockForWrite();
@@ -174,86 +253,84 @@ namespace core {
     }
     bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
     {
-        if(gtilecache.isEmpty()|gtilecache.isNull())
-            return false;
+        CacheItemQueue task(type,pos,tile,zoom);
+        QList<CacheItemQueue*> tiles;
+        tiles.append(&task);
+        return PutImagesToCache(tiles);
+    }
+    /**
+    * @brief Writes a batch of tiles in a single transaction
+    */
+    bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue*> &tiles)
+    {
         lock.lockForRead();
+        if(gtilecache.isEmpty())
+        {
+            lock.unlock();
+            return false;
+        }
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"PutImageToCache Start:";//<<pos;
+        qDebug()<<"PutImagesToCache Start:"<<tiles.count();
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        Connection *cn=connection();
+        bool ret=(cn!=0) && cn->db.transaction();
+        if(ret)
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
+            foreach(CacheItemQueue *task,tiles)
             {
+                cn->insertTile.bindValue(0,task->GetPosition().X());
+                cn->insertTile.bindValue(1,task->GetPosition().Y());
+                cn->insertTile.bindValue(2,task->GetZoom());
+                cn->insertTile.bindValue(3,(int)task->GetMapType());
+                cn->insertTile.bindValue(4,QDateTime::currentDateTime().toString());
+                if(!cn->insertTile.exec())
                 {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
+                    ret=false;
+                    break;
                 }
+                cn->insertData.bindValue(0,task->GetImg());
+                if(!cn->insertData.exec())
                 {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
+                    ret=false;
+                    break;
                 }
-                cn.close();
+            }
+            if(ret)
+                ret=cn->db.commit();
+            if(!ret)
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"PutImagesToCache: "<<cn->db.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                cn->db.rollback();
             }
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
-        return true;
+        return ret;
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
-        lock.lockForRead();
         QByteArray ar;
-        if(gtilecache.isEmpty()|gtilecache.isNull())
+        lock.lockForRead();
+        if(gtilecache.isEmpty())
+        {
+            lock.unlock();
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        }
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()<<","<<pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
+        Connection *cn=connection();
+        if(cn)
         {
-            QString db=dir+"Data.qmdb";
-            {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
-            }
+            cn->select.bindValue(0,pos.X());
+            cn->select.bindValue(1,pos.Y());
+            cn->select.bindValue(2,zoom);
+            cn->select.bindValue(3,(int)type);
+            if(cn->select.exec() && cn->select.next())
+                ar=cn->select.value(0).toByteArray();
+            cn->select.finish();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
         return ar;
     }
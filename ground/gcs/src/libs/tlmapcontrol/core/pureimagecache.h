@@ -43,6 +43,8 @@
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
+#include "cacheitemqueue.h"
 namespace core {
     class PureImageCache
     {
@@ -51,16 +53,24 @@ namespace core {
         PureImageCache();
         static bool CreateEmptyDB(const QString &file);
         bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
+        bool PutImagesToCache(const QList<CacheItemQueue*> &tiles);
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        class Connection;
+        Connection *connection();
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
         static qlonglong ConnCounter;
+        /**
+        * @brief The connection of each thread using the cache, a QSqlDatabase
+        *        may only be used by the thread that created it
+        */
+        QThreadStorage<Connection*> connections;
 
     };
 
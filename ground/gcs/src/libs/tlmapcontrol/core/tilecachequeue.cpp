@@ -31,7 +31,12 @@
 //#define DEBUG_TILECACHEQUEUE
  
 namespace core {
-TileCacheQueue::TileCacheQueue()
+/**
+* @brief Tiles written to the database in one transaction at most
+*/
+static const int MaxBatch=64;
+
+TileCacheQueue::TileCacheQueue():active(false)
 {
 
 }
@@ -45,34 +50,37 @@ void TileCacheQueue::EnqueueCacheTask(CacheItemQueue *task)
 #ifdef DEBUG_TILECACHEQUEUE
     qDebug()<<"DB Do I EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
 #endif //DEBUG_TILECACHEQUEUE
+    QMutexLocker locker(&mutex);
     if(!tileCacheQueue.contains(task))
     {
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug()<<"EnqueueCacheTask"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
 #endif //DEBUG_TILECACHEQUEUE
-        mutex.lock();
         tileCacheQueue.enqueue(task);
-        mutex.unlock();
-        if(this->isRunning())
+        if(active)
         {
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Wake Thread";
 #endif //DEBUG_TILECACHEQUEUE
-            //this->start(QThread::NormalPriority);
-            //waitmutex.lock();
             waitc.wakeAll();
-            //waitmutex.unlock();
         }
         else
         {
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Start Thread";
 #endif //DEBUG_TILECACHEQUEUE
+            // A thread that timed out may still be on its way out
+            this->wait();
+            active=true;
             this->start(QThread::NormalPriority);
         }
     }
 
 }
+/**
+* @brief Writes the queued tiles behind the loaders back, taking all tiles
+*        queued while the previous batch was written as the next batch
+*/
 void TileCacheQueue::run()
 {
 #ifdef DEBUG_TILECACHEQUEUE
@@ -80,49 +88,32 @@ void TileCacheQueue::run()
 #endif //DEBUG_TILECACHEQUEUE
     while(true)
     {
-        CacheItemQueue *task;
-#ifdef DEBUG_TILECACHEQUEUE
-        qDebug()<<"Cache";
-#endif //DEBUG_TILECACHEQUEUE
-        if(tileCacheQueue.count()>0)
-        {
-            mutex.lock();
-            task=tileCacheQueue.dequeue();
-            mutex.unlock();
-#ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
-#endif //DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
-            usleep(44);
-            delete task;
-        }
-
-        else
+        QList<CacheItemQueue*> batch;
+        mutex.lock();
+        if(tileCacheQueue.isEmpty())
         {
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug()<<"Cache engine BEGIN WAIT";
 #endif //DEBUG_TILECACHEQUEUE
-            waitmutex.lock();
-            int tout=4000;
-            if(!waitc.wait(&waitmutex,tout))
+            waitc.wait(&mutex,4000);
+            if(tileCacheQueue.isEmpty())
             {
-                waitmutex.unlock();
 #ifdef DEBUG_TILECACHEQUEUE
                 qDebug()<<"Cache Engine TimeOut";
 #endif //DEBUG_TILECACHEQUEUE
-                mutex.lock();
-                if(tileCacheQueue.count()==0)
-                {
-                    mutex.unlock();
-                    break;
-                }
+                active=false;
                 mutex.unlock();
+                break;
             }
+        }
+        while(!tileCacheQueue.isEmpty() && batch.count()<MaxBatch)
+            batch.append(tileCacheQueue.dequeue());
+        mutex.unlock();
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache Engine DID NOT TimeOut";
+        qDebug()<<"Cache engine Put:"<<batch.count()<<" tiles";
 #endif //DEBUG_TILECACHEQUEUE
-            waitmutex.unlock();
-        }
+        Cache::Instance()->ImageCache.PutImagesToCache(batch);
+        qDeleteAll(batch);
     }
 #ifdef DEBUG_TILECACHEQUEUE
     qDebug()<<"Cache Engine Stopped";
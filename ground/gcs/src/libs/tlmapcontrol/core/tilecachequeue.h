@@ -53,8 +53,12 @@ namespace core {
     private:
         void run();
         QMutex mutex;
-        QMutex waitmutex;
         QWaitCondition waitc;
+        /**
+        * @brief True from starting the thread until it decided to stop,
+        *        protected by mutex
+        */
+        bool active;
     };
 }
 #endif // TILECACHEQUEUE_H
@@ -0,0 +1,251 @@
+/**
+******************************************************************************
+*
+* @file       tilepack.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Read only tile package, memory mapped for offline use
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "tilepack.h"
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+
+//#define DEBUG_TILEPACK
+
+namespace core {
+    TilePack::TilePack():map(0),index(0),count(0)
+    {
+
+    }
+
+    TilePack::~TilePack()
+    {
+        if(map)
+            file.unmap(const_cast<uchar*>(map));
+    }
+
+    /**
+    * @brief Maps a tile package into memory and checks its index
+    *
+    * @return false if the file can not be mapped or is not a valid package
+    */
+    bool TilePack::Open(const QString &fileName)
+    {
+        file.setFileName(fileName);
+        if(!file.open(QIODevice::ReadOnly))
+            return false;
+        qint64 size=file.size();
+        if(size<HeaderSize)
+            return false;
+        map=file.map(0,size);
+        // The mapping stays valid after the file is closed
+        file.close();
+        if(!map)
+            return false;
+
+        quint32 n=qFromLittleEndian<quint32>(map+8);
+        quint64 indexOffset=qFromLittleEndian<quint64>(map+16);
+        if(qFromLittleEndian<quint32>(map)!=Magic ||
+                qFromLittleEndian<quint32>(map+4)!=Version ||
+                indexOffset<(quint64)HeaderSize ||
+                indexOffset>(quint64)size ||
+                (quint64)n*EntrySize>(quint64)size-indexOffset)
+        {
+#ifdef DEBUG_TILEPACK
+            qDebug()<<"TilePack: invalid header in"<<fileName;
+#endif //DEBUG_TILEPACK
+            return false;
+        }
+
+        // Check once that every image is inside the file and the index is
+        // sorted, so lookups do not have to
+        const uchar *entry=map+indexOffset;
+        for(quint32 i=0;i<n;i++,entry+=EntrySize)
+        {
+            quint64 offset=qFromLittleEndian<quint64>(entry+16);
+            quint32 length=qFromLittleEndian<quint32>(entry+4);
+            bool sorted=true;
+            if(i>0)
+            {
+                quint32 type=qFromLittleEndian<quint32>(entry);
+                quint32 lastType=qFromLittleEndian<quint32>(entry-EntrySize);
+                sorted=lastType<type || (lastType==type &&
+                        qFromLittleEndian<quint64>(entry-EntrySize+8)<qFromLittleEndian<quint64>(entry+8));
+            }
+            // Subtracted rather than added, a corrupt offset must not wrap
+            if(!sorted || offset<(quint64)HeaderSize || offset>indexOffset ||
+                    length>indexOffset-offset)
+            {
+#ifdef DEBUG_TILEPACK
+                qDebug()<<"TilePack: invalid index entry"<<i<<"in"<<fileName;
+#endif //DEBUG_TILEPACK
+                return false;
+            }
+        }
+
+        index=map+indexOffset;
+        count=n;
+        return true;
+    }
+
+    /**
+    * @brief Returns the image of a tile without copying it
+    *
+    * @return the image, empty if the package does not have the tile. The data
+    *         belongs to the mapping and is only valid as long as the package.
+    */
+    QByteArray TilePack::GetImage(const MapType::Types &type,const core::Point &pos,const int &zoom)const
+    {
+        if(!index || zoom<0 || zoom>30 || pos.X()<0 || pos.Y()<0 || pos.X()>=(1<<zoom) || pos.Y()>=(1<<zoom))
+            return QByteArray();
+
+        quint32 wantedType=(quint32)type;
+        quint64 wantedKey=QuadKey(pos,zoom);
+        quint32 low=0;
+        quint32 high=count;
+        while(low<high)
+        {
+            quint32 mid=low+(high-low)/2;
+            const uchar *entry=index+(quint64)mid*EntrySize;
+            quint32 entryType=qFromLittleEndian<quint32>(entry);
+            quint64 entryKey=qFromLittleEndian<quint64>(entry+8);
+            if(entryType<wantedType || (entryType==wantedType && entryKey<wantedKey))
+                low=mid+1;
+            else if(entryType==wantedType && entryKey==wantedKey)
+                return QByteArray::fromRawData(reinterpret_cast<const char*>(map+qFromLittleEndian<quint64>(entry+16)),
+                                               qFromLittleEndian<quint32>(entry+4));
+            else
+                high=mid;
+        }
+        return QByteArray();
+    }
+
+    /**
+    * @brief Returns the quadkey of a tile, the bits of the x and y
+    *        coordinates interleaved below a leading one that marks the zoom.
+    *        Neighbouring tiles get near keys, so they end up close in the file.
+    */
+    quint64 TilePack::QuadKey(const core::Point &pos,const int &zoom)
+    {
+        quint64 key=(quint64)1<<(2*zoom);
+        for(int bit=0;bit<zoom;bit++)
+        {
+            key|=(quint64)((pos.X()>>bit)&1)<<(2*bit);
+            key|=(quint64)((pos.Y()>>bit)&1)<<(2*bit+1);
+        }
+        return key;
+    }
+
+    bool TilePackWriter::Entry::operator<(const Entry &other)const
+    {
+        return type<other.type || (type==other.type && quadkey<other.quadkey);
+    }
+
+    TilePackWriter::TilePackWriter()
+    {
+
+    }
+
+    TilePackWriter::~TilePackWriter()
+    {
+        // A package that was not finished has no valid index
+        if(file.isOpen())
+        {
+            file.close();
+            file.remove();
+        }
+    }
+
+    bool TilePackWriter::Open(const QString &fileName)
+    {
+        entries.clear();
+        file.setFileName(fileName);
+        if(!file.open(QIODevice::WriteOnly|QIODevice::Truncate))
+            return false;
+        // The header is written by Finish()
+        return file.write(QByteArray(TilePack::HeaderSize,0))==TilePack::HeaderSize;
+    }
+
+    bool TilePackWriter::Add(const MapType::Types &type,const core::Point &pos,const int &zoom,const QByteArray &img)
+    {
+        if(!file.isOpen() || img.isEmpty() || zoom<0 || zoom>30 || pos.X()<0 || pos.Y()<0 || pos.X()>=(1<<zoom) || pos.Y()>=(1<<zoom))
+            return false;
+        Entry entry;
+        entry.type=(quint32)type;
+        entry.length=img.size();
+        entry.quadkey=TilePack::QuadKey(pos,zoom);
+        entry.offset=file.pos();
+        if(file.write(img)!=img.size())
+            return false;
+        entries.append(entry);
+        return true;
+    }
+
+    /**
+    * @brief Writes the index and the header and closes the package
+    */
+    bool TilePackWriter::Finish()
+    {
+        if(!file.isOpen())
+            return false;
+
+        // A tile added more than once keeps its last image, the earlier
+        // images stay in the file unreferenced
+        std::stable_sort(entries.begin(),entries.end());
+        QList<Entry> unique;
+        for(int i=0;i<entries.count();i++)
+        {
+            if(i+1<entries.count() && !(entries[i]<entries[i+1]))
+                continue;
+            unique.append(entries[i]);
+        }
+        entries=unique;
+
+        quint64 indexOffset=file.pos();
+        QByteArray index(entries.count()*TilePack::EntrySize,0);
+        uchar *entry=reinterpret_cast<uchar*>(index.data());
+        foreach(const Entry &e,entries)
+        {
+            qToLittleEndian<quint32>(e.type,entry);
+            qToLittleEndian<quint32>(e.length,entry+4);
+            qToLittleEndian<quint64>(e.quadkey,entry+8);
+            qToLittleEndian<quint64>(e.offset,entry+16);
+            entry+=TilePack::EntrySize;
+        }
+
+        QByteArray header(TilePack::HeaderSize,0);
+        uchar *h=reinterpret_cast<uchar*>(header.data());
+        qToLittleEndian<quint32>(TilePack::Magic,h);
+        qToLittleEndian<quint32>(TilePack::Version,h+4);
+        qToLittleEndian<quint32>(entries.count(),h+8);
+        qToLittleEndian<quint64>(indexOffset,h+16);
+
+        bool ret=file.write(index)==index.size() &&
+                file.seek(0) &&
+                file.write(header)==header.size() &&
+                file.flush();
+        file.close();
+        if(!ret)
+            file.remove();
+        return ret;
+    }
+}
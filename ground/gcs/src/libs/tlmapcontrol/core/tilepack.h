@@ -0,0 +1,96 @@
+/**
+******************************************************************************
+*
+* @file       tilepack.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Read only tile package, memory mapped for offline use
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TILEPACK_H
+#define TILEPACK_H
+
+#include "maptype.h"
+#include "point.h"
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+namespace core {
+    /**
+    * @brief A tile package holds the images of a set of tiles in one file.
+    *
+    * All values are little endian. The file starts with a header:
+    *   quint32 magic "TLTP", quint32 version, quint32 count, quint32 reserved,
+    *   quint64 offset of the index, quint64 reserved
+    * followed by the tile images and the index. The index has count entries of:
+    *   quint32 map type, quint32 image length, quint64 quadkey, quint64 image offset
+    * sorted by map type and quadkey, so a tile is found by a binary search.
+    */
+    class TilePack
+    {
+    public:
+        TilePack();
+        ~TilePack();
+        bool Open(const QString &file);
+        QString FileName()const{return file.fileName();}
+        int Count()const{return count;}
+        QByteArray GetImage(const MapType::Types &type,const core::Point &pos,const int &zoom)const;
+        static quint64 QuadKey(const core::Point &pos,const int &zoom);
+
+        static const quint32 Magic=0x50544c54;
+        static const quint32 Version=1;
+        static const int HeaderSize=32;
+        static const int EntrySize=24;
+    private:
+        QFile file;
+        const uchar *map;
+        const uchar *index;
+        quint32 count;
+    };
+
+    /**
+    * @brief Writes a tile package, the images go to the file as they are
+    *        added and only the index is kept in memory
+    */
+    class TilePackWriter
+    {
+    public:
+        TilePackWriter();
+        ~TilePackWriter();
+        bool Open(const QString &file);
+        bool Add(const MapType::Types &type,const core::Point &pos,const int &zoom,const QByteArray &img);
+        bool Finish();
+        QString FileName()const{return file.fileName();}
+        int Count()const{return entries.count();}
+    private:
+        struct Entry {
+            quint32 type;
+            quint32 length;
+            quint64 quadkey;
+            quint64 offset;
+            bool operator<(const Entry &other)const;
+        };
+        QFile file;
+        QList<Entry> entries;
+    };
+}
+#endif // TILEPACK_H
@@ -338,6 +338,16 @@ namespace core {
             //Attempt to read tile from cache
             if(accessmode != (AccessMode::ServerOnly) && type != MapType::UserImage) //Don't use cache if the user supplies a file. This is because
             {
+                // Tile packages are memory mapped, their tiles are not copied
+                // and need not be kept in the memory cache
+                ret=Cache::Instance()->GetImageFromTilePacks(type,pos,zoom);
+                if(!ret.isEmpty())
+                {
+                    errorvars.lock();
+                    ++diag.tilesFromPack;
+                    errorvars.unlock();
+                    return ret;
+                }
 #ifdef DEBUG_GMAPS
                 qDebug()<<"Try tile from DataBase";
 #endif //DEBUG_GMAPS
@@ -160,6 +160,16 @@ public:
 
     }
 
+    /**
+    * @brief Adds a tile package, as exported by the map ripper, whose tiles are used
+    *        before the tiles in the cache database. Packages in the cache location are added
+    *        automatically.
+    *
+    * @param file The tile package file
+    * @return false if the file is not a valid tile package
+    */
+    bool AddTilePack(QString const& file){return core::Cache::Instance()->AddTilePack(file);}
+
     /**
     * @brief  Deletes tiles in DataBase older than "days" days
     *
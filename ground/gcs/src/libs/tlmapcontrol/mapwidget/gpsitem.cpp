@@ -49,10 +49,7 @@ namespace mapcontrol
         localposition=map->FromLatLngToLocal(mapwidget->CurrentPosition());
         this->setPos(localposition.X(),localposition.Y());
         this->setZValue(4);
-        trail=new QGraphicsItemGroup(this);
-        trail->setParentItem(map);
-        trailLine=new QGraphicsItemGroup(this);
-        trailLine->setParentItem(map);
+        trail=new TrailPathItem(Qt::green,Qt::red,map);
         this->setFlag(QGraphicsItem::ItemIgnoresTransformations,true);
         mapfollowtype=UAVMapFollowType::None;
         trailtype=UAVTrailType::ByDistance;
@@ -86,16 +83,7 @@ namespace mapcontrol
             {
                 if(timer.elapsed()>trailtime*1000)
                 {
-                    TrailItem * ob=new TrailItem(position,altitude,Qt::green,map);
-                    trail->addToGroup(ob);
-                    connect(this,SIGNAL(setChildPosition()),ob,SLOT(setPosSLOT()));
-                    if(!lasttrailline.IsEmpty())
-                    {
-                        TrailLineItem * obj=new TrailLineItem(lasttrailline,position,Qt::red,map);
-                        trailLine->addToGroup(obj);
-                        connect(this,SIGNAL(setChildLine()),obj,SLOT(setLineSlot()));
-                    }
-                    lasttrailline=position;
+                    trail->AddPoint(position,altitude);
                     timer.restart();
                 }
 
@@ -104,16 +92,7 @@ namespace mapcontrol
             {
                 if(qAbs(internals::PureProjection::DistanceBetweenLatLng(lastcoord,position)*1000)>traildistance)
                 {
-                    TrailItem * ob=new TrailItem(position,altitude,Qt::green,map);
-                    trail->addToGroup(ob);
-                    connect(this,SIGNAL(setChildPosition()),ob,SLOT(setPosSLOT()));
-                    if(!lasttrailline.IsEmpty())
-                    {
-                        TrailLineItem * obj=new TrailLineItem(lasttrailline,position,Qt::red,map);
-                        trailLine->addToGroup(obj);
-                        connect(this,SIGNAL(setChildLine()),obj,SLOT(setLineSlot()));
-                    }
-                    lasttrailline=position;
+                    trail->AddPoint(position,altitude);
                     lastcoord=position;
                 }
             }
@@ -150,8 +129,6 @@ namespace mapcontrol
     {
         localposition=map->FromLatLngToLocal(coord);
         this->setPos(localposition.X(),localposition.Y());
-        emit setChildPosition();
-        emit setChildLine();
 
     }
 
@@ -168,20 +145,17 @@ namespace mapcontrol
     void GPSItem::SetShowTrail(const bool &value)
     {
         showtrail=value;
-        trail->setVisible(value);
+        trail->SetShowPoints(value);
 
     }
     void GPSItem::SetShowTrailLine(const bool &value)
     {
         showtrailline=value;
-        trailLine->setVisible(value);
+        trail->SetShowLine(value);
     }
     void GPSItem::DeleteTrail()const
     {
-        foreach(QGraphicsItem* i,trail->childItems())
-            delete i;
-        foreach(QGraphicsItem* i,trailLine->childItems())
-            delete i;
+        trail->Clear();
     }
     double GPSItem::Distance3D(const internals::PointLatLng &coord, const int &altitude)
     {
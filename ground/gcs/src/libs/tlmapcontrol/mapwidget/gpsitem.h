@@ -33,8 +33,7 @@
 #include "uavmapfollowtype.h"
 #include "uavtrailtype.h"
 #include <QtSvg/QSvgRenderer>
-#include "trailitem.h"
-#include "traillineitem.h"
+#include "trailpathitem.h"
 #include "../core/corecommon.h"
 
 namespace mapcontrol
@@ -158,6 +157,14 @@ namespace mapcontrol
         */
         void DeleteTrail()const;
         /**
+        * @brief Sets the number of trail points kept, the oldest points are
+        *        dropped when there are more
+        *
+        * @param points
+        */
+        void SetTrailPointBudget(int const& points){trail->SetPointBudget(points);}
+        int TrailPointBudget()const{return trail->PointBudget();}
+        /**
         * @brief Returns true if the UAV automaticaly sets WP reached value (changing its color)
         *
         * @return bool
@@ -192,9 +199,7 @@ namespace mapcontrol
         QPixmap pic;
         core::Point localposition;
         TLMapWidget* mapwidget;
-        QGraphicsItemGroup* trail;
-        QGraphicsItemGroup * trailLine;
-        internals::PointLatLng lasttrailline;
+        TrailPathItem* trail;
         QTime timer;
         bool showtrail;
         bool showtrailline;
@@ -210,8 +215,6 @@ namespace mapcontrol
     signals:
         void UAVReachedWayPoint(int const& waypointnumber,WayPointItem* waypoint);
         void UAVLeftSafetyBouble(internals::PointLatLng const& position);
-        void setChildPosition();
-        void setChildLine();
     };
 }
 #endif // GPSITEM_H
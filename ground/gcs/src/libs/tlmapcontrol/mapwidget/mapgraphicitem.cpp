@@ -347,6 +347,9 @@ namespace mapcontrol
          if(!lastimage.isNull())
             painter->drawImage(core->GetrenderOffset().X()-lastimagepoint.X(),core->GetrenderOffset().Y()-lastimagepoint.Y(),lastimage);
 
+        // The overlays of a tile are the layers of the map type in this order
+        QVector<MapType::Types> layers = TLMaps::Instance()->GetAllLayersOfType(core->GetMapType());
+
         for(int i = -core->GetsizeOfMapArea().Width(); i <= core->GetsizeOfMapArea().Width(); i++)
         {
             for(int j = -core->GetsizeOfMapArea().Height(); j <= core->GetsizeOfMapArea().Height(); j++)
@@ -368,14 +371,16 @@ namespace mapcontrol
                             //lock(t.Overlays)
                             if(t!=0)
                             {
-                                foreach(QByteArray img,t->Overlays)
+                                for(int layer = 0; layer < t->Overlays.count(); layer++)
                                 {
+                                    QByteArray img = t->Overlays.at(layer);
                                     if(img.count()!=0)
                                     {
                                         if(!found)
                                             found = true;
                                         {
-                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),PureImageProxy::FromStream(img));
+                                            MapType::Types type = layer < layers.count() ? layers.at(layer) : core->GetMapType();
+                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),pixmapCache.Pixmap(RawTile(type, t->GetPos(), t->GetZoom()), img));
                                         }
                                     }
                                 }
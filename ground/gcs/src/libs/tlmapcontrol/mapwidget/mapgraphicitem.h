@@ -31,6 +31,7 @@
 #include <QGraphicsItem>
 #include "../internals/core.h"
 #include "../core/diagnostics.h"
+#include "../core/pixmapcache.h"
 #include "configuration.h"
 #include <QtGui>
 #include <QTransform>
@@ -138,6 +139,12 @@ namespace mapcontrol
         qreal MapRenderTransform;
         void DrawMap2D(QPainter *painter);
         /**
+        * @brief Decoded images of the tiles last drawn
+        *
+        * @var pixmapCache
+        */
+        core::PixmapCache pixmapCache;
+        /**
         * @brief Maximum possible zoom
         *
         * @var maxZoom
@@ -29,7 +29,7 @@
 namespace mapcontrol
 {
 
-MapRipper::MapRipper(internals::Core * core, const internals::RectLatLng & rect):sleep(100),cancel(false),progressForm(0),core(core),yesToAll(false)
+MapRipper::MapRipper(internals::Core * core, const internals::RectLatLng & rect, const QString & packFile):sleep(100),cancel(false),progressForm(0),core(core),yesToAll(false)
     {
         if(!rect.IsEmpty())
         {
@@ -40,6 +40,9 @@ MapRipper::MapRipper(internals::Core * core, const internals::RectLatLng & rect)
             zoom=core->Zoom();
             maxzoom=core->MaxZoom();
             points=core->Projection()->GetAreaTileList(area,zoom,0);
+            // Without a package file the tiles only go to the tile cache
+            if(!packFile.isEmpty())
+                pack.Open(packFile);
             this->start();
             cancel=false;
             progressForm->show();
@@ -88,6 +91,7 @@ void MapRipper::finish()
         }
         else
         {
+            exportTilePack();
             progressForm->close();
             delete progressForm;
             this->deleteLater();
@@ -96,6 +100,7 @@ void MapRipper::finish()
     else
     {
         yesToAll=false;
+        exportTilePack();
         progressForm->close();
         delete progressForm;
         this->deleteLater();
@@ -125,6 +130,7 @@ void MapRipper::finish()
                     QByteArray img = TLMaps::Instance()->GetImageFromServer(type, p, zoom);
                     if(img.length()!=0)
                     {
+                        pack.Add(type, p, zoom, img);
                         goodtile=true;
                         img=NULL;
                     }
@@ -149,6 +155,16 @@ void MapRipper::finish()
         }
     }
 
+    /**
+    * @brief Finishes the tile package of the ripped tiles and starts using it,
+    *        if one was asked for
+    */
+    void MapRipper::exportTilePack()
+    {
+        if(pack.Count()>0 && pack.Finish())
+            core::Cache::Instance()->AddTilePack(pack.FileName());
+    }
+
     void MapRipper::stopFetching()
     {
         QMutexLocker locker(&mutex);
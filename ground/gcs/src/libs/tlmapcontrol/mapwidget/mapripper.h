@@ -34,6 +34,7 @@
 #include <QObject>
 #include <QMessageBox>
 #include "../core/corecommon.h"
+#include "../core/tilepack.h"
 
 namespace mapcontrol
 {
@@ -41,7 +42,7 @@ namespace mapcontrol
     {
         Q_OBJECT
     public:
-        MapRipper(internals::Core *,internals::RectLatLng const&);
+        MapRipper(internals::Core *,internals::RectLatLng const&,QString const& packFile=QString());
         void run();
     private:
         QList<core::Point> points;
@@ -55,6 +56,12 @@ namespace mapcontrol
         internals::Core * core;
         bool yesToAll;
         QMutex mutex;
+        /**
+        * @brief The ripped tiles of all zoom levels, exported to the package
+        *        file given to the constructor when ripping ends
+        */
+        core::TilePackWriter pack;
+        void exportTilePack();
 
     signals:
         void percentageChanged(int const& perc);
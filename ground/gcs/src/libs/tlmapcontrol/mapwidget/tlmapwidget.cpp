@@ -636,6 +636,11 @@ namespace mapcontrol
         new MapRipper(core,map->SelectedArea());
     }
 
+    void TLMapWidget::RipMapToTilePack(const QString &file)
+    {
+        new MapRipper(core,map->SelectedArea(),file);
+    }
+
     void TLMapWidget::setSelectedWP(QList<WayPointItem * >list)
     {
         this->scene()->clearSelection();
@@ -523,6 +523,12 @@ namespace mapcontrol
         * @brief Ripps the current selection to the DB
         */
         void RipMap();
+        /**
+        * @brief Ripps the current selection to the DB and to a tile package
+        *
+        * @param file the tile package to write, it is used as soon as ripping ends
+        */
+        void RipMapToTilePack(const QString &file);
         void OnSelectionChanged();
 
     };
@@ -0,0 +1,258 @@
+/**
+******************************************************************************
+*
+* @file       trailpath.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Bounded and decimated trail of positions
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "trailpath.h"
+#include <QPair>
+#include <QtCore/qmath.h>
+
+namespace mapcontrol
+{
+    /**
+    * @brief New samples are reduced once this many are pending
+    */
+    static const int Chunk=32;
+
+    /**
+    * @brief Distance of p from the segment a-b
+    */
+    static qreal segmentDistance(QPointF const& p,QPointF const& a,QPointF const& b)
+    {
+        QPointF ab=b-a;
+        qreal length2=ab.x()*ab.x()+ab.y()*ab.y();
+        qreal t=0;
+        if(length2>0)
+            t=qBound((qreal)0,((p.x()-a.x())*ab.x()+(p.y()-a.y())*ab.y())/length2,(qreal)1);
+        QPointF d=p-(a+t*ab);
+        return qSqrt(d.x()*d.x()+d.y()*d.y());
+    }
+
+    TrailPath::TrailPath():budget(DefaultBudget),first(0),count(0),tolerance(1.0),firstSeq(0),pendingSeq(0),dirty(true)
+    {
+        samples.resize(budget);
+        pixels.resize(budget);
+    }
+
+    /**
+    * @brief Sets the number of samples kept, dropping the oldest ones if there
+    *        are more
+    */
+    void TrailPath::SetBudget(int const& points)
+    {
+        int newBudget=qMax(points,2);
+        int keep=qMin(count,newBudget);
+        QVector<TrailSample> newSamples(newBudget);
+        QVector<QPointF> newPixels(newBudget);
+        for(int i=0;i<keep;i++)
+        {
+            newSamples[i]=Sample(count-keep+i);
+            newPixels[i]=Pixel(count-keep+i);
+        }
+        samples=newSamples;
+        pixels=newPixels;
+        budget=newBudget;
+        first=0;
+        firstSeq+=count-keep;
+        count=keep;
+        Redecimate();
+    }
+
+    void TrailPath::SetTolerance(qreal const& pixels)
+    {
+        tolerance=pixels;
+        Redecimate();
+    }
+
+    void TrailPath::Append(TrailSample const& sample,QPointF const& pixel)
+    {
+        if(count==budget)
+        {
+            // Drop the oldest sample, the reduced line then starts at the
+            // oldest one left
+            first=(first+1)%budget;
+            --count;
+            ++firstSeq;
+            while(!kept.isEmpty() && kept.first()<firstSeq)
+                kept.removeFirst();
+            if(pendingSeq<firstSeq)
+                pendingSeq=firstSeq;
+            if(pendingSeq>firstSeq && (kept.isEmpty() || kept.first()!=firstSeq))
+                kept.prepend(firstSeq);
+        }
+        int i=(first+count)%budget;
+        samples[i]=sample;
+        pixels[i]=pixel;
+        ++count;
+
+        quint64 lastSeq=firstSeq+count-1;
+        if(lastSeq-pendingSeq+1>=(quint64)Chunk)
+        {
+            // Continue the reduced line from its last vertex
+            Decimate(kept.isEmpty()?pendingSeq:kept.last(),lastSeq);
+            pendingSeq=lastSeq+1;
+        }
+        dirty=true;
+    }
+
+    /**
+    * @brief Sets the pixel positions of all samples, oldest first, and
+    *        reduces the whole trail again
+    */
+    void TrailPath::SetPixels(QVector<QPointF> const& newPixels)
+    {
+        for(int i=0;i<count && i<newPixels.count();i++)
+            pixels[(first+i)%budget]=newPixels.at(i);
+        Redecimate();
+    }
+
+    void TrailPath::Redecimate()
+    {
+        kept.clear();
+        pendingSeq=firstSeq;
+        if(count>0)
+        {
+            Decimate(firstSeq,firstSeq+count-1);
+            pendingSeq=firstSeq+count;
+        }
+        dirty=true;
+    }
+
+    void TrailPath::Clear()
+    {
+        firstSeq+=count;
+        pendingSeq=firstSeq;
+        first=0;
+        count=0;
+        kept.clear();
+        dirty=true;
+    }
+
+    /**
+    * @brief Reduces the samples from..to, both included, and appends the
+    *        vertices kept to the reduced line
+    */
+    void TrailPath::Decimate(quint64 const& from,quint64 const& to)
+    {
+        int n=(int)(to-from)+1;
+        QVector<bool> keep(n,false);
+        keep[0]=true;
+        keep[n-1]=true;
+
+        // Iterative, a long straight flight would nest deep otherwise
+        QList<QPair<int,int> > stack;
+        if(n>2)
+            stack.append(qMakePair(0,n-1));
+        while(!stack.isEmpty())
+        {
+            QPair<int,int> range=stack.takeLast();
+            QPointF a=PixelOf(from+range.first);
+            QPointF b=PixelOf(from+range.second);
+            qreal worst=0;
+            int worstIndex=-1;
+            for(int i=range.first+1;i<range.second;i++)
+            {
+                qreal d=segmentDistance(PixelOf(from+i),a,b);
+                if(d>worst)
+                {
+                    worst=d;
+                    worstIndex=i;
+                }
+            }
+            if(worstIndex>=0 && worst>tolerance)
+            {
+                keep[worstIndex]=true;
+                if(worstIndex-range.first>1)
+                    stack.append(qMakePair(range.first,worstIndex));
+                if(range.second-worstIndex>1)
+                    stack.append(qMakePair(worstIndex,range.second));
+            }
+        }
+
+        for(int i=0;i<n;i++)
+        {
+            if(keep[i] && (kept.isEmpty() || kept.last()<from+i))
+                kept.append(from+i);
+        }
+    }
+
+    /**
+    * @brief Returns the polyline through the reduced samples and the samples
+    *        not reduced yet, in pixels
+    */
+    const QPainterPath &TrailPath::Path()const
+    {
+        Vertices();
+        return path;
+    }
+
+    /**
+    * @brief Returns the indexes of the samples on the polyline, oldest first
+    */
+    const QVector<int> &TrailPath::Vertices()const
+    {
+        if(dirty)
+        {
+            vertices.clear();
+            vertices.reserve(kept.count()+(int)(firstSeq+count-pendingSeq));
+            foreach(quint64 seq,kept)
+                vertices.append((int)(seq-firstSeq));
+            for(quint64 seq=pendingSeq;seq<firstSeq+count;seq++)
+                vertices.append((int)(seq-firstSeq));
+
+            path=QPainterPath();
+            for(int i=0;i<vertices.count();i++)
+            {
+                if(i==0)
+                    path.moveTo(Pixel(vertices.at(i)));
+                else
+                    path.lineTo(Pixel(vertices.at(i)));
+            }
+            dirty=false;
+        }
+        return vertices;
+    }
+
+    /**
+    * @brief Returns the index of the drawn sample nearest to a pixel position
+    *
+    * @return the index, -1 if there is none within radius
+    */
+    int TrailPath::Nearest(QPointF const& pixel,qreal const& radius)const
+    {
+        int nearest=-1;
+        qreal best=radius*radius;
+        foreach(int i,Vertices())
+        {
+            QPointF d=Pixel(i)-pixel;
+            qreal d2=d.x()*d.x()+d.y()*d.y();
+            if(d2<=best)
+            {
+                best=d2;
+                nearest=i;
+            }
+        }
+        return nearest;
+    }
+}
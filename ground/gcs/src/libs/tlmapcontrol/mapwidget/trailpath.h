@@ -0,0 +1,102 @@
+/**
+******************************************************************************
+*
+* @file       trailpath.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Bounded and decimated trail of positions
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TRAILPATH_H
+#define TRAILPATH_H
+
+#include <QList>
+#include <QPainterPath>
+#include <QPointF>
+#include <QVector>
+#include "../internals/pointlatlng.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    struct TrailSample
+    {
+        internals::PointLatLng coord;
+        int altitude;
+        qint64 time;
+    };
+
+    /**
+    * @brief The last positions of a trail with their pixel positions at the
+    *        current zoom, and the polyline to draw for them.
+    *
+    * The samples are kept in a ring buffer of Budget() entries, once it is
+    * full every new sample replaces the oldest one. The polyline is reduced
+    * with the Douglas-Peucker algorithm so it leaves out samples that are
+    * less than Tolerance() pixels off the line. New samples are reduced in
+    * chunks as they come in, and SetPixels() reduces the whole trail again
+    * for a new zoom, so fewer samples are drawn the further out the map is.
+    */
+    class TLMAPWIDGET_EXPORT TrailPath
+    {
+    public:
+        TrailPath();
+        void SetBudget(int const& points);
+        int Budget()const{return budget;}
+        void SetTolerance(qreal const& pixels);
+        qreal Tolerance()const{return tolerance;}
+        int Count()const{return count;}
+        const TrailSample &Sample(int const& i)const{return samples[(first+i)%budget];}
+        QPointF Pixel(int const& i)const{return pixels[(first+i)%budget];}
+        void Append(TrailSample const& sample,QPointF const& pixel);
+        void SetPixels(QVector<QPointF> const& pixels);
+        void Clear();
+        const QPainterPath &Path()const;
+        const QVector<int> &Vertices()const;
+        int Nearest(QPointF const& pixel,qreal const& radius)const;
+
+        static const int DefaultBudget=4096;
+    private:
+        void Decimate(quint64 const& from,quint64 const& to);
+        void Redecimate();
+        QPointF PixelOf(quint64 const& seq)const{return Pixel((int)(seq-firstSeq));}
+        QVector<TrailSample> samples;
+        QVector<QPointF> pixels;
+        int budget;
+        int first;
+        int count;
+        qreal tolerance;
+        /**
+        * @brief Sequence number of the oldest sample, samples are numbered
+        *        from the start of the trail
+        */
+        quint64 firstSeq;
+        /**
+        * @brief The samples from firstSeq up to pendingSeq are reduced to the
+        *        kept ones, the samples from pendingSeq on are all drawn
+        */
+        quint64 pendingSeq;
+        QList<quint64> kept;
+        mutable bool dirty;
+        mutable QPainterPath path;
+        mutable QVector<int> vertices;
+    };
+}
+#endif // TRAILPATH_H
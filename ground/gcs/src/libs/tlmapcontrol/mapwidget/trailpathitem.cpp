@@ -0,0 +1,184 @@
+/**
+******************************************************************************
+*
+* @file       trailpathitem.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      A graphicsItem representing the trail of a UAV
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "trailpathitem.h"
+#include <QDateTime>
+#include <QGraphicsSceneHoverEvent>
+#include <QPainterPathStroker>
+
+namespace mapcontrol
+{
+    TrailPathItem::TrailPathItem(QBrush pointColor, QBrush lineColor, MapGraphicItem *map):QGraphicsItem(map),m_map(map),m_pointBrush(pointColor),showpoints(true),showline(true),shapeValid(false)
+    {
+        m_linePen.setBrush(lineColor);
+        m_linePen.setWidth(1);
+        setAcceptHoverEvents(true);
+        connect(map,SIGNAL(childRefreshPosition()),this,SLOT(RefreshPos()));
+        connect(map,SIGNAL(zoomChanged(double,double,double)),this,SLOT(Reproject()));
+    }
+
+    void TrailPathItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+    {
+        Q_UNUSED(option);
+        Q_UNUSED(widget);
+
+        if(showline)
+        {
+            painter->setPen(m_linePen);
+            painter->setBrush(Qt::NoBrush);
+            painter->drawPath(trail.Path());
+        }
+        if(showpoints)
+        {
+            painter->setPen(QPen(Qt::black));
+            painter->setBrush(m_pointBrush);
+            foreach(int i,trail.Vertices())
+                painter->drawEllipse(trail.Pixel(i),2,2);
+        }
+    }
+    QRectF TrailPathItem::boundingRect()const
+    {
+        return bounds;
+    }
+    QPainterPath TrailPathItem::shape()const
+    {
+        // Only the trail itself takes hover events, not the area it encloses
+        if(!shapeValid)
+        {
+            QPainterPathStroker stroker;
+            stroker.setWidth(8);
+            shapePath=stroker.createStroke(trail.Path());
+            shapeValid=true;
+        }
+        return shapePath;
+    }
+    int TrailPathItem::type()const
+    {
+        return Type;
+    }
+
+    void TrailPathItem::AddPoint(internals::PointLatLng const& coord,int const& altitude)
+    {
+        if(trail.Count()==0)
+            origin=coord;
+        originLocal=m_map->FromLatLngToLocal(origin);
+        setPos(originLocal.X(),originLocal.Y());
+
+        TrailSample sample;
+        sample.coord=coord;
+        sample.altitude=altitude;
+        sample.time=QDateTime::currentMSecsSinceEpoch();
+        prepareGeometryChange();
+        trail.Append(sample,toPixel(coord));
+        trailChanged();
+    }
+    void TrailPathItem::Clear()
+    {
+        prepareGeometryChange();
+        trail.Clear();
+        trailChanged();
+    }
+    void TrailPathItem::SetShowPoints(bool const& value)
+    {
+        showpoints=value;
+        setVisible(showpoints || showline);
+        update();
+    }
+    void TrailPathItem::SetShowLine(bool const& value)
+    {
+        showline=value;
+        setVisible(showpoints || showline);
+        update();
+    }
+    void TrailPathItem::SetPointBudget(int const& points)
+    {
+        prepareGeometryChange();
+        trail.SetBudget(points);
+        trailChanged();
+    }
+
+    void TrailPathItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
+    {
+        int i=trail.Nearest(event->pos(),4);
+        if(i<0)
+        {
+            setToolTip(QString());
+            return;
+        }
+        const TrailSample &sample=trail.Sample(i);
+        QString coord_str = " " + QString::number(sample.coord.Lat(), 'f', 6) + "   " + QString::number(sample.coord.Lng(), 'f', 6);
+        setToolTip(QString(tr("Position:")+"%1\n"+tr("Altitude:")+"%2\n"+tr("Time:")+"%3").arg(coord_str).arg(QString::number(sample.altitude)).arg(QDateTime::fromMSecsSinceEpoch(sample.time).toString()));
+    }
+
+    QPointF TrailPathItem::toPixel(internals::PointLatLng const& coord)const
+    {
+        core::Point local=m_map->FromLatLngToLocal(coord);
+        return QPointF(local.X()-originLocal.X(),local.Y()-originLocal.Y());
+    }
+
+    void TrailPathItem::trailChanged()
+    {
+        bounds=trail.Path().controlPointRect().adjusted(-3,-3,3,3);
+        shapeValid=false;
+        update();
+    }
+
+    /**
+    * @brief Moves the trail with the map. The pixel positions are only
+    *        computed again if the map was scaled.
+    */
+    void TrailPathItem::RefreshPos()
+    {
+        if(trail.Count()==0)
+            return;
+        originLocal=m_map->FromLatLngToLocal(origin);
+        setPos(originLocal.X(),originLocal.Y());
+
+        int last=trail.Count()-1;
+        QPointF moved=toPixel(trail.Sample(last).coord)-trail.Pixel(last);
+        if(qAbs(moved.x())>1 || qAbs(moved.y())>1)
+            Reproject();
+    }
+
+    /**
+    * @brief Computes the pixel positions for the current zoom and reduces the
+    *        trail for them
+    */
+    void TrailPathItem::Reproject()
+    {
+        if(trail.Count()==0)
+            return;
+        originLocal=m_map->FromLatLngToLocal(origin);
+        setPos(originLocal.X(),originLocal.Y());
+
+        QVector<QPointF> pixels(trail.Count());
+        for(int i=0;i<trail.Count();i++)
+            pixels[i]=toPixel(trail.Sample(i).coord);
+        prepareGeometryChange();
+        trail.SetPixels(pixels);
+        trailChanged();
+    }
+}
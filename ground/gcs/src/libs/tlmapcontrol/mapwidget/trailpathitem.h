@@ -0,0 +1,92 @@
+/**
+******************************************************************************
+*
+* @file       trailpathitem.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      A graphicsItem representing the trail of a UAV
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TRAILPATHITEM_H
+#define TRAILPATHITEM_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QObject>
+#include "trailpath.h"
+#include "mapgraphicitem.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+    * @brief Draws a whole trail as one item, the trail points as dots and
+    *        the trail line between them
+    */
+    class TLMAPWIDGET_EXPORT TrailPathItem:public QObject,public QGraphicsItem
+    {
+        Q_OBJECT
+        Q_INTERFACES(QGraphicsItem)
+    public:
+        enum { Type = UserType + 3 };
+        TrailPathItem(QBrush pointColor,QBrush lineColor,MapGraphicItem * map);
+        void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                    QWidget *widget);
+        QRectF boundingRect() const;
+        QPainterPath shape() const;
+        int type() const;
+
+        void AddPoint(internals::PointLatLng const& coord,int const& altitude);
+        void Clear();
+        void SetShowPoints(bool const& value);
+        bool ShowPoints()const{return showpoints;}
+        void SetShowLine(bool const& value);
+        bool ShowLine()const{return showline;}
+        /**
+        * @brief Sets the number of trail points kept, the oldest points are
+        *        dropped when there are more
+        */
+        void SetPointBudget(int const& points);
+        int PointBudget()const{return trail.Budget();}
+    protected:
+        void hoverMoveEvent(QGraphicsSceneHoverEvent *event);
+    private:
+        QPointF toPixel(internals::PointLatLng const& coord)const;
+        void trailChanged();
+        TrailPath trail;
+        MapGraphicItem * m_map;
+        QBrush m_pointBrush;
+        QPen m_linePen;
+        bool showpoints;
+        bool showline;
+        /**
+        * @brief The pixel positions of the trail are relative to this point
+        */
+        internals::PointLatLng origin;
+        core::Point originLocal;
+        QRectF bounds;
+        mutable QPainterPath shapePath;
+        mutable bool shapeValid;
+    public slots:
+        void RefreshPos();
+        void Reproject();
+    };
+}
+#endif // TRAILPATHITEM_H
@@ -0,0 +1,21 @@
+# Tile cache writes and reads, the per thread database connections and the
+# decoded pixmap cache, run with
+#   ./tst_tilecache
+# or with "-iterations n" to fix the number of benchmark iterations
+QT += sql
+TARGET = tst_tilecache
+
+INCLUDEPATH += ../../core
+
+SOURCES += tst_tilecache.cpp \
+    ../../core/pixmapcache.cpp \
+    ../../core/pureimage.cpp \
+    ../../core/pureimagecache.cpp \
+    ../../core/cacheitemqueue.cpp \
+    ../../core/rawtile.cpp \
+    ../../core/point.cpp \
+    ../../core/size.cpp
+
+HEADERS += ../../core/maptype.h
+
+include(../tlmapbench.pri)
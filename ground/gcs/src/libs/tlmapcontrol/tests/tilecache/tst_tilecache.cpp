@@ -0,0 +1,305 @@
+/**
+******************************************************************************
+*
+* @file       tst_tilecache.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Times the tile cache writes and reads and the decoded pixmap cache
+* @see        The GNU Public License (GPL) Version 3
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+#include <QTemporaryDir>
+#include <QBuffer>
+#include <QImage>
+#include <QPainter>
+
+#include "pureimagecache.h"
+#include "pixmapcache.h"
+#include "pureimage.h"
+
+using namespace core;
+
+// A 32x32 tile area at zoom 14, which is what a few minutes of panning loads
+static const int Zoom=14;
+static const int Side=32;
+static const int TileSize=256;
+// Tiles written by each transaction of the write behind queue
+static const int MaxBatch=64;
+// Threads reading from the cache at once, like the tile loaders do
+static const int Readers=4;
+// Tiles on a 1536x1024 map widget
+static const int ScreenTiles=24;
+
+/**
+ * Reads all the tiles from the cache, the way a tile loader thread does
+ */
+class Reader : public QThread
+{
+public:
+    Reader(PureImageCache *cache,const QList<Point> &lookups):cache(cache),lookups(lookups),found(0){}
+    PureImageCache *cache;
+    QList<Point> lookups;
+    int found;
+protected:
+    void run()
+    {
+        foreach(Point pos,lookups)
+            found+=!cache->GetImageFromCache(MapType::GoogleSatellite,pos,Zoom).isEmpty();
+    }
+};
+
+class tst_TileCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void putOneByOne();
+    void putBatched();
+    void sameTilesBack();
+    void concurrentReads();
+    void pixmapReused();
+    void pixmapDecodedAgain();
+    void pixmapEviction();
+    void repaintDecoding();
+    void repaintCached();
+
+private:
+    QByteArray image(const Point &pos);
+    QList<Point> tiles;
+    QList<QByteArray> images;
+    QTemporaryDir dir;
+    PureImageCache cache;
+};
+
+/**
+ * A PNG tile with some detail so it does not compress to nothing
+ */
+QByteArray tst_TileCache::image(const Point &pos)
+{
+    QImage tile(TileSize,TileSize,QImage::Format_RGB32);
+    tile.fill(Qt::white);
+    QPainter painter(&tile);
+    qsrand(pos.X()*Side+pos.Y()+1);
+    for(int i=0;i<40;i++)
+    {
+        painter.setPen(QColor(qrand()%256,qrand()%256,qrand()%256));
+        painter.drawLine(qrand()%TileSize,qrand()%TileSize,qrand()%TileSize,qrand()%TileSize);
+    }
+    painter.end();
+
+    QByteArray img;
+    QBuffer buffer(&img);
+    buffer.open(QIODevice::WriteOnly);
+    tile.save(&buffer,"PNG");
+    return img;
+}
+
+void tst_TileCache::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    cache.setGtileCache(dir.path()+QDir::separator());
+
+    Point origin(8000,5000);
+    for(int x=0;x<Side;x++)
+    {
+        for(int y=0;y<Side;y++)
+        {
+            Point pos(origin.X()+x,origin.Y()+y);
+            tiles.append(pos);
+            images.append(image(pos));
+        }
+    }
+
+    QList<CacheItemQueue*> batch;
+    for(int i=0;i<tiles.count();i++)
+        batch.append(new CacheItemQueue(MapType::GoogleSatellite,tiles[i],images[i],Zoom));
+    QVERIFY(cache.PutImagesToCache(batch));
+    qDeleteAll(batch);
+}
+
+/**
+ * Every tile in a transaction of its own, as the cache queue used to write
+ */
+void tst_TileCache::putOneByOne()
+{
+    int zoom=Zoom+1;
+    QBENCHMARK
+    {
+        // A new zoom each iteration, so every put inserts a new row
+        zoom++;
+        for(int i=0;i<tiles.count();i++)
+            QVERIFY(cache.PutImageToCache(images[i],MapType::GoogleMap,tiles[i],zoom));
+    }
+}
+
+/**
+ * Up to MaxBatch tiles per transaction, as the cache queue writes now
+ */
+void tst_TileCache::putBatched()
+{
+    int zoom=Zoom+1;
+    QList<CacheItemQueue*> batch;
+    QBENCHMARK
+    {
+        zoom++;
+        for(int i=0;i<tiles.count();i++)
+        {
+            batch.append(new CacheItemQueue(MapType::BingMap,tiles[i],images[i],zoom));
+            if(batch.count()==MaxBatch)
+            {
+                QVERIFY(cache.PutImagesToCache(batch));
+                qDeleteAll(batch);
+                batch.clear();
+            }
+        }
+        if(!batch.isEmpty())
+        {
+            QVERIFY(cache.PutImagesToCache(batch));
+            qDeleteAll(batch);
+            batch.clear();
+        }
+    }
+}
+
+void tst_TileCache::sameTilesBack()
+{
+    for(int i=0;i<tiles.count();i++)
+        QCOMPARE(cache.GetImageFromCache(MapType::GoogleSatellite,tiles[i],Zoom),images[i]);
+    QVERIFY(!cache.GetImageFromCache(MapType::GoogleMap,tiles.first(),Zoom+2).isEmpty());
+    QVERIFY(!cache.GetImageFromCache(MapType::BingMap,tiles.last(),Zoom+2).isEmpty());
+    QVERIFY(cache.GetImageFromCache(MapType::GoogleSatellite,Point(0,0),Zoom).isEmpty());
+}
+
+/**
+ * Readers in several threads, each of them with its own connection
+ */
+void tst_TileCache::concurrentReads()
+{
+    QList<Point> lookups=tiles;
+    qsrand(42);
+    for(int i=lookups.count()-1;i>0;i--)
+        lookups.swap(i,qrand()%(i+1));
+
+    QList<Reader*> readers;
+    for(int i=0;i<Readers;i++)
+        readers.append(new Reader(&cache,lookups));
+
+    QElapsedTimer timer;
+    timer.start();
+    foreach(Reader *reader,readers)
+        reader->start();
+    foreach(Reader *reader,readers)
+        QVERIFY(reader->wait(60000));
+    qint64 elapsed=timer.nsecsElapsed();
+
+    qDebug("%d threads read %d tiles each in %.2f ms, %.1f us per tile",
+           Readers,lookups.count(),elapsed/1e6,elapsed/1e3/(Readers*lookups.count()));
+
+    foreach(Reader *reader,readers)
+        QCOMPARE(reader->found,lookups.count());
+    qDeleteAll(readers);
+}
+
+void tst_TileCache::pixmapReused()
+{
+    PixmapCache pixmaps;
+    RawTile tile(MapType::GoogleSatellite,tiles.first(),Zoom);
+    QByteArray img=images.first();
+
+    QPixmap first=pixmaps.Pixmap(tile,img);
+    QCOMPARE(first.size(),QSize(TileSize,TileSize));
+    QPixmap second=pixmaps.Pixmap(tile,img);
+    QCOMPARE(second.cacheKey(),first.cacheKey());
+    QVERIFY(pixmaps.Size()>img.size());
+}
+
+/**
+ * A tile that got reloaded holds other data and is decoded again
+ */
+void tst_TileCache::pixmapDecodedAgain()
+{
+    PixmapCache pixmaps;
+    RawTile tile(MapType::GoogleSatellite,tiles.first(),Zoom);
+
+    QPixmap first=pixmaps.Pixmap(tile,images.first());
+    QByteArray reloaded=images.last();
+    QPixmap second=pixmaps.Pixmap(tile,reloaded);
+    QVERIFY(second.cacheKey()!=first.cacheKey());
+    QCOMPARE(second.toImage(),PureImageProxy::FromStream(reloaded).toImage());
+}
+
+void tst_TileCache::pixmapEviction()
+{
+    PixmapCache pixmaps;
+    RawTile firstTile(MapType::GoogleSatellite,tiles.first(),Zoom);
+    QPixmap first=pixmaps.Pixmap(firstTile,images.first());
+
+    // Room for about a dozen decoded tiles
+    pixmaps.setCapacity(pixmaps.Size()*12);
+    for(int i=1;i<tiles.count();i++)
+    {
+        pixmaps.Pixmap(RawTile(MapType::GoogleSatellite,tiles[i],Zoom),images[i]);
+        QVERIFY(pixmaps.Size()<=pixmaps.Capacity());
+    }
+
+    // The first tile was the least recently used, it has been decoded again
+    QVERIFY(pixmaps.Pixmap(firstTile,images.first()).cacheKey()!=first.cacheKey());
+
+    // The tile just drawn always stays, whatever the capacity
+    pixmaps.setCapacity(0);
+    QVERIFY(pixmaps.Size()>0);
+    pixmaps.Clear();
+    QCOMPARE(pixmaps.Size(),(qint64)0);
+}
+
+/**
+ * Repainting a screen of tiles, decoding them every time as the map used to
+ */
+void tst_TileCache::repaintDecoding()
+{
+    int drawn=0;
+    QBENCHMARK
+    {
+        for(int i=0;i<ScreenTiles;i++)
+            drawn+=!PureImageProxy::FromStream(images[i]).isNull();
+    }
+    QVERIFY(drawn>0);
+}
+
+/**
+ * The same repaints with the decoded pixmaps cached
+ */
+void tst_TileCache::repaintCached()
+{
+    PixmapCache pixmaps;
+    int drawn=0;
+    QBENCHMARK
+    {
+        for(int i=0;i<ScreenTiles;i++)
+            drawn+=!pixmaps.Pixmap(RawTile(MapType::GoogleSatellite,tiles[i],Zoom),images[i]).isNull();
+    }
+    QVERIFY(drawn>0);
+}
+
+QTEST_MAIN(tst_TileCache)
+
+#include "tst_tilecache.moc"
@@ -0,0 +1,18 @@
+# Tile package lookups compared with the SQLite tile cache, run with
+#   ./tst_tilepack
+# or with "-iterations n" to fix the number of benchmark iterations
+QT += sql
+TARGET = tst_tilepack
+
+INCLUDEPATH += ../../core
+
+SOURCES += tst_tilepack.cpp \
+    ../../core/tilepack.cpp \
+    ../../core/pureimagecache.cpp \
+    ../../core/cacheitemqueue.cpp \
+    ../../core/point.cpp \
+    ../../core/size.cpp
+
+HEADERS += ../../core/maptype.h
+
+include(../tlmapbench.pri)
@@ -0,0 +1,204 @@
+/**
+******************************************************************************
+*
+* @file       tst_tilepack.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Tests tile packages and compares their lookups with the tile cache
+* @see        The GNU Public License (GPL) Version 3
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QTemporaryDir>
+#include <QtEndian>
+
+#include "tilepack.h"
+#include "pureimagecache.h"
+
+using namespace core;
+
+// A 64x64 tile area at zoom 14 with images the size of typical satellite tiles
+static const int Zoom=14;
+static const int Side=64;
+static const int ImageSize=16384;
+
+class tst_TilePack : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void quadKey();
+    void sameTilesAsCache();
+    void missingTiles();
+    void invalidPack();
+    void fetchFromCache();
+    void fetchFromPack();
+
+private:
+    QByteArray image(const Point &pos);
+    bool Corrupted(qint64 at,quint64 value);
+    QTemporaryDir dir;
+    PureImageCache cache;
+    TilePack pack;
+    QList<Point> lookups;
+};
+
+QByteArray tst_TilePack::image(const Point &pos)
+{
+    QByteArray img(ImageSize,0);
+    quint32 seed=pos.X()*Side+pos.Y()+1;
+    for(int i=0;i<img.size();i++)
+    {
+        seed=seed*1103515245+12345;
+        img[i]=seed>>16;
+    }
+    return img;
+}
+
+void tst_TilePack::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    cache.setGtileCache(dir.path()+QDir::separator());
+
+    TilePackWriter writer;
+    QVERIFY(writer.Open(dir.path()+"/test.tlpack"));
+
+    Point origin(8000,5000);
+    QList<CacheItemQueue*> batch;
+    for(int x=0;x<Side;x++)
+    {
+        for(int y=0;y<Side;y++)
+        {
+            Point pos(origin.X()+x,origin.Y()+y);
+            QByteArray img=image(pos);
+            batch.append(new CacheItemQueue(MapType::GoogleSatellite,pos,img,Zoom));
+            QVERIFY(writer.Add(MapType::GoogleSatellite,pos,Zoom,img));
+            lookups.append(pos);
+        }
+        QVERIFY(cache.PutImagesToCache(batch));
+        qDeleteAll(batch);
+        batch.clear();
+    }
+    QVERIFY(writer.Finish());
+    QVERIFY(pack.Open(dir.path()+"/test.tlpack"));
+    QCOMPARE(pack.Count(),Side*Side);
+
+    // Panning asks for tiles in no particular order
+    qsrand(42);
+    for(int i=lookups.count()-1;i>0;i--)
+        lookups.swap(i,qrand()%(i+1));
+}
+
+void tst_TilePack::quadKey()
+{
+    // Bing quadkey "3" at zoom 1, "213" at zoom 3
+    QCOMPARE(TilePack::QuadKey(Point(1,1),1),(quint64)(4|3));
+    QCOMPARE(TilePack::QuadKey(Point(3,5),3),(quint64)(64|(2<<4)|(1<<2)|3));
+    QVERIFY(TilePack::QuadKey(Point(0,0),2)>TilePack::QuadKey(Point(1,1),1));
+}
+
+void tst_TilePack::sameTilesAsCache()
+{
+    foreach(Point pos,lookups)
+    {
+        QByteArray img=pack.GetImage(MapType::GoogleSatellite,pos,Zoom);
+        QCOMPARE(img,image(pos));
+        QCOMPARE(img,cache.GetImageFromCache(MapType::GoogleSatellite,pos,Zoom));
+    }
+}
+
+void tst_TilePack::missingTiles()
+{
+    Point pos=lookups.first();
+    QVERIFY(pack.GetImage(MapType::GoogleMap,pos,Zoom).isEmpty());
+    QVERIFY(pack.GetImage(MapType::GoogleSatellite,pos,Zoom+1).isEmpty());
+    QVERIFY(pack.GetImage(MapType::GoogleSatellite,Point(0,0),Zoom).isEmpty());
+    QVERIFY(pack.GetImage(MapType::GoogleSatellite,Point(-1,0),Zoom).isEmpty());
+    QVERIFY(pack.GetImage(MapType::GoogleSatellite,Point(1<<Zoom,0),Zoom).isEmpty());
+}
+
+void tst_TilePack::invalidPack()
+{
+    QString file=dir.path()+"/broken.tlpack";
+    QFile::copy(dir.path()+"/test.tlpack",file);
+    QFile broken(file);
+    QVERIFY(broken.open(QIODevice::ReadWrite));
+    QVERIFY(broken.resize(broken.size()-1));
+    broken.close();
+
+    TilePack truncated;
+    QVERIFY(!truncated.Open(file));
+    QVERIFY(truncated.GetImage(MapType::GoogleSatellite,lookups.first(),Zoom).isEmpty());
+
+    TilePack missing;
+    QVERIFY(!missing.Open(dir.path()+"/missing.tlpack"));
+
+    // Offsets that wrap around when added to a size
+    QVERIFY(!Corrupted(16,Q_UINT64_C(0xfffffffffffffff0)));
+    qint64 indexOffset=QFileInfo(dir.path()+"/test.tlpack").size()-(qint64)pack.Count()*TilePack::EntrySize;
+    QVERIFY(!Corrupted(indexOffset+16,Q_UINT64_C(0xffffffffffffff00)));
+}
+
+/**
+ * Opens a copy of the test package with a 64 bit value overwritten
+ */
+bool tst_TilePack::Corrupted(qint64 at,quint64 value)
+{
+    QString file=dir.path()+"/corrupted.tlpack";
+    QFile::remove(file);
+    QFile::copy(dir.path()+"/test.tlpack",file);
+    QFile corrupted(file);
+    if(!corrupted.open(QIODevice::ReadWrite))
+        return false;
+    uchar bytes[8];
+    qToLittleEndian(value,bytes);
+    corrupted.seek(at);
+    corrupted.write((const char*)bytes,sizeof(bytes));
+    corrupted.close();
+
+    TilePack pack;
+    return pack.Open(file);
+}
+
+void tst_TilePack::fetchFromCache()
+{
+    int found=0;
+    QBENCHMARK
+    {
+        foreach(Point pos,lookups)
+            found+=!cache.GetImageFromCache(MapType::GoogleSatellite,pos,Zoom).isEmpty();
+    }
+    QVERIFY(found>0);
+}
+
+void tst_TilePack::fetchFromPack()
+{
+    int found=0;
+    QBENCHMARK
+    {
+        foreach(Point pos,lookups)
+            found+=!pack.GetImage(MapType::GoogleSatellite,pos,Zoom).isEmpty();
+    }
+    QVERIFY(found>0);
+}
+
+QTEST_MAIN(tst_TilePack)
+
+#include "tst_tilepack.moc"
@@ -0,0 +1,6 @@
+# Shared settings of the map control benchmarks, which build the map sources
+# they test straight into the test app
+CONFIG += qtestlib
+TEMPLATE = app
+CONFIG -= app_bundle
+DEFINES += TLMAPWIDGET_LIBRARY
@@ -0,0 +1,15 @@
+# Trail reduction and the frame time of a trail over an hour long flight, run with
+#   ./tst_trailpath
+# sceneFrameTime compares the trail item with the item per trail point the map
+# used to have, both rendered through a graphics scene
+QT += widgets
+TARGET = tst_trailpath
+
+INCLUDEPATH += ../../mapwidget
+
+SOURCES += tst_trailpath.cpp \
+    ../../mapwidget/trailpath.cpp \
+    ../../internals/pointlatlng.cpp \
+    ../../internals/sizelatlng.cpp
+
+include(../tlmapbench.pri)
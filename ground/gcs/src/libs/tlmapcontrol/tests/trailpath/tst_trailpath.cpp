@@ -0,0 +1,260 @@
+/**
+******************************************************************************
+*
+* @file       tst_trailpath.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Tests the trail reduction and times drawing a long trail
+* @see        The GNU Public License (GPL) Version 3
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QImage>
+#include <QPainter>
+#include <QGraphicsScene>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsLineItem>
+#include <QtCore/qmath.h>
+
+#include "trailpath.h"
+
+using namespace mapcontrol;
+
+// Trail points of a flight at 10 Hz, as with a trail time that short
+static const int Rate=10;
+
+/**
+ * Draws a trail as one scene item, the way TrailPathItem does
+ */
+class TrailDrawing : public QGraphicsItem
+{
+public:
+    TrailDrawing(TrailPath const& trail):trail(trail){}
+    TrailPath const& trail;
+    QRectF boundingRect() const
+    {
+        return trail.Path().boundingRect().adjusted(-3,-3,3,3);
+    }
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+    {
+        Q_UNUSED(option);
+        Q_UNUSED(widget);
+        painter->setPen(Qt::red);
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPath(trail.Path());
+        painter->setPen(Qt::black);
+        painter->setBrush(Qt::green);
+        foreach(int i,trail.Vertices())
+            painter->drawEllipse(trail.Pixel(i),2,2);
+    }
+};
+
+class tst_TrailPath : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void boundedByBudget();
+    void withinTolerance();
+    void fewerPointsZoomedOut();
+    void frameTime_data();
+    void frameTime();
+    void sceneFrameTime_data();
+    void sceneFrameTime();
+
+private:
+    QPointF flight(int const& i);
+    void replay(TrailPath &trail,int const& minutes);
+    qreal distanceToLine(TrailPath const& trail,QPointF const& p);
+    void draw(TrailPath const& trail,QImage &image);
+};
+
+/**
+ * Circles drifting over the map with some noise, like a survey or loiter
+ */
+QPointF tst_TrailPath::flight(int const& i)
+{
+    qreal t=i/(qreal)Rate;
+    qreal noise=((i*7919)%13)/13.0-0.5;
+    return QPointF(200*qCos(t/20)+t/10+noise, 150*qSin(t/15)+noise);
+}
+
+void tst_TrailPath::replay(TrailPath &trail,int const& minutes)
+{
+    for(int i=0;i<minutes*60*Rate;i++)
+    {
+        TrailSample sample;
+        sample.altitude=100;
+        sample.time=i*1000/Rate;
+        trail.Append(sample,flight(i));
+    }
+}
+
+qreal tst_TrailPath::distanceToLine(TrailPath const& trail,QPointF const& p)
+{
+    const QVector<int> &v=trail.Vertices();
+    QLineF toFirst(p,trail.Pixel(v.first()));
+    qreal best=toFirst.length();
+    for(int i=0;i+1<v.count();i++)
+    {
+        QPointF a=trail.Pixel(v.at(i));
+        QPointF ab=trail.Pixel(v.at(i+1))-a;
+        qreal length2=QPointF::dotProduct(ab,ab);
+        qreal t=length2>0?qBound((qreal)0,QPointF::dotProduct(p-a,ab)/length2,(qreal)1):0;
+        best=qMin(best,QLineF(p,a+t*ab).length());
+    }
+    return best;
+}
+
+void tst_TrailPath::draw(TrailPath const& trail,QImage &image)
+{
+    QPainter painter(&image);
+    painter.translate(image.width()/2,image.height()/2);
+    painter.setPen(Qt::red);
+    painter.drawPath(trail.Path());
+    painter.setPen(Qt::black);
+    painter.setBrush(Qt::green);
+    foreach(int i,trail.Vertices())
+        painter.drawEllipse(trail.Pixel(i),2,2);
+}
+
+void tst_TrailPath::boundedByBudget()
+{
+    TrailPath trail;
+    trail.SetBudget(1000);
+    replay(trail,10);
+    QCOMPARE(trail.Count(),1000);
+    QVERIFY(trail.Vertices().count()<trail.Count());
+
+    // The newest samples are kept and the line ends at the newest one
+    QCOMPARE(trail.Sample(trail.Count()-1).time,(qint64)(10*60*Rate-1)*1000/Rate);
+    QCOMPARE(trail.Vertices().first(),0);
+    QCOMPARE(trail.Vertices().last(),trail.Count()-1);
+
+    trail.SetBudget(100);
+    QCOMPARE(trail.Count(),100);
+    QCOMPARE(trail.Sample(99).time,(qint64)(10*60*Rate-1)*1000/Rate);
+
+    trail.Clear();
+    QCOMPARE(trail.Count(),0);
+    QVERIFY(trail.Vertices().isEmpty());
+}
+
+void tst_TrailPath::withinTolerance()
+{
+    TrailPath trail;
+    replay(trail,10);
+    for(int i=0;i<trail.Count();i++)
+        QVERIFY(distanceToLine(trail,trail.Pixel(i))<=trail.Tolerance()+1e-6);
+}
+
+void tst_TrailPath::fewerPointsZoomedOut()
+{
+    TrailPath trail;
+    replay(trail,10);
+    int vertices=trail.Vertices().count();
+
+    QVector<QPointF> pixels(trail.Count());
+    for(int i=0;i<trail.Count();i++)
+        pixels[i]=trail.Pixel(i)/8;
+    trail.SetPixels(pixels);
+    QVERIFY(trail.Vertices().count()<vertices/2);
+}
+
+void tst_TrailPath::frameTime_data()
+{
+    QTest::addColumn<int>("minutes");
+    QTest::newRow("1 min")<<1;
+    QTest::newRow("10 min")<<10;
+    QTest::newRow("60 min")<<60;
+}
+
+/**
+ * Drawing the trail takes as long after an hour as after ten minutes
+ */
+void tst_TrailPath::frameTime()
+{
+    QFETCH(int,minutes);
+    TrailPath trail;
+    replay(trail,minutes);
+    QVERIFY(trail.Count()<=trail.Budget());
+    qDebug()<<trail.Count()<<"points,"<<trail.Vertices().count()<<"drawn";
+
+    QImage image(1024,768,QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK
+    {
+        draw(trail,image);
+    }
+}
+
+void tst_TrailPath::sceneFrameTime_data()
+{
+    QTest::addColumn<int>("minutes");
+    QTest::addColumn<bool>("itemPerPoint");
+    QTest::newRow("1 min, item per point")<<1<<true;
+    QTest::newRow("1 min, trail item")<<1<<false;
+    QTest::newRow("10 min, item per point")<<10<<true;
+    QTest::newRow("10 min, trail item")<<10<<false;
+    QTest::newRow("60 min, item per point")<<60<<true;
+    QTest::newRow("60 min, trail item")<<60<<false;
+}
+
+/**
+ * Rendering the map scene with the trail in it, with a dot and a line item
+ * for every trail point as the map used to, or with the one trail item
+ */
+void tst_TrailPath::sceneFrameTime()
+{
+    QFETCH(int,minutes);
+    QFETCH(bool,itemPerPoint);
+
+    QGraphicsScene scene;
+    TrailPath trail;
+    if(itemPerPoint)
+    {
+        QPointF last;
+        for(int i=0;i<minutes*60*Rate;i++)
+        {
+            QPointF pixel=flight(i);
+            QGraphicsEllipseItem *point=scene.addEllipse(-2,-2,4,4,QPen(Qt::black),Qt::green);
+            point->setPos(pixel);
+            if(i>0)
+                scene.addLine(QLineF(last,pixel),QPen(Qt::red));
+            last=pixel;
+        }
+    }
+    else
+    {
+        replay(trail,minutes);
+        scene.addItem(new TrailDrawing(trail));
+    }
+    qDebug()<<scene.items().count()<<"items";
+
+    QImage image(1024,768,QImage::Format_ARGB32_Premultiplied);
+    QRectF view(-512,-384,1024,768);
+    QBENCHMARK
+    {
+        QPainter painter(&image);
+        scene.render(&painter,QRectF(image.rect()),view);
+    }
+}
+
+QTEST_MAIN(tst_TrailPath)
+
+#include "tst_trailpath.moc"
@@ -9,17 +9,19 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     mapwidget/waypointitem.cpp \
     mapwidget/uavitem.cpp \
     mapwidget/gpsitem.cpp \
-    mapwidget/trailitem.cpp \
+    mapwidget/trailpath.cpp \
+    mapwidget/trailpathitem.cpp \
     mapwidget/homeitem.cpp \
     mapwidget/mapripform.cpp \
     mapwidget/mapripper.cpp \
-    mapwidget/traillineitem.cpp \
     mapwidget/mapline.cpp \
     mapwidget/mapcircle.cpp \
     mapwidget/waypointcurve.cpp \
     mapwidget/tlmapwidget.cpp \
     core/pureimagecache.cpp \
     core/pureimage.cpp \
+    core/pixmapcache.cpp \
+    core/tilepack.cpp \
     core/rawtile.cpp \
     core/memorycache.cpp \
     core/cache.cpp \
@@ -61,11 +63,11 @@ HEADERS += mapwidget/mapgraphicitem.h \
     mapwidget/gpsitem.h \
     mapwidget/uavmapfollowtype.h \
     mapwidget/uavtrailtype.h \
-    mapwidget/trailitem.h \
+    mapwidget/trailpath.h \
+    mapwidget/trailpathitem.h \
     mapwidget/homeitem.h \
     mapwidget/mapripform.h \
     mapwidget/mapripper.h \
-    mapwidget/traillineitem.h \
     mapwidget/mapline.h \
     mapwidget/mapcircle.h \
     mapwidget/waypointcurve.h \
@@ -74,6 +76,8 @@ HEADERS += mapwidget/mapgraphicitem.h \
     core/maptype.h \
     core/pureimagecache.h \
     core/pureimage.h \
+    core/pixmapcache.h \
+    core/tilepack.h \
     core/rawtile.h \
     core/memorycache.h \
     core/cache.h \
@@ -54,7 +54,8 @@ public:
             m_classId(classId),
             m_name(name),
             m_icon(QIcon()),
-            m_singleConfigurationGadget(false) {}
+            m_singleConfigurationGadget(false),
+            m_initialized(false) {}
     virtual ~IUAVGadgetFactory() {}
 
     virtual IUAVGadget *createGadget(QWidget *parent) = 0;
@@ -65,7 +66,12 @@ public:
     QString name() const { return m_name; }
     QIcon icon() const { return m_icon; }
     bool isSingleConfigurationGadget() { return m_singleConfigurationGadget; }
+    bool isInitialized() const { return m_initialized; }
+    void ensureInitialized() { if (!m_initialized) { m_initialized = true; initialize(); } }
 protected:
+    // Sets up what only the gadgets need, called once before the first
+    // gadget is created rather than while the plugins load
+    virtual void initialize() {}
     void setIcon(QIcon icon) { m_icon = icon; }
     void setSingleConfigurationGadgetTrue() { m_singleConfigurationGadget = true; }
 private:
@@ -73,6 +79,7 @@ private:
     QString m_name; // display name, should also be unique
     QIcon m_icon;
     bool m_singleConfigurationGadget; // true if there is exactly one configuration for this gadget
+    bool m_initialized; // true once initialize() ran
 };
 
 } // namespace Core
@@ -37,6 +37,7 @@
 #include "icore.h"
 
 #include <extensionsystem/pluginmanager.h>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QStringList>
 #include <QtCore/QSettings>
 #include <QtCore/QDebug>
@@ -272,7 +273,15 @@ IUAVGadget *UAVGadgetInstanceManager::createGadget(QString classId, QWidget *par
         else
             emit splashMessages(tr("Loading EmptyGadget"));
         QList<IUAVGadgetConfiguration*> *configs = configurations(classId);
+        QElapsedTimer timer;
+        timer.start();
+        if (!f->isInitialized()) {
+            f->ensureInitialized();
+            m_pm->profilingReport(QString("Initializing %1 factory").arg(f->classId()), timer.nsecsElapsed() / 1000);
+            timer.restart();
+        }
         IUAVGadget *g = f->createGadget(parent);
+        m_pm->profilingReport(QString("Creating %1 gadget").arg(f->classId()), timer.nsecsElapsed() / 1000);
         IUAVGadget *gadget = new UAVGadgetDecorator(g, configs, forceLoadConfiguration);
         m_gadgetInstances.append(gadget);
         connect(this, SIGNAL(configurationAdded(IUAVGadgetConfiguration*)), gadget, SLOT(configurationAdded(IUAVGadgetConfiguration*)));
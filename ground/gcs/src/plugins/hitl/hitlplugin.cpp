@@ -33,6 +33,7 @@
 #include "aerosimrcsimulator.h"
 #include "fgsimulator.h"
 #include "il2simulator.h"
+#include "silsimulator.h"
 #include "xplanesimulator.h"
 
 QList<SimulatorCreator* > HITLPlugin::typeSimulators;
@@ -58,6 +59,7 @@ bool HITLPlugin::initialize(const QStringList& args, QString *errMsg)
    addSimulator(new AeroSimRCSimulatorCreator("ASimRC", "AeroSimRC"));
    addSimulator(new FGSimulatorCreator("FG","FlightGear"));
    addSimulator(new IL2SimulatorCreator("IL2","IL2"));
+   addSimulator(new SILSimulatorCreator("SIL","Simulation target (lockstep SIL)"));
    addSimulator(new XplaneSimulatorCreator("X-Plane","X-Plane"));
 
    return true;
@@ -17,6 +17,7 @@ HEADERS += hitlplugin.h \
     aerosimrcsimulator.h \
     fgsimulator.h \
     il2simulator.h \
+    silsimulator.h \
     xplanesimulator.h
 SOURCES += hitlplugin.cpp \
     hitlwidget.cpp \
@@ -29,6 +30,7 @@ SOURCES += hitlplugin.cpp \
     aerosimrcsimulator.cpp \
     fgsimulator.cpp \
     il2simulator.cpp \
+    silsimulator.cpp \
     xplanesimulator.cpp
 OTHER_FILES += hitl.pluginspec \
                 hitl.json
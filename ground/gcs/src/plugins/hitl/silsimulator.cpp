@@ -0,0 +1,353 @@
+/**
+ ******************************************************************************
+ *
+ * @file       silsimulator.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup HITLPlugin HITL Plugin
+ * @{
+ * @brief Lockstep software in the loop link to the posix simulation target
+ *
+ * The simulation target is started with -s <port> and takes its sensors from
+ * this backend instead of its built in models. Each step the model here sends
+ * one sensor frame and only advances once the flight code answered with the
+ * actuators it computed from it, see sil_protocol.h. There is no timer in the
+ * loop, so a run is reproducible and goes as fast as both sides can compute.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "silsimulator.h"
+#include <QHostAddress>
+#include <string.h>
+
+namespace {
+const float MaxThrust = GRAVITY * 2;   // [m/s^2]
+const float ControlScaling = 500.0f;   // [deg/s] at full ActuatorDesired
+const float ActuatorTau = 0.02f;       // [s]
+const float Friction = 1.0f;           // [1/s]
+const float EarthRadius = 6.378137e6f; // [m]
+
+const quint32 MagPeriodUs = 1000000 / 75;
+const quint32 BaroPeriodUs = 1000000 / 20;
+const quint32 GpsPeriodUs = 1000000 / 10;
+}
+
+SILModel::SILModel() :
+    homeLatitude(0),
+    homeLongitude(0),
+    homeAltitude(0),
+    gauss(0.0f, 1.0f)
+{
+    be[0] = 100;
+    be[1] = 0;
+    be[2] = 400;
+    reset(false);
+}
+
+/**
+ * @brief SILModel::reset Puts the vehicle level on the ground at home and
+ * restarts the noise sequence, so every run sees the same noise
+ */
+void SILModel::reset(bool withNoise)
+{
+    memset(pos, 0, sizeof(pos));
+    memset(vel, 0, sizeof(vel));
+    memset(rates, 0, sizeof(rates));
+    accel[0] = 0;
+    accel[1] = 0;
+    accel[2] = -GRAVITY;
+    q[0] = 1;
+    q[1] = 0;
+    q[2] = 0;
+    q[3] = 0;
+
+    addNoise = withNoise;
+    rng.seed(1);
+    gauss.reset();
+
+    magTime = 0;
+    baroTime = 0;
+    gpsTime = 0;
+}
+
+void SILModel::setHome(double latitude, double longitude, float altitude, const float field[3])
+{
+    homeLatitude = latitude;
+    homeLongitude = longitude;
+    homeAltitude = altitude;
+    if (field[0] != 0 || field[1] != 0 || field[2] != 0)
+        memcpy(be, field, sizeof(be));
+}
+
+float SILModel::noise(float sigma)
+{
+    return addNoise ? sigma * gauss(rng) : 0;
+}
+
+/**
+ * @brief SILModel::step Advances the vehicle by dT with the outputs of the
+ * flight code
+ */
+void SILModel::step(const sil_actuator_frame &actuators, float dT)
+{
+    float thrust = actuators.armed ? actuators.throttle * MaxThrust : 0;
+    if (!(thrust > 0))
+        thrust = 0;
+
+    const float desired[3] = { actuators.roll, actuators.pitch, actuators.yaw };
+    const float alpha = expf(-dT / ActuatorTau);
+    for (int i = 0; i < 3; i++)
+        rates[i] = ControlScaling * desired[i] * (1 - alpha) + rates[i] * alpha;
+
+    // Integrate the attitude
+    float qdot[4];
+    qdot[0] = (-q[1] * rates[0] - q[2] * rates[1] - q[3] * rates[2]) * dT * DEG2RAD / 2;
+    qdot[1] = (q[0] * rates[0] - q[3] * rates[1] + q[2] * rates[2]) * dT * DEG2RAD / 2;
+    qdot[2] = (q[3] * rates[0] + q[0] * rates[1] - q[1] * rates[2]) * dT * DEG2RAD / 2;
+    qdot[3] = (-q[2] * rates[0] + q[1] * rates[1] + q[0] * rates[2]) * dT * DEG2RAD / 2;
+
+    float qmag = 0;
+    for (int i = 0; i < 4; i++) {
+        q[i] += qdot[i];
+        qmag += q[i] * q[i];
+    }
+    qmag = sqrtf(qmag);
+    for (int i = 0; i < 4; i++)
+        q[i] /= qmag;
+
+    // Third row of the rotation from earth to body, the body z axis in NED
+    const float bodyZ[3] = {
+        2 * (q[1] * q[3] + q[0] * q[2]),
+        2 * (q[2] * q[3] - q[0] * q[1]),
+        q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]
+    };
+
+    float nedAccel[3];
+    for (int i = 0; i < 3; i++)
+        nedAccel[i] = -thrust * bodyZ[i] - Friction * vel[i];
+    nedAccel[2] += GRAVITY;
+
+    for (int i = 0; i < 3; i++) {
+        vel[i] += nedAccel[i] * dT;
+        pos[i] += vel[i] * dT;
+    }
+
+    // Standing on the ground
+    if (pos[2] > 0) {
+        pos[2] = 0;
+        vel[2] = 0;
+        nedAccel[2] = 0;
+    }
+
+    // Accelerometers feel the acceleration less gravity
+    accel[0] = nedAccel[0];
+    accel[1] = nedAccel[1];
+    accel[2] = nedAccel[2] - GRAVITY;
+}
+
+/**
+ * @brief SILModel::sensors Samples the sensors at the current state
+ * @param frame Frame to fill, the header is left alone
+ * @param timeUs Simulation time of the sample
+ * @param dtUs Time since the previous sample
+ */
+void SILModel::sensors(sil_sensor_frame &frame, quint32 timeUs, quint32 dtUs)
+{
+    float Rbe[3][3];
+    Rbe[0][0] = q[0] * q[0] + q[1] * q[1] - q[2] * q[2] - q[3] * q[3];
+    Rbe[0][1] = 2 * (q[1] * q[2] + q[0] * q[3]);
+    Rbe[0][2] = 2 * (q[1] * q[3] - q[0] * q[2]);
+    Rbe[1][0] = 2 * (q[1] * q[2] - q[0] * q[3]);
+    Rbe[1][1] = q[0] * q[0] - q[1] * q[1] + q[2] * q[2] - q[3] * q[3];
+    Rbe[1][2] = 2 * (q[2] * q[3] + q[0] * q[1]);
+    Rbe[2][0] = 2 * (q[1] * q[3] + q[0] * q[2]);
+    Rbe[2][1] = 2 * (q[2] * q[3] - q[0] * q[1]);
+    Rbe[2][2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+
+    frame.time_us = timeUs;
+    frame.dt_us = dtUs;
+    frame.updated = 0;
+
+    for (int i = 0; i < 3; i++) {
+        frame.gyro[i] = rates[i] + noise(1.0f);
+        frame.accel[i] = Rbe[i][0] * accel[0] + Rbe[i][1] * accel[1] + Rbe[i][2] * accel[2] + noise(0.1f);
+        frame.mag[i] = Rbe[i][0] * be[0] + Rbe[i][1] * be[1] + Rbe[i][2] * be[2];
+        frame.velocity[i] = vel[i];
+    }
+
+    frame.baro_altitude = homeAltitude - pos[2] + noise(0.1f);
+    frame.airspeed = sqrtf(vel[0] * vel[0] + vel[1] * vel[1] + vel[2] * vel[2]);
+
+    double latitude = homeLatitude + pos[0] / EarthRadius * RAD2DEG;
+    double longitude = homeLongitude + pos[1] / (EarthRadius * cos(homeLatitude * DEG2RAD)) * RAD2DEG;
+    frame.latitude = qRound(latitude * 1e7);
+    frame.longitude = qRound(longitude * 1e7);
+    frame.altitude = homeAltitude - pos[2];
+
+    // The slower sensors are due once their period passed
+    if (timeUs - magTime >= MagPeriodUs || timeUs == 0) {
+        frame.updated |= SIL_UPDATED_MAG;
+        magTime = timeUs;
+    }
+    if (timeUs - baroTime >= BaroPeriodUs || timeUs == 0) {
+        frame.updated |= SIL_UPDATED_BARO | SIL_UPDATED_AIRSPEED;
+        baroTime = timeUs;
+    }
+    if (timeUs - gpsTime >= GpsPeriodUs || timeUs == 0) {
+        frame.updated |= SIL_UPDATED_GPS;
+        gpsTime = timeUs;
+    }
+}
+
+SILSimulator::SILSimulator(const SimulatorSettings& params) :
+    Simulator(params),
+    socket(NULL),
+    address(params.remoteAddress),
+    port(params.outPort > 0 ? params.outPort : SIL_DEFAULT_PORT),
+    step(0),
+    timeUs(0)
+{
+}
+
+SILSimulator::~SILSimulator()
+{
+    if (socket) {
+        socket->disconnect(this);
+        delete socket;
+        socket = NULL;
+    }
+}
+
+/**
+ * @brief SILSimulator::setupUdpPorts Opens the SIL link instead of the UDP
+ * ports, it connects to the remote address and output port
+ */
+void SILSimulator::setupUdpPorts(const QString& host, int inPort, int outPort)
+{
+    Q_UNUSED(host);
+    Q_UNUSED(inPort);
+    Q_UNUSED(outPort);
+
+    socket = new QTcpSocket();
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, SIGNAL(connected()), this, SLOT(onConnected()), Qt::DirectConnection);
+    connect(socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()), Qt::DirectConnection);
+    connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()), Qt::DirectConnection);
+}
+
+bool SILSimulator::setupProcess()
+{
+    QMutexLocker locker(&lock);
+
+    if (!settings.startSim) {
+        emit processOutput("Start the simulation target with -s " + QString::number(port) +
+                           " on " + address + "\n");
+        return true;
+    }
+
+    simProcess = new QProcess();
+    simProcess->setProcessChannelMode(QProcess::MergedChannels);
+    connect(simProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(processReadyRead()));
+
+    simProcess->start(settings.binPath, QStringList() << "-s" << QString::number(port));
+    if (!simProcess->waitForStarted()) {
+        emit processOutput("Error:" + simProcess->errorString());
+        return false;
+    }
+
+    return true;
+}
+
+void SILSimulator::processReadyRead()
+{
+    emit processOutput(QString(simProcess->readAllStandardOutput()));
+}
+
+/**
+ * @brief SILSimulator::transmitUpdate Keeps trying to connect to the simulation
+ * target. The steps themselves are driven by the answers from the target.
+ */
+void SILSimulator::transmitUpdate()
+{
+    if (socket && socket->state() == QAbstractSocket::UnconnectedState)
+        socket->connectToHost(address, port);
+}
+
+void SILSimulator::onConnected()
+{
+    emit processOutput("SIL link to " + address + ":" + QString::number(port) + " connected\n");
+
+    HomeLocation::DataFields home = posHome->getData();
+    model.setHome(home.Latitude / 1e7, home.Longitude / 1e7, home.Altitude, home.Be);
+    model.reset(settings.addNoise);
+
+    step = 0;
+    timeUs = 0;
+    received.clear();
+    sendSensors();
+}
+
+void SILSimulator::onDisconnected()
+{
+    emit processOutput("SIL link closed after " + QString::number(step) + " steps\n");
+}
+
+void SILSimulator::onReadyRead()
+{
+    received.append(socket->readAll());
+
+    while (received.size() >= (int)sizeof(sil_actuator_frame)) {
+        processUpdate(received.left(sizeof(sil_actuator_frame)));
+        received.remove(0, sizeof(sil_actuator_frame));
+    }
+}
+
+/**
+ * @brief SILSimulator::processUpdate Completes a step with the actuators the
+ * flight code answered and starts the next one
+ */
+void SILSimulator::processUpdate(const QByteArray& data)
+{
+    sil_actuator_frame actuators;
+    memcpy(&actuators, data.constData(), sizeof(actuators));
+
+    if (!sil_header_valid(&actuators.header, SIL_FRAME_ACTUATORS, sizeof(actuators)) ||
+            actuators.header.step != step) {
+        emit processOutput("SIL link out of step, reconnecting\n");
+        socket->abort();
+        return;
+    }
+
+    simulatorResponded();
+
+    model.step(actuators, StepUs * 1e-6f);
+    step++;
+    timeUs += StepUs;
+    sendSensors();
+}
+
+void SILSimulator::sendSensors()
+{
+    sil_sensor_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    sil_header_init(&frame.header, SIL_FRAME_SENSORS, sizeof(frame), step);
+    model.sensors(frame, timeUs, step ? StepUs : 0);
+
+    socket->write((const char *) &frame, sizeof(frame));
+}
@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ *
+ * @file       silsimulator.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup HITLPlugin HITL Plugin
+ * @{
+ * @brief Lockstep software in the loop link to the posix simulation target
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SILSIMULATOR_H
+#define SILSIMULATOR_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <random>
+#include "simulator.h"
+#include "sil_protocol.h"
+
+/**
+ * Multirotor model stepped by the SIL link, the same simple dynamics the
+ * simulation target uses when it runs without a link: ActuatorDesired sets
+ * the body rates through a first order lag, thrust acts along the body z
+ * axis against gravity and a linear drag.
+ */
+class SILModel
+{
+public:
+    SILModel();
+
+    void reset(bool withNoise);
+    void setHome(double latitude, double longitude, float altitude, const float be[3]);
+    void step(const sil_actuator_frame &actuators, float dT);
+    void sensors(sil_sensor_frame &frame, quint32 timeUs, quint32 dtUs);
+
+private:
+    float noise(float sigma);
+
+    double homeLatitude;
+    double homeLongitude;
+    float homeAltitude;
+    float be[3];
+
+    float pos[3];      // [m] NED from home
+    float vel[3];      // [m/s] NED
+    float accel[3];    // [m/s^2] specific force, NED
+    float q[4];
+    float rates[3];    // [deg/s] body
+
+    bool addNoise;
+    std::minstd_rand rng;
+    std::normal_distribution<float> gauss;
+
+    quint32 magTime;
+    quint32 baroTime;
+    quint32 gpsTime;
+};
+
+class SILSimulator: public Simulator
+{
+    Q_OBJECT
+
+public:
+    SILSimulator(const SimulatorSettings& params);
+    ~SILSimulator();
+
+    bool setupProcess();
+    void setupUdpPorts(const QString& host, int inPort, int outPort);
+
+private slots:
+    void transmitUpdate();
+    void onConnected();
+    void onDisconnected();
+    void onReadyRead();
+    void processReadyRead();
+
+private:
+    //! Length of a simulation step, the sensor period of the simulation target
+    static const quint32 StepUs = 2000;
+
+    void processUpdate(const QByteArray& data);
+    void sendSensors();
+
+    QTcpSocket* socket;
+    QString address;
+    quint16 port;
+    QByteArray received;
+
+    SILModel model;
+    quint32 step;
+    quint32 timeUs;
+};
+
+class SILSimulatorCreator : public SimulatorCreator
+{
+public:
+    SILSimulatorCreator(const QString& classId, const QString& description)
+        : SimulatorCreator (classId, description)
+    {}
+
+    Simulator* createSimulator(const SimulatorSettings& params)
+    {
+        return new SILSimulator(params);
+    }
+};
+
+#endif // SILSIMULATOR_H
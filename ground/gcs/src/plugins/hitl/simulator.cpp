@@ -204,9 +204,12 @@ void Simulator::onStart()
 
 }
 
-void Simulator::receiveUpdate()
+/**
+ * @brief Simulator::simulatorResponded Restarts the simulator connection
+ * timeout and reports the simulator as connected
+ */
+void Simulator::simulatorResponded()
 {
-	// Update connection timer and status
 	simTimer->setInterval(simTimeout);
 	simTimer->stop();
 	simTimer->start();
@@ -215,6 +218,12 @@ void Simulator::receiveUpdate()
 		simConnectionStatus = true;
 		emit simulatorConnected();
 	}
+}
+
+void Simulator::receiveUpdate()
+{
+	// Update connection timer and status
+	simulatorResponded();
 
 	// Process data
         while(inSocket->hasPendingDatagrams()) {
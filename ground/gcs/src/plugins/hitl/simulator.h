@@ -273,6 +273,8 @@ private slots:
     virtual void processUpdate(const QByteArray& data) = 0;
 
 protected:
+    void simulatorResponded();
+
     QProcess* simProcess;
     QTime* time;
     QUdpSocket* inSocket;//(new QUdpSocket());
@@ -0,0 +1,18 @@
+TEMPLATE = lib
+TARGET = LatencyProfilerGadget
+QT += widgets
+include(../../taulabsgcsplugin.pri)
+include(../../plugins/coreplugin/coreplugin.pri)
+include(../../plugins/uavobjects/uavobjects.pri)
+
+HEADERS += latencyprofilerplugin.h
+HEADERS += latencyprofilergadget.h
+HEADERS += latencyprofilergadgetwidget.h
+HEADERS += latencyprofilergadgetfactory.h
+SOURCES += latencyprofilerplugin.cpp
+SOURCES += latencyprofilergadget.cpp
+SOURCES += latencyprofilergadgetfactory.cpp
+SOURCES += latencyprofilergadgetwidget.cpp
+
+OTHER_FILES += LatencyProfilerGadget.pluginspec \
+                LatencyProfilerGadget.json
@@ -0,0 +1,39 @@
+/**
+ ******************************************************************************
+ *
+ * @file       latencyprofilergadget.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LatencyProfilerPlugin Latency Profiler Plugin
+ * @{
+ * @brief Shows the control path latency histograms reported by LatencyStats
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "latencyprofilergadget.h"
+#include "latencyprofilergadgetwidget.h"
+
+LatencyProfilerGadget::LatencyProfilerGadget(QString classId, LatencyProfilerGadgetWidget *widget, QWidget *parent) :
+        IUAVGadget(classId, parent),
+        m_widget(widget)
+{
+}
+
+LatencyProfilerGadget::~LatencyProfilerGadget()
+{
+    delete m_widget;
+}
@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ *
+ * @file       latencyprofilergadgetwidget.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LatencyProfilerPlugin Latency Profiler Plugin
+ * @{
+ * @brief Shows the control path latency histograms reported by LatencyStats
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "latencyprofilergadgetwidget.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "latencystats.h"
+
+#include <QPainter>
+#include <QFontMetrics>
+
+LatencyProfilerGadgetWidget::LatencyProfilerGadgetWidget(QWidget *parent) : QWidget(parent)
+{
+    setMinimumSize(128, 64);
+    setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    latencyStats = LatencyStats::GetInstance(objManager);
+    Q_ASSERT(latencyStats);
+
+    // All fields share the same element names, one per stage
+    QStringList names = latencyStats->getField("P50")->getElementNames();
+    foreach (const QString &name, names) {
+        StageStats stage = { name, 0, 0, 0, 0 };
+        stages.append(stage);
+    }
+
+    connect(latencyStats, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateStats(UAVObject*)));
+
+    setToolTip(tr("Median, 99th percentile and maximum latency of each control path stage.\n"
+                  "Requires firmware built with DIAG_LATENCY=YES."));
+}
+
+LatencyProfilerGadgetWidget::~LatencyProfilerGadgetWidget()
+{
+    // Do nothing
+}
+
+void LatencyProfilerGadgetWidget::updateStats(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+
+    LatencyStats::DataFields data = latencyStats->getData();
+    for (int i = 0; i < stages.size() && i < (int) LatencyStats::P50_NUMELEM; i++) {
+        stages[i].p50 = data.P50[i];
+        stages[i].p99 = data.P99[i];
+        stages[i].max = data.Max[i];
+        stages[i].samples = data.Samples[i];
+    }
+
+    update();
+}
+
+void LatencyProfilerGadgetWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    if (stages.isEmpty())
+        return;
+
+    QFontMetrics fm(painter.font());
+    int labelWidth = 0;
+    foreach (const StageStats &stage, stages)
+        labelWidth = qMax(labelWidth, fm.width(stage.name));
+    labelWidth += 8;
+
+    const int valueWidth = fm.width("00000 / 00000 / 00000 us (00000)") + 8;
+    const int barWidth = qMax(width() - labelWidth - valueWidth, 16);
+    const int rowHeight = height() / stages.size();
+
+    // All stages share one scale so they can be compared against each other
+    quint16 scale = 1;
+    foreach (const StageStats &stage, stages)
+        scale = qMax(scale, stage.max);
+
+    for (int i = 0; i < stages.size(); i++) {
+        const StageStats &stage = stages[i];
+        const int top = i * rowHeight;
+        const int barHeight = qMax(rowHeight - 6, 2);
+        QRect labelRect(0, top, labelWidth, rowHeight);
+        QRect valueRect(labelWidth + barWidth + 8, top, valueWidth, rowHeight);
+
+        painter.setPen(palette().color(QPalette::WindowText));
+        painter.drawText(labelRect, Qt::AlignVCenter | Qt::AlignLeft, stage.name);
+
+        if (stage.samples == 0) {
+            painter.drawText(valueRect, Qt::AlignVCenter | Qt::AlignLeft, tr("no data"));
+            continue;
+        }
+
+        const int p50 = barWidth * stage.p50 / scale;
+        const int p99 = barWidth * stage.p99 / scale;
+        const int max = barWidth * stage.max / scale;
+
+        painter.fillRect(labelWidth, top + 3, p99, barHeight, QColor(120, 170, 230));
+        painter.fillRect(labelWidth, top + 3, p50, barHeight, QColor(30, 90, 180));
+        painter.setPen(QPen(Qt::red, 2));
+        painter.drawLine(labelWidth + max, top + 1, labelWidth + max, top + rowHeight - 1);
+
+        painter.setPen(palette().color(QPalette::WindowText));
+        painter.drawText(valueRect, Qt::AlignVCenter | Qt::AlignLeft,
+                         QString("%1 / %2 / %3 us (%4)")
+                         .arg(stage.p50).arg(stage.p99).arg(stage.max).arg(stage.samples));
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ *
+ * @file       latencyprofilergadgetwidget.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup LatencyProfilerPlugin Latency Profiler Plugin
+ * @{
+ * @brief Shows the control path latency histograms reported by LatencyStats
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LATENCYPROFILERGADGETWIDGET_H_
+#define LATENCYPROFILERGADGETWIDGET_H_
+
+#include "uavobject.h"
+#include <QWidget>
+#include <QVector>
+
+class LatencyStats;
+
+/**
+ * Draws one bar per control path stage. The solid part of each bar is the
+ * median, the lighter part extends to the 99th percentile and the tick marks
+ * the worst case seen during the last reporting interval.
+ */
+class LatencyProfilerGadgetWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    LatencyProfilerGadgetWidget(QWidget *parent = 0);
+    ~LatencyProfilerGadgetWidget();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void updateStats(UAVObject *obj);
+
+private:
+    struct StageStats {
+        QString name;
+        quint16 p50;
+        quint16 p99;
+        quint16 max;
+        quint16 samples;
+    };
+
+    LatencyStats *latencyStats;
+    QVector<StageStats> stages;
+};
+
+#endif /* LATENCYPROFILERGADGETWIDGET_H_ */
@@ -38,6 +38,7 @@
 #include <QDir>
 #include <QFile>
 #include <QDateTime>
+#include <QFileDialog>
 
 #include <math.h>
 
@@ -382,6 +383,7 @@ void OPMapGadgetWidget::contextMenuEvent(QContextMenuEvent *event)
     contextMenu.addAction(reloadAct);
     contextMenu.addSeparator();
     contextMenu.addAction(ripAct);
+    contextMenu.addAction(ripToTilePackAct);
     contextMenu.addSeparator();
 
     QMenu maxUpdateRateSubMenu(tr("&Max Update Rate ") + "(" + QString::number(m_maxUpdateRate) + " ms)", this);
@@ -1257,6 +1259,9 @@ void OPMapGadgetWidget::createActions()
     ripAct = new QAction(tr("&Rip map"), this);
     ripAct->setStatusTip(tr("Rip the map tiles"));
     connect(ripAct, SIGNAL(triggered()), this, SLOT(onRipAct_triggered()));
+    ripToTilePackAct = new QAction(tr("Rip map to a tile &package..."), this);
+    ripToTilePackAct->setStatusTip(tr("Rip the map tiles and also save them to a tile package for offline use"));
+    connect(ripToTilePackAct, SIGNAL(triggered()), this, SLOT(onRipToTilePackAct_triggered()));
 
     copyMouseLatLonToClipAct = new QAction(tr("Mouse latitude and longitude"), this);
     copyMouseLatLonToClipAct->setStatusTip(tr("Copy the mouse latitude and longitude to the clipboard"));
@@ -1550,6 +1555,17 @@ void OPMapGadgetWidget::onRipAct_triggered()
     m_map->RipMap();
 }
 
+void OPMapGadgetWidget::onRipToTilePackAct_triggered()
+{
+    QString file = QFileDialog::getSaveFileName(this, tr("Save tile package"),
+            m_map->configuration->CacheLocation() + "rip-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".tlpack",
+            tr("Tile packages (*.tlpack)"));
+    if (file.isEmpty())
+        return;
+
+    m_map->RipMapToTilePack(file);
+}
+
 void OPMapGadgetWidget::onCopyMouseLatLonToClipAct_triggered()
 {
     QClipboard *clipboard = QApplication::clipboard();
@@ -175,6 +175,7 @@ private slots:
     */
     void onReloadAct_triggered();
     void onRipAct_triggered();
+    void onRipToTilePackAct_triggered();
     void onCopyMouseLatLonToClipAct_triggered();
     void onCopyMouseLatToClipAct_triggered();
     void onCopyMouseLonToClipAct_triggered();
@@ -250,6 +251,7 @@ private:
     QAction *closeAct2;
     QAction *reloadAct;
     QAction *ripAct;
+    QAction *ripToTilePackAct;
 	QAction *copyMouseLatLonToClipAct;
     QAction *copyMouseLatToClipAct;
     QAction *copyMouseLonToClipAct;
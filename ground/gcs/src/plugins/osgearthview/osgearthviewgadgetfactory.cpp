@@ -30,6 +30,8 @@
 #include "osgearthviewgadgetoptionspage.h"
 #include <coreplugin/iuavgadget.h>
 
+#include <osgQt/GraphicsWindowQt>
+
 OsgEarthviewGadgetFactory::OsgEarthviewGadgetFactory(QObject *parent) :
         IUAVGadgetFactory(QString("OsgEarthviewGadget"),
                           tr("Osg Earth View"),
@@ -41,6 +43,13 @@ OsgEarthviewGadgetFactory::~OsgEarthviewGadgetFactory()
 {
 }
 
+void OsgEarthviewGadgetFactory::initialize()
+{
+    // Only needed by the viewer widget, so startup without an earth view
+    // gadget does not set up OSG at all
+    osgQt::initQtWindowingSystem();
+}
+
 Core::IUAVGadget* OsgEarthviewGadgetFactory::createGadget(QWidget *parent)
 {
     OsgEarthviewWidget* gadgetWidget = new OsgEarthviewWidget(parent);
@@ -48,6 +48,9 @@ public:
     Core::IUAVGadget *createGadget(QWidget *parent);
     IUAVGadgetConfiguration *createConfiguration(QSettings* qSettings);
     IOptionsPage *createOptionsPage(IUAVGadgetConfiguration *config);
+
+protected:
+    void initialize();
 };
 
 #endif // OSGEARTHVIEWGADGETFACTORY_H_
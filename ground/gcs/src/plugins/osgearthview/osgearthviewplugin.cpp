@@ -31,8 +31,6 @@
 #include <QStringList>
 #include <extensionsystem/pluginmanager.h>
 
-#include <osgQt/GraphicsWindowQt>
-
 
 OsgEarthviewPlugin::OsgEarthviewPlugin()
 {
@@ -51,8 +49,6 @@ bool OsgEarthviewPlugin::initialize(const QStringList& args, QString *errMsg)
    mf = new OsgEarthviewGadgetFactory(this);
    addAutoReleasedObject(mf);
 
-   osgQt::initQtWindowingSystem();
-
    return true;
 }
 
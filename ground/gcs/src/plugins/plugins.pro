@@ -125,6 +125,12 @@ plugin_systemhealth.depends += plugin_uavobjects
 plugin_systemhealth.depends += plugin_uavtalk
 SUBDIRS += plugin_systemhealth
 
+# Latency Profiler gadget
+plugin_latencyprofiler.subdir = latencyprofiler
+plugin_latencyprofiler.depends = plugin_coreplugin
+plugin_latencyprofiler.depends += plugin_uavobjects
+SUBDIRS += plugin_latencyprofiler
+
 # Config gadget
 plugin_config.subdir = config
 plugin_config.depends = plugin_coreplugin
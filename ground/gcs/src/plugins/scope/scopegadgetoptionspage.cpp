@@ -259,17 +259,11 @@ void ScopeGadgetOptionsPage::on_cmbSpectrogramSource_currentIndexChanged(QString
         switch(vibrationAnalysisSettingsData.FFTWindowSize)
         {
         default:
-        case VibrationAnalysisSettings::FFTWINDOWSIZE_16 :
-            fftWindowSize = 16;
+        case VibrationAnalysisSettings::FFTWINDOWSIZE_128 :
+            fftWindowSize = 128;
             break;
-        case VibrationAnalysisSettings::FFTWINDOWSIZE_64 :
-            fftWindowSize = 64;
-            break;
-        case VibrationAnalysisSettings::FFTWINDOWSIZE_256 :
-            fftWindowSize = 256;
-            break;
-        case VibrationAnalysisSettings::FFTWINDOWSIZE_1024 :
-            fftWindowSize = 1024;
+        case VibrationAnalysisSettings::FFTWINDOWSIZE_512 :
+            fftWindowSize = 512;
             break;
         }
 
@@ -278,7 +272,11 @@ void ScopeGadgetOptionsPage::on_cmbSpectrogramSource_currentIndexChanged(QString
 
         // Set values to UAVO
         options_page->sbSpectrogramWidth->setValue(fftWindowSize / 2);
-        options_page->sbSpectrogramFrequency->setValue(1000.0f/vibrationAnalysisSettingsData.SampleRate); // Sample rate is in ms
+
+        // The accels are analyzed at the rate they are sampled, which the output reports
+        float sampleRate = vibrationAnalysisOutput->getData().SampleRate;
+        if (sampleRate > 0)
+            options_page->sbSpectrogramFrequency->setValue(sampleRate);
 
         options_page->sbSpectrogramFrequency->setEnabled(false);
         options_page->sbSpectrogramWidth->setEnabled(false);
@@ -415,6 +413,7 @@ void ScopeGadgetOptionsPage::on_cmbUAVObjectsSpectrogram_currentIndexChanged(QSt
         return;
 
     QList<UAVObjectField*> fieldList = objData->getFields();
+    int maxElements = 1;
     foreach (UAVObjectField* field, fieldList) {
 
         if(field->getType() == UAVObjectField::STRING || field->getType() == UAVObjectField::ENUM)
@@ -422,6 +421,10 @@ void ScopeGadgetOptionsPage::on_cmbUAVObjectsSpectrogram_currentIndexChanged(QSt
 
         if(field->getElementNames().count() > 1)
         {
+            // The field name alone selects all of its elements
+            options_page->cmbUavoFieldSpectrogram->addItem(field->getName());
+            maxElements = qMax(maxElements, field->getElementNames().count());
+
             foreach(QString elemName , field->getElementNames())
             {
                 options_page->cmbUavoFieldSpectrogram->addItem(field->getName() + "-" + elemName);
@@ -432,9 +435,10 @@ void ScopeGadgetOptionsPage::on_cmbUAVObjectsSpectrogram_currentIndexChanged(QSt
     }
 
     // Get range from UAVO name
-    unsigned int maxWidth = objManager->getNumInstances(objData->getObjID());
+    unsigned int numInstances = objManager->getNumInstances(objData->getObjID());
+    unsigned int maxWidth = numInstances * maxElements;
     options_page->sbSpectrogramWidth->setRange(0, maxWidth);
-    options_page->sbSpectrogramWidth->setValue(maxWidth);
+    options_page->sbSpectrogramWidth->setValue(numInstances);
 
 }
 
@@ -153,8 +153,13 @@ bool SpectrogramData::append(UAVObject* multiObj)
         // Get list of object instances
         QVector<UAVObject*> list = objManager->getObjectInstancesVector(multiObj->getName());
 
+        // Without a subfield, all elements of the field are used and each instance holds
+        // as many samples as the field has elements
+        UAVObjectField* multiField =  multiObj->getField(uavFieldName);
+        unsigned int numElements = (multiField && !haveSubField) ? multiField->getNumElements() : 1;
+
         // Remove a row's worth of data.
-        unsigned int spectrogramWidth = list.size();
+        unsigned int spectrogramWidth = list.size() * numElements;
 
         // Check that there is a full window worth of data. While GCS is starting up, the size of
         // multiple instance UAVOs is 1, so it's possible for spurious data to come in before
@@ -168,7 +173,6 @@ bool SpectrogramData::append(UAVObject* multiObj)
         QVector<double> values;
 
         timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-        UAVObjectField* multiField =  multiObj->getField(uavFieldName);
         Q_ASSERT(multiField);
         if (multiField ) {
 
@@ -176,23 +180,29 @@ bool SpectrogramData::append(UAVObject* multiObj)
             foreach (UAVObject *obj, list) {
                 UAVObjectField* field =  obj->getField(uavFieldName);
 
-                double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-                double vecVal = currentValue;
-                //Normally some math would go here, modifying vecVal before appending it to values
-                // .
-                // .
-                // .
-
-
-                // Second to last step, see if autoscale is turned on and if the value exceeds the maximum for the scope.
-                if ( zMaximum == 0 &&  vecVal > rasterData->interval(Qt::ZAxis).maxValue()){
-                    // Change scope maximum and color depth
-                    rasterData->setInterval(Qt::ZAxis, QwtInterval(0, vecVal) );
-                    autoscaleValueUpdated = vecVal;
+                for (unsigned int i = 0; i < numElements; i++) {
+                    double currentValue;
+                    if (numElements > 1)
+                        currentValue = field->getDouble(i) * pow(10, scalePower);
+                    else
+                        currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+
+                    double vecVal = currentValue;
+                    //Normally some math would go here, modifying vecVal before appending it to values
+                    // .
+                    // .
+                    // .
+
+
+                    // Second to last step, see if autoscale is turned on and if the value exceeds the maximum for the scope.
+                    if ( zMaximum == 0 &&  vecVal > rasterData->interval(Qt::ZAxis).maxValue()){
+                        // Change scope maximum and color depth
+                        rasterData->setInterval(Qt::ZAxis, QwtInterval(0, vecVal) );
+                        autoscaleValueUpdated = vecVal;
+                    }
+                    // Last step, assign value to vector
+                    values += vecVal;
                 }
-                // Last step, assign value to vector
-                values += vecVal;
             }
 
             while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon){
@@ -10,12 +10,14 @@ HEADERS += systemhealthgadgetwidget.h
 HEADERS += systemhealthgadgetfactory.h
 HEADERS += systemhealthgadgetconfiguration.h
 HEADERS += systemhealthgadgetoptionspage.h
+HEADERS += taskloaditem.h
 SOURCES += systemhealthplugin.cpp
 SOURCES += systemhealthgadget.cpp
 SOURCES += systemhealthgadgetfactory.cpp
 SOURCES += systemhealthgadgetwidget.cpp
 SOURCES += systemhealthgadgetconfiguration.cpp
 SOURCES += systemhealthgadgetoptionspage.cpp
+SOURCES += taskloaditem.cpp
 OTHER_FILES += SystemHealthGadget.pluginspec \
     SystemHealthGadget.json
 FORMS += systemhealthgadgetoptionspage.ui
@@ -49,6 +49,8 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
     background = new QGraphicsSvgItem();
     foreground = new QGraphicsSvgItem();
     nolink = new QGraphicsSvgItem();
+    taskLoad = new TaskLoadItem();
+    connect(taskLoad, SIGNAL(sizeChanged()), this, SLOT(fitScene()));
 
     paint();
 
@@ -81,6 +83,21 @@ void SystemHealthGadgetWidget::onAutopilotConnect()
 void SystemHealthGadgetWidget::onAutopilotDisconnect()
 {
     nolink->setVisible(true);
+    taskLoad->clear();
+}
+
+/**
+  * Fit the alarm panel and the task load rows below it into the view
+  */
+void SystemHealthGadgetWidget::fitScene()
+{
+    QRectF bounds = background->boundingRect();
+    taskLoad->setWidth(bounds.width());
+    taskLoad->setPos(bounds.left(), bounds.bottom());
+    bounds |= taskLoad->mapRectToScene(taskLoad->boundingRect());
+
+    scene()->setSceneRect(bounds);
+    fitInView(bounds, Qt::KeepAspectRatio);
 }
 
 void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
@@ -159,9 +176,7 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
                nolink->setZValue(100);
            }
 
-         QGraphicsScene *l_scene = scene();
-         l_scene->setSceneRect(background->boundingRect());
-         fitInView(background, Qt::KeepAspectRatio );
+         fitScene();
 
          // Check whether the autopilot is connected already, by the way:
          ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -185,6 +200,7 @@ void SystemHealthGadgetWidget::paint()
     l_scene->addItem(background);
     l_scene->addItem(foreground);
     l_scene->addItem(nolink);
+    l_scene->addItem(taskLoad);
     update();
 }
 
@@ -204,7 +220,7 @@ void SystemHealthGadgetWidget::paintEvent(QPaintEvent *event)
 void SystemHealthGadgetWidget::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
-    fitInView(background, Qt::KeepAspectRatio );
+    fitScene();
 }
 
 void SystemHealthGadgetWidget::mousePressEvent ( QMouseEvent * event )
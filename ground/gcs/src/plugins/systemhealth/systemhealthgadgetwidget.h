@@ -31,6 +31,7 @@
 #include "systemhealthgadgetconfiguration.h"
 #include "uavobject.h"
 #include "uavtalk/telemetrymanager.h"
+#include "taskloaditem.h"
 #include <QGraphicsView>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
@@ -59,12 +60,14 @@ private slots:
    void updateAlarms(UAVObject *systemAlarm); // Called by the systemalarms UAVObject
    void onAutopilotConnect();
    void onAutopilotDisconnect();
+   void fitScene();
 
 private:
    QSvgRenderer *m_renderer;
    QGraphicsSvgItem *background;
    QGraphicsSvgItem *foreground;
    QGraphicsSvgItem *nolink;
+   TaskLoadItem *taskLoad;
 
                    // Simple flag to skip rendering if the
    bool fgenabled; // layer does not exist.
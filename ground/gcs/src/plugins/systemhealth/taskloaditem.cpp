@@ -0,0 +1,137 @@
+/**
+ ******************************************************************************
+ *
+ * @file       taskloaditem.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup SystemHealthPlugin System Health Plugin
+ * @{
+ * @brief Per task CPU load panel drawn underneath the alarm panel
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "taskloaditem.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "taskinfo.h"
+
+#include <QPainter>
+
+// Height of one task row in scene units
+static const qreal ROW_HEIGHT = 12;
+
+TaskLoadItem::TaskLoadItem(QGraphicsItem *parent) : QGraphicsObject(parent), width(200)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    taskInfo = TaskInfo::GetInstance(objManager);
+    Q_ASSERT(taskInfo);
+    connect(taskInfo, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateTasks(UAVObject*)));
+
+    setToolTip(tr("CPU time, context switches per second, longest single activation\n"
+                  "and time spent waiting on queues for each running task.\n"
+                  "Requires firmware built with task diagnostics."));
+}
+
+void TaskLoadItem::setWidth(qreal w)
+{
+    prepareGeometryChange();
+    width = w;
+}
+
+QRectF TaskLoadItem::boundingRect() const
+{
+    return QRectF(0, 0, width, ROW_HEIGHT * qMax(tasks.size(), 1));
+}
+
+void TaskLoadItem::clear()
+{
+    prepareGeometryChange();
+    tasks.clear();
+    update();
+    emit sizeChanged();
+}
+
+void TaskLoadItem::updateTasks(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+
+    TaskInfo::DataFields data = taskInfo->getData();
+    QStringList names = taskInfo->getField("Running")->getElementNames();
+
+    QList<TaskLoad> running;
+    for (int i = 0; i < names.size() && i < (int) TaskInfo::RUNNING_NUMELEM; i++) {
+        if (data.Running[i] != TaskInfo::RUNNING_TRUE)
+            continue;
+
+        TaskLoad task = { names[i], data.RunningTime[i], data.ContextSwitches[i],
+                          data.MaxActivation[i], data.QueueWait[i] };
+        running.append(task);
+    }
+
+    bool resized = running.size() != tasks.size();
+    if (resized)
+        prepareGeometryChange();
+    tasks = running;
+    update();
+    if (resized)
+        emit sizeChanged();
+}
+
+void TaskLoadItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    QFont font = painter->font();
+    font.setPixelSize(ROW_HEIGHT * 0.7);
+    painter->setFont(font);
+    painter->setPen(Qt::white);
+
+    if (tasks.isEmpty()) {
+        painter->drawText(boundingRect(), Qt::AlignCenter, tr("No task statistics"));
+        return;
+    }
+
+    const qreal labelWidth = width * 0.25;
+    const qreal barWidth = width * 0.30;
+    const qreal valueLeft = labelWidth + barWidth + 4;
+
+    for (int i = 0; i < tasks.size(); i++) {
+        const TaskLoad &task = tasks[i];
+        const qreal top = i * ROW_HEIGHT;
+
+        painter->drawText(QRectF(0, top, labelWidth, ROW_HEIGHT),
+                          Qt::AlignVCenter | Qt::AlignLeft, task.name);
+
+        // Queue wait behind the CPU bar so both read against the same 100% scale
+        QRectF bar(labelWidth, top + 2, barWidth, ROW_HEIGHT - 4);
+        painter->fillRect(bar, QColor(60, 60, 60));
+        painter->fillRect(QRectF(bar.left(), bar.top(), barWidth * qMin<int>(task.queueWait, 100) / 100, bar.height()),
+                          QColor(90, 120, 170));
+        QColor cpuColor = task.cpu > 50 ? QColor(220, 60, 40) : task.cpu > 20 ? QColor(230, 180, 40) : QColor(60, 180, 75);
+        painter->fillRect(QRectF(bar.left(), bar.top() + bar.height() / 4, barWidth * qMin<int>(task.cpu, 100) / 100, bar.height() / 2),
+                          cpuColor);
+
+        painter->drawText(QRectF(valueLeft, top, width - valueLeft, ROW_HEIGHT),
+                          Qt::AlignVCenter | Qt::AlignLeft,
+                          tr("%1% cpu  %2/s  %3 us  %4% wait")
+                          .arg(task.cpu).arg(task.switches).arg(task.maxActivation).arg(task.queueWait));
+    }
+}
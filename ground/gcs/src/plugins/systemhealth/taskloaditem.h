@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ *
+ * @file       taskloaditem.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup SystemHealthPlugin System Health Plugin
+ * @{
+ * @brief Per task CPU load panel drawn underneath the alarm panel
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TASKLOADITEM_H_
+#define TASKLOADITEM_H_
+
+#include "uavobject.h"
+#include <QGraphicsObject>
+#include <QList>
+
+class TaskInfo;
+
+/**
+ * Plots the scheduler statistics published in TaskInfo: one row per
+ * running task with a CPU bar and the switch rate, longest activation
+ * and queue wait next to it.
+ */
+class TaskLoadItem : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    TaskLoadItem(QGraphicsItem *parent = 0);
+
+    void setWidth(qreal width);
+    QRectF boundingRect() const;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+
+public slots:
+    void clear();
+
+signals:
+    void sizeChanged();
+
+private slots:
+    void updateTasks(UAVObject *obj);
+
+private:
+    struct TaskLoad {
+        QString name;
+        quint8 cpu;
+        quint16 switches;
+        quint16 maxActivation;
+        quint8 queueWait;
+    };
+
+    TaskInfo *taskInfo;
+    QList<TaskLoad> tasks;
+    qreal width;
+};
+
+#endif /* TASKLOADITEM_H_ */
@@ -0,0 +1,8 @@
+# Replays telemetry into the GCS UAVObjects and times the property change
+# notifications with nothing, a few and all properties bound, run with
+#   ./tst_notifybench
+TARGET = tst_notifybench
+
+SOURCES += tst_notifybench.cpp
+
+include(../uavobjectsbench.pri)
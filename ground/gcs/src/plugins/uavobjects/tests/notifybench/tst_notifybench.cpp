@@ -0,0 +1,206 @@
+/**
+******************************************************************************
+*
+* @file       tst_notifybench.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Replays telemetry into all UAVObjects and times the property notifications
+* @see        The GNU Public License (GPL) Version 3
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QMetaMethod>
+
+#include "uavobjectmanager.h"
+#include "uavdataobject.h"
+#include "uavobjectsinit.h"
+
+// Updates in the replayed log, about a minute of a busy telemetry link
+static const int Frames = 20000;
+
+// Objects with all their properties bound, like the PFD and the map do
+static const int BoundObjects = 5;
+
+/**
+ * Stands in for the QML bindings, counts the notifications it gets
+ */
+class Receiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    Receiver() : count(0) {}
+    int count;
+
+public slots:
+    void notified() { count++; }
+};
+
+class tst_NotifyBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void onlyChangesNotified();
+    void replay_data();
+    void replay();
+
+private:
+    int bind(UAVDataObject *obj, Receiver *receiver);
+    void unbindAll(Receiver *receiver);
+
+    UAVObjectManager *objMngr;
+    QList<UAVDataObject*> objects;
+    QList<int> frameObject;     // Object updated by each frame of the log
+    QList<QByteArray> frameData;    // And the data it was updated with
+};
+
+/**
+ * Build a log in which every frame changes a few bytes of the last data of
+ * an object, as sensor and state updates do
+ */
+void tst_NotifyBench::initTestCase()
+{
+    qsrand(1);
+
+    objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    QList<QByteArray> last;
+    foreach (const QVector<UAVDataObject*> &instances, objMngr->getDataObjectsVector()) {
+        UAVDataObject *obj = instances.first();
+        if (obj->getNumBytes() == 0)
+            continue;
+        objects.append(obj);
+        last.append(QByteArray(obj->getNumBytes(), 0));
+    }
+    QVERIFY(!objects.isEmpty());
+
+    for (int i = 0; i < Frames; ++i) {
+        int index = qrand() % objects.size();
+        QByteArray &bytes = last[index];
+        int changes = 1 + qrand() % 4;
+        for (int n = 0; n < changes; ++n)
+            bytes[qrand() % bytes.size()] = (char)(qrand() & 0xff);
+        frameObject.append(index);
+        frameData.append(bytes);
+    }
+}
+
+void tst_NotifyBench::cleanupTestCase()
+{
+    delete objMngr;
+}
+
+/**
+ * Connect the receiver to the change signal of every property of an object
+ * \return the number of signals connected
+ */
+int tst_NotifyBench::bind(UAVDataObject *obj, Receiver *receiver)
+{
+    const QMetaObject *meta = obj->metaObject();
+    QMetaMethod slot = receiver->metaObject()->method(
+                receiver->metaObject()->indexOfSlot("notified()"));
+    int bound = 0;
+
+    for (int i = meta->propertyOffset(); i < meta->propertyCount(); ++i) {
+        QMetaProperty property = meta->property(i);
+        if (property.hasNotifySignal() && connect(obj, property.notifySignal(), receiver, slot))
+            bound++;
+    }
+
+    return bound;
+}
+
+void tst_NotifyBench::unbindAll(Receiver *receiver)
+{
+    foreach (UAVDataObject *obj, objects)
+        obj->disconnect(receiver);
+}
+
+/**
+ * Unpacking the data an object already holds notifies nothing, changed data
+ * notifies the bound properties
+ */
+void tst_NotifyBench::onlyChangesNotified()
+{
+    Receiver receiver;
+
+    foreach (UAVDataObject *obj, objects) {
+        if (bind(obj, &receiver) == 0)
+            continue;
+
+        QByteArray bytes(obj->getNumBytes(), 0);
+        for (int i = 0; i < bytes.size(); ++i)
+            bytes[i] = (char)(0x40 + i);
+
+        obj->unpack((const quint8 *)bytes.constData());
+        int first = receiver.count;
+        obj->unpack((const quint8 *)bytes.constData());
+        if (receiver.count != first)
+            QFAIL(qPrintable(obj->getName() + " notified unchanged data"));
+
+        // All 0xff is a NaN in float fields, still nothing changed
+        bytes.fill((char)0xff);
+        obj->unpack((const quint8 *)bytes.constData());
+        int changed = receiver.count;
+        QVERIFY(changed > first);
+        obj->unpack((const quint8 *)bytes.constData());
+        if (receiver.count != changed)
+            QFAIL(qPrintable(obj->getName() + " notified an unchanged NaN"));
+    }
+
+    unbindAll(&receiver);
+}
+
+void tst_NotifyBench::replay_data()
+{
+    QTest::addColumn<int>("boundObjects");
+
+    QTest::newRow("nothing bound") << 0;
+    QTest::newRow("a few objects bound") << BoundObjects;
+    QTest::newRow("everything bound") << objects.size();
+}
+
+/**
+ * Unpack every frame of the log, which emits the property notifications
+ */
+void tst_NotifyBench::replay()
+{
+    QFETCH(int, boundObjects);
+
+    Receiver receiver;
+    int bound = 0;
+    for (int i = 0; i < boundObjects && i < objects.size(); ++i)
+        bound += bind(objects[i], &receiver);
+
+    QBENCHMARK {
+        for (int i = 0; i < frameObject.size(); ++i)
+            objects[frameObject[i]]->unpack((const quint8 *)frameData[i].constData());
+    }
+
+    qDebug("%d properties bound, %d notifications", bound, receiver.count);
+
+    unbindAll(&receiver);
+}
+
+QTEST_MAIN(tst_NotifyBench)
+#include "tst_notifybench.moc"
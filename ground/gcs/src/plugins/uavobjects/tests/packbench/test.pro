@@ -0,0 +1,8 @@
+# Checks the generated pack/unpack code of every UAVObject against the generic
+# field by field code and times both, run with
+#   ./tst_packbench
+TARGET = tst_packbench
+
+SOURCES += tst_packbench.cpp
+
+include(../uavobjectsbench.pri)
@@ -0,0 +1,205 @@
+/**
+******************************************************************************
+*
+* @file       tst_packbench.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Checks and times the generated pack/unpack code of all UAVObjects
+* @see        The GNU Public License (GPL) Version 3
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+
+#include "uavobjectmanager.h"
+#include "uavdataobject.h"
+#include "uavobjectfield.h"
+#include "uavobjectsinit.h"
+
+class tst_PackBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void packMatchesFields();
+    void unpackMatchesFields();
+    void pack_data();
+    void pack();
+    void unpack_data();
+    void unpack();
+
+private:
+    void randomize(QByteArray &bytes);
+    void packFields(UAVObject *obj, quint8 *dataOut);
+    void unpackFields(UAVObject *obj, const quint8 *dataIn);
+
+    UAVObjectManager *objMngr;
+    QList<UAVDataObject*> objects;
+    QList<QByteArray> wire;     // Random packed data of each object
+};
+
+void tst_PackBench::initTestCase()
+{
+    qsrand(1);
+
+    objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    foreach (const QVector<UAVDataObject*> &instances, objMngr->getDataObjectsVector()) {
+        UAVDataObject *obj = instances.first();
+
+        // Time the packing alone, not the property notifications
+        obj->disconnect();
+
+        QByteArray bytes(obj->getNumBytes(), 0);
+        randomize(bytes);
+
+        objects.append(obj);
+        wire.append(bytes);
+    }
+
+    QVERIFY(!objects.isEmpty());
+}
+
+void tst_PackBench::cleanupTestCase()
+{
+    delete objMngr;
+}
+
+void tst_PackBench::randomize(QByteArray &bytes)
+{
+    for (int i = 0; i < bytes.size(); ++i)
+        bytes[i] = (char)(qrand() & 0xff);
+}
+
+/**
+ * The field by field packing UAVObject::pack() used before the generated code
+ */
+void tst_PackBench::packFields(UAVObject *obj, quint8 *dataOut)
+{
+    QMutexLocker locker(obj->getMutex());
+    qint32 offset = 0;
+    foreach (UAVObjectField *field, obj->getFields()) {
+        field->pack(&dataOut[offset]);
+        offset += field->getNumBytes();
+    }
+}
+
+void tst_PackBench::unpackFields(UAVObject *obj, const quint8 *dataIn)
+{
+    QMutexLocker locker(obj->getMutex());
+    qint32 offset = 0;
+    foreach (UAVObjectField *field, obj->getFields()) {
+        field->unpack(&dataIn[offset]);
+        offset += field->getNumBytes();
+    }
+}
+
+/**
+ * Data unpacked by the fields and packed by the generated code comes out unchanged
+ */
+void tst_PackBench::packMatchesFields()
+{
+    for (int i = 0; i < objects.size(); ++i) {
+        UAVDataObject *obj = objects[i];
+        QByteArray out(obj->getNumBytes(), 0);
+
+        unpackFields(obj, (const quint8 *)wire[i].constData());
+        QCOMPARE(obj->pack((quint8 *)out.data()), (qint32)obj->getNumBytes());
+
+        if (out != wire[i])
+            QFAIL(qPrintable(obj->getName()));
+    }
+}
+
+/**
+ * Data unpacked by the generated code and packed by the fields comes out unchanged
+ */
+void tst_PackBench::unpackMatchesFields()
+{
+    for (int i = 0; i < objects.size(); ++i) {
+        UAVDataObject *obj = objects[i];
+        QByteArray out(obj->getNumBytes(), 0);
+
+        QCOMPARE(obj->unpack((const quint8 *)wire[i].constData()), (qint32)obj->getNumBytes());
+        packFields(obj, (quint8 *)out.data());
+
+        if (out != wire[i])
+            QFAIL(qPrintable(obj->getName()));
+    }
+}
+
+void tst_PackBench::pack_data()
+{
+    QTest::addColumn<bool>("generated");
+
+    QTest::newRow("fields") << false;
+    QTest::newRow("generated") << true;
+}
+
+/**
+ * Pack every object once per iteration
+ */
+void tst_PackBench::pack()
+{
+    QFETCH(bool, generated);
+
+    int maxBytes = 0;
+    foreach (UAVDataObject *obj, objects)
+        maxBytes = qMax(maxBytes, (int)obj->getNumBytes());
+    QByteArray buffer(maxBytes, 0);
+    quint8 *out = (quint8 *)buffer.data();
+
+    QBENCHMARK {
+        foreach (UAVDataObject *obj, objects) {
+            if (generated)
+                obj->pack(out);
+            else
+                packFields(obj, out);
+        }
+    }
+}
+
+void tst_PackBench::unpack_data()
+{
+    pack_data();
+}
+
+/**
+ * Unpack every object once per iteration, as the telemetry receive path does
+ */
+void tst_PackBench::unpack()
+{
+    QFETCH(bool, generated);
+
+    QBENCHMARK {
+        for (int i = 0; i < objects.size(); ++i) {
+            const quint8 *in = (const quint8 *)wire[i].constData();
+            if (generated)
+                objects[i]->unpack(in);
+            else
+                unpackFields(objects[i], in);
+        }
+    }
+}
+
+QTEST_MAIN(tst_PackBench)
+
+#include "tst_packbench.moc"
@@ -0,0 +1,8 @@
+# Times creating the GCS UAVObjects and their instances and reports the heap
+# they take, run with
+#   ./tst_schemabench
+TARGET = tst_schemabench
+
+SOURCES += tst_schemabench.cpp
+
+include(../uavobjectsbench.pri)
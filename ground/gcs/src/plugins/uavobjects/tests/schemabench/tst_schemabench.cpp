@@ -0,0 +1,167 @@
+/**
+******************************************************************************
+*
+* @file       tst_schemabench.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+* @brief      Times creating all UAVObjects and their instances, and the heap they use
+* @see        The GNU Public License (GPL) Version 3
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QElapsedTimer>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "uavobjectmanager.h"
+#include "uavdataobject.h"
+#include "uavobjectfield.h"
+#include "uavobjectsinit.h"
+
+// Instances created of each multi instance object, like a long waypoint list
+static const int Instances = 100;
+
+class tst_SchemaBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void startup();
+    void instances();
+    void clonesMatch();
+
+private:
+    static qint64 heapInUse();
+};
+
+/**
+ * Bytes currently allocated from the heap, -1 where this can't be told
+ */
+qint64 tst_SchemaBench::heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return (qint64)mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+    return (qint64)(unsigned int)mallinfo().uordblks;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * What the GCS does at start up: create and register every object
+ */
+void tst_SchemaBench::startup()
+{
+    // The first run also creates the shared schemas, time it separately
+    for (int run = 0; run < 2; ++run) {
+        qint64 heapBefore = heapInUse();
+        QElapsedTimer timer;
+        timer.start();
+
+        UAVObjectManager *objMngr = new UAVObjectManager();
+        UAVObjectsInitialize(objMngr);
+
+        qint64 elapsed = timer.nsecsElapsed();
+        qint64 heap = heapInUse() - heapBefore;
+        int objects = objMngr->getDataObjectsVector().size();
+
+        qDebug("%s: %d objects in %.2f ms, %lld bytes of heap",
+               run == 0 ? "first start" : "next start ", objects,
+               elapsed / 1e6, heap);
+
+        QVERIFY(objects > 0);
+        delete objMngr;
+    }
+}
+
+/**
+ * Extra instances of every multi instance object, created with clone() as
+ * the telemetry does for instances the GCS hasn't seen yet
+ */
+void tst_SchemaBench::instances()
+{
+    UAVObjectManager *objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    QList<UAVDataObject*> multi;
+    foreach (const QVector<UAVDataObject*> &objInstances, objMngr->getDataObjectsVector()) {
+        if (!objInstances.first()->isSingleInstance())
+            multi.append(objInstances.first());
+    }
+
+    if (multi.isEmpty())
+        QSKIP("No multi instance objects");
+
+    qint64 heapBefore = heapInUse();
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int instId = 1; instId <= Instances; ++instId) {
+        foreach (UAVDataObject *obj, multi)
+            QVERIFY(objMngr->registerObject(obj->clone(instId)));
+    }
+
+    qint64 elapsed = timer.nsecsElapsed();
+    qint64 heap = heapInUse() - heapBefore;
+    int created = Instances * multi.size();
+
+    qDebug("%d instances of %d objects in %.2f ms, %.1f us and %lld bytes each",
+           created, multi.size(), elapsed / 1e6, elapsed / 1e3 / created,
+           heap / created);
+
+    delete objMngr;
+}
+
+/**
+ * A clone describes its fields just like the object it was cloned from
+ */
+void tst_SchemaBench::clonesMatch()
+{
+    UAVObjectManager *objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+
+    foreach (const QVector<UAVDataObject*> &objInstances, objMngr->getDataObjectsVector()) {
+        UAVDataObject *obj = objInstances.first();
+        UAVDataObject *clone = obj->dirtyClone();
+
+        QList<UAVObjectField*> fields = obj->getFields();
+        QList<UAVObjectField*> cloneFields = clone->getFields();
+        QCOMPARE(cloneFields.size(), fields.size());
+
+        for (int i = 0; i < fields.size(); ++i) {
+            QCOMPARE(cloneFields[i]->getName(), fields[i]->getName());
+            QCOMPARE(cloneFields[i]->getUnits(), fields[i]->getUnits());
+            QCOMPARE(cloneFields[i]->getType(), fields[i]->getType());
+            QCOMPARE(cloneFields[i]->getElementNames(), fields[i]->getElementNames());
+            QCOMPARE(cloneFields[i]->getOptions(), fields[i]->getOptions());
+            QCOMPARE(cloneFields[i]->getDataOffset(), fields[i]->getDataOffset());
+            QVERIFY(cloneFields[i]->getObject() == clone);
+        }
+
+        delete clone;
+    }
+
+    delete objMngr;
+}
+
+QTEST_MAIN(tst_SchemaBench)
+#include "tst_schemabench.moc"
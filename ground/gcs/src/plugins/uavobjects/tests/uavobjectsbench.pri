@@ -0,0 +1,26 @@
+# Shared settings of the GCS UAVObjects benchmarks. They build against the
+# UAVObjects generated with make uavobjects_gcs, or the ones in
+# UAVOBJECT_SYNTHETICS if set.
+CONFIG += qtestlib
+QT -= gui
+TEMPLATE = app
+CONFIG -= app_bundle
+DEFINES += UAVOBJECTS_LIBRARY
+
+isEmpty(UAVOBJECT_SYNTHETICS): UAVOBJECT_SYNTHETICS = $$PWD/../../../../../../build/uavobject-synthetics/gcs
+
+INCLUDEPATH += $$PWD/.. $$UAVOBJECT_SYNTHETICS
+
+HEADERS += $$PWD/../uavobject.h \
+    $$PWD/../uavdataobject.h \
+    $$PWD/../uavmetaobject.h \
+    $$PWD/../uavobjectfield.h \
+    $$PWD/../uavobjectmanager.h \
+    $$files($$UAVOBJECT_SYNTHETICS/*.h)
+
+SOURCES += $$PWD/../uavobject.cpp \
+    $$PWD/../uavdataobject.cpp \
+    $$PWD/../uavmetaobject.cpp \
+    $$PWD/../uavobjectfield.cpp \
+    $$PWD/../uavobjectmanager.cpp \
+    $$files($$UAVOBJECT_SYNTHETICS/*.cpp)
@@ -37,14 +37,11 @@ UAVMetaObject::UAVMetaObject(quint32 objID, const QString& name, UAVObject *pare
     this->parent = parent;
     // Setup default metadata of metaobject (can not be changed)
     UAVObject::MetadataInitialize(ownMetadata);
-    // Setup fields
-    QStringList modesBitField;
-    modesBitField << tr("FlightReadOnly") << tr("GCSReadOnly") << tr("FlightTelemetryAcked") << tr("GCSTelemetryAcked") << tr("FlightUpdatePeriodic") << tr("FlightUpdateOnChange") << tr("GCSUpdatePeriodic") << tr("GCSUpdateOnChange");
-    QList<UAVObjectField*> fields;    
-    fields.append( new UAVObjectField(tr("Modes"), tr("boolean"), UAVObjectField::BITFIELD, modesBitField, QStringList()) );
-    fields.append( new UAVObjectField(tr("Flight Telemetry Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
-    fields.append( new UAVObjectField(tr("GCS Telemetry Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
-    fields.append( new UAVObjectField(tr("Logging Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
+    // Setup fields, all metaobjects share the same field schema
+    static const QList<const UAVObjectField::Schema*> schemas = createFieldSchemas();
+    QList<UAVObjectField*> fields;
+    foreach (const UAVObjectField::Schema* schema, schemas)
+        fields.append( new UAVObjectField(schema) );
     // Initialize parent
     UAVObject::initialize(0);
     UAVObject::initializeFields(fields, (quint8*)&parentMetadata, sizeof(Metadata));
@@ -52,6 +49,21 @@ UAVMetaObject::UAVMetaObject(quint32 objID, const QString& name, UAVObject *pare
     parentMetadata = parent->getDefaultMetadata();
 }
 
+/**
+ * Create the schema of the metadata fields
+ */
+QList<const UAVObjectField::Schema*> UAVMetaObject::createFieldSchemas()
+{
+    QStringList modesBitField;
+    modesBitField << tr("FlightReadOnly") << tr("GCSReadOnly") << tr("FlightTelemetryAcked") << tr("GCSTelemetryAcked") << tr("FlightUpdatePeriodic") << tr("FlightUpdateOnChange") << tr("GCSUpdatePeriodic") << tr("GCSUpdateOnChange");
+    QList<const UAVObjectField::Schema*> schemas;
+    schemas.append( new UAVObjectField::Schema(tr("Modes"), tr("boolean"), UAVObjectField::BITFIELD, modesBitField, QStringList()) );
+    schemas.append( new UAVObjectField::Schema(tr("Flight Telemetry Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
+    schemas.append( new UAVObjectField::Schema(tr("GCS Telemetry Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
+    schemas.append( new UAVObjectField::Schema(tr("Logging Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
+    return schemas;
+}
+
 /**
  * Get the parent object
  */
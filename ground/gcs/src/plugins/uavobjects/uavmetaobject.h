@@ -30,6 +30,7 @@
 
 #include "uavobjects_global.h"
 #include "uavobject.h"
+#include "uavobjectfield.h"
 
 class UAVOBJECTS_EXPORT UAVMetaObject: public UAVObject
 {
@@ -45,6 +46,8 @@ public:
     Metadata getData();
 
 private:
+    static QList<const UAVObjectField::Schema*> createFieldSchemas();
+
     UAVObject* parent;
     Metadata ownMetadata;
     Metadata parentMetadata;
@@ -273,6 +273,31 @@ UAVObjectField* UAVObject::getField(const QString& name)
 qint32 UAVObject::pack(quint8* dataOut)
 {
     QMutexLocker locker(mutex);
+    packFields(dataOut);
+    return numBytes;
+}
+
+/**
+ * Unpack the object data from a byte array
+ * @returns The number of bytes copied
+ */
+qint32 UAVObject::unpack(const quint8* dataIn)
+{
+    QMutexLocker locker(mutex);
+    unpackFields(dataIn);
+    emit objectUnpacked(this); // trigger object updated event
+    emit objectUpdated(this);
+
+    return numBytes;
+}
+
+/**
+ * Pack all fields one after the other, called with the object locked.
+ * The generated objects override this with code specialized for their
+ * layout, this generic version is used by the metaobjects.
+ */
+void UAVObject::packFields(quint8* dataOut)
+{
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -280,16 +305,13 @@ qint32 UAVObject::pack(quint8* dataOut)
         field->pack(&dataOut[offset]);
         offset += field->getNumBytes();
     }
-    return numBytes;
 }
 
 /**
- * Unpack the object data from a byte array
- * @returns The number of bytes copied
+ * Unpack all fields one after the other, called with the object locked
  */
-qint32 UAVObject::unpack(const quint8* dataIn)
+void UAVObject::unpackFields(const quint8* dataIn)
 {
-    QMutexLocker locker(mutex);
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -297,10 +319,6 @@ qint32 UAVObject::unpack(const quint8* dataIn)
         field->unpack(&dataIn[offset]);
         offset += field->getNumBytes();
     }
-    emit objectUnpacked(this); // trigger object updated event
-    emit objectUpdated(this);
-
-    return numBytes;
 }
 
 /**
@@ -37,7 +37,9 @@
 #include <QString>
 #include <QList>
 #include <QFile>
+#include <QtEndian>
 #include <qglobal.h>
+#include <cstring>
 #include "uavobjectfield.h"
 
 #ifdef _MSC_VER
@@ -245,6 +247,33 @@ protected:
     void initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes);
     void setDescription(const QString& description);
     void setCategory(const QString& category);
+    virtual void packFields(quint8* dataOut);
+    virtual void unpackFields(const quint8* dataIn);
+
+    /**
+     * Convert numElements values of type T between the object data and the
+     * little endian wire format, used by the generated pack/unpack code
+     */
+    template <typename T>
+    static inline void packElements(quint8* dataOut, const quint8* dataIn, int numElements)
+    {
+        for (int index = 0; index < numElements; ++index)
+        {
+            T value;
+            memcpy(&value, &dataIn[index*sizeof(T)], sizeof(T));
+            qToLittleEndian<T>(value, &dataOut[index*sizeof(T)]);
+        }
+    }
+
+    template <typename T>
+    static inline void unpackElements(quint8* dataOut, const quint8* dataIn, int numElements)
+    {
+        for (int index = 0; index < numElements; ++index)
+        {
+            T value = qFromLittleEndian<T>(&dataIn[index*sizeof(T)]);
+            memcpy(&dataOut[index*sizeof(T)], &value, sizeof(T));
+        }
+    }
 
 };
 
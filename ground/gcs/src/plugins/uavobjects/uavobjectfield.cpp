@@ -29,7 +29,7 @@
 #include <QtEndian>
 #include <QDebug>
 
-UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldType type, quint32 numElements, const QStringList& options, const QString &limits)
+UAVObjectField::Schema::Schema(const QString& name, const QString& units, FieldType type, quint32 numElements, const QStringList& options, const QString &limits)
 {
     QStringList elementNames;
     // Set element names
@@ -38,16 +38,16 @@ UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldT
         elementNames.append(QString("%1").arg(n));
     }
     // Initialize
-    constructorInitialize(name, units, type, elementNames, options,limits);
+    initialize(name, units, type, elementNames, options,limits);
 
 }
 
-UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QString &limits)
+UAVObjectField::Schema::Schema(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QString &limits)
 {
-    constructorInitialize(name, units, type, elementNames, options,limits);
+    initialize(name, units, type, elementNames, options,limits);
 }
 
-void UAVObjectField::constructorInitialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options,const QString &limits)
+void UAVObjectField::Schema::initialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options,const QString &limits)
 {
     // Copy params
     this->name = name;
@@ -55,9 +55,6 @@ void UAVObjectField::constructorInitialize(const QString& name, const QString& u
     this->type = type;
     this->options = options;
     this->numElements = elementNames.length();
-    this->offset = 0;
-    this->data = NULL;
-    this->obj = NULL;
     this->elementNames = elementNames;
     // Set field size
     switch (type)
@@ -99,7 +96,7 @@ void UAVObjectField::constructorInitialize(const QString& name, const QString& u
     limitsInitialize(limits);
 }
 
-void UAVObjectField::limitsInitialize(const QString &limits)
+void UAVObjectField::Schema::limitsInitialize(const QString &limits)
 {
     /// format
     /// (TY)->type (EQ-equal;NE-not equal;BE-between;BI-bigger;SM-smaller)
@@ -194,19 +191,55 @@ void UAVObjectField::limitsInitialize(const QString &limits)
 }
 
 
+/**
+ * Create a field described by a schema shared with other instances
+ */
+UAVObjectField::UAVObjectField(const Schema* schema)
+{
+    this->schema = schema;
+    this->ownsSchema = false;
+    this->offset = 0;
+    this->data = NULL;
+    this->obj = NULL;
+}
+
+UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldType type, quint32 numElements, const QStringList& options, const QString &limits)
+{
+    this->schema = new Schema(name, units, type, numElements, options, limits);
+    this->ownsSchema = true;
+    this->offset = 0;
+    this->data = NULL;
+    this->obj = NULL;
+}
+
+UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QString &limits)
+{
+    this->schema = new Schema(name, units, type, elementNames, options, limits);
+    this->ownsSchema = true;
+    this->offset = 0;
+    this->data = NULL;
+    this->obj = NULL;
+}
+
+UAVObjectField::~UAVObjectField()
+{
+    if (ownsSchema)
+        delete schema;
+}
+
 bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
 {
-    if(!elementLimits.keys().contains(index))
+    if(!schema->elementLimits.keys().contains(index))
         return true;
 
-    foreach(LimitStruct struc,elementLimits.value(index))
+    foreach(LimitStruct struc,schema->elementLimits.value(index))
     {
         if((struc.board!=board) && board!=0 && struc.board!=0)
             continue;
         switch(struc.type)
         {
         case EQUAL:
-            switch (type)
+            switch (schema->type)
             {
             case INT8:
             case INT16:
@@ -247,7 +280,7 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
             }
             break;
         case NOT_EQUAL:
-            switch (type)
+            switch (schema->type)
             {
             case INT8:
             case INT16:
@@ -290,12 +323,12 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
         case BETWEEN:
             if(struc.values.length()<2)
             {
-                qDebug()<<__FUNCTION__<<"between limit with less than 1 pair, aborting; field:"<<name;
+                qDebug()<<__FUNCTION__<<"between limit with less than 1 pair, aborting; field:"<<schema->name;
                 return true;
             }
             if(struc.values.length()>2)
-                qDebug()<<__FUNCTION__<<"between limit with more than 1 pair, using first; field"<<name;
-            switch (type)
+                qDebug()<<__FUNCTION__<<"between limit with more than 1 pair, using first; field"<<schema->name;
+            switch (schema->type)
             {
             case INT8:
             case INT16:
@@ -313,7 +346,7 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
                 return true;
                 break;
             case ENUM:
-                    if(!(options.indexOf(var.toString())>=options.indexOf(struc.values.at(0).toString()) && options.indexOf(var.toString())<=options.indexOf(struc.values.at(1).toString())))
+                    if(!(schema->options.indexOf(var.toString())>=schema->options.indexOf(struc.values.at(0).toString()) && schema->options.indexOf(var.toString())<=schema->options.indexOf(struc.values.at(1).toString())))
                         return false;
                 return true;
                 break;
@@ -332,12 +365,12 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
         case BIGGER:
             if(struc.values.length()<1)
             {
-                qDebug()<<__FUNCTION__<<"BIGGER limit with less than 1 value, aborting; field:"<<name;
+                qDebug()<<__FUNCTION__<<"BIGGER limit with less than 1 value, aborting; field:"<<schema->name;
                 return true;
             }
             if(struc.values.length()>1)
-                qDebug()<<__FUNCTION__<<"BIGGER limit with more than 1 value, using first; field"<<name;
-            switch (type)
+                qDebug()<<__FUNCTION__<<"BIGGER limit with more than 1 value, using first; field"<<schema->name;
+            switch (schema->type)
             {
             case INT8:
             case INT16:
@@ -355,7 +388,7 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
                 return true;
                 break;
             case ENUM:
-                    if(!(options.indexOf(var.toString())>=options.indexOf(struc.values.at(0).toString())))
+                    if(!(schema->options.indexOf(var.toString())>=schema->options.indexOf(struc.values.at(0).toString())))
                         return false;
                 return true;
                 break;
@@ -372,7 +405,7 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
             }
             break;
         case SMALLER:
-            switch (type)
+            switch (schema->type)
             {
             case INT8:
             case INT16:
@@ -390,7 +423,7 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
                 return true;
                 break;
             case ENUM:
-                    if(!(options.indexOf(var.toString())<=options.indexOf(struc.values.at(0).toString())))
+                    if(!(schema->options.indexOf(var.toString())<=schema->options.indexOf(struc.values.at(0).toString())))
                         return false;
                 return true;
                 break;
@@ -412,9 +445,9 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
 
 QVariant UAVObjectField::getMaxLimit(quint32 index,int board)
 {
-    if(!elementLimits.keys().contains(index))
+    if(!schema->elementLimits.keys().contains(index))
         return QVariant();
-    foreach(LimitStruct struc,elementLimits.value(index))
+    foreach(LimitStruct struc,schema->elementLimits.value(index))
     {
         if((struc.board!=board) && board!=0 && struc.board!=0)
             continue;
@@ -441,9 +474,9 @@ QVariant UAVObjectField::getMaxLimit(quint32 index,int board)
 }
 QVariant UAVObjectField::getMinLimit(quint32 index, int board)
 {
-    if(!elementLimits.keys().contains(index))
+    if(!schema->elementLimits.keys().contains(index))
         return QVariant();
-    foreach(LimitStruct struc,elementLimits.value(index))
+    foreach(LimitStruct struc,schema->elementLimits.value(index))
     {
         if((struc.board!=board) && board!=0 && struc.board!=0)
             return QVariant();
@@ -478,12 +511,12 @@ void UAVObjectField::initialize(quint8* data, quint32 dataOffset, UAVObject* obj
 
 UAVObjectField::FieldType UAVObjectField::getType()
 {
-    return type;
+    return schema->type;
 }
 
 QString UAVObjectField::getTypeAsString()
 {
-    switch (type)
+    switch (schema->type)
     {
     case UAVObjectField::INT8:
         return "int8";
@@ -512,7 +545,7 @@ QString UAVObjectField::getTypeAsString()
 
 QStringList UAVObjectField::getElementNames()
 {
-    return elementNames;
+    return schema->elementNames;
 }
 
 UAVObject* UAVObjectField::getObject()
@@ -523,35 +556,35 @@ UAVObject* UAVObjectField::getObject()
 void UAVObjectField::clear()
 {
     QMutexLocker locker(obj->getMutex());
-    switch (type)
+    switch (schema->type)
     {
     case BITFIELD:
-        memset(&data[offset], 0, numBytesPerElement*((quint32)(1+(numElements-1)/8)));
+        memset(&data[offset], 0, schema->numBytesPerElement*((quint32)(1+(schema->numElements-1)/8)));
         break;
     default:
-        memset(&data[offset], 0, numBytesPerElement*numElements);
+        memset(&data[offset], 0, schema->numBytesPerElement*schema->numElements);
         break;
     }
 }
 
 QString UAVObjectField::getName()
 {
-    return name;
+    return schema->name;
 }
 
 QString UAVObjectField::getUnits()
 {
-    return units;
+    return schema->units;
 }
 
 QStringList UAVObjectField::getOptions()
 {
-    return options;
+    return schema->options;
 }
 
 quint32 UAVObjectField::getNumElements()
 {
-    return numElements;
+    return schema->numElements;
 }
 
 quint32 UAVObjectField::getDataOffset()
@@ -561,13 +594,13 @@ quint32 UAVObjectField::getDataOffset()
 
 quint32 UAVObjectField::getNumBytes()
 {
-    switch (type)
+    switch (schema->type)
     {
     case BITFIELD:
-        return numBytesPerElement * ((quint32) (1+(numElements-1)/8));
+        return schema->numBytesPerElement * ((quint32) (1+(schema->numElements-1)/8));
         break;
     default:
-        return numBytesPerElement * numElements;
+        return schema->numBytesPerElement * schema->numElements;
         break;
     }
 }
@@ -575,12 +608,12 @@ quint32 UAVObjectField::getNumBytes()
 QString UAVObjectField::toString()
 {
     QString sout;
-    sout.append ( QString("%1: [ ").arg(name) );
-    for (unsigned int n = 0; n < numElements; ++n)
+    sout.append ( QString("%1: [ ").arg(schema->name) );
+    for (unsigned int n = 0; n < schema->numElements; ++n)
     {
         sout.append( QString("%1 ").arg(getDouble(n)) );
     }
-    sout.append( QString("] %1\n").arg(units) );
+    sout.append( QString("] %1\n").arg(schema->units) );
     return sout;
 }
 
@@ -589,71 +622,71 @@ qint32 UAVObjectField::pack(quint8* dataOut)
 {
     QMutexLocker locker(obj->getMutex());
     // Pack each element in output buffer
-    switch (type)
+    switch (schema->type)
     {
     case INT8:
-        memcpy(dataOut, &data[offset], numElements);
+        memcpy(dataOut, &data[offset], schema->numElements);
         break;
     case INT16:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             qint16 value;
-            memcpy(&value, &data[offset + numBytesPerElement*index], numBytesPerElement);
-            qToLittleEndian<qint16>(value, &dataOut[numBytesPerElement*index]);
+            memcpy(&value, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
+            qToLittleEndian<qint16>(value, &dataOut[schema->numBytesPerElement*index]);
         }
         break;
     case INT32:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             qint32 value;
-            memcpy(&value, &data[offset + numBytesPerElement*index], numBytesPerElement);
-            qToLittleEndian<qint32>(value, &dataOut[numBytesPerElement*index]);
+            memcpy(&value, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
+            qToLittleEndian<qint32>(value, &dataOut[schema->numBytesPerElement*index]);
         }
         break;
     case UINT8:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
-            dataOut[numBytesPerElement*index] = data[offset + numBytesPerElement*index];
+            dataOut[schema->numBytesPerElement*index] = data[offset + schema->numBytesPerElement*index];
         }
         break;
     case UINT16:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             quint16 value;
-            memcpy(&value, &data[offset + numBytesPerElement*index], numBytesPerElement);
-            qToLittleEndian<quint16>(value, &dataOut[numBytesPerElement*index]);
+            memcpy(&value, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
+            qToLittleEndian<quint16>(value, &dataOut[schema->numBytesPerElement*index]);
         }
         break;
     case UINT32:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             quint32 value;
-            memcpy(&value, &data[offset + numBytesPerElement*index], numBytesPerElement);
-            qToLittleEndian<quint32>(value, &dataOut[numBytesPerElement*index]);
+            memcpy(&value, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
+            qToLittleEndian<quint32>(value, &dataOut[schema->numBytesPerElement*index]);
         }
         break;
     case FLOAT32:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             quint32 value;
-            memcpy(&value, &data[offset + numBytesPerElement*index], numBytesPerElement);
-            qToLittleEndian<quint32>(value, &dataOut[numBytesPerElement*index]);
+            memcpy(&value, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
+            qToLittleEndian<quint32>(value, &dataOut[schema->numBytesPerElement*index]);
         }
         break;
     case ENUM:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
-            dataOut[numBytesPerElement*index] = data[offset + numBytesPerElement*index];
+            dataOut[schema->numBytesPerElement*index] = data[offset + schema->numBytesPerElement*index];
         }
         break;
     case BITFIELD:
-        for (quint32 index = 0; index < (quint32)(1+(numElements-1)/8); ++index)
+        for (quint32 index = 0; index < (quint32)(1+(schema->numElements-1)/8); ++index)
         {
-            dataOut[numBytesPerElement*index] = data[offset + numBytesPerElement*index];
+            dataOut[schema->numBytesPerElement*index] = data[offset + schema->numBytesPerElement*index];
         }
         break;
     case STRING:
-        memcpy(dataOut, &data[offset], numElements);
+        memcpy(dataOut, &data[offset], schema->numElements);
         break;
     }
     // Done
@@ -664,71 +697,71 @@ qint32 UAVObjectField::unpack(const quint8* dataIn)
 {
     QMutexLocker locker(obj->getMutex());
     // Unpack each element from input buffer
-    switch (type)
+    switch (schema->type)
     {
     case INT8:
-        memcpy(&data[offset], dataIn, numElements);
+        memcpy(&data[offset], dataIn, schema->numElements);
         break;
     case INT16:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             qint16 value;
-            value = qFromLittleEndian<qint16>(&dataIn[numBytesPerElement*index]);
-            memcpy(&data[offset + numBytesPerElement*index], &value, numBytesPerElement);
+            value = qFromLittleEndian<qint16>(&dataIn[schema->numBytesPerElement*index]);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &value, schema->numBytesPerElement);
         }
         break;
     case INT32:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             qint32 value;
-            value = qFromLittleEndian<qint32>(&dataIn[numBytesPerElement*index]);
-            memcpy(&data[offset + numBytesPerElement*index], &value, numBytesPerElement);
+            value = qFromLittleEndian<qint32>(&dataIn[schema->numBytesPerElement*index]);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &value, schema->numBytesPerElement);
         }
         break;
     case UINT8:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
-            data[offset + numBytesPerElement*index] = dataIn[numBytesPerElement*index];
+            data[offset + schema->numBytesPerElement*index] = dataIn[schema->numBytesPerElement*index];
         }
         break;
     case UINT16:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             quint16 value;
-            value = qFromLittleEndian<quint16>(&dataIn[numBytesPerElement*index]);
-            memcpy(&data[offset + numBytesPerElement*index], &value, numBytesPerElement);
+            value = qFromLittleEndian<quint16>(&dataIn[schema->numBytesPerElement*index]);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &value, schema->numBytesPerElement);
         }
         break;
     case UINT32:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             quint32 value;
-            value = qFromLittleEndian<quint32>(&dataIn[numBytesPerElement*index]);
-            memcpy(&data[offset + numBytesPerElement*index], &value, numBytesPerElement);
+            value = qFromLittleEndian<quint32>(&dataIn[schema->numBytesPerElement*index]);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &value, schema->numBytesPerElement);
         }
         break;
     case FLOAT32:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
             quint32 value;
-            value = qFromLittleEndian<quint32>(&dataIn[numBytesPerElement*index]);
-            memcpy(&data[offset + numBytesPerElement*index], &value, numBytesPerElement);
+            value = qFromLittleEndian<quint32>(&dataIn[schema->numBytesPerElement*index]);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &value, schema->numBytesPerElement);
         }
         break;
     case ENUM:
-        for (quint32 index = 0; index < numElements; ++index)
+        for (quint32 index = 0; index < schema->numElements; ++index)
         {
-            data[offset + numBytesPerElement*index] = dataIn[numBytesPerElement*index];
+            data[offset + schema->numBytesPerElement*index] = dataIn[schema->numBytesPerElement*index];
         }
         break;
     case BITFIELD:
-        for (quint32 index = 0; index < (quint32)(1+(numElements-1)/8); ++index)
+        for (quint32 index = 0; index < (quint32)(1+(schema->numElements-1)/8); ++index)
         {
-            data[offset + numBytesPerElement*index] = dataIn[numBytesPerElement*index];
+            data[offset + schema->numBytesPerElement*index] = dataIn[schema->numBytesPerElement*index];
         }
         break;
     case STRING:
-        memcpy(&data[offset], dataIn, numElements);
+        memcpy(&data[offset], dataIn, schema->numElements);
         break;
     }
     // Done
@@ -737,7 +770,7 @@ qint32 UAVObjectField::unpack(const quint8* dataIn)
 
 bool UAVObjectField::isNumeric()
 {
-    switch (type)
+    switch (schema->type)
     {
     case INT8:
         return true;
@@ -776,7 +809,7 @@ bool UAVObjectField::isNumeric()
 
 bool UAVObjectField::isText()
 {
-    switch (type)
+    switch (schema->type)
     {
     case INT8:
         return false;
@@ -817,85 +850,85 @@ QVariant UAVObjectField::getValue(quint32 index)
 {
     QMutexLocker locker(obj->getMutex());
     // Check that index is not out of bounds
-    if ( index >= numElements )
+    if ( index >= schema->numElements )
     {
         return QVariant();
     }
     // Get value
-    switch (type)
+    switch (schema->type)
     {
     case INT8:
     {
         qint8 tmpint8;
-        memcpy(&tmpint8, &data[offset + numBytesPerElement*index], numBytesPerElement);
+        memcpy(&tmpint8, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
         return QVariant(tmpint8);
         break;
     }
     case INT16:
     {
         qint16 tmpint16;
-        memcpy(&tmpint16, &data[offset + numBytesPerElement*index], numBytesPerElement);
+        memcpy(&tmpint16, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
         return QVariant(tmpint16);
         break;
     }
     case INT32:
     {
         qint32 tmpint32;
-        memcpy(&tmpint32, &data[offset + numBytesPerElement*index], numBytesPerElement);
+        memcpy(&tmpint32, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
         return QVariant(tmpint32);
         break;
     }
     case UINT8:
     {
         quint8 tmpuint8;
-        memcpy(&tmpuint8, &data[offset + numBytesPerElement*index], numBytesPerElement);
+        memcpy(&tmpuint8, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
         return QVariant(tmpuint8);
         break;
     }
     case UINT16:
     {
         quint16 tmpuint16;
-        memcpy(&tmpuint16, &data[offset + numBytesPerElement*index], numBytesPerElement);
+        memcpy(&tmpuint16, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
         return QVariant(tmpuint16);
         break;
     }
     case UINT32:
     {
         quint32 tmpuint32;
-        memcpy(&tmpuint32, &data[offset + numBytesPerElement*index], numBytesPerElement);
+        memcpy(&tmpuint32, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
         return QVariant(tmpuint32);
         break;
     }
     case FLOAT32:
     {
         float tmpfloat;
-        memcpy(&tmpfloat, &data[offset + numBytesPerElement*index], numBytesPerElement);
+        memcpy(&tmpfloat, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
         return QVariant(tmpfloat);
         break;
     }
     case ENUM:
     {
         quint8 tmpenum;
-        memcpy(&tmpenum, &data[offset + numBytesPerElement*index], numBytesPerElement);
-        //            Q_ASSERT((tmpenum < options.length()) && (tmpenum >= 0)); // catch bad enum settings
-        if(tmpenum >= options.length()) {
-            qDebug() << "Invalid value for" << name;
+        memcpy(&tmpenum, &data[offset + schema->numBytesPerElement*index], schema->numBytesPerElement);
+        //            Q_ASSERT((tmpenum < schema->options.length()) && (tmpenum >= 0)); // catch bad enum settings
+        if(tmpenum >= schema->options.length()) {
+            qDebug() << "Invalid value for" << schema->name;
             return QVariant( QString("Bad Value") );
         }
-        return QVariant( options[tmpenum] );
+        return QVariant( schema->options[tmpenum] );
         break;
     }
     case BITFIELD:
     {
         quint8 tmpbitfield;
-        memcpy(&tmpbitfield, &data[offset + numBytesPerElement*((quint32)(index/8))], numBytesPerElement);
+        memcpy(&tmpbitfield, &data[offset + schema->numBytesPerElement*((quint32)(index/8))], schema->numBytesPerElement);
         tmpbitfield = (tmpbitfield >> (index % 8)) & 1;
         return QVariant( tmpbitfield );
         break;
     }
     case STRING:
     {
-        data[offset + numElements - 1] = '\0';
+        data[offset + schema->numElements - 1] = '\0';
         QString str((char*)&data[offset]);
         return QVariant( str );
         break;
@@ -909,7 +942,7 @@ bool UAVObjectField::checkValue(const QVariant& value, quint32 index)
 {
     QMutexLocker locker(obj->getMutex());
     // Check that index is not out of bounds
-    if ( index >= numElements )
+    if ( index >= schema->numElements )
     {
         return false;
     }
@@ -918,7 +951,7 @@ bool UAVObjectField::checkValue(const QVariant& value, quint32 index)
     // Update value if the access mode permits
     if ( UAVObject::GetFlightAccess(mdata) == UAVObject::ACCESS_READWRITE )
     {
-        switch (type)
+        switch (schema->type)
         {
         case INT8:
         case INT16:
@@ -933,12 +966,12 @@ bool UAVObjectField::checkValue(const QVariant& value, quint32 index)
             break;
         case ENUM:
         {
-            qint8 tmpenum = options.indexOf( value.toString() );
+            qint8 tmpenum = schema->options.indexOf( value.toString() );
             return ((tmpenum < 0) ? false : true);
             break;
         }
         default:
-            qDebug() << "checkValue: other types" << type;
+            qDebug() << "checkValue: other types" << schema->type;
             Q_ASSERT(0); // To catch any programming errors where we tried to test invalid values
             break;
         }
@@ -950,7 +983,7 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
 {
     QMutexLocker locker(obj->getMutex());
     // Check that index is not out of bounds
-    if ( index >= numElements )
+    if ( index >= schema->numElements )
     {
         return;
     }
@@ -959,63 +992,63 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
     // Update value if the access mode permits
     if ( UAVObject::GetGcsAccess(mdata) == UAVObject::ACCESS_READWRITE )
     {
-        switch (type)
+        switch (schema->type)
         {
         case INT8:
         {
             qint8 tmpint8 = value.toInt();
-            memcpy(&data[offset + numBytesPerElement*index], &tmpint8, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &tmpint8, schema->numBytesPerElement);
             break;
         }
         case INT16:
         {
             qint16 tmpint16 = value.toInt();
-            memcpy(&data[offset + numBytesPerElement*index], &tmpint16, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &tmpint16, schema->numBytesPerElement);
             break;
         }
         case INT32:
         {
             qint32 tmpint32 = value.toInt();
-            memcpy(&data[offset + numBytesPerElement*index], &tmpint32, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &tmpint32, schema->numBytesPerElement);
             break;
         }
         case UINT8:
         {
             quint8 tmpuint8 = value.toUInt();
-            memcpy(&data[offset + numBytesPerElement*index], &tmpuint8, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &tmpuint8, schema->numBytesPerElement);
             break;
         }
         case UINT16:
         {
             quint16 tmpuint16 = value.toUInt();
-            memcpy(&data[offset + numBytesPerElement*index], &tmpuint16, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &tmpuint16, schema->numBytesPerElement);
             break;
         }
         case UINT32:
         {
             quint32 tmpuint32 = value.toUInt();
-            memcpy(&data[offset + numBytesPerElement*index], &tmpuint32, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &tmpuint32, schema->numBytesPerElement);
             break;
         }
         case FLOAT32:
         {
             float tmpfloat = value.toFloat();
-            memcpy(&data[offset + numBytesPerElement*index], &tmpfloat, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &tmpfloat, schema->numBytesPerElement);
             break;
         }
         case ENUM:
         {
-            qint8 tmpenum = options.indexOf( value.toString() );
+            qint8 tmpenum = schema->options.indexOf( value.toString() );
             Q_ASSERT(tmpenum >= 0); // To catch any programming errors where we set invalid values
-            memcpy(&data[offset + numBytesPerElement*index], &tmpenum, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*index], &tmpenum, schema->numBytesPerElement);
             break;
         }
         case BITFIELD:
         {
             quint8 tmpbitfield;
-            memcpy(&tmpbitfield, &data[offset + numBytesPerElement*((quint32)(index/8))], numBytesPerElement);
+            memcpy(&tmpbitfield, &data[offset + schema->numBytesPerElement*((quint32)(index/8))], schema->numBytesPerElement);
             tmpbitfield = (tmpbitfield & ~(1 << (index % 8))) | ( (value.toUInt()!=0?1:0) << (index % 8) );
-            memcpy(&data[offset + numBytesPerElement*((quint32)(index/8))], &tmpbitfield, numBytesPerElement);
+            memcpy(&data[offset + schema->numBytesPerElement*((quint32)(index/8))], &tmpbitfield, schema->numBytesPerElement);
             break;
         }
         case STRING:
@@ -1023,7 +1056,7 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
             QString str = value.toString();
             QByteArray barray = str.toLatin1();
             quint32 index;
-            for (index = 0; index < (quint32)barray.length() && index < (numElements-1); ++index)
+            for (index = 0; index < (quint32)barray.length() && index < (schema->numElements-1); ++index)
             {
                 data[offset+index] = barray[index];
             }
@@ -51,8 +51,35 @@ public:
         int board;
     } LimitStruct;
 
+    /**
+     * The description of a field, which is the same for all instances of
+     * an object. The generated objects create the schema of their fields
+     * once and share it between all instances and clones.
+     */
+    class UAVOBJECTS_EXPORT Schema
+    {
+    public:
+        Schema(const QString& name, const QString& units, FieldType type, quint32 numElements, const QStringList& options, const QString& limits=QString());
+        Schema(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QString& limits=QString());
+
+        QString name;
+        QString units;
+        FieldType type;
+        QStringList elementNames;
+        QStringList options;
+        quint32 numElements;
+        quint32 numBytesPerElement;
+        QMap<quint32, QList<LimitStruct> > elementLimits;
+
+    private:
+        void initialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QString &limits);
+        void limitsInitialize(const QString &limits);
+    };
+
+    UAVObjectField(const Schema* schema);
     UAVObjectField(const QString& name, const QString& units, FieldType type, quint32 numElements, const QStringList& options,const QString& limits=QString());
     UAVObjectField(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options,const QString& limits=QString());
+    ~UAVObjectField();
     void initialize(quint8* data, quint32 dataOffset, UAVObject* obj);
     UAVObject* getObject();
     FieldType getType();
@@ -82,20 +109,12 @@ signals:
     void fieldUpdated(UAVObjectField* field);
 
 protected:
-    QString name;
-    QString units;
-    FieldType type;
-    QStringList elementNames;
-    QStringList options;
-    quint32 numElements;
-    quint32 numBytesPerElement;
+    const Schema* schema;
+    bool ownsSchema;
     quint32 offset;
     quint8* data;
     UAVObject* obj;
-    QMap<quint32, QList<LimitStruct> > elementLimits;
     void clear();
-    void constructorInitialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QString &limits);
-    void limitsInitialize(const QString &limits);
 
 
 };
@@ -72,6 +72,7 @@ HEADERS += $$UAVOBJECT_SYNTHETICS/accels.h \
     $$UAVOBJECT_SYNTHETICS/homelocation.h \
     $$UAVOBJECT_SYNTHETICS/hottsettings.h \
 	$$UAVOBJECT_SYNTHETICS/hwaq32.h \
+    $$UAVOBJECT_SYNTHETICS/heapledger.h \
     $$UAVOBJECT_SYNTHETICS/hwcolibri.h \
     $$UAVOBJECT_SYNTHETICS/hwcoptercontrol.h \
     $$UAVOBJECT_SYNTHETICS/hwdiscoveryf4.h \
@@ -88,6 +89,7 @@ HEADERS += $$UAVOBJECT_SYNTHETICS/accels.h \
     $$UAVOBJECT_SYNTHETICS/i2cvmuserprogram.h \
     $$UAVOBJECT_SYNTHETICS/inssettings.h \
     $$UAVOBJECT_SYNTHETICS/insstate.h \
+    $$UAVOBJECT_SYNTHETICS/latencystats.h \
     $$UAVOBJECT_SYNTHETICS/loitercommand.h \
     $$UAVOBJECT_SYNTHETICS/loggingsettings.h \
     $$UAVOBJECT_SYNTHETICS/loggingstats.h \
@@ -194,6 +196,7 @@ SOURCES += $$UAVOBJECT_SYNTHETICS/accels.cpp \
     $$UAVOBJECT_SYNTHETICS/homelocation.cpp \
     $$UAVOBJECT_SYNTHETICS/hottsettings.cpp \
 	$$UAVOBJECT_SYNTHETICS/hwaq32.cpp \
+    $$UAVOBJECT_SYNTHETICS/heapledger.cpp \
     $$UAVOBJECT_SYNTHETICS/hwcolibri.cpp \
     $$UAVOBJECT_SYNTHETICS/hwcoptercontrol.cpp \
     $$UAVOBJECT_SYNTHETICS/hwdiscoveryf4.cpp \
@@ -210,6 +213,7 @@ SOURCES += $$UAVOBJECT_SYNTHETICS/accels.cpp \
     $$UAVOBJECT_SYNTHETICS/i2cvmuserprogram.cpp \
     $$UAVOBJECT_SYNTHETICS/inssettings.cpp \
     $$UAVOBJECT_SYNTHETICS/insstate.cpp \
+    $$UAVOBJECT_SYNTHETICS/latencystats.cpp \
     $$UAVOBJECT_SYNTHETICS/loitercommand.cpp \
     $$UAVOBJECT_SYNTHETICS/loggingsettings.cpp \
     $$UAVOBJECT_SYNTHETICS/loggingstats.cpp \
@@ -32,23 +32,29 @@
  */
 #include "$(NAMELC).h"
 #include "uavobjectfield.h"
+#include <QMetaMethod>
+#include <cstring>
 
 const QString $(NAME)::NAME = QString("$(NAME)");
 const QString $(NAME)::DESCRIPTION = QString("$(DESCRIPTION)");
 const QString $(NAME)::CATEGORY = QString("$(CATEGORY)");
+const quint32 $(NAME)::FIELD_OFFSETS[$(NAME)::NUMFIELDS] = { $(FIELDOFFSETS) };
 
 /**
  * Constructor
  */
 $(NAME)::$(NAME)(): UAVDataObject(OBJID, ISSINGLEINST, ISSETTINGS, NAME)
 {
-    // Create fields
+    // Create fields, the schema of the fields is shared by all instances
+    static const QList<const UAVObjectField::Schema*> schemas = createFieldSchemas();
     QList<UAVObjectField*> fields;
-$(FIELDSINIT)
+    foreach (const UAVObjectField::Schema* schema, schemas)
+        fields.append( new UAVObjectField(schema) );
     // Initialize object
     initializeFields(fields, (quint8*)&data, NUMBYTES);
     // Set the default field values
     setDefaultFieldValues();
+    notifiedData = data;
     // Set the object description
     setDescription(DESCRIPTION);
 
@@ -59,6 +65,16 @@ $(FIELDSINIT)
             SLOT(emitNotifications()));
 }
 
+/**
+ * Create the schema of the fields, this is only done for the first instance
+ */
+QList<const UAVObjectField::Schema*> $(NAME)::createFieldSchemas()
+{
+    QList<const UAVObjectField::Schema*> schemas;
+$(FIELDSINIT)
+    return schemas;
+}
+
 /**
  * Get the default metadata for this object
  */
@@ -114,9 +130,56 @@ void $(NAME)::setData(const DataFields& data)
     }
 }
 
+/**
+ * Pack the data fields into the little endian wire format. The layout is
+ * known here, so every field is copied with its own type and size instead
+ * of going through the generic UAVObjectField::pack().
+ */
+void $(NAME)::packData(const DataFields& data, quint8* dataOut)
+{
+    const quint8* dataIn = (const quint8*)&data;
+$(PACKFIELDS)
+}
+
+/**
+ * Unpack the data fields from the little endian wire format
+ */
+void $(NAME)::unpackData(DataFields& data, const quint8* dataIn)
+{
+    quint8* dataOut = (quint8*)&data;
+$(UNPACKFIELDS)
+}
+
+/**
+ * Called by UAVObject::pack() with the object locked
+ */
+void $(NAME)::packFields(quint8* dataOut)
+{
+    packData(data, dataOut);
+}
+
+/**
+ * Called by UAVObject::unpack() with the object locked
+ */
+void $(NAME)::unpackFields(const quint8* dataIn)
+{
+    unpackData(data, dataIn);
+}
+
+/**
+ * Emit the change notifications of the properties which changed since the
+ * last notification. Properties which nothing is connected to are skipped,
+ * so objects which are not shown in QML cost almost nothing on an update.
+ */
 void $(NAME)::emitNotifications()
 {
-    $(NOTIFY_PROPERTIES_CHANGED)
+    mutex->lock();
+    DataFields oldData = notifiedData;
+    DataFields newData = data;
+    notifiedData = data;
+    mutex->unlock();
+
+$(NOTIFY_PROPERTIES_CHANGED)
 }
 
 /**
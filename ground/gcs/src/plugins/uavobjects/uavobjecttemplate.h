@@ -66,6 +66,8 @@ $(DATAFIELDINFO)
     static const bool ISSINGLEINST = $(ISSINGLEINST);
     static const bool ISSETTINGS = $(ISSETTINGS);
     static const quint32 NUMBYTES = $(NUMBYTES);
+    static const quint32 NUMFIELDS = $(NUMFIELDS);
+    static const quint32 FIELD_OFFSETS[NUMFIELDS];   // Byte offset of each field in DataFields and on the wire
 
     // Functions
     $(NAME)();
@@ -77,6 +79,8 @@ $(DATAFIELDINFO)
     UAVDataObject* dirtyClone();
 	
     static $(NAME)* GetInstance(UAVObjectManager* objMngr, quint32 instID = 0);
+    static void packData(const DataFields& data, quint8* dataOut);
+    static void unpackData(DataFields& data, const quint8* dataIn);
     static qint32 getNumInstances(UAVObjectManager* objMngr) {return objMngr->getNumInstances(OBJID);}
 
 $(PROPERTY_GETTERS)
@@ -87,12 +91,18 @@ $(PROPERTY_SETTERS)
 signals:
 $(PROPERTY_NOTIFICATIONS)
 
+protected:
+    void packFields(quint8* dataOut);
+    void unpackFields(const quint8* dataIn);
+
 private slots:
     void emitNotifications();
 	
 private:
     DataFields data;
+    DataFields notifiedData;    // The values last notified to the property listeners
 
+    static QList<const UAVObjectField::Schema*> createFieldSchemas();
     void setDefaultFieldValues();
 
 };
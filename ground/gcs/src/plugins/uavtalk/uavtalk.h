@@ -97,7 +97,6 @@ protected:
     static const quint16 OBJID_NOTFOUND = 0x0000;
 
     static const int TX_BUFFER_SIZE = 2*1024;
-    static const quint8 crc_table[256];
 
     // Types
     typedef enum {STATE_SYNC, STATE_TYPE, STATE_SIZE, STATE_OBJID, STATE_INSTID, STATE_DATA, STATE_CS} RxStateType;
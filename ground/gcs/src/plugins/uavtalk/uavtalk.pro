@@ -9,12 +9,14 @@ HEADERS += uavtalk.h \
     telemetrymonitor.h \
     telemetrymanager.h \
     uavtalk_global.h \
-    telemetry.h
+    telemetry.h \
+    $$GCS_SOURCE_TREE/../../shared/api/crc.h
 SOURCES += uavtalk.cpp \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
     telemetrymanager.cpp \
-    telemetry.cpp
+    telemetry.cpp \
+    $$GCS_SOURCE_TREE/../../shared/api/crc.c
 DEFINES += UAVTALK_LIBRARY
 OTHER_FILES += UAVTalk.pluginspec \
     UAVTalk.json
\ No newline at end of file
@@ -50,10 +50,22 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
             return false;
         }
 
+    // Generate the per object files of the changed objects in parallel
+    GeneratorManifest manifest(flightOutputPath,
+            QStringList() << flightCodeTemplate << flightIncludeTemplate);
+    bool generated = manifest.generate(parser,
+            [](ObjectInfo* info) {
+                return QStringList() << info->namelc + ".c" << info->namelc + ".h";
+            },
+            [this](ObjectInfo* info) { return process_object(info); });
+    if (!generated) {
+        cout << "Error: Could not generate flight object files" << endl;
+        return false;
+    }
+
     sizeCalc = 0;
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo* info=parser->getObjectByIndex(objidx);
-        process_object(info);
         flightObjInit.append("#ifdef UAVOBJ_INIT_" + info->namelc +"\r\n");
         flightObjInit.append("    " + info->name + "Initialize();\r\n");
         flightObjInit.append("#endif\r\n");
@@ -25,6 +25,7 @@
  */
 
 #include "uavobjectgeneratorgcs.h"
+#include <QSet>
 using namespace std;
 
 bool UAVObjectGeneratorGCS::generate(UAVObjectParser* parser,QString templatepath,QString outputpath) {
@@ -35,6 +36,10 @@ bool UAVObjectGeneratorGCS::generate(UAVObjectParser* parser,QString templatepat
     fieldTypeStrCPPClass << "INT8" << "INT16" << "INT32"
         << "UINT8" << "UINT16" << "UINT32" << "FLOAT32" << "ENUM";
 
+    // Integer type swapped to little endian, none for single bytes
+    fieldTypeStrWire << "" << "qint16" << "qint32" <<
+        "" << "quint16" << "quint32" << "quint32" << "";
+
     gcsCodePath = QDir( templatepath + QString(GCS_CODE_DIR));
     gcsOutputPath = QDir( outputpath + QString("gcs") );
     gcsOutputPath.mkpath(gcsOutputPath.absolutePath());
@@ -51,9 +56,21 @@ bool UAVObjectGeneratorGCS::generate(UAVObjectParser* parser,QString templatepat
     QString objInc;
     QString gcsObjInit;
 
+    // Generate the per object files of the changed objects in parallel
+    GeneratorManifest manifest(gcsOutputPath,
+            QStringList() << gcsCodeTemplate << gcsIncludeTemplate);
+    bool generated = manifest.generate(parser,
+            [](ObjectInfo* info) {
+                return QStringList() << info->namelc + ".cpp" << info->namelc + ".h";
+            },
+            [this](ObjectInfo* info) { return process_object(info); });
+    if (!generated) {
+        cout << "Error: Could not generate gcs object files" << endl;
+        return false;
+    }
+
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo* info=parser->getObjectByIndex(objidx);
-        process_object(info);
 
         gcsObjInit.append("    objMngr->registerObject( new " + info->name + "() );\n");
         objInc.append("#include \"" + info->namelc + ".h\"\n");
@@ -119,6 +136,20 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
     QStringList reservedProperties;
     reservedProperties << "Description" << "Metadata";
 
+    //the notifications find their signal with QMetaMethod::fromSignal(), which
+    //needs a signal name that isn't overloaded in the object or its base classes
+    QSet<QString> notifySignals;
+    notifySignals << "presentOnHardwareChanged";
+    auto addNotifySignal = [&](const QString &notifySignal) {
+        if (notifySignals.contains(notifySignal)) {
+            cerr << "Error: " << info->name.toStdString() << " would overload signal "
+                 << notifySignal.toStdString() << endl;
+            return false;
+        }
+        notifySignals << notifySignal;
+        return true;
+    };
+
     for (int n = 0; n < info->fields.length(); ++n)
     {
         FieldInfo *field = info->fields[n];
@@ -130,6 +161,9 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
         type = fieldTypeStrCPP[field->type];
         // Append field
         if ( field->numElements > 1 ) {
+            if (!addNotifySignal(field->name + "Changed"))
+                return false;
+
             //add both field(elementIndex)/setField(elemntIndex,value) and field_element properties
             //field_element is more convenient if only certain element is used
             //and much easier to use from the qml side
@@ -162,6 +196,8 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
 
             for (int elementIndex = 0; elementIndex < field->numElements; elementIndex++) {
                 QString elementName = field->elementNames[elementIndex];
+                if (!addNotifySignal(field->name + "_" + elementName + "Changed"))
+                    return false;
                 properties += QString("    Q_PROPERTY(%1 %2 READ get%2 WRITE set%2 NOTIFY %2Changed);\n")
                         .arg(type).arg(field->name+"_"+elementName);
                 propertyGetters +=
@@ -183,6 +219,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                                 "   mutex->lock();\n"
                                 "   bool changed = data.%2[%5] != value;\n"
                                 "   data.%2[%5] = value;\n"
+                                "   notifiedData.%2[%5] = value;\n"
                                 "   mutex->unlock();\n"
                                 "   if (changed) emit %2_%3Changed(value);\n"
                                 "}\n\n")
@@ -191,11 +228,15 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                         QString("    void %1_%2Changed(%3 value);\n")
                         .arg(field->name).arg(elementName).arg(type);
                 propertyNotificationsImpl +=
-                        QString("        //if (data.%1[%2] != oldData.%1[%2])\n"
-                                "            emit %1_%3Changed(data.%1[%2]);\n")
-                        .arg(field->name).arg(elementIndex).arg(elementName);
+                        QString("    if (memcmp(&newData.%1[%2], &oldData.%1[%2], sizeof(newData.%1[%2])) != 0 &&\n"
+                                "        isSignalConnected(QMetaMethod::fromSignal(&%4::%1_%3Changed)))\n"
+                                "        emit %1_%3Changed(newData.%1[%2]);\n")
+                        .arg(field->name).arg(elementIndex).arg(elementName).arg(info->name);
             }
         } else {
+            if (!addNotifySignal(field->name + "Changed"))
+                return false;
+
             properties += QString("    Q_PROPERTY(%1 %2 READ get%2 WRITE set%2 NOTIFY %2Changed);\n")
                     .arg(type).arg(field->name);
             propertyGetters +=
@@ -217,6 +258,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                             "   mutex->lock();\n"
                             "   bool changed = data.%2 != value;\n"
                             "   data.%2 = value;\n"
+                            "   notifiedData.%2 = value;\n"
                             "   mutex->unlock();\n"
                             "   if (changed) emit %2Changed(value);\n"
                             "}\n\n")
@@ -225,9 +267,10 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                     QString("    void %1Changed(%2 value);\n")
                     .arg(field->name).arg(type);
             propertyNotificationsImpl +=
-                    QString("        //if (data.%1 != oldData.%1)\n"
-                            "            emit %1Changed(data.%1);\n")
-                    .arg(field->name);
+                    QString("    if (memcmp(&newData.%1, &oldData.%1, sizeof(newData.%1)) != 0 &&\n"
+                            "        isSignalConnected(QMetaMethod::fromSignal(&%2::%1Changed)))\n"
+                            "        emit %1Changed(newData.%1);\n")
+                    .arg(field->name).arg(info->name);
         }
     }
 
@@ -263,7 +306,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                               .arg(varOptionName)
                               .arg(options[m]) );
             }
-            finit.append( QString("    fields.append( new UAVObjectField(QString(\"%1\"), QString(\"%2\"), UAVObjectField::ENUM, %3, %4, QString(\"%5\")));\n")
+            finit.append( QString("    schemas.append( new UAVObjectField::Schema(QString(\"%1\"), QString(\"%2\"), UAVObjectField::ENUM, %3, %4, QString(\"%5\")));\n")
                           .arg(info->fields[n]->name)
                           .arg(info->fields[n]->units)
                           .arg(varElemName)
@@ -272,7 +315,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
         }
         // For all other types
         else {
-            finit.append( QString("    fields.append( new UAVObjectField(QString(\"%1\"), QString(\"%2\"), UAVObjectField::%3, %4, QStringList(), QString(\"%5\")));\n")
+            finit.append( QString("    schemas.append( new UAVObjectField::Schema(QString(\"%1\"), QString(\"%2\"), UAVObjectField::%3, %4, QStringList(), QString(\"%5\")));\n")
                           .arg(info->fields[n]->name)
                           .arg(info->fields[n]->units)
                           .arg(fieldTypeStrCPPClass[info->fields[n]->type])
@@ -398,6 +441,39 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
 
     outCode.replace(QString("$(INITFIELDS)"), initfields);
 
+    // Replace the $(PACKFIELDS), $(UNPACKFIELDS) and $(FIELDOFFSETS) tags.
+    // The fields are laid out in DataFields as they are on the wire, so the
+    // offsets are the same on both sides.
+    QString packfields;
+    QString unpackfields;
+    QStringList offsets;
+    int offset = 0;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        FieldInfo* field = info->fields[n];
+        QString wireType = fieldTypeStrWire[field->type];
+        int size = field->numBytes * field->numElements;
+
+        if (wireType.isEmpty()) {
+            packfields.append( QString("    memcpy(&dataOut[%1], &dataIn[%1], %2); // %3\n")
+                               .arg(offset).arg(size).arg(field->name) );
+            unpackfields.append( QString("    memcpy(&dataOut[%1], &dataIn[%1], %2); // %3\n")
+                                 .arg(offset).arg(size).arg(field->name) );
+        } else {
+            packfields.append( QString("    packElements<%1>(&dataOut[%2], &dataIn[%2], %3); // %4\n")
+                               .arg(wireType).arg(offset).arg(field->numElements).arg(field->name) );
+            unpackfields.append( QString("    unpackElements<%1>(&dataOut[%2], &dataIn[%2], %3); // %4\n")
+                                 .arg(wireType).arg(offset).arg(field->numElements).arg(field->name) );
+        }
+
+        offsets << QString().setNum(offset);
+        offset += size;
+    }
+    outCode.replace(QString("$(PACKFIELDS)"), packfields);
+    outCode.replace(QString("$(UNPACKFIELDS)"), unpackfields);
+    outCode.replace(QString("$(FIELDOFFSETS)"), offsets.join(", "));
+    outInclude.replace(QString("$(NUMFIELDS)"), QString().setNum(info->fields.length()));
+
     // Write the GCS code
     bool res = writeFileIfDiffrent( gcsOutputPath.absolutePath() + "/" + info->namelc + ".cpp", outCode );
     if (!res) {
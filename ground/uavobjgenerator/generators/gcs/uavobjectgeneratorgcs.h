@@ -40,7 +40,7 @@ private:
     bool process_object(ObjectInfo* info);
 
     QString gcsCodeTemplate,gcsIncludeTemplate;
-    QStringList fieldTypeStrCPP,fieldTypeStrCPPClass;
+    QStringList fieldTypeStrCPP,fieldTypeStrCPPClass,fieldTypeStrWire;
     QDir gcsCodePath;
     QDir gcsOutputPath;
 };
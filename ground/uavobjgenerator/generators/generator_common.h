@@ -29,6 +29,7 @@
 
 #include "../uavobjectparser.h"
 #include "generator_io.h"
+#include "generator_manifest.h"
 
 // These special chars (regexp) will be removed from C/java identifiers
 #define ENUM_SPECIAL_CHARS "[\\.\\-\\s\\+/\\(\\)]"
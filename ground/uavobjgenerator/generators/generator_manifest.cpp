@@ -0,0 +1,205 @@
+/**
+ ******************************************************************************
+ *
+ * @file       generator_manifest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Per object record of the generated files and their inputs
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "generator_manifest.h"
+#include "generator_io.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QtConcurrent/QtConcurrentMap>
+#include <iostream>
+
+#define MANIFEST_FILE "uavobjects.manifest"
+#define MANIFEST_HEADER "# uavobjgenerator manifest: object hash outputs..."
+
+using namespace std;
+
+bool GeneratorManifest::serial = false;
+
+/**
+ * Hash of the generator binary, so that a rebuilt generator regenerates
+ * everything once
+ */
+static QByteArray generatorHash()
+{
+    static QByteArray hash;
+
+    if (hash.isNull()) {
+        QFile self(QCoreApplication::applicationFilePath());
+        QCryptographicHash sha(QCryptographicHash::Sha1);
+        if (self.open(QFile::ReadOnly))
+            sha.addData(self.readAll());
+        hash = sha.result();
+    }
+
+    return hash;
+}
+
+/**
+ * Load the manifest of a language
+ * @param outputPath directory of the generated files
+ * @param templates contents of all templates the per object files use
+ */
+GeneratorManifest::GeneratorManifest(const QDir& outputPath, const QStringList& templates) :
+    outputPath(outputPath)
+{
+    fileName = outputPath.absoluteFilePath(MANIFEST_FILE);
+
+    QCryptographicHash sha(QCryptographicHash::Sha1);
+    sha.addData(generatorHash());
+    foreach (const QString& text, templates) {
+        sha.addData(text.toUtf8());
+        sha.addData("\0", 1);
+    }
+    baseHash = sha.result();
+
+    load();
+}
+
+/**
+ * Generate the files of all objects that changed, spread over the cores.
+ * @param parser the parsed objects
+ * @param outputs the files generated for an object, relative to the output directory
+ * @param process generates the files of one object, called concurrently
+ * @returns true if all objects were generated and the manifest was written
+ */
+bool GeneratorManifest::generate(UAVObjectParser* parser,
+                                 std::function<QStringList(ObjectInfo*)> outputs,
+                                 std::function<bool(ObjectInfo*)> process)
+{
+    QAtomicInt generated(0);
+
+    std::function<bool(ObjectInfo*)> job = [&](ObjectInfo* info) -> bool {
+        QStringList files = outputs(info);
+
+        if (!serial && isCurrent(info, files))
+            return true;
+
+        if (!process(info))
+            return false;
+
+        update(info, files);
+        generated.ref();
+        return true;
+    };
+
+    QList<bool> results;
+    if (serial) {
+        foreach (ObjectInfo* info, parser->getObjectInfo())
+            results.append(job(info));
+    } else {
+        results = QtConcurrent::blockingMapped<QList<bool> >(parser->getObjectInfo(), job);
+    }
+
+    cout << "  regenerated " << generated.load() << " of " << parser->getNumObjects() << " objects" << endl;
+
+    bool res = save();
+    if (!res)
+        cout << "Error: Could not write " << fileName.toStdString() << endl;
+
+    return res && !results.contains(false);
+}
+
+/**
+ * Generate every object on the calling thread, whether it changed or not
+ */
+void GeneratorManifest::setSerial(bool value)
+{
+    serial = value;
+}
+
+QByteArray GeneratorManifest::objectHash(ObjectInfo* info) const
+{
+    QCryptographicHash sha(QCryptographicHash::Sha1);
+    sha.addData(baseHash);
+    sha.addData(info->sourceHash);
+    sha.addData(info->name.toUtf8());
+    return sha.result().toHex();
+}
+
+bool GeneratorManifest::isCurrent(ObjectInfo* info, const QStringList& outputs) const
+{
+    QByteArray hash = objectHash(info);
+
+    QMutexLocker lock(&mutex);
+
+    QMap<QString, Entry>::const_iterator entry = entries.constFind(info->name);
+    if (entry == entries.constEnd() || entry->hash != hash || entry->outputs != outputs)
+        return false;
+
+    foreach (const QString& output, outputs) {
+        if (!outputPath.exists(output))
+            return false;
+    }
+
+    return true;
+}
+
+void GeneratorManifest::update(ObjectInfo* info, const QStringList& outputs)
+{
+    Entry entry;
+    entry.hash = objectHash(info);
+    entry.outputs = outputs;
+
+    QMutexLocker lock(&mutex);
+    entries.insert(info->name, entry);
+}
+
+void GeneratorManifest::load()
+{
+    QString text = readFile(fileName, false);
+
+    foreach (const QString& line, text.split('\n', QString::SkipEmptyParts)) {
+        if (line.startsWith('#'))
+            continue;
+
+        QStringList words = line.split(' ', QString::SkipEmptyParts);
+        if (words.length() < 3)
+            continue;
+
+        Entry entry;
+        entry.hash = words[1].toLatin1();
+        entry.outputs = words.mid(2);
+        entries.insert(words[0], entry);
+    }
+}
+
+bool GeneratorManifest::save()
+{
+    QString text = MANIFEST_HEADER "\n";
+
+    // Objects not generated in this run, e.g. when only some were asked
+    // for, keep their entries
+    for (QMap<QString, Entry>::const_iterator entry = entries.constBegin();
+         entry != entries.constEnd(); ++entry) {
+        text.append(entry.key() + " " + QString::fromLatin1(entry->hash) + " " +
+                    entry->outputs.join(" ") + "\n");
+    }
+
+    return writeFileIfDiffrent(fileName, text);
+}
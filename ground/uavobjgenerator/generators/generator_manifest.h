@@ -0,0 +1,84 @@
+/**
+ ******************************************************************************
+ *
+ * @file       generator_manifest.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @brief      Per object record of the generated files and their inputs
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef GENERATORMANIFEST_H
+#define GENERATORMANIFEST_H
+
+#include <functional>
+#include <QByteArray>
+#include <QDir>
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+
+#include "../uavobjectparser.h"
+
+/**
+ * Every language generator keeps a manifest in its output directory. It
+ * lists, for each object, the hash of everything the generated files depend
+ * on (the XML of the object, the templates and the generator itself) and
+ * the files generated from it. Objects whose inputs did not change and
+ * whose files are still there are skipped, the others are generated in
+ * parallel. Together with writing files only when their content changed
+ * this leaves the timestamps of all unaffected outputs alone, so make only
+ * rebuilds the translation units that include a changed object.
+ *
+ * In serial mode every object is generated, one after the other, as the
+ * generator did before it had a manifest.
+ */
+class GeneratorManifest
+{
+public:
+    GeneratorManifest(const QDir& outputPath, const QStringList& templates);
+
+    bool generate(UAVObjectParser* parser,
+                  std::function<QStringList(ObjectInfo*)> outputs,
+                  std::function<bool(ObjectInfo*)> process);
+
+    static void setSerial(bool serial);
+
+private:
+    struct Entry {
+        QByteArray hash;
+        QStringList outputs;
+    };
+
+    QByteArray objectHash(ObjectInfo* info) const;
+    bool isCurrent(ObjectInfo* info, const QStringList& outputs) const;
+    void update(ObjectInfo* info, const QStringList& outputs);
+    void load();
+    bool save();
+
+    QDir outputPath;
+    QString fileName;
+    QByteArray baseHash;
+    QMap<QString, Entry> entries;
+    mutable QMutex mutex;
+
+    static bool serial;
+};
+
+#endif
@@ -50,9 +50,20 @@ bool UAVObjectGeneratorJava::generate(UAVObjectParser* parser,QString templatepa
     QString objInc;
     QString javaObjInit;
 
+    // Generate the per object files of the changed objects in parallel
+    GeneratorManifest manifest(javaOutputPath, QStringList() << javaCodeTemplate);
+    bool generated = manifest.generate(parser,
+            [](ObjectInfo* info) {
+                return QStringList() << info->name + ".java";
+            },
+            [this](ObjectInfo* info) { return process_object(info); });
+    if (!generated) {
+        cout << "Error: Could not generate java object files" << endl;
+        return false;
+    }
+
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo* info=parser->getObjectByIndex(objidx);
-        process_object(info);
 
         javaObjInit.append("\t\t\tobjMngr.registerObject( new " + info->name + "() );\n");
         objInc.append("#include \"" + info->namelc + ".h\"\n");
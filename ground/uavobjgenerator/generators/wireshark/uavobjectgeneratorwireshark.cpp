@@ -83,11 +83,24 @@ bool UAVObjectGeneratorWireshark::generate(UAVObjectParser* parser,QString templ
 		  uavobjectsOutputPath.absoluteFilePath(uavostaticfiles[i]));
     }
 
-    /* Generate the per-object files from the templates, and keep track of the list of generated filenames */
+    /* Generate the per-object files of the changed objects from the templates in parallel */
+    GeneratorManifest manifest(uavobjectsOutputPath, QStringList() << wiresharkCodeTemplate);
+    bool generated = manifest.generate(parser,
+            [](ObjectInfo* info) {
+              return QStringList() << "packet-op-uavobjects-" + info->namelc + ".c";
+            },
+            [this, &uavobjectsOutputPath](ObjectInfo* info) {
+              return process_object(info, uavobjectsOutputPath);
+            });
+    if (!generated) {
+      cout << "Error: Could not generate wireshark object files" << endl;
+      return false;
+    }
+
+    /* Keep track of the list of generated filenames */
     QString objFileNames;
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
       ObjectInfo* info = parser->getObjectByIndex(objidx);
-      process_object(info, uavobjectsOutputPath);
       objFileNames.append(" packet-op-uavobjects-" + info->namelc + ".c");
     }
 
@@ -27,6 +27,8 @@
 #include <QFile>
 #include <QString>
 #include <QStringList>
+#include <QtConcurrent/QtConcurrentMap>
+#include <functional>
 #include <iostream>
 
 #include "generators/java/uavobjectgeneratorjava.h"
@@ -41,11 +43,21 @@
 
 using namespace std;
 
+/**
+ * One XML file, parsed by its own parser so that the files can be parsed in
+ * parallel
+ */
+struct ParseJob {
+    QFileInfo fileinfo;
+    UAVObjectParser* parser;
+    QString result;
+};
+
 /**
  * print usage info
  */
 void usage() {
-    cout << "Usage: uavobjectgenerator [-gcs] [-flight] [-java] [-matlab] [-wireshark] [-none] [-v] xml_path template_base [UAVObj1] ... [UAVObjN]" << endl;
+    cout << "Usage: uavobjectgenerator [-gcs] [-flight] [-java] [-matlab] [-wireshark] [-none] [-serial] [-v] xml_path template_base [UAVObj1] ... [UAVObjN]" << endl;
     cout << "Languages: "<< endl;
     cout << "\t-gcs           build groundstation code" << endl;
     cout << "\t-flight        build flight code" << endl;
@@ -55,6 +67,8 @@ void usage() {
     cout << "\tIf no language is specified ( and not -none ) -> all are built." << endl;
     cout << "Misc: "<< endl;
     cout << "\t-none          build no language - just parse xml's" << endl;
+    cout << "\t-serial        parse and generate on one thread and regenerate all objects," << endl;
+    cout << "\t               to check the output of the parallel generator against" << endl;
     cout << "\t-h             this help" << endl;
     cout << "\t-v             verbose" << endl;
     cout << "\tinput_path     path to UAVObject definition (.xml) files." << endl;
@@ -104,6 +118,9 @@ int main(int argc, char *argv[])
     bool do_matlab=(arguments_stringlist.removeAll("-matlab")>0);
     bool do_wireshark=(arguments_stringlist.removeAll("-wireshark")>0);
     bool do_none=(arguments_stringlist.removeAll("-none")>0); //
+    bool serial=(arguments_stringlist.removeAll("-serial")>0);
+
+    GeneratorManifest::setSerial(serial);
 
     bool do_all=((do_gcs||do_flight||do_java||do_matlab)==false);
     bool do_allObjects=true;
@@ -140,7 +157,7 @@ int main(int argc, char *argv[])
     QFileInfoList xmlList = xmlPath.entryInfoList();
 
     // Read in each XML file and parse object(s) in them
-    
+    QList<ParseJob> jobs;
     for (int n = 0; n < xmlList.length(); ++n) {
         QFileInfo fileinfo = xmlList[n];
         if (!do_allObjects) {
@@ -152,18 +169,39 @@ int main(int argc, char *argv[])
         }
         if (verbose)
           cout << "Parsing XML file: " << fileinfo.fileName().toStdString() << endl;
-        QString filename = fileinfo.fileName();
-        QString xmlstr = readFile(fileinfo.absoluteFilePath());
 
-        QString res = parser->parseXML(xmlstr, filename);
+        ParseJob job;
+        job.fileinfo = fileinfo;
+        job.parser = new UAVObjectParser();
+        jobs.append(job);
+    }
 
-        if (!res.isNull()) {
+    std::function<void(ParseJob&)> parse = [](ParseJob& job) {
+        QString filename = job.fileinfo.fileName();
+        QString xmlstr = readFile(job.fileinfo.absoluteFilePath());
+
+        job.result = job.parser->parseXML(xmlstr, filename);
+    };
+    if (serial) {
+        for (int n = 0; n < jobs.length(); ++n)
+            parse(jobs[n]);
+    } else {
+        QtConcurrent::blockingMap(jobs, parse);
+    }
+
+    // Merge in file order, so the objects keep the order of a serial parse
+    for (int n = 0; n < jobs.length(); ++n) {
+        ParseJob& job = jobs[n];
+        if (!job.result.isNull()) {
 	    if (!verbose) {
-               cout << "Error in XML file: " << fileinfo.fileName().toStdString() << endl;
+               cout << "Error in XML file: " << job.fileinfo.fileName().toStdString() << endl;
             }
-            cout << "Error parsing " << res.toStdString() << endl;
+            cout << "Error parsing " << job.result.toStdString() << endl;
             return RETURN_ERR_XML;
         }
+
+        parser->takeObjects(job.parser);
+        delete job.parser;
     }
 
     if (objects_stringlist.length() > 0) {
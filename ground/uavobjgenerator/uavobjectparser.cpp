@@ -26,6 +26,7 @@
 
 #include <QTextStream>
 #include "uavobjectparser.h"
+#include <QCryptographicHash>
 
 /**
  * Constructor
@@ -68,6 +69,20 @@ ObjectInfo* UAVObjectParser::getObjectByIndex(int objIndex)
     return objInfo[objIndex];
 }
 
+/**
+ * Move the objects and units of another parser to the end of this one.
+ * XML files can be parsed by separate parsers in parallel and then be
+ * merged in file order.
+ */
+void UAVObjectParser::takeObjects(UAVObjectParser* other)
+{
+    objInfo.append(other->objInfo);
+    other->objInfo.clear();
+
+    all_units.append(other->all_units);
+    all_units.removeDuplicates();
+}
+
 /**
  * Get the name of the object
  */
@@ -155,6 +170,8 @@ QString UAVObjectParser::parseXML(QString& xml, QString& filename)
         return genErrorMsg(filename, errorMsg, errorLine, errorCol);
     }
 
+    QByteArray sourceHash = QCryptographicHash::hash(xml.toUtf8(), QCryptographicHash::Sha1);
+
     // Read all objects contained in the XML file, creating an new ObjectInfo for each
     QDomElement docElement = doc.documentElement();
     QDomNode node = docElement.firstChild();
@@ -163,6 +180,7 @@ QString UAVObjectParser::parseXML(QString& xml, QString& filename)
         ObjectInfo* info = new ObjectInfo;
 
         info->filename=filename;
+        info->sourceHash=sourceHash;
         // Process object attributes
         QString status = processObjectAttributes(node, info);
         if (!status.isNull())
@@ -81,6 +81,7 @@ typedef struct  {
     QString name;
     QString namelc; /** name in lowercase */
     QString filename;
+    QByteArray sourceHash; /** hash of the XML text the object was parsed from */
     quint32 id;
     bool isSingleInst;
     bool isSettings;
@@ -107,6 +108,7 @@ public:
     // Functions
     UAVObjectParser();
     QString parseXML(QString& xml, QString& filename);
+    void takeObjects(UAVObjectParser* other);
     int getNumObjects();
     QList<ObjectInfo*> getObjectInfo();
     QString getObjectName(int objIndex);
@@ -1,7 +1,7 @@
 # -------------------------------------------------
 # Project created by QtCreator 2010-03-21T20:44:17
 # -------------------------------------------------
-QT += xml
+QT += xml concurrent
 QT -= gui
 
 macx {
@@ -12,12 +12,13 @@ macx {
 cache()
 
 TARGET = uavobjgenerator
-CONFIG += console
+CONFIG += console c++11
 CONFIG -= app_bundle
 TEMPLATE = app
 SOURCES += main.cpp \
     uavobjectparser.cpp \
     generators/generator_io.cpp \
+    generators/generator_manifest.cpp \
     generators/java/uavobjectgeneratorjava.cpp \
     generators/flight/uavobjectgeneratorflight.cpp \
     generators/gcs/uavobjectgeneratorgcs.cpp \
@@ -26,6 +27,7 @@ SOURCES += main.cpp \
     generators/generator_common.cpp
 HEADERS += uavobjectparser.h \
     generators/generator_io.h \
+    generators/generator_manifest.h \
     generators/java/uavobjectgeneratorjava.h \
     generators/gcs/uavobjectgeneratorgcs.h \
     generators/matlab/uavobjectgeneratormatlab.h \
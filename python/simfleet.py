@@ -0,0 +1,227 @@
+#!/usr/bin/python -B
+
+# Insert the parent directory into the module import search path.
+import os
+import sys
+sys.path.insert(1, os.path.dirname(sys.path[0]))
+
+import argparse
+import errno
+import socket
+import subprocess
+import time
+from taulabs import telemetry
+
+#-------------------------------------------------------------------------------
+USAGE = "%(prog)s [options] count"
+DESC  = """
+  Run a fleet of simulated vehicles on this host and report their loop timing.
+
+  Every vehicle is an instance of the posix simulation target started with
+  -i <n>, which moves all of its ports up by 20 * n and keeps its settings in
+  its own flash file, and -r <seed> for its sensor noise.  One thread services
+  the telemetry of all instances.  The loop timing comes from LatencyStats, so
+  build the simulation with DIAG_LATENCY=YES.\
+"""
+
+# Must match PIOS_SYS_INSTANCE_PORT_STRIDE in PiOS.posix/posix/pios_sys.c
+PORT_STRIDE = 20
+TELEMETRY_PORT = 9000
+
+LATENCY_ELEMENTS = ['SensorToAttitude', 'AttitudeToStabilization',
+                    'StabilizationToActuator', 'SensorToActuator',
+                    'StabilizationPeriod']
+
+#-------------------------------------------------------------------------------
+def launch(elf, workdir, instance, seed, sil_port):
+    """ Starts one instance, its console output goes to sim<instance>.log """
+
+    cmd = [elf, '-i', str(instance), '-r', str(seed)]
+    if sil_port is not None:
+        cmd += ['-s', str(sil_port)]
+
+    log = open(os.path.join(workdir, 'sim%d.log' % instance), 'w')
+
+    return subprocess.Popen(cmd, cwd=workdir, stdout=log,
+                            stderr=subprocess.STDOUT)
+
+def connect(host, port, timeout, proc=None):
+    """ Connects to an instance once its telemetry port is open """
+
+    deadline = time.time() + timeout
+
+    while True:
+        try:
+            return telemetry.NetworkTelemetry(host=host, port=port,
+                                              service_in_iter=False)
+        except socket.error as e:
+            if e.errno != errno.ECONNREFUSED or time.time() > deadline:
+                raise
+            if proc is not None and proc.poll() is not None:
+                raise RuntimeError("simulator on port %d exited with %d" %
+                                   (port, proc.returncode))
+            time.sleep(0.2)
+
+def latency_of(values):
+    """ Finds the LatencyStats instance among the last values of a stream """
+
+    for cls, obj in values.iteritems():
+        if cls.__name__ == 'UAVO_LatencyStats':
+            return obj
+
+    return None
+
+def median(lst):
+    lst = sorted(lst)
+    mid = len(lst) // 2
+
+    if len(lst) % 2:
+        return lst[mid]
+
+    return (lst[mid - 1] + lst[mid]) / 2.0
+
+def report(streams, ports):
+    """ Prints the per instance loop timing and the fleet aggregate """
+
+    per_instance = []
+
+    print
+    print "%-4s %-6s %-24s %8s %8s %8s %8s" % \
+        ("inst", "port", "latency [us]", "p50", "p99", "max", "samples")
+
+    for i, t in enumerate(streams):
+        stats = latency_of(t.get_last_values())
+        per_instance.append(stats)
+
+        if stats is None:
+            print "%-4d %-6d %s" % (i, ports[i],
+                "no LatencyStats (build with DIAG_LATENCY=YES)" if not t._done()
+                else "connection closed")
+            continue
+
+        for e, name in enumerate(LATENCY_ELEMENTS):
+            print "%-4s %-6s %-24s %8d %8d %8d %8d" % (
+                i if e == 0 else "", ports[i] if e == 0 else "", name,
+                stats.P50[e], stats.P99[e], stats.Max[e], stats.Samples[e])
+
+    reporting = [s for s in per_instance if s is not None]
+    if not reporting:
+        return
+
+    # Percentiles do not combine, so the fleet shows the median instance and
+    # the worst instance rather than a percentile over all samples
+    print "%-11s %-24s %8s %8s %8s %8s" % \
+        ("fleet (%d)" % len(reporting), "", "med p50", "worst p99",
+         "worst max", "samples")
+
+    for e, name in enumerate(LATENCY_ELEMENTS):
+        print "%-11s %-24s %8.0f %9d %9d %8d" % ("", name,
+            median([s.P50[e] for s in reporting]),
+            max([s.P99[e] for s in reporting]),
+            max([s.Max[e] for s in reporting]),
+            sum([s.Samples[e] for s in reporting]))
+
+#-------------------------------------------------------------------------------
+def main():
+    parser = argparse.ArgumentParser(usage=USAGE, description=DESC,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+
+    default_elf = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                               "..", "build", "sim_posix", "sim_posix.elf")
+
+    parser.add_argument("count", type=int,
+                        help="number of vehicles")
+
+    parser.add_argument("-e", "--elf",
+                        default=default_elf,
+                        help="simulation binary (default %(default)s)")
+
+    parser.add_argument("-w", "--workdir",
+                        default="simfleet",
+                        help="directory for the flash files and logs")
+
+    parser.add_argument("-r", "--seed",
+                        type=int, default=1,
+                        help="seed of instance 0, instance n uses seed + n")
+
+    parser.add_argument("-s", "--sil-port",
+                        type=int, default=None,
+                        help="start every instance with a lockstep SIL link "
+                             "on this port, offset like the others")
+
+    parser.add_argument("-c", "--connect-only",
+                        action="store_true", default=False,
+                        help="attach to instances that are already running")
+
+    parser.add_argument("--host",
+                        default="127.0.0.1",
+                        help="host of the instances for --connect-only")
+
+    parser.add_argument("-d", "--duration",
+                        type=float, default=None,
+                        help="seconds to run, default until interrupted")
+
+    parser.add_argument("-i", "--interval",
+                        type=float, default=5.0,
+                        help="seconds between reports")
+
+    args = parser.parse_args()
+
+    if args.count < 1:
+        parser.error("count must be at least 1")
+
+    procs = []
+
+    try:
+        if not args.connect_only:
+            if not os.path.isdir(args.workdir):
+                os.makedirs(args.workdir)
+
+            for i in range(args.count):
+                procs.append(launch(os.path.abspath(args.elf), args.workdir,
+                                    i, args.seed + i, args.sil_port))
+
+        ports = [TELEMETRY_PORT + i * PORT_STRIDE for i in range(args.count)]
+
+        streams = []
+        for i, port in enumerate(ports):
+            streams.append(connect(args.host, port, 30,
+                                   procs[i] if procs else None))
+            print "Connected to instance %d on port %d" % (i, port)
+
+        fleet = telemetry.MultiTelemetry(streams)
+
+        start = time.time()
+        end = start + args.duration if args.duration is not None else None
+        next_report = start + args.interval
+
+        while not fleet._done():
+            now = time.time()
+
+            if end is not None and now >= end:
+                break
+
+            if now >= next_report:
+                report(streams, ports)
+                next_report += args.interval
+
+            wake = next_report if end is None else min(next_report, end)
+            fleet.service_connection(max(0, wake - time.time()))
+
+        report(streams, ports)
+
+    except KeyboardInterrupt:
+        pass
+
+    finally:
+        for p in procs:
+            if p.poll() is None:
+                p.terminate()
+
+        for p in procs:
+            p.wait()
+
+#-------------------------------------------------------------------------------
+
+if __name__ == "__main__":
+    main()
@@ -369,6 +369,85 @@ class NetworkTelemetry(FDTelemetry):
 
         FDTelemetry.__init__(self, fd=s.fileno(), *args, **kwargs)
 
+class MultiTelemetry():
+    """ Services several fd based telemetry streams from a single thread. """
+    def __init__(self, streams):
+        """ Multiplexes existing connections, e.g. to a fleet of simulators.
+
+         - streams: a list of FDTelemetry instances created with
+             service_in_iter=False
+
+        Each stream keeps its own last_values and handshake state.  Only the
+        servicing is shared: one select() waits on all of them and every
+        stream that is ready gets a nonblocking service_connection().
+        """
+
+        self.streams = list(streams)
+        self.closed = set()
+
+    def _live_streams(self):
+        return [t for t in self.streams if t not in self.closed]
+
+    def service_connection(self, timeout=None):
+        """ Wait until at least one stream has IO and service those that do.
+
+        Returns the streams that were serviced.
+        """
+
+        live = self._live_streams()
+        if not live:
+            return []
+
+        rdSet = [t.fd for t in live]
+        wrSet = [t.fd for t in live if len(t.send_buf) > 0]
+
+        if timeout is None:
+            r,w,e = select.select(rdSet, wrSet, [])
+        else:
+            r,w,e = select.select(rdSet, wrSet, [], timeout)
+
+        ready = set(r) | set(w)
+        serviced = []
+
+        for t in live:
+            if t.fd not in ready:
+                continue
+
+            try:
+                t.service_connection(0)
+            except RuntimeError:
+                # The other end went away, stop polling it
+                with t.cond:
+                    t.eof = True
+                    t.cond.notifyAll()
+                self.closed.add(t)
+                continue
+
+            serviced.append(t)
+
+        return serviced
+
+    def get_last_values(self):
+        """ Returns the last values of each stream, in stream order. """
+        return [t.get_last_values() for t in self.streams]
+
+    def _done(self):
+        return not self._live_streams()
+
+    def start_thread(self):
+        """ Starts one thread servicing all streams. """
+        from threading import Thread
+
+        def run():
+            while not self._done():
+                self.service_connection()
+
+        t = Thread(target=run, name="multi telemetry svc thread")
+
+        t.daemon=True
+
+        t.start()
+
 # TODO XXX : Plumb appropriate cleanup / file close for these classes
 
 class SerialTelemetry(FDTelemetry):
@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ * @file       crc.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup Shared CRC kernels
+ * @{
+ * @addtogroup
+ * @{
+ * @brief CRC8, CRC16 and CRC32 shared by the flight code and the GCS
+ *
+ * The block updates use slice-by-N tables: N bytes are folded into the CRC
+ * per step with one lookup per byte in N tables instead of N dependent
+ * lookups in one table. The number of slices is chosen per platform in
+ * crc.c since every extra slice costs 256 table entries of flash.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef CRC_H_
+#define CRC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lookup tables, [0] is the classic byte table */
+extern const uint8_t crc8_table[][256];
+extern const uint16_t crc16_table[][256];
+extern const uint32_t crc32_table[][256];
+
+/* CRC8, poly 0x07, MSB first (the UAVTalk checksum) */
+static inline uint8_t crc8_update_byte(uint8_t crc, uint8_t data)
+{
+	return crc8_table[0][crc ^ data];
+}
+
+/* CRC16, HDLC poly 0x8408, LSB first */
+static inline uint16_t crc16_update_byte(uint16_t crc, uint8_t data)
+{
+	return (crc >> 8) ^ crc16_table[0][(crc ^ data) & 0xff];
+}
+
+/* CRC32, poly 0x04C11DB7, MSB first */
+static inline uint32_t crc32_update_byte(uint32_t crc, uint8_t data)
+{
+	return (crc << 8) ^ crc32_table[0][(crc >> 24) ^ data];
+}
+
+uint8_t crc8_update(uint8_t crc, const uint8_t *data, uint32_t length);
+uint16_t crc16_update(uint16_t crc, const uint8_t *data, uint32_t length);
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC_H_ */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,119 @@
+/**
+ ******************************************************************************
+ * @file       sil_protocol.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @addtogroup Shared Software in the loop protocol
+ * @{
+ * @addtogroup
+ * @{
+ * @brief Frames exchanged between the GCS SIL backend and the posix target
+ *
+ * The GCS runs the vehicle model and is the master clock. For every step it
+ * sends one sensor frame. The flight code publishes the sensors, runs its
+ * control loop on them and answers with one actuator frame carrying the same
+ * step number, after which the GCS advances the model by dt_us and sends the
+ * next step. Neither side runs on wall clock time in between, so a run is
+ * reproducible and only limited by how fast both sides compute a step.
+ *
+ * Both ends run on the same machine, the frames are sent in host byte order.
+ * All fields are four bytes wide so the layout has no padding.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SIL_PROTOCOL_H_
+#define SIL_PROTOCOL_H_
+
+#include <stdint.h>
+
+#define SIL_PROTOCOL_MAGIC    0x4c495354  /* "TSIL" */
+#define SIL_PROTOCOL_VERSION  1
+#define SIL_DEFAULT_PORT      9010
+
+/* Matches the elements of ActuatorCommand.Channel */
+#define SIL_ACTUATOR_CHANNELS 10
+
+enum sil_frame_type {
+	SIL_FRAME_SENSORS   = 1,
+	SIL_FRAME_ACTUATORS = 2,
+};
+
+/* Bits of sil_sensor_frame.updated for the sensors slower than the step */
+#define SIL_UPDATED_MAG      0x01
+#define SIL_UPDATED_BARO     0x02
+#define SIL_UPDATED_GPS      0x04
+#define SIL_UPDATED_AIRSPEED 0x08
+
+struct sil_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t type;               /* enum sil_frame_type */
+	uint32_t length;             /* of the whole frame */
+	uint32_t step;
+};
+
+/* GCS to flight: sensors at the start of a step */
+struct sil_sensor_frame {
+	struct sil_header header;
+	uint32_t time_us;            /* simulation time of this step */
+	uint32_t dt_us;              /* time since the previous step */
+	uint32_t updated;            /* SIL_UPDATED_* */
+	float gyro[3];               /* deg/s, body frame */
+	float accel[3];              /* m/s^2, body frame */
+	float mag[3];                /* mGa, body frame */
+	float baro_altitude;         /* m */
+	float airspeed;              /* m/s, calibrated */
+	int32_t latitude;            /* deg * 1e7 */
+	int32_t longitude;           /* deg * 1e7 */
+	float altitude;              /* m above the geoid */
+	float velocity[3];           /* m/s, NED */
+};
+
+/* Flight to GCS: outputs computed from the sensors of the same step */
+struct sil_actuator_frame {
+	struct sil_header header;
+	uint32_t armed;
+	float roll;                  /* ActuatorDesired, -1 to 1 */
+	float pitch;
+	float yaw;
+	float throttle;
+	float channel[SIL_ACTUATOR_CHANNELS]; /* ActuatorCommand, us */
+};
+
+static inline void sil_header_init(struct sil_header *header, enum sil_frame_type type,
+				   uint32_t length, uint32_t step)
+{
+	header->magic = SIL_PROTOCOL_MAGIC;
+	header->version = SIL_PROTOCOL_VERSION;
+	header->type = type;
+	header->length = length;
+	header->step = step;
+}
+
+static inline int sil_header_valid(const struct sil_header *header, enum sil_frame_type type,
+				   uint32_t length)
+{
+	return header->magic == SIL_PROTOCOL_MAGIC &&
+		header->version == SIL_PROTOCOL_VERSION &&
+		header->type == type && header->length == length;
+}
+
+#endif /* SIL_PROTOCOL_H_ */
+
+/**
+ * @}
+ * @}
+ */